@@ -0,0 +1,97 @@
+/******************************************************************************
+ * Copyright 2003 Jonathan Cohen, Nat Duca, David Luebke, Brenden Schubert    *
+ *                Johns Hopkins University and University of Virginia         *
+ ******************************************************************************
+ * This file is distributed as part of the GLOD library, and as such, falls   *
+ * under the terms of the GLOD public license. GLOD is distributed without    *
+ * any warranty, implied or otherwise. See the GLOD license for more details. *
+ *                                                                            *
+ * You should have recieved a copy of the GLOD Open-Source License with this  *
+ * copy of GLOD; if not, please visit the GLOD web page,                      *
+ * http://www.cs.jhu.edu/~graphics/GLOD/license for more information          *
+ ******************************************************************************/
+/* PLY models for the samples and tools: read_plyfile() maps a PLY file and
+ * parses its vertices and faces in parallel, then splits the faces into
+ * per-patch triangle index lists that index the vertex list directly, so
+ * they can go straight to glodInsertElements().
+ ****************************************************************************/
+#ifndef PLYMODEL_H
+#define PLYMODEL_H
+
+#include "ply.h"
+
+struct glodVBO;
+
+/* SetupVertexArray modes */
+#define VERTEX_ARRAY_ELEMENTS 1 /* one shared vertex array plus per-patch indices */
+#define VERTEX_ARRAY_ARRAYS   2 /* one unindexed vertex array per patch */
+
+typedef struct Vertex {
+    float coord[3];
+    float normal[3];
+    unsigned char color[4];
+    float texcoord[2];
+} Vertex;
+
+/* the vertex list doubles as the interleaved vertex array */
+typedef Vertex VertexArray;
+
+typedef struct Face {
+    int nverts;
+    int *verts;                 /* points into PlyModel::face_lists */
+    int patch_num;
+} Face;
+
+typedef struct PatchList {
+    int nindices;               /* 3 per triangle */
+    unsigned int *indices;      /* into PlyModel::vlist */
+    VertexArray *va;            /* VERTEX_ARRAY_ARRAYS: nindices vertices */
+} PatchList;
+
+typedef struct PlyModel {
+    int nverts;
+    Vertex *vlist;
+    int nfaces;
+    Face *flist;
+    void *face_lists;           /* pool holding every face's verts */
+
+    int npatches;
+    PatchList *plist;
+    int va_mode;                /* last SetupVertexArray mode, or 0 */
+
+    int has_vertex_normals;
+    int has_vertex_colors;
+    int has_texcoords;
+    int has_texture;
+    unsigned int texture_id;
+    unsigned char solid_color[4];
+
+    float min[3];
+    float max[3];
+} PlyModel;
+
+/* Reads a PLY file (ascii or either binary byte order) into model, which
+ * is overwritten.  Polygons are split into triangle fans and patches are
+ * numbered 0..npatches-1 in order of the faces' patch_num property. */
+int read_plyfile(char *filename, PlyModel *model);
+int read_plyfile_threads(char *filename, PlyModel *model, int num_threads);
+void DeleteModel(PlyModel *model);
+
+/* centers the model's bounding box on the origin and returns the length of
+ * its diagonal */
+float CenterOnOrigin(PlyModel *model);
+void ComputeVertexNormals(PlyModel *model, int inv);
+void InvertVertexNormals(PlyModel *model);
+
+/* fills pVBO with the model's vertex arrays for the given patch, as
+ * glodInsertElements (VERTEX_ARRAY_ELEMENTS) or glodInsertArrays
+ * (VERTEX_ARRAY_ARRAYS) expects them after SetupVertexArray */
+void GetPatchVBO(PlyModel *model, int patch, struct glodVBO *pVBO);
+
+/* OpenGL helpers */
+void SetupTexture(PlyModel *model, char *filename);
+void SetupVertexArray(PlyModel *model, int mode);
+void BindVertexArray(PlyModel *model, int patch);
+void DrawModelVA(PlyModel *model, int patch);
+
+#endif /* PLYMODEL_H */
@@ -53,15 +53,12 @@ extern "C" {
 /// reserved for glod_core.h::GLOD_FORMAT_UNKNOWN
 #define GLOD_RESERVED                   0x0000 
 
-#ifdef GLOD_COREPROFILE_FIXED
 #define GLOD_CONTINUOUS                 0x0001
-#endif
 #define GLOD_DISCRETE                   0x0002
 #define GLOD_DISCRETE_MANUAL            0x0003
 #define GLOD_DISCRETE_PATCH             0x0004
-#ifdef GLOD_COREPROFILE_FIXED
+#define GLOD_MULTI_TRIANGULATION        0x0005
 #define GLOD_VDS                        0x0001
-#endif        
 /* Object Param Names
  ***************************************************************************/
 #define GLOD_READBACK_SIZE         0x01
@@ -69,6 +66,10 @@ extern "C" {
 #define GLOD_PATCH_NAMES           0x03
 #define GLOD_PATCH_SIZES           0x04
 #define GLOD_XFORM_MATRIX          0x05
+#define GLOD_BUFFER_SIZES          0x06
+#define GLOD_NUM_LEVELS            0x07
+#define GLOD_BUFFER_RANGES         0x08
+#define GLOD_PATCH_RANGES          0x09
 
 #define GLOD_BUILD_OPERATOR        0x20
 #define GLOD_BUILD_QUEUE_MODE      0x21
@@ -81,6 +82,8 @@ extern "C" {
 #define GLOD_BUILD_ERROR_SPECS     0x28
 #define GLOD_BUILD_PERMISSION_GRID_PRECISION 0x29
 #define GLOD_QUADRIC_MULTIPLIER	   0x2a
+#define GLOD_BUILD_NODE_LAYOUT     0x2b
+#define GLOD_BUILD_TIME            0x2c
     
 #define GLOD_XFORM                 0x41
 #define GLOD_APPLY_OBJECT_XFORM    0x42
@@ -110,6 +113,10 @@ extern "C" {
 #define GLOD_SNAPSHOT_TRI_SPEC           0x02
 #define GLOD_SNAPSHOT_ERROR_SPEC         0x03
 
+#define GLOD_LAYOUT_DEPTH_FIRST           0x01
+#define GLOD_LAYOUT_BREADTH_FIRST_BLOCKED 0x02
+#define GLOD_LAYOUT_VAN_EMDE_BOAS         0x03
+
 /* GLOD Group Params
  ***************************************************************************/
 #define GLOD_ADAPT_MODE                   0x01
@@ -117,6 +124,19 @@ extern "C" {
 #define GLOD_OBJECT_SPACE_ERROR_THRESHOLD 0x03
 #define GLOD_SCREEN_SPACE_ERROR_THRESHOLD 0x04
 #define GLOD_MAX_TRIANGLES                0x05
+#define GLOD_NUM_CHANGED_PATCHES          0x06
+#define GLOD_CHANGED_PATCHES              0x07
+#define GLOD_DEFERRED_COMMIT              0x08
+#define GLOD_ADAPT_TIME                   0x09
+#define GLOD_ADAPT_ITERATIONS             0x0A
+#define GLOD_ADAPT_COARSEN_OPS            0x0B
+#define GLOD_ADAPT_REFINE_OPS             0x0C
+#define GLOD_ADAPT_HEAP_OPS               0x0D
+#define GLOD_ADAPT_ERROR_EVALS            0x0E
+#define GLOD_ADAPT_OBJECTS_TOUCHED        0x0F
+#define GLOD_ADAPT_TRIS_BEFORE            0x10
+#define GLOD_ADAPT_TRIS_AFTER             0x11
+#define GLOD_ERROR_UPDATE_TOLERANCE       0x12
 
 /* Group::Possible Param Values
  ***************************************************************************/
@@ -155,6 +175,7 @@ GLOD_APIENTRY void glodLoadObject( GLuint name, GLuint groupname,
 GLOD_APIENTRY void glodReadbackObject( GLuint name, GLvoid *data );
 GLOD_APIENTRY void glodFillArrays( GLuint object_name, GLuint patch_name, glodVBO *pVBO );
 GLOD_APIENTRY void glodFillElements( GLuint object_name, GLuint patch_name, GLenum type, GLvoid* out_elements, glodVBO  *pVBO );
+GLOD_APIENTRY void glodFillObjectBuffers( GLuint object_name, GLenum type, GLvoid* out_elements, glodVBO *pVBO );
 
 
 GLOD_APIENTRY void glodInsertArrays( GLuint name, GLuint patchname,
@@ -167,9 +188,13 @@ GLOD_APIENTRY void glodInsertElements( GLuint name, GLuint patchname,
 
 GLOD_APIENTRY void glodInstanceObject( GLuint name, GLuint instancename, 
                                        GLuint groupname );
+GLOD_APIENTRY void glodInstanceObjects( GLuint name, GLsizei count,
+                                        const GLuint *instancenames,
+                                        GLuint groupname );
 GLOD_APIENTRY void glodNewObject( GLuint name, GLuint groupname,
                                   GLenum format );
 GLOD_APIENTRY void glodBuildObject( GLuint name );
+GLOD_APIENTRY void glodBuildObjects( GLsizei count, const GLuint *names );
 GLOD_APIENTRY void glodDeleteObject( GLuint name );
 
 GLOD_APIENTRY void glodDrawPatch( GLuint name, GLuint patchname );
@@ -178,8 +203,13 @@ GLOD_APIENTRY void glodSetLayout(int rows, int cols);
 
 GLOD_APIENTRY void glodNewGroup( GLuint groupname );
 GLOD_APIENTRY void glodAdaptGroup( GLuint groupname );
+GLOD_APIENTRY void glodCommitGroup( GLuint groupname );
 GLOD_APIENTRY void glodObjectXform( GLuint object_name, float m1[16],
                                     float m2[16], float m3[16] );
+GLOD_APIENTRY void glodObjectXforms( GLsizei count, const GLuint *object_names,
+                                     const float *matrices );
+GLOD_APIENTRY void glodAttachObjectXforms( GLsizei count, const GLuint *object_names,
+                                           const float *matrices );
 GLOD_APIENTRY void glodDeleteGroup( GLuint groupname );
 
 GLOD_APIENTRY void glodObjectParameterf( GLuint name, GLenum pname,
@@ -107,6 +107,41 @@ typedef struct PlyOtherElems {  /* "other" elements, not interpreted by user */
     OtherElem *other_list;        /* list of data for other elements */
 } PlyOtherElems;
 
+typedef struct PlyElement {     /* description of an element */
+    char *name;                   /* element name */
+    int num;                      /* number of elements in this object */
+    int size;                     /* bytes per element in a binary file, or
+                                     -1 if it has list properties */
+    int nprops;                   /* number of properties for this element */
+    PlyProperty **props;          /* list of properties in the file */
+    char *store_prop;             /* flags: property wanted by user? */
+} PlyElement;
+
+typedef struct PlyFile {        /* description of PLY file */
+    FILE *fp;                     /* file pointer, when writing */
+    int file_type;                /* ascii or binary */
+    float version;                /* version number of file */
+    int nelems;                   /* number of elements of object */
+    PlyElement **elems;           /* list of elements */
+    int num_comments;             /* number of comments */
+    char **comments;              /* list of comments */
+    int num_obj_info;             /* number of items of object information */
+    char **obj_info;              /* list of object info items */
+    PlyElement *which_elem;       /* which element we're currently using */
+    PlyOtherElems *other_elems;   /* "other" elements from a PLY file */
+
+    /* when reading, the whole file is mapped (or, failing that, read) into
+       memory and elements are parsed straight out of it */
+    char *map;                    /* first byte of the file */
+    size_t map_size;              /* bytes in the file */
+    int map_kind;                 /* how map was obtained, for ply_close */
+    void *map_handles[2];         /* Win32 file and mapping handles */
+    int swap;                     /* binary data needs its bytes swapped */
+    char *cursor;                 /* next unread byte of element data */
+    int cursor_elem;              /* element type the cursor is in */
+    int cursor_count;             /* elements of that type already read */
+} PlyFile;
+
 #ifndef ALLOCN
 #define REALLOCN(PTR,TYPE,OLD_N,NEW_N)                                  \
 {                                                                   \
@@ -141,7 +176,40 @@ typedef struct PlyOtherElems {  /* "other" elements, not interpreted by user */
 
 #define FREE(PTR)  { free((PTR)); (PTR) = NULL; }
 #endif
-    
+
+/* writing */
+PlyFile *ply_write(FILE *fp, int nelems, char **elem_names, int file_type);
+PlyFile *ply_open_for_writing(char *filename, int nelems, char **elem_names,
+                              int file_type, float *version);
+void ply_describe_element(PlyFile *plyfile, char *elem_name, int nelems,
+                          int nprops, PlyProperty *prop_list);
+void ply_describe_property(PlyFile *plyfile, char *elem_name,
+                           PlyProperty *prop);
+void ply_element_count(PlyFile *plyfile, char *elem_name, int nelems);
+void ply_put_comment(PlyFile *plyfile, char *comment);
+void ply_put_obj_info(PlyFile *plyfile, char *obj_info);
+void ply_header_complete(PlyFile *plyfile);
+void ply_put_element_setup(PlyFile *plyfile, char *elem_name);
+void ply_put_element(PlyFile *plyfile, void *elem_ptr);
+void ply_put_other_elements(PlyFile *plyfile);
+
+/* reading */
+PlyFile *ply_open_for_reading(char *filename, int *nelems, char ***elem_names,
+                              int *file_type, float *version);
+PlyProperty **ply_get_element_description(PlyFile *plyfile, char *elem_name,
+                                          int *nelems, int *nprops);
+int ply_get_property(PlyFile *plyfile, char *elem_name, PlyProperty *prop);
+void ply_get_element_setup(PlyFile *plyfile, char *elem_name, int nprops,
+                           PlyProperty *prop_list);
+int ply_get_element(PlyFile *plyfile, void *elem_ptr);
+int ply_get_elements(PlyFile *plyfile, void *elems, int elem_size,
+                     int num_threads, void **lists);
+void ply_free_lists(void *lists);
+char **ply_get_comments(PlyFile *plyfile, int *num_comments);
+char **ply_get_obj_info(PlyFile *plyfile, int *num_obj_info);
+
+void ply_close(PlyFile *plyfile);
+
 
 /* 
 
@@ -211,11 +279,21 @@ for each element type in the file
          specify a list of all the properties you want to get)
         for each actual data element of this type in the file
             ply_get_element()
+        (or ply_get_elements() to read them all into an array at once)
     else if we want to keep "other" elements
         ply_get_other_element()
 
 ply_close()
 
+The file is memory-mapped, and element types must be read in the order
+they appear in it; element types that are never asked for are skipped.
+ply_get_elements() parses large element lists in parallel chunks, and can
+put every list property of the element type into one shared pool
+(released with ply_free_lists()) instead of a malloc per element.  ASCII
+files are chunked by line, so they must hold one element per line, as
+every PLY writer produces.  "Other" properties and elements are not
+carried along by this implementation.
+
 */
 
 
@@ -342,7 +420,7 @@ This example demonstrates the basic components of the header.  Each part
 of the header is a carraige-return terminated ASCII string that begins with a 
 keyword.  Even the start and end of the header ("ply<cr>" and 
 "end_header<cr>") are in this form.  The characters "ply<cr>" must be the 
-first four characters of the file, since they serve as the files magic number.  
+first four characters of the file, since they serve as the file�s magic number.  
 Following the start of the header is the keyword "format" and a specification 
 of either ASCII or binary format, followed by a version number.  Next is the 
 description of each of the elements in the polygon file, and within each 
@@ -0,0 +1,601 @@
+/******************************************************************************
+ * Copyright 2003 Jonathan Cohen, Nat Duca, David Luebke, Brenden Schubert    *
+ *                Johns Hopkins University and University of Virginia         *
+ ******************************************************************************
+ * This file is distributed as part of the GLOD library, and as such, falls   *
+ * under the terms of the GLOD public license. GLOD is distributed without    *
+ * any warranty, implied or otherwise. See the GLOD license for more details. *
+ *                                                                            *
+ * You should have recieved a copy of the GLOD Open-Source License with this  *
+ * copy of GLOD; if not, please visit the GLOD web page,                      *
+ * http://www.cs.jhu.edu/~graphics/GLOD/license for more information          *
+ ******************************************************************************/
+/* Offline LOD baker: builds the hierarchies for every asset in a manifest,
+ * all at once through glodBuildObjects, and writes each one out as a
+ * readback file that read_model (and glodLoadObject) can load. Nothing is
+ * drawn, so no window or GL context is needed.
+ ****************************************************************************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#include "glod.h"
+#include "PlyModel.h"
+
+// the container read_model.cpp writes and loads: magic, blob size,
+// bounding box max, then the glodReadbackObject blob
+const int RBK_MAGIC = 1230985712;
+
+#define MAX_LINE 4096
+
+#define NO_SNAPSHOT 0
+#define TRI_SNAPSHOT 1
+#define ERROR_SNAPSHOT 2
+#define PERCENT_SNAPSHOT 3
+
+struct Asset {
+    char* in_file;
+    char* out_file;
+    int line;
+
+    // build parameters; the defaults are simplify's
+    int mode;
+    int simp_mode;
+    int edge_lock;
+    int build_op;
+    int queue_mode;
+    float share_tolerance;
+    float pg_precision;
+    int inv;
+    int snapshot_type;
+    int num_levels;
+    GLint* level_tris;
+    GLfloat* level_errors;
+    float reduction_factor;
+
+    // report
+    int loaded;
+    int written;
+    int checked;
+    int verts;
+    int tris;
+    int levels;
+    int readback_size;
+    float max[3];
+    double load_ms;
+    double build_ms;
+    double write_ms;
+};
+
+int s_Verbose = 0;
+int s_Check = 0;
+
+double GetMilliseconds() {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+#endif
+}
+
+void Usage() {
+    printf("Usage:\n");
+    printf("   bake [-v] [-check] <manifest>\n");
+    printf("       Builds GLOD hierarchies for the PLY files listed in the manifest and\n");
+    printf("       writes each one out as a readback file for read_model/glodLoadObject.\n");
+    printf("       The builds run in parallel, one per processor.\n");
+    printf("       -check loads each written file back with glodLoadObject, adapts\n");
+    printf("       it to half its triangles and reads the cut out again.\n");
+    printf("Manifest:\n");
+    printf("   One asset per line: [flags] <input.ply> <output.rbk>\n");
+    printf("   Blank lines and anything after a # are ignored.\n");
+    printf("Flags (as for simplify):\n");
+    printf("      -i    Inverts the calculated normals\n");
+    printf("      -c    Uses continuous LOD instead of Discrete\n");
+    printf("      -d    Uses discrete LOD (the default)\n");
+    printf("      -q    Uses quadric error instead of error spheres\n");
+    printf("      -e    Uses full edge collapse instead of half edge\n");
+    printf("      -l    Enables border lock (prevents borders from being simplified)\n");
+    printf("      -lq   Uses the lazy simplification queue (faster)\n");
+    printf("      -pg <p>          Uses permission grid error with precision p\n");
+    printf("      -share <t>       Sharing tolerance when building the hierarchy\n");
+    printf("      -ntris <n>...    Triangle counts for the snapshot levels\n");
+    printf("      -errors <e>...   Error values for the snapshot levels\n");
+    printf("      -percent <f>     Percent reduction factor for each level\n");
+    printf("\n");
+}
+
+/***************************************************************************
+ * Manifest
+ ***************************************************************************/
+void InitAsset(Asset* asset, int line) {
+    memset(asset, 0, sizeof(Asset));
+    asset->line = line;
+    asset->mode = GLOD_DISCRETE;
+    asset->simp_mode = GLOD_METRIC_SPHERES;
+    asset->edge_lock = GLOD_BORDER_UNLOCK;
+    asset->build_op = GLOD_OPERATOR_HALF_EDGE_COLLAPSE;
+    asset->queue_mode = GLOD_QUEUE_GREEDY;
+    asset->pg_precision = 1.0f;
+    asset->snapshot_type = NO_SNAPSHOT;
+}
+
+void FreeAsset(Asset* asset) {
+    free(asset->in_file);
+    free(asset->out_file);
+    delete [] asset->level_tris;
+    delete [] asset->level_errors;
+}
+
+char* CopyString(const char* s) {
+    char* copy = (char*) malloc(strlen(s) + 1);
+    strcpy(copy, s);
+    return copy;
+}
+
+int IsNumber(const char* s) {
+    char* end;
+    if(s == NULL)
+        return 0;
+    strtod(s, &end);
+    return end != s && *end == '\0';
+}
+
+// Counts the numbers that follow token i, for -ntris and -errors.
+int CountNumbers(char** tokens, int ntokens, int i) {
+    int n = 0;
+    while(i + 1 + n < ntokens && IsNumber(tokens[i + 1 + n]))
+        n++;
+    return n;
+}
+
+// Parses one manifest line; returns 0 (after saying why) if it's bad.
+int ParseAsset(char* text, const char* manifest, Asset* asset) {
+    char* tokens[MAX_LINE / 2];
+    char* files[2];
+    int ntokens = 0, nfiles = 0;
+    int i;
+
+    for(char* tok = strtok(text, " \t\r\n"); tok != NULL; tok = strtok(NULL, " \t\r\n"))
+        tokens[ntokens++] = tok;
+
+    for(i = 0; i < ntokens; i++) {
+        char* t = tokens[i];
+
+        if(strcmp(t, "-i") == 0) {
+            asset->inv = 1;
+        } else if(strcmp(t, "-c") == 0) {
+            asset->mode = GLOD_CONTINUOUS;
+        } else if(strcmp(t, "-p") == 0) {
+            // patch-LOD hierarchies have no readback to write out
+            fprintf(stderr, "%s:%i: -p hierarchies cannot be baked\n", manifest, asset->line);
+            return 0;
+        } else if(strcmp(t, "-d") == 0) {
+            asset->mode = GLOD_DISCRETE;
+        } else if(strcmp(t, "-q") == 0) {
+            asset->simp_mode = GLOD_METRIC_QUADRICS;
+        } else if(strcmp(t, "-e") == 0) {
+            asset->build_op = GLOD_OPERATOR_EDGE_COLLAPSE;
+        } else if(strcmp(t, "-l") == 0) {
+            asset->edge_lock = GLOD_BORDER_LOCK;
+        } else if(strcmp(t, "-lq") == 0) {
+            asset->queue_mode = GLOD_QUEUE_LAZY;
+        } else if(strcmp(t, "-pg") == 0) {
+            asset->simp_mode = GLOD_METRIC_PERMISSION_GRID;
+            asset->pg_precision = 2.0f;
+            if(IsNumber(i + 1 < ntokens ? tokens[i + 1] : NULL) && atof(tokens[i + 1]) > 0.0f)
+                asset->pg_precision = (float) atof(tokens[++i]);
+        } else if(strcmp(t, "-share") == 0) {
+            if(! IsNumber(i + 1 < ntokens ? tokens[i + 1] : NULL)) {
+                fprintf(stderr, "%s:%i: -share needs a tolerance\n", manifest, asset->line);
+                return 0;
+            }
+            asset->share_tolerance = (float) atof(tokens[++i]);
+        } else if(strcmp(t, "-ntris") == 0 || strcmp(t, "-errors") == 0 || strcmp(t, "-percent") == 0) {
+            int n = CountNumbers(tokens, ntokens, i);
+            if(asset->snapshot_type != NO_SNAPSHOT) {
+                fprintf(stderr, "%s:%i: only one of -ntris, -errors and -percent may be given\n", manifest, asset->line);
+                return 0;
+            }
+            if(n == 0 || (t[1] == 'p' && n != 1)) {
+                fprintf(stderr, "%s:%i: %s needs %s\n", manifest, asset->line, t,
+                        t[1] == 'p' ? "a reduction factor" : "at least one level");
+                return 0;
+            }
+            if(t[1] == 'n') {
+                asset->snapshot_type = TRI_SNAPSHOT;
+                asset->level_tris = new GLint[n];
+                for(int l = 0; l < n; l++)
+                    asset->level_tris[l] = atoi(tokens[i + 1 + l]);
+            } else if(t[1] == 'e') {
+                asset->snapshot_type = ERROR_SNAPSHOT;
+                asset->level_errors = new GLfloat[n];
+                for(int l = 0; l < n; l++)
+                    asset->level_errors[l] = (GLfloat) atof(tokens[i + 1 + l]);
+            } else {
+                asset->snapshot_type = PERCENT_SNAPSHOT;
+                asset->reduction_factor = (float) atof(tokens[i + 1]);
+                if(asset->reduction_factor > 1)
+                    asset->reduction_factor /= 100;
+            }
+            asset->num_levels = n;
+            i += n;
+        } else if(t[0] == '-') {
+            fprintf(stderr, "%s:%i: unknown flag %s\n", manifest, asset->line, t);
+            return 0;
+        } else {
+            if(nfiles == 2) {
+                fprintf(stderr, "%s:%i: more than an input and an output file\n", manifest, asset->line);
+                return 0;
+            }
+            files[nfiles++] = t;
+        }
+    }
+
+    if(nfiles != 2) {
+        fprintf(stderr, "%s:%i: needs an input and an output file\n", manifest, asset->line);
+        return 0;
+    }
+    asset->in_file = CopyString(files[0]);
+    asset->out_file = CopyString(files[1]);
+    return 1;
+}
+
+// Reads every asset in the manifest; returns the number read, or -1.
+int ReadManifest(const char* manifest, Asset** assets) {
+    FILE* f = fopen(manifest, "r");
+    char text[MAX_LINE];
+    int line = 0, num = 0, max = 16, bad = 0;
+
+    if(f == NULL) {
+        fprintf(stderr, "Could not open %s.\n", manifest);
+        return -1;
+    }
+    *assets = (Asset*) malloc(sizeof(Asset) * max);
+    while(fgets(text, sizeof(text), f) != NULL) {
+        line++;
+        char* comment = strchr(text, '#');
+        if(comment != NULL)
+            *comment = '\0';
+        char* c = text;
+        while(isspace((unsigned char)*c))
+            c++;
+        if(*c == '\0')
+            continue;
+
+        if(num == max) {
+            max *= 2;
+            *assets = (Asset*) realloc(*assets, sizeof(Asset) * max);
+        }
+        InitAsset(&(*assets)[num], line);
+        if(ParseAsset(c, manifest, &(*assets)[num]))
+            num++;
+        else {
+            FreeAsset(&(*assets)[num]);
+            bad++;
+        }
+    }
+    fclose(f);
+
+    if(bad > 0) {
+        for(int i = 0; i < num; i++)
+            FreeAsset(&(*assets)[i]);
+        free(*assets);
+        *assets = NULL;
+        return -1;
+    }
+    return num;
+}
+
+/***************************************************************************
+ * Baking
+ ***************************************************************************/
+
+// Loads the asset's PLY file into a new object called name.
+int LoadAsset(Asset* asset, GLuint name) {
+    PlyModel model;
+    double start = GetMilliseconds();
+
+    if(read_plyfile(asset->in_file, &model) != PLY_OKAY)
+        return 0;
+    if(! model.has_vertex_normals)
+        ComputeVertexNormals(&model, asset->inv);
+    else if(asset->inv)
+        InvertVertexNormals(&model);
+
+    asset->verts = model.nverts;
+    asset->tris = 0;
+    for(int j = 0; j < 3; j++)
+        asset->max[j] = model.max[j];
+
+    glodNewObject(name, 0, asset->mode);
+    for(int pnum = 0; pnum < model.npatches; pnum++) {
+        glodVBO vbo;
+        GetPatchVBO(&model, pnum, &vbo);
+        glodInsertElements(name, pnum,
+                           GL_TRIANGLES, model.plist[pnum].nindices, GL_UNSIGNED_INT, model.plist[pnum].indices,
+                           0, 0.0, &vbo);
+        asset->tris += model.plist[pnum].nindices / 3;
+    }
+    // the object has its own copy now
+    DeleteModel(&model);
+
+    glodObjectParameteri(name, GLOD_BUILD_OPERATOR, asset->build_op);
+    glodObjectParameteri(name, GLOD_BUILD_ERROR_METRIC, asset->simp_mode);
+    glodObjectParameteri(name, GLOD_BUILD_BORDER_MODE, asset->edge_lock);
+    glodObjectParameteri(name, GLOD_BUILD_QUEUE_MODE, asset->queue_mode);
+    glodObjectParameterf(name, GLOD_BUILD_SHARE_TOLERANCE, asset->share_tolerance);
+    glodObjectParameterf(name, GLOD_BUILD_PERMISSION_GRID_PRECISION, asset->pg_precision);
+    if(asset->mode != GLOD_CONTINUOUS) {
+        if(asset->snapshot_type == TRI_SNAPSHOT) {
+            glodObjectParameteri(name, GLOD_BUILD_SNAPSHOT_MODE, GLOD_SNAPSHOT_TRI_SPEC);
+            glodObjectParameteriv(name, GLOD_BUILD_TRI_SPECS, asset->num_levels, asset->level_tris);
+        } else if(asset->snapshot_type == ERROR_SNAPSHOT) {
+            glodObjectParameteri(name, GLOD_BUILD_SNAPSHOT_MODE, GLOD_SNAPSHOT_ERROR_SPEC);
+            glodObjectParameterfv(name, GLOD_BUILD_ERROR_SPECS, asset->num_levels, asset->level_errors);
+        } else if(asset->snapshot_type == PERCENT_SNAPSHOT) {
+            glodObjectParameterf(name, GLOD_BUILD_PERCENT_REDUCTION_FACTOR, asset->reduction_factor);
+        }
+    }
+
+    if(glodGetError() != GLOD_NO_ERROR) {
+        glodDeleteObject(name);
+        return 0;
+    }
+    asset->load_ms = GetMilliseconds() - start;
+    return 1;
+}
+
+// Writes the built object called name to the asset's output file.
+int WriteAsset(Asset* asset, GLuint name) {
+    GLint size, micros;
+    char* data;
+    int extra = 3 * sizeof(float) + 2 * sizeof(int);
+    double start = GetMilliseconds();
+
+    glodGetObjectParameteriv(name, GLOD_BUILD_TIME, &micros);
+    asset->build_ms = micros / 1000.0;
+    glodGetObjectParameteriv(name, GLOD_NUM_LEVELS, &asset->levels);
+    glodGetObjectParameteriv(name, GLOD_READBACK_SIZE, &size);
+    asset->readback_size = size;
+
+    data = (char*) malloc(size + extra);
+    memcpy(data, &RBK_MAGIC, sizeof(int));
+    memcpy(data + sizeof(int), &size, sizeof(int));
+    memcpy(data + 2 * sizeof(int), asset->max, 3 * sizeof(float));
+    glodReadbackObject(name, (void*) (data + extra));
+
+    FILE* f = fopen(asset->out_file, "wb");
+    int ok = (f != NULL && fwrite(data, size + extra, 1, f) == 1);
+    if(f != NULL && fclose(f) != 0)
+        ok = 0;
+    free(data);
+    if(! ok)
+        fprintf(stderr, "Could not write %s.\n", asset->out_file);
+
+    asset->write_ms = GetMilliseconds() - start;
+    return ok;
+}
+
+// Loads the asset's output file back into a new object called name, in a
+// group of its own, adapts it to half its triangles and fills every patch.
+int CheckAsset(Asset* asset, GLuint name) {
+    int extra = 3 * sizeof(float) + 2 * sizeof(int);
+    int magic = 0, size = 0, ok = 1;
+    char* data = NULL;
+
+    FILE* f = fopen(asset->out_file, "rb");
+    if(f != NULL && fread(&magic, sizeof(int), 1, f) == 1 &&
+       fread(&size, sizeof(int), 1, f) == 1 && magic == RBK_MAGIC && size > 0) {
+        data = (char*) malloc(size + extra);
+        if(fseek(f, 0, SEEK_SET) != 0 || fread(data, size + extra, 1, f) != 1) {
+            free(data);
+            data = NULL;
+        }
+    }
+    if(f != NULL)
+        fclose(f);
+    if(data == NULL) {
+        fprintf(stderr, "Could not read %s back.\n", asset->out_file);
+        return 0;
+    }
+
+    glodLoadObject(name, name, data + extra);
+    free(data);
+    if(glodGetError() != GLOD_NO_ERROR) {
+        fprintf(stderr, "Could not load %s.\n", asset->out_file);
+        return 0;
+    }
+    glodGroupParameteri(name, GLOD_ADAPT_MODE, GLOD_TRIANGLE_BUDGET);
+    glodGroupParameteri(name, GLOD_MAX_TRIANGLES, asset->tris > 1 ? asset->tris / 2 : 1);
+    glodAdaptGroup(name);
+
+    GLint npatches = 0;
+    glodGetObjectParameteriv(name, GLOD_NUM_PATCHES, &npatches);
+    GLint* patches = new GLint[npatches];
+    GLint* sizes = new GLint[2 * npatches];
+    glodGetObjectParameteriv(name, GLOD_PATCH_NAMES, patches);
+    glodGetObjectParameteriv(name, GLOD_PATCH_SIZES, sizes);
+
+    int tris = 0;
+    for(int p = 0; p < npatches && ok; p++) {
+        GLuint* indices = new GLuint[sizes[2*p] > 0 ? sizes[2*p] : 1];
+        GLfloat* verts = new GLfloat[3 * (sizes[2*p+1] > 0 ? sizes[2*p+1] : 1)];
+        glodVBO vbo;
+        memset(&vbo, 0, sizeof(vbo));
+        vbo.mV.p = verts;
+        vbo.mV.size = 3;
+        vbo.mV.type = GL_FLOAT;
+        glodFillElements(name, patches[p], GL_UNSIGNED_INT, indices, &vbo);
+        for(int i = 0; i < sizes[2*p]; i++)
+            if(indices[i] >= (GLuint) sizes[2*p+1])
+                ok = 0;
+        tris += sizes[2*p] / 3;
+        delete [] indices;
+        delete [] verts;
+    }
+    delete [] patches;
+    delete [] sizes;
+
+    if(glodGetError() != GLOD_NO_ERROR || tris == 0)
+        ok = 0;
+    if(! ok)
+        fprintf(stderr, "%s does not adapt or fill after loading.\n", asset->out_file);
+    glodDeleteObject(name);
+    glodDeleteGroup(name);
+    return ok;
+}
+
+const char* BaseName(const char* path) {
+    const char* slash = strrchr(path, '/');
+    const char* backslash = strrchr(path, '\\');
+    if(backslash > slash)
+        slash = backslash;
+    return slash ? slash + 1 : path;
+}
+
+void PrintReport(Asset* assets, int num, double build_wall_ms) {
+    double load_ms = 0, build_ms = 0, write_ms = 0;
+    int done = 0;
+    long long tris = 0, bytes = 0;
+
+    printf("\n%-28s %9s %9s %6s %9s %10s %9s %10s\n",
+           "asset", "verts", "tris", "levels", "load ms", "build ms", "write ms", "rbk KB");
+    for(int i = 0; i < num; i++) {
+        Asset* a = &assets[i];
+        if(! a->loaded) {
+            printf("%-28.28s   failed to load\n", BaseName(a->in_file));
+            continue;
+        }
+        char levels[16];
+        if(a->mode == GLOD_CONTINUOUS)
+            strcpy(levels, "-");
+        else
+            sprintf(levels, "%i", a->levels);
+        printf("%-28.28s %9i %9i %6s %9.1f %10.1f %9.1f %10.1f%s\n",
+               BaseName(a->in_file), a->verts, a->tris, levels,
+               a->load_ms, a->build_ms, a->write_ms, a->readback_size / 1024.0,
+               ! a->written ? "  (not written)" :
+               (s_Check && ! a->checked) ? "  (check failed)" : "");
+        load_ms += a->load_ms;
+        build_ms += a->build_ms;
+        write_ms += a->write_ms;
+        tris += a->tris;
+        if(a->written) {
+            bytes += a->readback_size;
+            done++;
+        }
+    }
+    printf("%-28s %9s %9lli %6s %9.1f %10.1f %9.1f %10.1f\n",
+           "total", "", tris, "", load_ms, build_ms, write_ms, bytes / 1024.0);
+    printf("\nBaked %i of %i assets. The builds took %.1f ms on %.1f ms of wall clock",
+           done, num, build_ms, build_wall_ms);
+    if(build_wall_ms > 0)
+        printf(" (%.2fx)", build_ms / build_wall_ms);
+    printf(".\n");
+}
+
+int main(int argc, char** argv) {
+    const char* manifest = NULL;
+    Asset* assets;
+    int num, i;
+
+    for(i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--help") == 0) {
+            Usage();
+            return 0;
+        } else if(strcmp(argv[i], "-v") == 0) {
+            s_Verbose = 1;
+        } else if(strcmp(argv[i], "-check") == 0) {
+            s_Check = 1;
+        } else if(manifest == NULL) {
+            manifest = argv[i];
+        } else {
+            Usage();
+            return 1;
+        }
+    }
+    if(manifest == NULL) {
+        printf("No manifest specified. Cannot continue.\n\n");
+        Usage();
+        return 1;
+    }
+
+    num = ReadManifest(manifest, &assets);
+    if(num < 0)
+        return 1;
+
+    glodInit();
+
+    // load everything first, so that all the builds can run together
+    GLuint* names = new GLuint[num];
+    int num_loaded = 0;
+    for(i = 0; i < num; i++) {
+        if(s_Verbose)
+            printf("Loading %s...\n", assets[i].in_file);
+        assets[i].loaded = LoadAsset(&assets[i], i);
+        if(assets[i].loaded)
+            names[num_loaded++] = i;
+        else
+            fprintf(stderr, "%s:%i: could not load %s.\n", manifest, assets[i].line, assets[i].in_file);
+    }
+
+    if(s_Verbose)
+        printf("Building %i objects...\n", num_loaded);
+    double start = GetMilliseconds();
+    glodBuildObjects(num_loaded, names);
+    double build_wall_ms = GetMilliseconds() - start;
+    if(glodGetError() != GLOD_NO_ERROR) {
+        fprintf(stderr, "Build failed.\n");
+        return 1;
+    }
+
+    for(i = 0; i < num_loaded; i++) {
+        Asset* a = &assets[names[i]];
+        if(s_Verbose)
+            printf("Writing %s...\n", a->out_file);
+        a->written = WriteAsset(a, names[i]);
+        glodDeleteObject(names[i]);
+    }
+
+    // the objects are gone, so their names can be reused for the check
+    for(i = 0; s_Check && i < num_loaded; i++) {
+        Asset* a = &assets[names[i]];
+        if(! a->written)
+            continue;
+        if(s_Verbose)
+            printf("Checking %s...\n", a->out_file);
+        a->checked = CheckAsset(a, names[i]);
+    }
+
+    PrintReport(assets, num, build_wall_ms);
+
+    int failed = 0;
+    for(i = 0; i < num; i++) {
+        if(! assets[i].written || (s_Check && ! assets[i].checked))
+            failed++;
+        FreeAsset(&assets[i]);
+    }
+    free(assets);
+    delete [] names;
+    glodShutdown();
+    return failed > 0 ? 1 : 0;
+}
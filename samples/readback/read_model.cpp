@@ -432,10 +432,12 @@ int main(int argc, char ** argv) {
             // foo
             s_PatchNames[pnum] = pnum*2;
             BindVertexArray(&s_Model, pnum);
+            glodVBO vbo;
+            GetPatchVBO(&s_Model, pnum, &vbo);
             
             glodInsertElements(0, s_PatchNames[pnum],
                 GL_TRIANGLES, s_Model.plist[pnum].nindices, GL_UNSIGNED_INT, s_Model.plist[pnum].indices,
-                0,0.0);
+                0,0.0,&vbo);
                 /*	glodInsertArrays(0, 0, GL_TRIANGLES, 0, s_Model.plist[0].nindices,
             0,0.0);*/
         }
@@ -721,8 +721,9 @@ void LoadScene() {
 	glodNewObject(obj->glod_name, obj->glod_group, mode);
 	
 	for (int pnum=0; pnum<obj->model->plymodel.npatches; pnum++){
-	    BindVertexArray(&mod->plymodel, pnum);
-	    glodInsertArrays(obj->glod_name, pnum, GL_TRIANGLES, 0, obj->model->plymodel.plist[pnum].nindices, 0, 0);
+	    glodVBO vbo;
+	    GetPatchVBO(&mod->plymodel, pnum, &vbo);
+	    glodInsertArrays(obj->glod_name, pnum, GL_TRIANGLES, 0, obj->model->plymodel.plist[pnum].nindices, 0, 0, &vbo);
 	}
 
 	glodBuildObject(obj->glod_name);
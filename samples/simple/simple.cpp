@@ -398,10 +398,12 @@ int main(int argc, char ** argv) {
         printf("This model has %i patches!\n", s_Model.npatches);
         for(int pnum = 0; pnum < s_Model.npatches; pnum++) {
             BindVertexArray(&s_Model, pnum);
+            glodVBO vbo;
+            GetPatchVBO(&s_Model, pnum, &vbo);
             
             glodInsertElements(0, pnum, 
                 GL_TRIANGLES, s_Model.plist[pnum].nindices, GL_UNSIGNED_INT, s_Model.plist[pnum].indices,
-                0,0.0);
+                0,0.0,&vbo);
                 /*   glodInsertArrays(0, 0, GL_TRIANGLES, 0, s_Model.plist[0].nindices,
             0,0.0);*/
         }
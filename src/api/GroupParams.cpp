@@ -76,7 +76,12 @@ void glodGroupParameteri(GLuint name, GLenum pname, GLint param)
     case GLOD_SCREEN_SPACE_ERROR_THRESHOLD:
 	group->setScreenSpaceErrorThreshold((float)param);
 	break;
-
+    case GLOD_DEFERRED_COMMIT:
+	group->setDeferCommit(param != 0);
+	break;
+    case GLOD_ERROR_UPDATE_TOLERANCE:
+	group->setErrorUpdateTolerance((float)param);
+	break;
 
     default:
       GLOD_SetError(GLOD_UNKNOWN_PROPERTY, "Unknown property", pname);
@@ -105,6 +110,9 @@ void glodGroupParameterf (GLuint name, GLenum pname, GLfloat param)
     case GLOD_SCREEN_SPACE_ERROR_THRESHOLD:
 	group->setScreenSpaceErrorThreshold(param);
 	break;
+    case GLOD_ERROR_UPDATE_TOLERANCE:
+	group->setErrorUpdateTolerance(param);
+	break;
     default:
       GLOD_SetError(GLOD_UNKNOWN_PROPERTY, "Unknown property", pname);
       return;
@@ -124,11 +132,46 @@ void glodGetGroupParameteriv (GLuint name, GLenum pname, GLint *param) {
 	GLOD_SetError(GLOD_INVALID_NAME, "Group does not exist");
 	return;
     }
-//    switch(pname) {
-//    default:
+    switch(pname) {
+    case GLOD_NUM_CHANGED_PATCHES:
+	*param = group->getNumChangedPatches();
+	break;
+    case GLOD_CHANGED_PATCHES:
+	if (group->getNumChangedPatches() > 0)
+	    memcpy(param, group->getChangedPatches(),
+		   sizeof(GLint) * 3 * group->getNumChangedPatches());
+	break;
+    case GLOD_ADAPT_TIME:
+	*param = group->getStats().microseconds;
+	break;
+    case GLOD_ADAPT_ITERATIONS:
+	*param = group->getStats().iterations;
+	break;
+    case GLOD_ADAPT_COARSEN_OPS:
+	*param = group->getStats().coarsenOps;
+	break;
+    case GLOD_ADAPT_REFINE_OPS:
+	*param = group->getStats().refineOps;
+	break;
+    case GLOD_ADAPT_HEAP_OPS:
+	*param = group->getStats().heapOps;
+	break;
+    case GLOD_ADAPT_ERROR_EVALS:
+	*param = group->getStats().errorEvals;
+	break;
+    case GLOD_ADAPT_OBJECTS_TOUCHED:
+	*param = group->getStats().objectsTouched;
+	break;
+    case GLOD_ADAPT_TRIS_BEFORE:
+	*param = group->getStats().trisBefore;
+	break;
+    case GLOD_ADAPT_TRIS_AFTER:
+	*param = group->getStats().trisAfter;
+	break;
+    default:
       GLOD_SetError(GLOD_UNKNOWN_PROPERTY, "Unknown property", pname);
-//      return;
-//    }
+      return;
+    }
 }
 
 /* glodGroupParameterfv
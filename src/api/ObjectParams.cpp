@@ -26,6 +26,8 @@
 
 #include <xbs.h>
 
+extern GLint* GetLevelRanges(GLOD_Object* obj);
+
 /***************************************************************************/
 
 void glodObjectParameteri (GLuint name, GLenum pname, GLint param) {
@@ -93,6 +95,23 @@ void glodObjectParameteri (GLuint name, GLenum pname, GLint param) {
             }
             break;
         }
+        case GLOD_BUILD_NODE_LAYOUT:
+        {
+            switch(param)
+            {
+                case GLOD_LAYOUT_DEPTH_FIRST:
+                case GLOD_LAYOUT_BREADTH_FIRST_BLOCKED:
+                case GLOD_LAYOUT_VAN_EMDE_BOAS:
+                    obj->nodeLayout = param;
+                    break;
+                default:
+                    GLOD_SetError(GLOD_UNSUPPORTED_PROPERTY,
+                                  "Unsupported node layout.", param);
+                    return;
+                    break;
+            }
+            break;
+        }
         case GLOD_BUILD_ERROR_METRIC:
         {
             switch(param)
@@ -373,16 +392,16 @@ void glodGetObjectParameteriv (GLuint name, GLenum pname, GLint *param) {
         case GLOD_PATCH_NAMES: 
         {
             unsigned int k; ptrdiff_t d;
-            HASHTABLE_WALK(obj->patch_id_map, node); //hashtable  --> patch name to 0-based-patch-index
+            HASHTABLE_WALK(obj->shared->patch_id_map, node); //hashtable  --> patch name to 0-based-patch-index
             k = node->key - 1; 
 			d = node->data.uData.nValue - 1;
             param[d] = k;
-            HASHTABLE_WALK_END(obj->patch_id_map);
+            HASHTABLE_WALK_END(obj->shared->patch_id_map);
         }
         break;
         case GLOD_READBACK_SIZE:
         {
-            int more = 4 + 8 + 8 * HashtableNumElements(obj->patch_id_map);
+            int more = 4 + 8 + 8 * HashtableNumElements(obj->shared->patch_id_map);
             *param = obj->hierarchy->getReadbackSize() + more;
         }
         return;
@@ -395,13 +414,57 @@ void glodGetObjectParameteriv (GLuint name, GLenum pname, GLint *param) {
 
             unsigned int k; ptrdiff_t d;
             GLuint nV, nI;
-            HASHTABLE_WALK(obj->patch_id_map, node); //hashtable  --> patch name to 0-based-patch-index
+            HASHTABLE_WALK(obj->shared->patch_id_map, node); //hashtable  --> patch name to 0-based-patch-index
             k = node->key - 1; 
 			d = node->data.uData.nValue - 1;
             obj->cut->getReadbackSizes(d, &nI, &nV);
             param[(2*d)] = nI;
             param[(2*d)+1] = nV;
-            HASHTABLE_WALK_END(obj->patch_id_map);
+            HASHTABLE_WALK_END(obj->shared->patch_id_map);
+            return;
+        }
+        case GLOD_NUM_LEVELS:
+            if(obj->hierarchy == NULL) {
+                GLOD_SetError(GLOD_INVALID_STATE, "Object has not been built: ", name);
+                return;
+            }
+            *param = obj->hierarchy->getNumLevels();
+            return;
+        case GLOD_BUILD_TIME:
+            if(obj->hierarchy == NULL) {
+                GLOD_SetError(GLOD_INVALID_STATE, "Object has not been built: ", name);
+                return;
+            }
+            *param = obj->buildMicroseconds;
+            return;
+        case GLOD_BUFFER_SIZES:
+        case GLOD_BUFFER_RANGES:
+        case GLOD_PATCH_RANGES:
+        {
+            if(obj->hierarchy == NULL || obj->cut == NULL) {
+                GLOD_SetError(GLOD_INVALID_STATE, "Object has not been built: ", name);
+                return;
+            }
+            GLint* ranges = GetLevelRanges(obj);
+            if(ranges == NULL) {
+                GLOD_SetError(GLOD_UNSUPPORTED_PROPERTY, "This hierarchy has no discrete levels");
+                return;
+            }
+            int npatches = obj->hierarchy->GetPatchCount();
+            if(pname == GLOD_BUFFER_SIZES) {
+                param[0] = obj->shared->buffer_sizes[0];
+                param[1] = obj->shared->buffer_sizes[1];
+            } else if(pname == GLOD_BUFFER_RANGES) {
+                memcpy(param, ranges, sizeof(GLint) * 2 *
+                       obj->hierarchy->getNumLevels() * npatches);
+            } else {
+                // the published level of each patch picks its range
+                for(int p = 0; p < npatches; p++) {
+                    int level = obj->cut->getPatchLevel(p);
+                    param[2*p] = ranges[2*(level*npatches + p)];
+                    param[2*p+1] = ranges[2*(level*npatches + p)+1];
+                }
+            }
             return;
         }
         default:
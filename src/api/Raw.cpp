@@ -29,7 +29,7 @@
 
 /***************************************************************************/
 
-void HandlePatch(GLOD_Object* obj, GLOD_RawPatch* patch, int level, float geometric_error);
+int HandlePatch(GLOD_Object* obj, GLOD_RawPatch* patch, int level, float geometric_error);
 GLOD_RawPatch* ProducePatch(GLenum mode, 
 			GLenum first, GLenum count, 
 			void* indices, GLenum indices_type, glodVBO*); // in RawConvert.c
@@ -60,9 +60,9 @@ void glodInsertArrays( GLuint name, GLuint patchname,
   }
 
   // convert the any-named patch to a 0...N number
-  if(!HashtableKeyExists(obj->patch_id_map, patchname+1)) { // does this patch already exist
-      p->name = HashtableNumElements(obj->patch_id_map);
-      HashtableAddInt(obj->patch_id_map, patchname+1, p->name+1);
+  if(!HashtableKeyExists(obj->shared->patch_id_map, patchname+1)) { // does this patch already exist
+      p->name = HashtableNumElements(obj->shared->patch_id_map);
+      HashtableAddInt(obj->shared->patch_id_map, patchname+1, p->name+1);
   } else {
     if(obj->format != GLOD_DISCRETE_MANUAL) {
       GLOD_SetError(GLOD_INVALID_NAME, "A patch of this name already exists!\n");
@@ -71,8 +71,9 @@ void glodInsertArrays( GLuint name, GLuint patchname,
     }
   }
   
-  // handle this patch
-  HandlePatch(obj, p, level, geometric_error);
+  // handle this patch; if it is refused, its name is free again
+  if(!HandlePatch(obj, p, level, geometric_error))
+    HashtableDeleteCautious(obj->shared->patch_id_map, patchname+1);
 }
 #endif
 
@@ -98,9 +99,9 @@ void glodInsertElements (GLuint name, GLuint patchname,
   }
 
   // convert the any-named patch to a 0...N number
-  if(!HashtableKeyExists(obj->patch_id_map, patchname+1) ) { // does this patch already exist
-      p->name = HashtableNumElements(obj->patch_id_map);
-      HashtableAddInt(obj->patch_id_map, patchname+1, p->name+1);
+  if(!HashtableKeyExists(obj->shared->patch_id_map, patchname+1) ) { // does this patch already exist
+      p->name = HashtableNumElements(obj->shared->patch_id_map);
+      HashtableAddInt(obj->shared->patch_id_map, patchname+1, p->name+1);
   } else {
     if(obj->format != GLOD_DISCRETE_MANUAL) {
       GLOD_SetError(GLOD_INVALID_NAME, "A patch of this name already exists!\n");
@@ -109,8 +110,9 @@ void glodInsertElements (GLuint name, GLuint patchname,
     }
   }
   
-  // handle this patch
-  HandlePatch(obj, p, level, geometric_error);
+  // handle this patch; if it is refused, its name is free again
+  if(!HandlePatch(obj, p, level, geometric_error))
+    HashtableDeleteCautious(obj->shared->patch_id_map, patchname+1);
 }
 
 /***************************************************************************
@@ -135,7 +137,7 @@ GLOD_APIENTRY void glodFillArrays( GLuint name, GLuint patch_name, glodVBO *pVBO
   }
   
   // look up the real patch name
-  patch_id = HashtableSearchInt(obj->patch_id_map, patch_name+1); // lameness
+  patch_id = HashtableSearchInt(obj->shared->patch_id_map, patch_name+1); // lameness
   if(patch_id == 0) {
     // this patch isn't there
     GLOD_SetError(GLOD_INVALID_PATCH, "Patch of the specified doesn't exist.", patch_name);
@@ -165,7 +167,7 @@ GLOD_APIENTRY void glodFillElements( GLuint name, GLuint patch_name, GLenum type
   }
 
   // look up the real patch name
-  patch_id = HashtableSearchInt(obj->patch_id_map, patch_name+1); // lameness
+  patch_id = HashtableSearchInt(obj->shared->patch_id_map, patch_name+1); // lameness
   if(patch_id == 0) {
     // this patch isn't there
     GLOD_SetError(GLOD_INVALID_PATCH, "Patch of the specified doesn't exist.", patch_name);
@@ -180,6 +182,25 @@ GLOD_APIENTRY void glodFillElements( GLuint name, GLuint patch_name, GLenum type
 
 }
 
+extern int ProduceBuffers(GLOD_Object* obj, void* indices, GLenum indices_type,
+                          glodVBO *pVBO);
+
+GLOD_APIENTRY void glodFillObjectBuffers( GLuint name, GLenum type, GLvoid* out_elements, glodVBO *pVBO ) {
+  GLOD_Object* obj = (GLOD_Object*) HashtableSearchPtr(s_APIState.object_hash, name);
+  
+  if(obj == NULL) {
+    GLOD_SetError(GLOD_INVALID_NAME, "Object does not exist", name);
+    return;
+  }
+  
+  if(obj->hierarchy == NULL) {
+    GLOD_SetError(GLOD_INVALID_STATE, "This object has not been built!", name);
+    return;
+  }
+
+  ProduceBuffers(obj, out_elements, type, pVBO);
+}
+
 /***************************************************************************
  ***************************************************************************/
 GLOD_RawPatch::~GLOD_RawPatch() {
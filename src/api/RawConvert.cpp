@@ -20,6 +20,7 @@
 
 #include "glod_core.h"
 #include "Hierarchy.h"
+#include "AttribSetArray.h"
 #include "hash.h"
 
 #include <memory.h>
@@ -73,6 +74,116 @@ int GetStrideSize(int numElements, int type);
 
 int PredictSizes(VaState* va, GLuint mode, int count, GLvoid* indices, int *num_triangles, int *num_vertices, int *num_elems);
 
+/***** FAST INGEST ---> float arrays with byte/short/int indices, in one pass ******/
+// The layout nearly every caller hands us: float vertices, normals,
+// colors and texcoords, indexed by unsigned integers or not at all.
+static bool IsFastIngest(VaState* vas, GLenum mode) {
+  if(mode != GL_TRIANGLES || vas->va_type != GL_FLOAT)
+    return false;
+  if(vas->na && vas->na_type != GL_FLOAT)
+    return false;
+  if(vas->ta && vas->ta_type != GL_FLOAT)
+    return false;
+  if(vas->ca && (vas->ca_type != GL_FLOAT || vas->ca_size != 3))
+    return false;
+  if(vas->ia && vas->ia_type != GL_UNSIGNED_BYTE &&
+     vas->ia_type != GL_UNSIGNED_SHORT && vas->ia_type != GL_UNSIGNED_INT)
+    return false;
+  return true;
+}
+
+// Copies n floats per vertex for count vertices starting at vertex first;
+// a tightly packed source goes over in one block.
+static void IngestFloats(float* dst, void* src, int stride, int n,
+                         int first, int count) {
+  char* s = (char*)src + first * stride;
+  if(stride == (int)(n * sizeof(GLfloat))) {
+    memcpy(dst, s, count * n * sizeof(GLfloat));
+    return;
+  }
+  for(int i = 0; i < count; i++)
+    memcpy(dst + i * n, s + i * stride, n * sizeof(GLfloat));
+}
+
+static inline void IngestVertex(VaState* vas, VaPack* vap, size_t src, int dst) {
+  memcpy(vap->va + 3*dst, (char*)vas->va + src * vas->va_stride, 3 * sizeof(GLfloat));
+  if(vap->na)
+    memcpy(vap->na + 3*dst, (char*)vas->na + src * vas->na_stride, 3 * sizeof(GLfloat));
+  if(vap->ta)
+    memcpy(vap->ta + 2*dst, (char*)vas->ta + src * vas->ta_stride, 2 * sizeof(GLfloat));
+  if(vap->ca)
+    memcpy(vap->ca + 3*dst, (char*)vas->ca + src * vas->ca_stride, 3 * sizeof(GLfloat));
+}
+
+// Largest number of flat map slots IngestIndexed spends per index; indices
+// spread wider than this go through the hashtable instead.
+#define MAX_MAP_SLOTS_PER_INDEX 8
+
+// Renumbers the referenced vertices in order of first use, copying each
+// one over as it is first seen. A flat map sized by the largest index
+// replaces the hashtable of the generic path, unless the indices are so
+// sparse that the map would dwarf the input. Returns the number of unique
+// vertices.
+template <class I>
+static int IngestIndexed(VaState* vas, VaPack* vap, int nindices) {
+  const I* ia = (const I*)vas->ia + vas->first;
+  unsigned int max_index = 0;
+  int nverts = 0;
+
+  for(int i = 0; i < nindices; i++)
+    if(ia[i] > max_index)
+      max_index = ia[i];
+
+  if(sizeof(I) < sizeof(GLuint) ||
+     max_index / MAX_MAP_SLOTS_PER_INDEX < (unsigned int)nindices) {
+    size_t map_size = (size_t)max_index + 1;
+    int* global_to_local = (int*) malloc(sizeof(int) * map_size);
+    memset(global_to_local, 0xff, sizeof(int) * map_size); // all -1
+
+    for(int i = 0; i < nindices; i++) {
+      unsigned int g = ia[i];
+      int local = global_to_local[g];
+      if(local == -1) {
+        local = global_to_local[g] = nverts++;
+        IngestVertex(vas, vap, (size_t)g + vas->first, local);
+      }
+      vap->ia[i] = local;
+    }
+    free(global_to_local);
+    return nverts;
+  }
+
+  // warning: keys and values in the hashtable are +1 of their true ones
+  HashTable* index_hash = AllocHashtable();
+  HashtableReserve(index_hash, nindices);
+  for(int i = 0; i < nindices; i++) {
+    unsigned int g = ia[i];
+    int local = HashtableSearchInt(index_hash, g + 1) - 1;
+    if(local == -1) {
+      local = nverts++;
+      HashtableAddInt(index_hash, g + 1, local + 1);
+      IngestVertex(vas, vap, (size_t)g + vas->first, local);
+    }
+    vap->ia[i] = local;
+  }
+  FreeHashtableCautious(index_hash);
+  return nverts;
+}
+
+// Unindexed triangles use every vertex once, in order.
+static int IngestArrays(VaState* vas, VaPack* vap, int nindices) {
+  IngestFloats(vap->va, vas->va, vas->va_stride, 3, vas->first, nindices);
+  if(vap->na)
+    IngestFloats(vap->na, vas->na, vas->na_stride, 3, vas->first, nindices);
+  if(vap->ta)
+    IngestFloats(vap->ta, vas->ta, vas->ta_stride, 2, vas->first, nindices);
+  if(vap->ca)
+    IngestFloats(vap->ca, vas->ca, vas->ca_stride, 3, vas->first, nindices);
+  for(int i = 0; i < nindices; i++)
+    vap->ia[i] = i;
+  return nindices;
+}
+
 /***** PRODUCE PATCH ---> goes from current VA state to a GLOD_RawPatch ******/
 GLOD_RawPatch* ProducePatch(GLenum mode, 
 			GLenum first, GLenum count, 
@@ -107,9 +218,9 @@ GLOD_RawPatch* ProducePatch(GLenum mode,
   vas.ca_type = pVBO->mC.type;
 
   if( vas.va_stride == 0 ) vas.va_stride = GetStrideSize( vas.va_size, vas.va_type );
-  if( vas.na_stride == 0 ) vas.na_stride = GetStrideSize( 3, vas.na_type );;
-  if( vas.ta_stride == 0 ) vas.ta_stride = GetStrideSize( vas.ta_size, vas.ta_type );
-  if( vas.ca_stride == 0 ) vas.ca_stride = GetStrideSize( vas.ca_size, vas.ca_type );
+  if( vas.na && vas.na_stride == 0 ) vas.na_stride = GetStrideSize( 3, vas.na_type );
+  if( vas.ta && vas.ta_stride == 0 ) vas.ta_stride = GetStrideSize( vas.ta_size, vas.ta_type );
+  if( vas.ca && vas.ca_stride == 0 ) vas.ca_stride = GetStrideSize( vas.ca_size, vas.ca_type );
  
   vas.ia = indices;
   vas.ia_type = indices_type;
@@ -179,10 +290,24 @@ GLOD_RawPatch* ProducePatch(GLenum mode,
   vap.ia = p->triangles;
   vap.va = p->vertices; vap.na = p->vertex_normals; vap.ca = p->vertex_colors; vap.ta = p->vertex_texture_coords;
   int i=0; float buf[4]; int ibuf[3]; int j = 0;
+
+  if(IsFastIngest(&vas, mode)) {
+    int nindices = num_triangles * 3;
+    if(vas.ia == NULL)
+      p->num_vertices = IngestArrays(&vas, &vap, nindices);
+    else if(vas.ia_type == GL_UNSIGNED_BYTE)
+      p->num_vertices = IngestIndexed<GLubyte>(&vas, &vap, nindices);
+    else if(vas.ia_type == GL_UNSIGNED_SHORT)
+      p->num_vertices = IngestIndexed<GLushort>(&vas, &vap, nindices);
+    else
+      p->num_vertices = IngestIndexed<GLuint>(&vas, &vap, nindices);
+    return p;
+  }
   
   {
     // what we have to do is figure out whether 
     HashTable* index_hash = AllocHashtable();
+    HashtableReserve(index_hash, num_vertices);
     int cur_idx = 0; int a;
     // warning: keys in hashtable are +1 of their true index
     for(i = 0; i < num_triangles; i++) { // foreach triangle
@@ -232,35 +357,288 @@ GLOD_RawPatch* ProducePatch(GLenum mode,
   return p;
 }
 
-/***** PRODUCE VA ---> goes from a GLOD_Cut to GLOD_RawPatch to the current VA state ******/
-/**** WE ONLY PRODUCE GL_TRIANGLE ARRAYS */
-int ProduceVA(GLOD_Cut* c, int patch, 
-              void* indices, GLenum indices_type, glodVBO *pVBO ) {
-  VaState vas;
+/***** DIRECT FILL ---> from a cut's vertex storage straight into the VA ******/
+// Stores N float components into one element of a user array of type T,
+// scaled into T's range. The float layouts that nearly every caller asks
+// for reduce to a plain copy.
+template <class T, int N>
+struct VaStore {
+  static inline void store(char* dst, const GLfloat* src, float scale) {
+    for(int k = 0; k < N; k++)
+      ((T*)dst)[k] = (T)(src[k] * scale);
+  }
+};
 
-  // GetVAState(&vas);
-  vas.va = pVBO->mV.p;
-  vas.va_size = pVBO->mV.size;
-  vas.va_stride = pVBO->mV.stride;
-  vas.va_type = pVBO->mV.type;
+template <int N>
+struct VaStore<GLfloat, N> {
+  static inline void store(char* dst, const GLfloat* src, float scale) {
+    memcpy(dst, src, N * sizeof(GLfloat));
+  }
+};
+
+// Colors are kept as unsigned bytes, so byte arrays take them as they are
+// and everything else goes through 0..1 first.
+template <class T>
+struct VaStoreColor {
+  static inline void store(char* dst, const GLubyte* src, float scale) {
+    for(int k = 0; k < 3; k++)
+      ((T*)dst)[k] = (T)(src[k] / 255.0f * scale);
+  }
+};
 
-  vas.na = pVBO->mN.p;
-  vas.na_stride = pVBO->mN.stride;
-  vas.na_type = pVBO->mN.type;
+template <>
+struct VaStoreColor<GLfloat> {
+  static inline void store(char* dst, const GLubyte* src, float scale) {
+    for(int k = 0; k < 3; k++)
+      ((GLfloat*)dst)[k] = src[k] / 255.0f;
+  }
+};
 
-  vas.ta = pVBO->mT.p;
-  vas.ta_size = pVBO->mT.size;
-  vas.ta_stride = pVBO->mT.stride;
-  vas.ta_type = pVBO->mT.type;
+template <>
+struct VaStoreColor<GLubyte> {
+  static inline void store(char* dst, const GLubyte* src, float scale) {
+    memcpy(dst, src, 3);
+  }
+};
+
+// Copies one attribute of count vertices. order gives the source vertex of
+// each output vertex; NULL means they line up one to one.
+template <class Store, class Src>
+static void FillAttrib(char* dst, int dst_stride,
+                       const unsigned char* src, int src_stride,
+                       const unsigned int* order, int count, float scale) {
+  int i;
+  if(order == NULL) {
+    for(i = 0; i < count; i++)
+      Store::store(dst + i * dst_stride,
+                   (const Src*)(src + i * src_stride), scale);
+  } else {
+    for(i = 0; i < count; i++)
+      Store::store(dst + i * dst_stride,
+                   (const Src*)(src + order[i] * src_stride), scale);
+  }
+}
 
-  vas.ca = pVBO->mC.p;
-  vas.ca_size = pVBO->mC.size;
-  vas.ca_stride = pVBO->mC.stride;
-  vas.ca_type = pVBO->mC.type;
+template <int N>
+static void FillFloatAttrib(GLenum type, char* dst, int dst_stride,
+                            const unsigned char* src, int src_stride,
+                            const unsigned int* order, int count, float scale) {
+#define FILL(T) FillAttrib<VaStore<T, N>, GLfloat>(dst, dst_stride, src, src_stride, order, count, scale)
+  switch(type) {
+  case GL_BYTE:           FILL(GLbyte);   break;
+  case GL_UNSIGNED_BYTE:  FILL(GLubyte);  break;
+  case GL_SHORT:          FILL(GLshort);  break;
+  case GL_UNSIGNED_SHORT: FILL(GLushort); break;
+  case GL_INT:            FILL(GLint);    break;
+  case GL_UNSIGNED_INT:   FILL(GLuint);   break;
+  case GL_FLOAT:          FILL(GLfloat);  break;
+  case GL_DOUBLE:         FILL(GLdouble); break;
+  default:
+    assert(false);
+  }
+#undef FILL
+}
 
-  vas.ia = indices;
-  vas.ia_type = indices_type;
-  vas.first = 0;
+static void FillColorAttrib(GLenum type, char* dst, int dst_stride,
+                            const unsigned char* src, int src_stride,
+                            const unsigned int* order, int count, float scale) {
+#define FILL(T) FillAttrib<VaStoreColor<T>, GLubyte>(dst, dst_stride, src, src_stride, order, count, scale)
+  switch(type) {
+  case GL_BYTE:           FILL(GLbyte);   break;
+  case GL_UNSIGNED_BYTE:  FILL(GLubyte);  break;
+  case GL_SHORT:          FILL(GLshort);  break;
+  case GL_UNSIGNED_SHORT: FILL(GLushort); break;
+  case GL_INT:            FILL(GLint);    break;
+  case GL_UNSIGNED_INT:   FILL(GLuint);   break;
+  case GL_FLOAT:          FILL(GLfloat);  break;
+  case GL_DOUBLE:         FILL(GLdouble); break;
+  default:
+    assert(false);
+  }
+#undef FILL
+}
+
+// Index output, for the compact case where GLOD's indices go out as is,
+// moved up by bias when the vertices land further into the array...
+template <class T>
+static void FillIndices(void* vdst, const unsigned int* src, int count,
+                        unsigned int bias) {
+  T* dst = (T*)vdst;
+  for(int i = 0; i < count; i++)
+    dst[i] = (T)(src[i] + bias);
+}
+
+template <>
+void FillIndices<GLuint>(void* vdst, const unsigned int* src, int count,
+                         unsigned int bias) {
+  if(bias == 0) {
+    memcpy(vdst, src, count * sizeof(GLuint));
+    return;
+  }
+  GLuint* dst = (GLuint*)vdst;
+  for(int i = 0; i < count; i++)
+    dst[i] = src[i] + bias;
+}
+
+static void FillIndices(GLenum type, void* dst, const unsigned int* src,
+                        int count, unsigned int bias) {
+  switch(type) {
+  case GL_UNSIGNED_BYTE:
+    FillIndices<GLubyte>(dst, src, count, bias); break;
+  case GL_UNSIGNED_SHORT:
+    FillIndices<GLushort>(dst, src, count, bias); break;
+  case GL_UNSIGNED_INT:
+    FillIndices<GLuint>(dst, src, count, bias); break;
+  default:
+    assert(false);
+  }
+}
+
+// ... and for half-edge levels, whose vertices are numbered in order of
+// first use. Returns the number of vertices; order receives their sources.
+template <class T>
+static int CompactIndices(void* vdst, const unsigned int* src, int count,
+                          int* global_to_local, unsigned int* order) {
+  T* dst = (T*)vdst;
+  int nverts = 0;
+  for(int i = 0; i < count; i++) {
+    unsigned int g = src[i];
+    if(global_to_local[g] == -1) {
+      global_to_local[g] = nverts;
+      order[nverts++] = g;
+    }
+    dst[i] = (T)global_to_local[g];
+  }
+  return nverts;
+}
+
+static bool IsDirectLayout(AttribSetArray* verts, int attr, int type, int count) {
+  return verts->getAttribType(attr) == type &&
+    verts->getAttribCount(attr) == count;
+}
+
+// True if verts has the layout that AttribSetArray::create builds, which is
+// the only one the direct path knows, for every attribute vas asks for.
+static bool CanWriteDirect(VaState* vas, AttribSetArray* verts) {
+  return IsDirectLayout(verts, AS_POSITION, GL_FLOAT, 3) &&
+    (!vas->na || !verts->hasAttrib(AS_NORMAL) ||
+     IsDirectLayout(verts, AS_NORMAL, GL_FLOAT, 3)) &&
+    (!vas->ca || !verts->hasAttrib(AS_COLOR) ||
+     IsDirectLayout(verts, AS_COLOR, GL_UNSIGNED_BYTE, 3)) &&
+    (!vas->ta || !verts->hasAttrib(AS_TEXTURE0) ||
+     IsDirectLayout(verts, AS_TEXTURE0, GL_FLOAT, 2));
+}
+
+static bool IsDirectIndexType(GLenum type) {
+  return type == GL_UNSIGNED_BYTE || type == GL_UNSIGNED_SHORT ||
+    type == GL_UNSIGNED_INT;
+}
+
+// Writes count vertices of verts into the user's arrays, starting at array
+// element dst_first. order is as for FillAttrib.
+static void WriteVerts(VaState* vas, AttribSetArray* verts, int dst_first,
+                       const unsigned int* order, int count) {
+  unsigned char* base = verts->getData();
+  int vsize = verts->getVertexSize();
+
+  FillFloatAttrib<3>(vas->va_type, (char*)vas->va + dst_first * vas->va_stride,
+                     vas->va_stride,
+                     base + verts->getAttribOffset(AS_POSITION), vsize,
+                     order, count, 1.0f);
+  if(vas->na && verts->hasAttrib(AS_NORMAL))
+    FillFloatAttrib<3>(vas->na_type, (char*)vas->na + dst_first * vas->na_stride,
+                       vas->na_stride,
+                       base + verts->getAttribOffset(AS_NORMAL), vsize,
+                       order, count, fixSetType(1.0f, vas->na_type));
+  if(vas->ta && verts->hasAttrib(AS_TEXTURE0))
+    FillFloatAttrib<2>(vas->ta_type, (char*)vas->ta + dst_first * vas->ta_stride,
+                       vas->ta_stride,
+                       base + verts->getAttribOffset(AS_TEXTURE0), vsize,
+                       order, count, fixSetType(1.0f, vas->ta_type));
+  if(vas->ca && verts->hasAttrib(AS_COLOR))
+    FillColorAttrib(vas->ca_type, (char*)vas->ca + dst_first * vas->ca_stride,
+                    vas->ca_stride,
+                    base + verts->getAttribOffset(AS_COLOR), vsize,
+                    order, count, fixSetType(1.0f, vas->ca_type));
+}
+
+// Writes the patch straight into the caller's arrays in one pass. Returns 0,
+// having written nothing, if the patch or the request has a layout that only
+// the generic path handles.
+static int DirectVA(VaState* vas, GLOD_CutPatchData* d) {
+  AttribSetArray* verts = d->verts;
+
+  if(!CanWriteDirect(vas, verts))
+    return 0;
+  if(vas->ia && !IsDirectIndexType(vas->ia_type))
+    return 0;
+
+  const unsigned int* order;
+  unsigned int* local_order = NULL;
+  int count;
+
+  if(vas->ia == NULL) {
+    // unindexed: one output vertex per index
+    order = d->indices;
+    count = d->numIndices;
+  } else if(d->compact) {
+    order = NULL;
+    count = verts->getSize();
+    FillIndices(vas->ia_type, vas->ia, d->indices, d->numIndices, 0);
+  } else {
+    int nglobal = verts->getSize();
+    int* global_to_local = new int[nglobal];
+    for(int i = 0; i < nglobal; i++)
+      global_to_local[i] = -1;
+    local_order = new unsigned int[d->numIndices < (unsigned)nglobal ?
+                                   d->numIndices : nglobal];
+    switch(vas->ia_type) {
+    case GL_UNSIGNED_BYTE:
+      count = CompactIndices<GLubyte>(vas->ia, d->indices, d->numIndices,
+                                      global_to_local, local_order); break;
+    case GL_UNSIGNED_SHORT:
+      count = CompactIndices<GLushort>(vas->ia, d->indices, d->numIndices,
+                                       global_to_local, local_order); break;
+    default:
+      count = CompactIndices<GLuint>(vas->ia, d->indices, d->numIndices,
+                                     global_to_local, local_order); break;
+    }
+    delete [] global_to_local;
+    order = local_order;
+  }
+
+  WriteVerts(vas, verts, 0, order, count);
+
+  if(local_order != NULL)
+    delete [] local_order;
+  return 1;
+}
+
+// Reads the user's array description into vas, checking that it is
+// something we can write to and filling in zero strides.
+static int SetupVA(VaState* vas, void* indices, GLenum indices_type, glodVBO *pVBO) {
+  vas->va = pVBO->mV.p;
+  vas->va_size = pVBO->mV.size;
+  vas->va_stride = pVBO->mV.stride;
+  vas->va_type = pVBO->mV.type;
+
+  vas->na = pVBO->mN.p;
+  vas->na_stride = pVBO->mN.stride;
+  vas->na_type = pVBO->mN.type;
+
+  vas->ta = pVBO->mT.p;
+  vas->ta_size = pVBO->mT.size;
+  vas->ta_stride = pVBO->mT.stride;
+  vas->ta_type = pVBO->mT.type;
+
+  vas->ca = pVBO->mC.p;
+  vas->ca_size = pVBO->mC.size;
+  vas->ca_stride = pVBO->mC.stride;
+  vas->ca_type = pVBO->mC.type;
+
+  vas->ia = indices;
+  vas->ia_type = indices_type;
+  vas->first = 0;
   
   // verify the state of these vertex arrays...
   // we can only read at the moment:
@@ -268,24 +646,46 @@ int ProduceVA(GLOD_Cut* c, int patch,
   //    2d texture coords
   //    normals
   //    vertices
-  if(vas.va == NULL) {
+  if(vas->va == NULL) {
     GLOD_SetError(GLOD_INVALID_DATA_FORMAT, "glGetPointerv(vp) == NULL. Cannot continue!");
     return 0;
   }
-  if(vas.va_size != 3) {
+  if(vas->va_size != 3) {
     GLOD_SetError(GLOD_INVALID_DATA_FORMAT, "Not a 3-coord vertex array!");
     return 0;
   }
   
-  if(vas.ca && vas.ca_size == 4) {
+  if(vas->ca && vas->ca_size == 4) {
     GLOD_SetError(GLOD_INVALID_DATA_FORMAT, "Only tri-color RGB is supported.");
     return 0;
   }
 
-  if(vas.ta && vas.ta_size != 2) {
+  if(vas->ta && vas->ta_size != 2) {
     GLOD_SetError(GLOD_INVALID_DATA_FORMAT, "Only 2-D texcoords are supported.");
     return 0;
   }
+
+  // tightly packed arrays may come in with a zero stride
+  if(vas->va_stride == 0) vas->va_stride = GetStrideSize(vas->va_size, vas->va_type);
+  if(vas->na && vas->na_stride == 0) vas->na_stride = GetStrideSize(3, vas->na_type);
+  if(vas->ta && vas->ta_stride == 0) vas->ta_stride = GetStrideSize(vas->ta_size, vas->ta_type);
+  if(vas->ca && vas->ca_stride == 0) vas->ca_stride = GetStrideSize(vas->ca_size, vas->ca_type);
+  return 1;
+}
+
+/***** PRODUCE VA ---> goes from a GLOD_Cut to GLOD_RawPatch to the current VA state ******/
+/**** WE ONLY PRODUCE GL_TRIANGLE ARRAYS */
+int ProduceVA(GLOD_Cut* c, int patch, 
+              void* indices, GLenum indices_type, glodVBO *pVBO ) {
+  VaState vas;
+  if(!SetupVA(&vas, indices, indices_type, pVBO))
+    return 0;
+
+  // cuts that expose their vertex storage are written straight into the
+  // user's arrays, skipping the temporary RawPatch below
+  GLOD_CutPatchData data;
+  if(c->getPatchData(patch, &data) && DirectVA(&vas, &data))
+    return 1;
   
   // what are the maximum sizes for the readback?
   GLuint cut_nindices, cut_nverts;
@@ -359,6 +759,139 @@ int ProduceVA(GLOD_Cut* c, int patch,
   return 1;
 }
 
+/***** PRODUCE BUFFERS ---> every level of a hierarchy as one vertex and one index array ******/
+
+// Lays the levels of h out back to back. ranges gets an (index offset,
+// index count) pair for each level and patch, level major; bases gets the
+// first vertex of each such pair's vertices. Levels of a patch that share
+// their vertex storage share their vertices here too. Returns the number
+// of vertices; *nindices gets the number of indices.
+static int LayoutBuffers(Hierarchy* h, GLint* ranges, GLint* bases,
+                         int* nindices) {
+  int nlevels = h->getNumLevels();
+  int npatches = h->GetPatchCount();
+  AttribSetArray** last_verts = new AttribSetArray*[npatches];
+  int* last_base = new int[npatches];
+  int nverts = 0;
+  *nindices = 0;
+
+  for(int p = 0; p < npatches; p++)
+    last_verts[p] = NULL;
+
+  for(int l = 0; l < nlevels; l++) {
+    for(int p = 0; p < npatches; p++) {
+      int i = l * npatches + p;
+      GLOD_CutPatchData data;
+      ranges[2*i] = *nindices;
+      ranges[2*i+1] = 0;
+      bases[i] = 0;
+      if(!h->getLevelPatchData(l, p, &data))
+        continue;
+      if(data.verts != last_verts[p]) {
+        last_verts[p] = data.verts;
+        last_base[p] = nverts;
+        nverts += data.verts->getSize();
+      }
+      ranges[2*i+1] = data.numIndices;
+      bases[i] = last_base[p];
+      *nindices += data.numIndices;
+    }
+  }
+
+  delete [] last_verts;
+  delete [] last_base;
+  return nverts;
+}
+
+// The (offset, count) table for obj's hierarchy, built on first use and
+// kept with the patch mappings along with the vertex bases that go with
+// it. NULL if the hierarchy has no levels.
+GLint* GetLevelRanges(GLOD_Object* obj) {
+  GLOD_ObjectShared* shared = obj->shared;
+  if(shared->level_ranges == NULL) {
+    Hierarchy* h = obj->hierarchy;
+    int n = h->getNumLevels() * h->GetPatchCount();
+    if(n == 0)
+      return NULL;
+    int nindices;
+    shared->level_ranges = new GLint[2 * n];
+    shared->level_bases = new GLint[n];
+    shared->buffer_sizes[1] = LayoutBuffers(h, shared->level_ranges,
+                                            shared->level_bases, &nindices);
+    shared->buffer_sizes[0] = nindices;
+  }
+  return shared->level_ranges;
+}
+
+static int IndexSize(GLenum type) {
+  switch(type) {
+  case GL_UNSIGNED_BYTE:  return sizeof(GLubyte);
+  case GL_UNSIGNED_SHORT: return sizeof(GLushort);
+  default:                return sizeof(GLuint);
+  }
+}
+
+int ProduceBuffers(GLOD_Object* obj, void* indices, GLenum indices_type,
+                   glodVBO *pVBO) {
+  Hierarchy* h = obj->hierarchy;
+  VaState vas;
+  if(!SetupVA(&vas, indices, indices_type, pVBO))
+    return 0;
+
+  if(indices == NULL) {
+    GLOD_SetError(GLOD_INVALID_PARAM, "An index array is required");
+    return 0;
+  }
+  if(!IsDirectIndexType(indices_type)) {
+    GLOD_SetError(GLOD_INVALID_PARAM, "Unsupported index type", indices_type);
+    return 0;
+  }
+
+  GLint* ranges = GetLevelRanges(obj);
+  if(ranges == NULL) {
+    GLOD_SetError(GLOD_UNSUPPORTED_PROPERTY, "This hierarchy has no discrete levels");
+    return 0;
+  }
+  if((indices_type == GL_UNSIGNED_BYTE && obj->shared->buffer_sizes[1] > 0x100) ||
+     (indices_type == GL_UNSIGNED_SHORT && obj->shared->buffer_sizes[1] > 0x10000)) {
+    GLOD_SetError(GLOD_INVALID_PARAM, "Too many vertices for the index type",
+                  obj->shared->buffer_sizes[1]);
+    return 0;
+  }
+
+  int npatches = h->GetPatchCount();
+  int n = h->getNumLevels() * npatches;
+  GLint* bases = obj->shared->level_bases;
+
+  // vertices go out once for each block, the indices once per level
+  AttribSetArray** last_verts = new AttribSetArray*[npatches];
+  for(int p = 0; p < npatches; p++)
+    last_verts[p] = NULL;
+
+  int isize = IndexSize(indices_type);
+  int ok = 1;
+  for(int i = 0; i < n; i++) {
+    GLOD_CutPatchData data;
+    int p = i % npatches;
+    if(!h->getLevelPatchData(i / npatches, p, &data))
+      continue;
+    if(!CanWriteDirect(&vas, data.verts)) {
+      GLOD_SetError(GLOD_INVALID_DATA_FORMAT, "Unsupported vertex layout");
+      ok = 0;
+      break;
+    }
+    if(data.verts != last_verts[p]) {
+      last_verts[p] = data.verts;
+      WriteVerts(&vas, data.verts, bases[i], NULL, data.verts->getSize());
+    }
+    FillIndices(indices_type, (char*)indices + ranges[2*i] * isize,
+                data.indices, data.numIndices, bases[i]);
+  }
+
+  delete [] last_verts;
+  return ok;
+}
+
 
 // to get a tri in a array format, verts should be
 //  {tri*3, tri*3+1, tri*3+2}
@@ -414,9 +947,10 @@ void GetTriangle(VaState* vas, int mode, int tri, int* dst) {
       dst[1] = GetIntAtOffset((char*)vas->ia, vas->first+tri*3+1, vas->ia_type);
       dst[2] = GetIntAtOffset((char*)vas->ia, vas->first+tri*3+2, vas->ia_type);
     } else {
-      dst[0] = vas->first + tri*3;
-      dst[1] = vas->first + tri*3+1;
-      dst[2] = vas->first + tri*3+2;
+      // GetV adds first to these
+      dst[0] = tri*3;
+      dst[1] = tri*3+1;
+      dst[2] = tri*3+2;
     }
     return;
 	
@@ -429,8 +963,8 @@ void GetTriangle(VaState* vas, int mode, int tri, int* dst) {
 int SetV(VaState* vas, int mode, float* src, int vert) {
   vert += vas->first;
   SetValAtOffsetf((char*)vas->va + vert*vas->va_stride, 0, vas->va_type, src[0]);
-  SetValAtOffsetf((char*)vas->va + 4 + vert*vas->va_stride, 1, vas->va_type, src[1]);
-  SetValAtOffsetf((char*)vas->va + 8 + vert*vas->va_stride, 2, vas->va_type, src[2]);
+  SetValAtOffsetf((char*)vas->va + GetStrideSize(1, vas->va_type) + vert*vas->va_stride, 1, vas->va_type, src[1]);
+  SetValAtOffsetf((char*)vas->va + GetStrideSize(2, vas->va_type) + vert*vas->va_stride, 2, vas->va_type, src[2]);
   return 3;
 }
 
@@ -438,12 +972,14 @@ int SetV(VaState* vas, int mode, float* src, int vert) {
 
 int SetN(VaState* vas, int mode, float* src, int vert) {
   vert += vas->first;
-    src[0] = fixSetType(src[0], vas->na_type);
-    src[1] = fixSetType(src[1], vas->na_type);
-    src[2] = fixSetType(src[2], vas->na_type);
-  SetValAtOffsetf((char*)vas->na + vert*vas->na_stride, 0, vas->na_type, src[0]);
-  SetValAtOffsetf((char*)vas->na + 4 + vert*vas->na_stride, 1, vas->na_type, src[1]);
-  SetValAtOffsetf((char*)vas->na + 8 + vert*vas->na_stride, 2, vas->na_type, src[2]);
+  // scale a copy; src is shared by every output vertex that uses it
+  float n[3];
+    n[0] = fixSetType(src[0], vas->na_type);
+    n[1] = fixSetType(src[1], vas->na_type);
+    n[2] = fixSetType(src[2], vas->na_type);
+  SetValAtOffsetf((char*)vas->na + vert*vas->na_stride, 0, vas->na_type, n[0]);
+  SetValAtOffsetf((char*)vas->na + GetStrideSize(1, vas->na_type) + vert*vas->na_stride, 1, vas->na_type, n[1]);
+  SetValAtOffsetf((char*)vas->na + GetStrideSize(2, vas->na_type) + vert*vas->na_stride, 2, vas->na_type, n[2]);
   return 3;
 }
 
@@ -451,21 +987,23 @@ int SetN(VaState* vas, int mode, float* src, int vert) {
 
 int SetT(VaState* vas, int mode, float* src, int vert) {
   vert += vas->first;
-    src[0] = fixSetType(src[0], vas->ta_type);
-    src[1] = fixSetType(src[1], vas->ta_type);
-  SetValAtOffsetf((char*)vas->ta + vert*vas->ta_stride, 0, vas->ta_type, src[0]);
-  SetValAtOffsetf((char*)vas->ta + 4 + vert*vas->ta_stride, 1, vas->ta_type, src[1]);
+  float t[2];
+    t[0] = fixSetType(src[0], vas->ta_type);
+    t[1] = fixSetType(src[1], vas->ta_type);
+  SetValAtOffsetf((char*)vas->ta + vert*vas->ta_stride, 0, vas->ta_type, t[0]);
+  SetValAtOffsetf((char*)vas->ta + GetStrideSize(1, vas->ta_type) + vert*vas->ta_stride, 1, vas->ta_type, t[1]);
   return 2;
 }
 
 int SetC(VaState* vas, int mode, float* src, int vert) {
   vert += vas->first;
-    src[0] = fixSetType(src[0], vas->ca_type);
-    src[1] = fixSetType(src[1], vas->ca_type);
-    src[2] = fixSetType(src[2], vas->ca_type);
-    SetValAtOffsetf((char*)vas->ca + vert*vas->ca_stride, 0, vas->ca_type, src[0]);
-    SetValAtOffsetf((char*)vas->ca + 4 + vert*vas->ca_stride, 1, vas->ca_type, src[1]);
-    SetValAtOffsetf((char*)vas->ca + 8 + vert*vas->ca_stride, 2, vas->ca_type, src[2]);
+  float c[3];
+    c[0] = fixSetType(src[0], vas->ca_type);
+    c[1] = fixSetType(src[1], vas->ca_type);
+    c[2] = fixSetType(src[2], vas->ca_type);
+    SetValAtOffsetf((char*)vas->ca + vert*vas->ca_stride, 0, vas->ca_type, c[0]);
+    SetValAtOffsetf((char*)vas->ca + GetStrideSize(1, vas->ca_type) + vert*vas->ca_stride, 1, vas->ca_type, c[1]);
+    SetValAtOffsetf((char*)vas->ca + GetStrideSize(2, vas->ca_type) + vert*vas->ca_stride, 2, vas->ca_type, c[2]);
   return 3;
 }
 
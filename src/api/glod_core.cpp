@@ -18,6 +18,11 @@
 #include <stdio.h>
 #include <memory.h>
 #include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
 
 #include "glod_core.h"
 #include "glod_glext.h"
@@ -33,6 +38,23 @@ VDS::Manager s_VDSMemoryManager;
 
 /*****************************************************************************/
 
+// wall clock for adapt and build stats
+double GLOD_GetMicroseconds()
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart * 1000000.0 / (double)freq.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+#endif
+}
+
+/*****************************************************************************/
+
 /* glodInit
  ***************************************************************************/
 GLOD_APIENTRY GLuint glodInit() {
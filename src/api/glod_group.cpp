@@ -28,7 +28,6 @@
 #else
 #include <values.h>
 #endif
-
 #include "xbs.h"
 #include "glod_core.h"
 #include "hash.h"
@@ -50,7 +49,6 @@
 
 /*---------------------------------Functions-------------------------------- */
 
-
 //
 //
 //     API ENTRIES
@@ -150,10 +148,12 @@ void glodDeleteGroup(GLuint name)
 	return;
     }
 
-    // iterate through group objects... delete each object
-    for(i = 0; i < group->getNumObjects(); i++)
+    // iterate through group objects... delete each object. Deleting an
+    // object pulls it out of the group (moving the last one into its
+    // slot), so always take them from the back.
+    while((i = group->getNumObjects()) > 0)
     {
-	obj = group->getObject(i);
+	obj = group->getObject(i-1);
         
         glodDeleteObject(obj->name);
     }
@@ -182,6 +182,18 @@ void glodAdaptGroup(GLuint name) {
 } /* End of glodAdaptGroup() **/
 
 
+void glodCommitGroup(GLuint name) {
+    GLOD_Group *group =
+	(GLOD_Group *)HashtableSearchPtr(s_APIState.group_hash, name);
+    
+    if(group == NULL) {
+	GLOD_SetError(GLOD_INVALID_NAME, "Group does not exist", name);
+	return;
+    }
+    group->commit();
+} /* End of glodCommitGroup() **/
+
+
 
 
 
@@ -204,22 +216,7 @@ void glodAdaptGroup(GLuint name) {
 void GLOD_Group::addObject(GLOD_Object *obj)
 {
     if (numObjects == maxObjects)
-    {
-	if (maxObjects == 0)
-	{
-	    objects = new (GLOD_Object*)();
-	    maxObjects = 1;
-	}
-	else
-	{
-	    GLOD_Object **newObjects = new GLOD_Object *[maxObjects*2];
-	    for (int i=0; i<numObjects; i++)
-		newObjects[i] = objects[i];
-	    delete [] objects;
-	    objects = newObjects;
-	    maxObjects *= 2;
-	}
-    }
+	reserveObjects((maxObjects == 0) ? 1 : maxObjects*2);
 
     objects[numObjects++] = obj;
     //printf("adding object %i num %i\n", obj->name, numObjects);
@@ -229,7 +226,6 @@ void GLOD_Group::addObject(GLOD_Object *obj)
 
 	obj->cut->setGroup(this);
 
-#ifdef GLOD_COREPROFILE_FIXED
 	if( obj->format == GLOD_VDS ) {
 
 	switch (errorMode)
@@ -256,7 +252,6 @@ void GLOD_Group::addObject(GLOD_Object *obj)
 	mpSimplifier->AddCut(   ((VDSCut*)obj->cut)->mpCut );
 //	fprintf(stderr, "mpSimplifier->CutAdded\n");
     }	
-#endif
 #ifndef GLOD_USE_TILES
     currentNumTris += obj->cut->currentNumTris;
 #else
@@ -269,6 +264,29 @@ void GLOD_Group::addObject(GLOD_Object *obj)
 
 
 
+/*****************************************************************************\
+ @ GLOD_Group::reserveObjects
+ -----------------------------------------------------------------------------
+ description : Grows the object array to hold at least count objects
+ input       : 
+ output      : 
+ notes       : Lets bulk instancing size the array once up front
+\*****************************************************************************/
+void GLOD_Group::reserveObjects(int count)
+{
+    if (count <= maxObjects)
+	return;
+
+    GLOD_Object **newObjects = new GLOD_Object *[count];
+    for (int i=0; i<numObjects; i++)
+	newObjects[i] = objects[i];
+    delete [] objects;
+    objects = newObjects;
+    maxObjects = count;
+} /* End of GLOD_Group::reserveObjects() **/
+
+
+
 /*****************************************************************************\
  @ GLOD_Group::removeObject
  -----------------------------------------------------------------------------
@@ -440,7 +458,6 @@ GLOD_Group::adaptTriangleBudget()
 	currentNumTris = 0;
     for (int i=0; i<numObjects; i++)
     {
-#ifdef GLOD_COREPROFILE_FIXED
 		if( objects[ i ]->format == GLOD_VDS )
 		{
 			if (VDScutCounted == true)
@@ -450,7 +467,6 @@ GLOD_Group::adaptTriangleBudget()
 			currentNumTris += objects[i]->cut->currentNumTris;
 		}
 		else
-#endif
 		{
 			currentNumTris += objects[i]->cut->currentNumTris;
 		}
@@ -465,9 +481,7 @@ GLOD_Group::adaptTriangleBudget()
     {
 		GLOD_Object *obj = objects[i];
 	
-#ifdef GLOD_COREPROFILE_FIXED
 		if( obj->format != GLOD_VDS )
-#endif
 		{
 			obj->budgetCoarsenHeapData=HeapElement(obj);
 			obj->budgetRefineHeapData=HeapElement(obj);
@@ -477,7 +491,6 @@ GLOD_Group::adaptTriangleBudget()
 		// therefore, we only need a single entry in the queues for all 
 		// VDS objects in the group; VDS will take care of distributing the
 		// triangles to each object according to its current error.
-#ifdef GLOD_COREPROFILE_FIXED
 		if( obj->format == GLOD_VDS )
 		{
 			if (VDScutAdded == true)
@@ -485,7 +498,6 @@ GLOD_Group::adaptTriangleBudget()
 			else
 				VDScutAdded = true;
 		}
-#endif
 		if (errorMode == ObjectSpace)
 		{
 			obj->budgetCoarsenHeapData.setKey(
@@ -564,6 +576,7 @@ GLOD_Group::adaptTriangleBudget()
     while (roomToRefine || overBudget || !queuesBalanced)
     {		
 		IterationCounter++ ;
+		stats.iterations++;
 		if(IterationCounter > 100) //check if there is endless loop
 		{
 			if(isEndlessLoop()) //break
@@ -644,6 +657,7 @@ GLOD_Group::adaptTriangleBudget()
             printf("tri term %i errorTerm %f\n", triTermination, errorTermination);
 #endif
             refineObj->cut->refine(errorMode, triTermination, errorTermination);
+            stats.refineOps++;
 
 			int afterTris = refineObj->cut->currentNumTris;
 			currentNumTris = currentNumTris - beforeTris + afterTris;
@@ -829,6 +843,7 @@ GLOD_Group::adaptTriangleBudget()
 				triTermination = 0;
 
 			coarsenObj->cut->coarsen(errorMode, triTermination, errorTermination);
+			stats.coarsenOps++;
 		
 			int afterTris = coarsenObj->cut->currentNumTris;
 			currentNumTris = currentNumTris - beforeTris + afterTris;
@@ -1705,6 +1720,7 @@ GLOD_Group::adaptTriangleBudget()
 	
 	//if (obj->cut->currentErrorScreenSpace()==0){
 	    obj->cut->coarsen(ObjectSpace, 0.0, MAXFLOAT);
+	    stats.coarsenOps++;
 	//    for (int i=0; i<GLOD_NUM_TILES; i++)
 	//	obj->inArea[i]=0;
 	    ///obj->numAreas=0;
@@ -1844,6 +1860,7 @@ else
 		
 	while (roomToRefine)
 	{
+	    stats.iterations++;
 	    
 	    //printf("Beginning refine pass\n");
 	    
@@ -1877,6 +1894,7 @@ else
 	    //if ((errorMode == ScreenSpace) && (errorTermination < refineObj->cut->currentErrorScreenSpace()))
 		//errorTermination = 0;
 	    refineObj->cut->refine(errorMode, triTermination, errorTermination);
+	    stats.refineOps++;
 	    
 	    //printf("refining %u\n", refineObj->name);
 	    
@@ -2071,10 +2089,27 @@ GLOD_Group::adapt()
 	};
     }
 
+  double startTime = GLOD_GetMicroseconds();
+  unsigned int startHeapOps = refineQueue->numOps + coarsenQueue->numOps;
+  // each cut's view counts its own evaluations; VDS cuts are counted by
+  // the group's simplifier, whose threads never touch a view's count
+  unsigned int startErrorEvals =
+      (mpSimplifier != NULL) ? mpSimplifier->mNumErrorEvaluations : 0;
+  memset(&stats, 0, sizeof(stats));
+  trisBefore.resize(numObjects);
+
   for (int i=0; i<numObjects; i++)
     {
 		GLOD_Object *obj = objects[i];
+		obj->cut->view.numErrorEvaluations = 0;
+		if (obj->attachedXform != NULL)
+		{
+		    obj->cut->view.SetFrom(obj->attachedXform);
+		    obj->cut->viewChanged();
+		}
 		obj->cut->updateStats();
+		trisBefore[i] = obj->cut->currentNumTris;
+		stats.trisBefore += trisBefore[i];
     }
     switch(adaptMode)
     {
@@ -2083,12 +2118,102 @@ GLOD_Group::adapt()
 	break;
       case ErrorThreshold:
 	adaptErrorThreshold();
+	stats.iterations = numObjects;
 	break;
     }
+
+    for (int i=0; i<numObjects; i++)
+    {
+	int tris = objects[i]->cut->currentNumTris;
+	stats.trisAfter += tris;
+	if (tris == trisBefore[i])
+	    continue;
+	stats.objectsTouched++;
+	// threshold mode jumps straight to the new level: one step each
+	if (adaptMode == ErrorThreshold)
+	{
+	    if (tris < trisBefore[i])
+		stats.coarsenOps++;
+	    else
+		stats.refineOps++;
+	}
+    }
+    stats.heapOps = refineQueue->numOps + coarsenQueue->numOps - startHeapOps;
+    stats.errorEvals = (mpSimplifier != NULL) ?
+        mpSimplifier->mNumErrorEvaluations - startErrorEvals : 0;
+    for (int i=0; i<numObjects; i++)
+	stats.errorEvals += objects[i]->cut->view.numErrorEvaluations;
+    stats.microseconds = (int)(GLOD_GetMicroseconds() - startTime);
+    if (!deferCommit)
+	commit();
     return;
 } /* End of GLOD_Group::adapt() **/
 
 
+/*****************************************************************************\
+ @ GLOD_Group::commit
+ -----------------------------------------------------------------------------
+ description : Publishes the cuts computed by adapt() to readback and drawing
+ input       : 
+ output      : 
+ notes       : Must not run while a fill on this group is in progress; adapt()
+               itself may.
+\*****************************************************************************/
+void
+GLOD_Group::commit()
+{
+    for (int i=0; i<numObjects; i++)
+	objects[i]->cut->commit();
+    recordChanges();
+} /* End of GLOD_Group::commit() **/
+
+
+/*****************************************************************************\
+ @ GLOD_Group::recordChanges
+ -----------------------------------------------------------------------------
+ description : Rebuilds the list of patches whose level changed in this commit
+ input       : 
+ output      : 
+ notes       : Each object remembers the level of its patches as of the last
+               commit. A newly added object has no levels yet, so all of its
+               patches are reported the first time.
+\*****************************************************************************/
+void
+GLOD_Group::recordChanges()
+{
+    changedPatches.clear();
+    for (int i=0; i<numObjects; i++)
+    {
+	GLOD_Object *obj = objects[i];
+	int numPatches = obj->hierarchy->GetPatchCount();
+	if (obj->patchLevels == NULL)
+	{
+	    obj->patchLevels = new int[numPatches];
+	    for (int p=0; p<numPatches; p++)
+		obj->patchLevels[p] = -1;
+	}
+	for (int p=0; p<numPatches; p++)
+	{
+	    int level = obj->cut->getPatchLevel(p);
+	    if (level != -1 && level == obj->patchLevels[p])
+		continue;
+	    obj->patchLevels[p] = level;
+
+	    // cuts that expose their patches are counted without a readback
+	    GLuint nindices, nverts;
+	    GLOD_CutPatchData data;
+	    if (obj->cut->getPatchData(p, &data))
+		nindices = data.numIndices;
+	    else
+		obj->cut->getReadbackSizes(p, &nindices, &nverts);
+	    changedPatches.push_back(obj->name);
+	    changedPatches.push_back(obj->shared->patchName(p));
+	    changedPatches.push_back(nindices/3);
+	}
+    }
+} /* End of GLOD_Group::recordChanges() **/
+
+
 /*****************************************************************************\
   $Log: glod_group.cpp,v $
   Revision 1.50  2005/04/26 20:11:35  gfx_friends
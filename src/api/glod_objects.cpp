@@ -35,7 +35,9 @@
 #include <xbs.h>
 #include "Discrete.h"
 #include "DiscretePatch.h"
+#include "MTHierarchy.h"
 #include "Continuous.h"
+#include "threads.h"
 //
 //
 //     API ENTRIES
@@ -52,17 +54,10 @@ void glodNewObject(GLuint name, GLuint groupname, GLenum format) {
     }
     
     // is this format supported?
-#ifdef GLOD_COREPROFILE_FIXED
-	if( !(format == GLOD_DISCRETE || format == GLOD_CONTINUOUS || format == GLOD_DISCRETE_MANUAL || format == GLOD_DISCRETE_PATCH) ) {
+	if( !(format == GLOD_DISCRETE || format == GLOD_CONTINUOUS || format == GLOD_DISCRETE_MANUAL || format == GLOD_DISCRETE_PATCH || format == GLOD_MULTI_TRIANGULATION) ) {
         GLOD_SetError(GLOD_BAD_HIERARCHY, "Invalid hierarchy type:", format);
         return;
     }
-#else
-	if( !(format == GLOD_DISCRETE || format == GLOD_DISCRETE_MANUAL || format == GLOD_DISCRETE_PATCH) ) {
-		GLOD_SetError( GLOD_BAD_HIERARCHY, "Invalid hierarchy type:", format );
-		return;
-	}
-#endif
     // make the object
     obj = new GLOD_Object();
     obj->name = name;
@@ -71,98 +66,190 @@ void glodNewObject(GLuint name, GLuint groupname, GLenum format) {
     HashtableAddPtr(s_APIState.object_hash, name, obj); // put it in the namespace
     
     // initialize the patch table
-    obj->patch_id_map = AllocHashtableBySize(PATCH_HASH_BUCKET_SIZE);
+    obj->shared = new GLOD_ObjectShared();
     
-#ifdef GLOD_COREPROFILE_FIXED
 	// prepare for inserting arrays
     // this is hierarchy-type specific
-    if(format == GLOD_CONTINUOUS || format == GLOD_DISCRETE || format == GLOD_DISCRETE_PATCH) {
+    if(format == GLOD_CONTINUOUS || format == GLOD_DISCRETE || format == GLOD_DISCRETE_PATCH || format == GLOD_MULTI_TRIANGULATION) {
         
     } else if(format == GLOD_DISCRETE_MANUAL) {
         //...
     }
-#endif
     // do not make the group yet! An object can only be in a group if it has a hierarchy!!!!
     // we do this in glodBuildObject / glodLoadObject
 }
 
 
-void glodInstanceObject(GLuint name, GLuint instancename, GLuint groupname)
+/*
+ * Makes an instance of a built object. Everything that is fixed after the
+ * build (hierarchy, patch mappings) is shared with the source by
+ * reference; the instance only gets its own cut, which holds its
+ * transform and current level of detail. The build settings are copied
+ * so that parameter queries on the instance answer like the source,
+ * except for the snapshot spec arrays: each object frees its own, and an
+ * instance is never built, so it gets none.
+ */
+static void MakeInstance(GLOD_Object* obj, GLuint instancename,
+                         GLuint groupname, GLOD_Group* group)
 {
-    GLOD_Object* obj; GLOD_Object* dst;
-    obj = (GLOD_Object*) HashtableSearchPtr(s_APIState.object_hash, name);
-    if(obj == NULL ) {
-        GLOD_SetError(GLOD_INVALID_NAME, "Source object doesn't exist:", name);
-        return;
-    }
-    if( HashtableKeyExists(s_APIState.object_hash, instancename) ) {
-        GLOD_SetError(GLOD_INVALID_NAME, "An object already exists named ",  name);
-        return;
-    } 
-    if(obj->hierarchy == NULL) {
-        GLOD_SetError(GLOD_INVALID_STATE, "The source object has not been simplified yet." );
-        return;
-    }
+    GLOD_Object* dst = new GLOD_Object();
     
-    // make the object
-    dst = new GLOD_Object(*obj);
-    
-    //fprintf(stderr, "In InstanceObject() - made GLOD_Object %x from GLOD_Object %x\n", dst, obj);
-    //fprintf(stderr, "\tGLOD_Object(dst)=%x -> cut: %x -> mpCut: %x\n GLOD_Object(obj)=%x -> cut: %x -> mpCut: %x\n", dst, dst->cut, dst->cut->mpCut, obj, obj->cut, obj->cut->mpCut);
     dst->name = instancename;
+    dst->format = obj->format;
     dst->group_name = groupname;
+    dst->importance = obj->importance;
+    dst->queueMode = obj->queueMode;
+    dst->opType = obj->opType;
+    dst->shareTolerance = obj->shareTolerance;
+    dst->borderLock = obj->borderLock;
+    dst->errorMetric = obj->errorMetric;
+    dst->nodeLayout = obj->nodeLayout;
+    dst->snapMode = obj->snapMode;
+    dst->reductionPercent = obj->reductionPercent;
+    dst->numSnapshotSpecs = 0;
+    dst->snapshotTriSpecs = NULL;
+    dst->numSnapshotErrorSpecs = 0;
+    dst->snapshotErrorSpecs = NULL;
+    dst->pgPrecision = obj->pgPrecision;
+    dst->quadricMultiplier = obj->quadricMultiplier;
+    dst->buildMicroseconds = obj->buildMicroseconds;
+    
+    dst->hierarchy = obj->hierarchy;
     dst->hierarchy->LockInstance();
-    dst->budgetCoarsenHeapData=HeapElement(dst);
-    dst->budgetRefineHeapData=HeapElement(dst);
-    dst->inArea=new int[GLOD_NUM_TILES];
+    dst->shared = obj->shared;
+    dst->shared->LockInstance();
     
     HashtableAddPtr(s_APIState.object_hash, instancename, dst);
     
-    // duplicate the patch_id_map... we don't have to worry about this changing
-    dst->patch_id_map = AllocHashtableBySize(PATCH_HASH_BUCKET_SIZE);
-    HASHTABLE_WALK(obj->patch_id_map, node); //hashtable  --> patch name to 0
-    HashtableAddData(dst->patch_id_map, node->key, &node->data);
-    HASHTABLE_WALK_END(obj->patch_id_map);
-    
     // make a cut
     dst->cut = obj->hierarchy->makeCut();
     
-    //fprintf(stderr, "After dst->cut = obj->hierarchy->makeCut(),\nGLOD_Object(dst)=%x -> cut: %x -> mpCut: %x\n GLOD_Object(obj)=%x -> cut: %x -> mpCut: %x\n", dst, dst->cut, dst->cut->mpCut, obj, obj->cut, obj->cut->mpCut);
-    
-    // add it to the group...  
+    group->addObject(dst);
+}
+
+/*
+ * Formats that are simplified by XBS collect their inserted patches in a
+ * Model; DISCRETE_MANUAL keeps them as a GLOD_RawObject.
+ */
+static bool BuildsFromModel(unsigned int format)
+{
+    return format == GLOD_DISCRETE || format == GLOD_CONTINUOUS || format == GLOD_DISCRETE_PATCH ||
+        format == GLOD_MULTI_TRIANGULATION;
+}
+
+static GLOD_Group* FindOrMakeGroup(GLuint groupname)
+{
     GLOD_Group* group = (GLOD_Group*) HashtableSearchPtr(s_APIState.group_hash, groupname);
     if(group == NULL) {
         group = new GLOD_Group();
         HashtableAddPtr(s_APIState.group_hash, groupname, group);
     }
-    group->addObject(dst);
-    
+    return group;
+}
+
+void glodInstanceObject(GLuint name, GLuint instancename, GLuint groupname)
+{
+    GLOD_Object* obj;
+    obj = (GLOD_Object*) HashtableSearchPtr(s_APIState.object_hash, name);
+    if(obj == NULL ) {
+        GLOD_SetError(GLOD_INVALID_NAME, "Source object doesn't exist:", name);
+        return;
+    }
+    if( HashtableKeyExists(s_APIState.object_hash, instancename) ) {
+        GLOD_SetError(GLOD_INVALID_NAME, "An object already exists named ",  instancename);
+        return;
+    } 
+    if(obj->hierarchy == NULL) {
+        GLOD_SetError(GLOD_INVALID_STATE, "The source object has not been simplified yet." );
+        return;
+    }
     
+    MakeInstance(obj, instancename, groupname, FindOrMakeGroup(groupname));
 } /* End of glodInstanceObject() */
 
 
-void glodBuildObject (GLuint name) { 
+static int CompareNames(const void* a, const void* b)
+{
+    GLuint name_a = *(const GLuint*) a;
+    GLuint name_b = *(const GLuint*) b;
+    return (name_a > name_b) - (name_a < name_b);
+}
+
+void glodInstanceObjects(GLuint name, GLsizei count, const GLuint* instancenames, GLuint groupname)
+{
+    GLOD_Object* obj;
+    obj = (GLOD_Object*) HashtableSearchPtr(s_APIState.object_hash, name);
+    if(obj == NULL ) {
+        GLOD_SetError(GLOD_INVALID_NAME, "Source object doesn't exist:", name);
+        return;
+    }
+    if(count < 0 || (count > 0 && instancenames == NULL)) {
+        GLOD_SetError(GLOD_INVALID_PARAM, "Bad instance count or name list.");
+        return;
+    }
+    if(obj->hierarchy == NULL) {
+        GLOD_SetError(GLOD_INVALID_STATE, "The source object has not been simplified yet." );
+        return;
+    }
+    
+    // check every name up front so that a bad one creates nothing
+    for(int i = 0; i < count; i++) {
+        if( HashtableKeyExists(s_APIState.object_hash, instancenames[i]) ) {
+            GLOD_SetError(GLOD_INVALID_NAME, "An object already exists named ",  instancenames[i]);
+            return;
+        }
+    }
+    GLuint* sorted = new GLuint[count];
+    memcpy(sorted, instancenames, sizeof(GLuint) * count);
+    qsort(sorted, count, sizeof(GLuint), CompareNames);
+    for(int i = 1; i < count; i++) {
+        if(sorted[i] == sorted[i-1]) {
+            GLOD_SetError(GLOD_INVALID_NAME, "Instance name repeated in list:", sorted[i]);
+            delete [] sorted;
+            return;
+        }
+    }
+    delete [] sorted;
     
-    GLOD_Object* obj; GLOD_Group* group;
+    GLOD_Group* group = FindOrMakeGroup(groupname);
+    HashtableReserve(s_APIState.object_hash,
+                     HashtableNumElements(s_APIState.object_hash) + count);
+    group->reserveObjects(group->getNumObjects() + count);
     
-    obj = (GLOD_Object*) HashtableSearchPtr(s_APIState.object_hash, name);
+    for(int i = 0; i < count; i++)
+        MakeInstance(obj, instancenames[i], groupname, group);
+} /* End of glodInstanceObjects() */
+
+
+/*
+ * Building is split in three so that glodBuildObjects can run the
+ * expensive middle step for several objects on separate threads; the
+ * lookup before it and the cut and group setup after it use the API's
+ * hash tables and error state and stay on the calling thread.
+ */
+static GLOD_Object* FindUnbuiltObject(GLuint name)
+{
+    GLOD_Object* obj = (GLOD_Object*) HashtableSearchPtr(s_APIState.object_hash, name);
     if(obj == NULL ) {
         GLOD_SetError(GLOD_INVALID_NAME, "Object doesn't exist: ", name);
-        return;
+        return NULL;
+    }
+    // check our state
+    if(BuildsFromModel(obj->format) && obj->prebuild_buffer == NULL) {
+        GLOD_SetError(GLOD_INVALID_STATE, "Object has already been built:", name);
+        return NULL;
     }
+    return obj;
+}
+
+// Turns the inserted geometry into a hierarchy. Touches nothing outside obj;
+// an error is left in obj->buildError for FinishBuild to report.
+static void BuildHierarchy(GLOD_Object* obj)
+{
+    double startTime = GLOD_GetMicroseconds();
     Model *model=NULL;
     // Build the object
-#ifdef GLOD_COREPROFILE_FIXED
-	if( obj->format == GLOD_DISCRETE || obj->format == GLOD_CONTINUOUS || obj->format == GLOD_DISCRETE_PATCH ) {
-#else
-	if( obj->format == GLOD_DISCRETE || obj->format == GLOD_DISCRETE_PATCH ) {
-#endif
-        // check our state
-        if(obj->prebuild_buffer == NULL) {
-            GLOD_SetError(GLOD_INVALID_STATE, "Object has already been built:", name);
-            return;
-        }
-        
+    if(BuildsFromModel(obj->format)) {
         // run it through XBS
         
         XBSSimplifier *simp;
@@ -171,8 +258,8 @@ void glodBuildObject (GLuint name) {
         printf("Sharing...\n"); fflush(stdout);
 #endif
         
-        model = new Model((GLOD_RawObject*)obj->prebuild_buffer);
-        delete ((GLOD_RawObject*) obj->prebuild_buffer);
+        // the patches were streamed into this as they were inserted
+        model = (Model*) obj->prebuild_buffer;
         
         model->share(obj->shareTolerance);
         model->indexVertTris();
@@ -202,19 +289,23 @@ void glodBuildObject (GLuint name) {
         case GLOD_DISCRETE:
             obj->hierarchy = new DiscreteHierarchy(obj->opType);
             break;
-#ifdef GLOD_COREPROFILE_FIXED
 		case GLOD_VDS:
             obj->hierarchy = new VDSHierarchy();
+            ((VDSHierarchy*) obj->hierarchy)->nodeLayout = obj->nodeLayout;
             break;
-#endif
         case GLOD_DISCRETE_PATCH:
             obj->hierarchy = new DiscretePatchHierarchy(obj->opType);
             break;
+        case GLOD_MULTI_TRIANGULATION:
+            obj->hierarchy = new MTHierarchy();
+            break;
         }
         simp = new XBSSimplifier(model, obj->opType, obj->queueMode, 
             obj->hierarchy);
         delete simp;
         simp = NULL;
+        obj->buildError = model->buildError;
+        obj->buildErrorMessage = model->buildErrorMessage;
         delete model;
         model = NULL;
 #ifdef VERBOSE
@@ -234,6 +325,16 @@ void glodBuildObject (GLuint name) {
     }
 
     obj->prebuild_buffer = NULL; // each of the above branches must free this themselves.
+    obj->buildMicroseconds = (int)(GLOD_GetMicroseconds() - startTime);
+}
+
+static void FinishBuild(GLOD_Object* obj)
+{
+    // the API error state is only touched from the calling thread
+    if(obj->buildError != GLOD_NO_ERROR) {
+        GLOD_SetError(obj->buildError, obj->buildErrorMessage, obj->name);
+        obj->buildError = GLOD_NO_ERROR;
+    }
     
     // put a reference on this hierarchy for later gc
     obj->hierarchy->LockInstance();
@@ -242,15 +343,77 @@ void glodBuildObject (GLuint name) {
     obj->cut = obj->hierarchy->makeCut();
     
     // now add it to the group
-    group = (GLOD_Group*) HashtableSearchPtr(s_APIState.group_hash, obj->group_name);
-    if(group == NULL) {
-        group = new GLOD_Group();
-        HashtableAddPtr(s_APIState.group_hash, obj->group_name, group);
-    }
-    group->addObject(obj);
+    FindOrMakeGroup(obj->group_name)->addObject(obj);
+}
+
+void glodBuildObject (GLuint name) { 
+    GLOD_Object* obj = FindUnbuiltObject(name);
+    if(obj == NULL)
+        return;
+    
+    BuildHierarchy(obj);
+    FinishBuild(obj);
 } /* End of glodBuildObject() **/
 
 
+// ParallelForEach body for glodBuildObjects
+static void BuildHierarchies(void* pContext, int first, int last)
+{
+    GLOD_Object** objs = (GLOD_Object**) pContext;
+    for(int i = first; i <= last; i++)
+        BuildHierarchy(objs[i]);
+}
+
+// largest inserted model first
+static int CompareBuildSizes(const void* a, const void* b)
+{
+    GLOD_Object* obj_a = *(GLOD_Object**) a;
+    GLOD_Object* obj_b = *(GLOD_Object**) b;
+    int tris_a = BuildsFromModel(obj_a->format) ? ((Model*) obj_a->prebuild_buffer)->getNumTris() : 0;
+    int tris_b = BuildsFromModel(obj_b->format) ? ((Model*) obj_b->prebuild_buffer)->getNumTris() : 0;
+    return (tris_a < tris_b) - (tris_a > tris_b);
+}
+
+void glodBuildObjects(GLsizei count, const GLuint* names)
+{
+    if(count < 0 || (count > 0 && names == NULL)) {
+        GLOD_SetError(GLOD_INVALID_PARAM, "Bad object count or name list.");
+        return;
+    }
+    if(count == 0)
+        return;
+    
+    // check every name up front so that a bad one builds nothing
+    GLOD_Object** objs = new GLOD_Object*[count];
+    for(int i = 0; i < count; i++) {
+        objs[i] = FindUnbuiltObject(names[i]);
+        if(objs[i] == NULL) {
+            delete [] objs;
+            return;
+        }
+        for(int j = 0; j < i; j++) {
+            if(objs[j] == objs[i]) {
+                GLOD_SetError(GLOD_INVALID_NAME, "Object name repeated in list:", names[i]);
+                delete [] objs;
+                return;
+            }
+        }
+    }
+    
+    // start the big builds first so that one doesn't hold up the end
+    GLOD_Object** order = new GLOD_Object*[count];
+    memcpy(order, objs, sizeof(GLOD_Object*) * count);
+    qsort(order, count, sizeof(GLOD_Object*), CompareBuildSizes);
+    ParallelForEach(0, count - 1, GetNumSystemProcessors(), BuildHierarchies, order);
+    delete [] order;
+    
+    // cuts and group membership in the order the names were given
+    for(int i = 0; i < count; i++)
+        FinishBuild(objs[i]);
+    delete [] objs;
+} /* End of glodBuildObjects() */
+
+
 void glodDeleteObject(GLuint name)
 {
     GLOD_Object* obj =
@@ -261,8 +424,6 @@ void glodDeleteObject(GLuint name)
         return;
     }
     
-    FreeHashtableCautious(obj->patch_id_map); // deletes the patch mappings... we're cautious b/c the mappings aren't pointers but actually integers
-    
     HashtableDeleteCautious(s_APIState.object_hash, obj->name); // this does not delete the object!!!
     delete obj;                                                 // this does
     
@@ -280,7 +441,7 @@ void glodObjectXform(GLuint objectname, float m1[16], float m2[16], float m3[16]
         return;
     }
     
-    if(obj->hierarchy != NULL) {
+    if(obj->hierarchy == NULL) {
         GLOD_SetError(GLOD_INVALID_STATE, "Object has not been built: ", objectname);
         return;
     }
@@ -305,6 +466,57 @@ void glodObjectXform(GLuint objectname, float m1[16], float m2[16], float m3[16]
     obj->cut->viewChanged();  
 }
 
+// Sets the transform of many objects at once. Each matrix is a single,
+// already-combined 4x4 in column-major order, packed one after another.
+// Unknown or unbuilt names are flagged and skipped; the rest still apply.
+void glodObjectXforms(GLsizei count, const GLuint* objectnames, const float* matrices)
+{
+    if(count < 0 || (count > 0 && (objectnames == NULL || matrices == NULL))) {
+        GLOD_SetError(GLOD_INVALID_PARAM, "Bad object count, name list or matrix list.");
+        return;
+    }
+    
+    for(int i = 0; i < count; i++) {
+        GLOD_Object *obj =
+            (GLOD_Object*) HashtableSearchPtr(s_APIState.object_hash, objectnames[i]);
+        if(obj == NULL) {
+            GLOD_SetError(GLOD_INVALID_NAME, "Object doesn't exist:", objectnames[i]);
+            continue;
+        }
+        if(obj->hierarchy == NULL) {
+            GLOD_SetError(GLOD_INVALID_STATE, "Object has not been built: ", objectnames[i]);
+            continue;
+        }
+        obj->cut->view.SetFrom(matrices + 16*i);
+        obj->cut->viewChanged();
+    }
+}
+
+// Points each object at a matrix owned by the application, which the
+// object's group reads at the start of every glodAdaptGroup. Passing a
+// NULL matrix array detaches the objects again.
+void glodAttachObjectXforms(GLsizei count, const GLuint* objectnames, const float* matrices)
+{
+    if(count < 0 || (count > 0 && objectnames == NULL)) {
+        GLOD_SetError(GLOD_INVALID_PARAM, "Bad object count or name list.");
+        return;
+    }
+    
+    for(int i = 0; i < count; i++) {
+        GLOD_Object *obj =
+            (GLOD_Object*) HashtableSearchPtr(s_APIState.object_hash, objectnames[i]);
+        if(obj == NULL) {
+            GLOD_SetError(GLOD_INVALID_NAME, "Object doesn't exist:", objectnames[i]);
+            continue;
+        }
+        if(obj->hierarchy == NULL) {
+            GLOD_SetError(GLOD_INVALID_STATE, "Object has not been built: ", objectnames[i]);
+            continue;
+        }
+        obj->attachedXform = (matrices == NULL) ? NULL : matrices + 16*i;
+    }
+}
+
 /***************************************************************************/
 
 void glodReadbackObject(GLuint name, GLvoid *data) { 
@@ -320,12 +532,12 @@ void glodReadbackObject(GLuint name, GLvoid *data) {
     memcpy(data, &obj->format, sizeof(int)); offset += sizeof(int);
     
     // now write out the patch->packed_patch hashtable
-    memcpy(((char*)data)+offset, &obj->patch_id_map->num_elements, sizeof(unsigned int)); offset += sizeof(unsigned int);
+    memcpy(((char*)data)+offset, &obj->shared->patch_id_map->num_elements, sizeof(unsigned int)); offset += sizeof(unsigned int);
     
-    HASHTABLE_WALK(obj->patch_id_map, node);
+    HASHTABLE_WALK(obj->shared->patch_id_map, node);
     memcpy(((char*)data)+offset, (void*)&node->key, sizeof(unsigned int)); offset += sizeof(unsigned int);
     memcpy(((char*)data)+offset, (void*) &node->data, sizeof(unsigned int)); offset += sizeof(unsigned int);
-    HASHTABLE_WALK_END(obj->patch_id_map);
+    HASHTABLE_WALK_END(obj->shared->patch_id_map);
     
     // now we have the object
     obj->hierarchy->readback((void*)((char*)data + offset));
@@ -352,14 +564,14 @@ void glodLoadObject(GLuint name, GLuint group_name, const GLvoid *data) {
     obj->format = format;
     
     // load the indirect table
-    obj->patch_id_map = AllocHashtableBySize(PATCH_HASH_BUCKET_SIZE);
+    obj->shared = new GLOD_ObjectShared();
     unsigned int num_indirects;
     memcpy(&num_indirects, ((char*)data) + offset, sizeof(unsigned int)); offset += sizeof(unsigned int);
     for(int i = 0; i < num_indirects; i++) {
         unsigned int k; unsigned int value;
         memcpy(&k, ((char*)data) + offset, sizeof(unsigned int)); offset += sizeof(unsigned int);    
         memcpy(&value, ((char*)data) + offset, sizeof(unsigned int)); offset += sizeof(unsigned int);    
-		HashtableAddInt(obj->patch_id_map, k, value);
+		HashtableAddInt(obj->shared->patch_id_map, k, value);
     }
     
     // read the hierarchy
@@ -367,25 +579,25 @@ void glodLoadObject(GLuint name, GLuint group_name, const GLvoid *data) {
     case GLOD_DISCRETE:
         obj->hierarchy = new DiscreteHierarchy(Half_Edge_Collapse); // placeholder: op type gets set in the load()
         break;
-#ifdef GLOD_COREPROFILE_FIXED
 	case GLOD_CONTINUOUS:
         obj->hierarchy = new VDSHierarchy();
         ((VDSHierarchy*) obj->hierarchy)->InitForLoad();
         break;
-#endif
     case GLOD_DISCRETE_PATCH:
         obj->hierarchy = new DiscretePatchHierarchy(Half_Edge_Collapse);
         break;
+    case GLOD_MULTI_TRIANGULATION:
+        obj->hierarchy = new MTHierarchy();
+        break;
     default:
         GLOD_SetError(GLOD_BAD_HIERARCHY, "Invalid hierarchy type in source data.", format );
-        FreeHashtableCautious(obj->patch_id_map);
         HashtableDeleteCautious(s_APIState.object_hash, obj->name);
         delete obj;
         return;
     }
     if(obj->hierarchy->load((void*)(((char*)data) + offset)) == 0) {
+        GLOD_SetError(GLOD_INVALID_DATA_FORMAT, "Load failed: damaged or incompatible object data.", format);
         // we need to reset the object to a base state
-        FreeHashtableCautious(obj->patch_id_map);
         HashtableDeleteCautious(s_APIState.object_hash, obj->name);
         delete obj;
         return;
@@ -407,17 +619,18 @@ void glodLoadObject(GLuint name, GLuint group_name, const GLvoid *data) {
 /***************************************************************************/
 
 /* called by glodInsertArrays and glodInsertElements which are in Raw.cpp */
-void HandlePatch(GLOD_Object* obj, GLOD_RawPatch* patch, int level, float geometric_error) {
-    // now store this patch until build time
-#ifdef GLOD_COREPROFILE_FIXED
-	if( obj->format == GLOD_DISCRETE || obj->format == GLOD_CONTINUOUS || obj->format == GLOD_DISCRETE_PATCH ) {
-#else
-	if( obj->format == GLOD_DISCRETE || obj->format == GLOD_DISCRETE_PATCH ) {
-#endif
-		// DISCRETE & CONTINUOUS PATCH ACCUMULATION STEP
-        if(obj->prebuild_buffer == NULL) obj->prebuild_buffer = (void*) new GLOD_RawObject();
-        GLOD_RawObject* raw = (GLOD_RawObject*) obj->prebuild_buffer;
-        raw->AddPatch(patch);
+int HandlePatch(GLOD_Object* obj, GLOD_RawPatch* patch, int level, float geometric_error) {
+    if(BuildsFromModel(obj->format)) {
+        // DISCRETE & CONTINUOUS: stream the patch straight into the build
+        // Model, so that no raw copy of the whole object is kept around
+        if(obj->prebuild_buffer == NULL) obj->prebuild_buffer = (void*) new Model();
+        Model* model = (Model*) obj->prebuild_buffer;
+        int ok = model->addPatch(patch, patch->name);
+        delete patch;
+        if(!ok) {
+            GLOD_SetError(GLOD_INVALID_DATA_FORMAT, "Patches must all have the same attributes");
+            return 0;
+        }
     } else {
         // store patches & levels
         patch->level = level;
@@ -427,6 +640,7 @@ void HandlePatch(GLOD_Object* obj, GLOD_RawPatch* patch, int level, float geomet
         GLOD_RawObject* raw = (GLOD_RawObject*) obj->prebuild_buffer;
         raw->AddPatch(patch);
     }
+    return 1;
 }
 
 /***************************************************************************/
@@ -436,9 +650,14 @@ void glodDrawPatch(GLuint name, GLuint patchname) {
         GLOD_SetError(GLOD_INVALID_NAME, "Object does not exist", name);
         return;
     }
+    if(obj->format == GLOD_CONTINUOUS) {
+        // VDS cuts live in system memory only; read them back instead
+        GLOD_SetError(GLOD_INVALID_STATE, "Continuous objects cannot be drawn; use glodFillElements or glodFillArrays", name);
+        return;
+    }
     
     // look up the real patch name
-    int patch_id = HashtableSearchInt(obj->patch_id_map, patchname+1); // lameness
+    int patch_id = HashtableSearchInt(obj->shared->patch_id_map, patchname+1); // lameness
     if(patch_id == 0) {
         // this patch isn't there
         GLOD_SetError(GLOD_INVALID_PATCH, "Patch of the specified doesn't exist.", patchname);
@@ -466,14 +685,24 @@ GLOD_Object::~GLOD_Object()
         delete cut;
         cut = NULL;
     }
+    delete [] patchLevels;
+    patchLevels = NULL;
     if (hierarchy != NULL)
     {
         hierarchy->ReleaseInstance();
         hierarchy = NULL;
     }
+    if (shared != NULL)
+    {
+        shared->ReleaseInstance();
+        shared = NULL;
+    }
     if (prebuild_buffer != NULL)
     {
-        delete (GLOD_RawObject*) prebuild_buffer;
+        if (BuildsFromModel(format))
+            delete (Model*) prebuild_buffer;
+        else
+            delete (GLOD_RawObject*) prebuild_buffer;
         prebuild_buffer = NULL;
     }
     if (snapshotTriSpecs != NULL)
@@ -5,37 +5,55 @@
  * All rights reserved
  *
  * See the file LICENSE.txt for information on redistributing this software.
+ ***************************************************************************
+ * The chained table from CR has since been replaced by an open-addressing
+ * table: a flat, power-of-two sized slot array probed linearly. It grows
+ * by doubling once it is three quarters full, and deletes shift the rest of
+ * the probe run backwards rather than leaving tombstones behind, so lookups
+ * stay short no matter how many objects come and go.
  */
 
 #include "hash.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-HashTable *AllocHashtable( void )
+static unsigned int RoundUpPow2( unsigned int n )
 {
-	unsigned int i;
-	HashTable *hash = (HashTable *) malloc( sizeof( HashTable )) ;
-        hash->num_buckets = HASH_DEFAULT_NUM_BUCKETS;
-        hash->buckets = (HashNode**) malloc(sizeof(HashNode*) * hash->num_buckets);
+	unsigned int p = 8;
+	while ( p < n )
+		p <<= 1;
+	return p;
+}
+
+/* Fibonacci hashing: GLOD names tend to be small and sequential, so
+ * spread them over the whole table. The product's top bits are the well
+ * mixed ones, so the slot is taken from there rather than the low bits. */
+static unsigned int doHash( HashTable* hash, unsigned int key )
+{
+	return (key * 2654435769u) >> hash->hash_shift;
+}
+
+static void InitBuckets( HashTable *hash, unsigned int num_buckets )
+{
+	unsigned int bits = 0;
+	while ( (1u << bits) < num_buckets )
+		bits++;
+	hash->hash_shift = 32 - bits;
+	hash->num_buckets = num_buckets;
 	hash->num_elements = 0;
-	for (i = 0 ; i < hash->num_buckets ; i++)
-	{
-		hash->buckets[i] = NULL;
-	}
-	return hash;
+	hash->buckets = (HashNode*) calloc( num_buckets, sizeof(HashNode) );
+}
+
+HashTable *AllocHashtable( void )
+{
+	return AllocHashtableBySize( HASH_DEFAULT_NUM_BUCKETS );
 }
 
 HashTable *AllocHashtableBySize( int numB )
 {
-	unsigned int i;
 	HashTable *hash = (HashTable *) malloc( sizeof( HashTable )) ;
-        hash->num_buckets = numB;
-        hash->buckets = (HashNode**) malloc(sizeof(HashNode*) * hash->num_buckets);
-	hash->num_elements = 0;
-	for (i = 0 ; i < hash->num_buckets ; i++)
-	{
-		hash->buckets[i] = NULL;
-	}
+	InitBuckets( hash, RoundUpPow2( numB > 0 ? (unsigned int) numB : 0 ) );
 	return hash;
 }
 
@@ -45,72 +63,93 @@ void FreeHashtable( HashTable *hash )
 
 	for ( i = 0; i < hash->num_buckets; i++ )
 	{
-		if ( hash->buckets[i] ) 
-		{
-			if( hash->buckets[i]->data.mType == HashData::ePtr )
-				free( hash->buckets[i]->data.uData.pData );
-			free( hash->buckets[i] );
-		}
+		if ( hash->buckets[i].used && hash->buckets[i].data.mType == HashData::ePtr )
+			free( hash->buckets[i].data.uData.pData );
 	}
-        free( hash->buckets );
+	free( hash->buckets );
 	free( hash );
 }
 
 void FreeHashtableCautious( HashTable *hash )
 {
-	unsigned int i;
+	free( hash->buckets );
+	free( hash );
+}
 
-	for ( i = 0; i < hash->num_buckets; i++ )
+/* returns the slot holding key, or the empty slot where it would go */
+static unsigned int FindSlot( HashTable *h, unsigned int key )
+{
+	unsigned int mask = h->num_buckets - 1;
+	unsigned int index = doHash( h, key );
+	while ( h->buckets[index].used && h->buckets[index].key != key )
+		index = (index + 1) & mask;
+	return index;
+}
+
+static void Rehash( HashTable *h, unsigned int num_buckets )
+{
+	HashNode *old = h->buckets;
+	unsigned int old_num = h->num_buckets;
+	unsigned int i, count = h->num_elements;
+
+	InitBuckets( h, num_buckets );
+	for ( i = 0; i < old_num; i++ )
 	{
-		if ( hash->buckets[i] ) 
-		{
-		    HashNode *next = hash->buckets[i];
-		    while (next !=NULL){
-			next = hash->buckets[i]->next;
-			free (hash->buckets[i]);
-			hash->buckets[i] = next;
-		    }
-			free( hash->buckets[i] );
-		}
+		if ( old[i].used )
+			h->buckets[ FindSlot( h, old[i].key ) ] = old[i];
 	}
-        free( hash->buckets );
-	free( hash );
+	h->num_elements = count;
+	free( old );
 }
 
+void HashtableReserve( HashTable *h, unsigned int num_elements )
+{
+	unsigned int want = RoundUpPow2( num_elements + num_elements / 3 + 1 );
+	if ( want > h->num_buckets )
+		Rehash( h, want );
+}
 
-static unsigned int doHash( HashTable* hash, unsigned int key )
+/* Adding a key that is already present replaces its value. */
+static HashNode *InsertSlot( HashTable *h, unsigned int key )
 {
-	return key % hash->num_buckets;
+	HashNode *node;
+
+	if ( (h->num_elements + 1) * 4 > h->num_buckets * 3 )
+		Rehash( h, h->num_buckets * 2 );
+
+	node = &h->buckets[ FindSlot( h, key ) ];
+	if ( !node->used )
+	{
+		node->used = 1;
+		node->key = key;
+		h->num_elements++;
+	}
+	return node;
 }
 
-void HashtableAddPtr( HashTable *h, unsigned int key, void *data )
+void *HashtableAddPtr( HashTable *h, unsigned int key, void *data )
 {
-	HashNode *node = (HashNode *) malloc( sizeof( HashNode ) );
-	node->key = key;
+	unsigned int count = h->num_elements;
+	HashNode *node = InsertSlot( h, key );
+	void *old = NULL;
 
+	if ( h->num_elements == count && node->data.mType == HashData::ePtr )
+		old = node->data.uData.pData;
 	node->data.mType = HashData::ePtr;
 	node->data.uData.pData = data;
-	node->next = h->buckets[doHash( h, key )];
-	h->buckets[ doHash( h, key ) ] = node;
-	h->num_elements++;
+	return old;
 }
 
 void HashtableAddInt( HashTable *h, unsigned int key, int data )
 {
-	HashNode *node = (HashNode *) malloc( sizeof( HashNode ) );
-	node->key = key;
-
+	HashNode *node = InsertSlot( h, key );
 	node->data.mType = HashData::eInt;
 	node->data.uData.nValue = data;
-	node->next = h->buckets[doHash( h, key )];
-	h->buckets[ doHash( h, key ) ] = node;
-	h->num_elements++;
 }
 
 void HashtableAddData( HashTable *h, unsigned int key, HashData *data )
 {
-	HashNode *node = (HashNode *) malloc( sizeof( HashNode ) );
-	node->key = key;
+	HashNode *node = InsertSlot( h, key );
 
 	node->data.mType = data->mType;
 
@@ -118,79 +157,67 @@ void HashtableAddData( HashTable *h, unsigned int key, HashData *data )
 		node->data.uData.nValue = data->uData.nValue;
 	else
 		node->data.uData.pData = data->uData.pData;
-
-	node->next = h->buckets[doHash( h, key )];
-	h->buckets[ doHash( h, key ) ] = node;
-	h->num_elements++;
 }
 
-
-void HashtableDelete( HashTable *h, unsigned int key )
+/* Backward-shift deletion: pull later members of the probe run into the
+ * hole so that no tombstones are needed. */
+static void RemoveSlot( HashTable *h, unsigned int hole )
 {
-	unsigned int index = doHash( h, key );
-	HashNode *temp, *beftemp = NULL;
-	for ( temp = h->buckets[index]; temp; temp = temp->next )
+	unsigned int mask = h->num_buckets - 1;
+	unsigned int next = hole;
+
+	for (;;)
 	{
-		if ( temp->key == key )
+		unsigned int home;
+		next = (next + 1) & mask;
+		if ( !h->buckets[next].used )
 			break;
-		beftemp = temp;
+		home = doHash( h, h->buckets[next].key );
+		/* leave it alone if its home lies cyclically within (hole, next] */
+		if ( hole <= next ? (hole < home && home <= next)
+		                  : (hole < home || home <= next) )
+			continue;
+		h->buckets[hole] = h->buckets[next];
+		hole = next;
 	}
-	if ( !temp )
-		return; /* not an error */
-	if ( beftemp )
-		beftemp->next = temp->next;
-	else
-		h->buckets[index] = temp->next;
+	h->buckets[hole].used = 0;
 	h->num_elements--;
+}
+
+void HashtableDelete( HashTable *h, unsigned int key )
+{
+	unsigned int index = FindSlot( h, key );
+	if ( !h->buckets[index].used )
+		return; /* not an error */
 
-	if( temp->data.mType == HashData::ePtr )
-		free( temp->data.uData.pData );
-	free( temp );
+	if( h->buckets[index].data.mType == HashData::ePtr )
+		free( h->buckets[index].data.uData.pData );
+	RemoveSlot( h, index );
 }
 
 void HashtableDeleteCautious( HashTable *h, unsigned int key )
 {
-	unsigned int index = doHash( h, key );
-	HashNode *temp, *beftemp = NULL;
-	for ( temp = h->buckets[index]; temp; temp = temp->next )
-	{
-		if ( temp->key == key )
-			break;
-		beftemp = temp;
-	}
-	if ( !temp )
+	unsigned int index = FindSlot( h, key );
+	if ( !h->buckets[index].used )
 		return; /* not an error */
-	if ( beftemp )
-		beftemp->next = temp->next;
-	else
-		h->buckets[index] = temp->next;
-	h->num_elements--;
-	free( temp );
+	RemoveSlot( h, index );
 }
 
-bool HashtableKeyExists( HashTable *h, unsigned int key )
+HashNode *HashtableSearchNode( HashTable *h, unsigned int key )
 {
-	unsigned int index = doHash( h, key );
-	HashNode *temp;
-	for ( temp = h->buckets[index]; temp; temp = temp->next )
-	{
-		if ( temp->key == key )
-			break;
-	}
+	HashNode *node = &h->buckets[ FindSlot( h, key ) ];
+	return node->used ? node : NULL;
+}
 
-	return temp != 0;
+bool HashtableKeyExists( HashTable *h, unsigned int key )
+{
+	return HashtableSearchNode( h, key ) != NULL;
 }
 
 
 void *HashtableSearchPtr( HashTable *h, unsigned int key )
 {
-	unsigned int index = doHash( h, key );
-	HashNode *temp;
-	for ( temp = h->buckets[index]; temp; temp = temp->next )
-	{
-		if ( temp->key == key )
-			break;
-	}
+	HashNode *temp = HashtableSearchNode( h, key );
 	if ( !temp )
 		return NULL;
 
@@ -205,13 +232,7 @@ void *HashtableSearchPtr( HashTable *h, unsigned int key )
 
 int HashtableSearchInt(HashTable* h, unsigned int key)
 {
-	unsigned int index = doHash( h, key );
-	HashNode *temp;
-	for ( temp = h->buckets[index]; temp; temp = temp->next )
-	{
-		if ( temp->key == key )
-			break;
-	}
+	HashNode *temp = HashtableSearchNode( h, key );
 
 	if ( !temp )
 		return 0;
@@ -225,7 +246,25 @@ int HashtableSearchInt(HashTable* h, unsigned int key)
 	return temp->data.uData.nValue;
 }
 
-unsigned int HashtableNumElements( HashTable *h) 
+unsigned int HashtableNumElements( HashTable *h)
 {
 	return h->num_elements;
 }
+
+HashNode *HashtableIterFirst( HashTable *h, HashIterator *it )
+{
+	it->h = h;
+	it->slot = (unsigned int) -1;
+	return HashtableIterNext( it );
+}
+
+HashNode *HashtableIterNext( HashIterator *it )
+{
+	HashTable *h = it->h;
+	for ( it->slot++; it->slot < h->num_buckets; it->slot++ )
+	{
+		if ( h->buckets[it->slot].used )
+			return &h->buckets[it->slot];
+	}
+	return NULL;
+}
@@ -0,0 +1,93 @@
+/*
+  Regression check for glodInstanceObjects() and glodDeleteObject(): builds
+  an object of each simplified format with snapshot specs set, instances
+  it, and deletes the instances and the source.  Run with "make -C src
+  check".
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <GL/gl.h>
+#include <glod.h>
+
+#define ROWS  20
+#define COLS  30
+
+static GLfloat verts[(ROWS + 1) * (COLS + 1) * 3];
+static GLuint tris[ROWS * COLS * 6];
+
+static void make_sphere(void)
+{
+  int r, c, n = 0;
+
+  for (r = 0; r <= ROWS; r++)
+    for (c = 0; c <= COLS; c++) {
+      float th = M_PI * r / ROWS, ph = 2 * M_PI * c / COLS;
+      verts[n++] = sin(th) * cos(ph);
+      verts[n++] = sin(th) * sin(ph);
+      verts[n++] = cos(th);
+    }
+  n = 0;
+  for (r = 0; r < ROWS; r++)
+    for (c = 0; c < COLS; c++) {
+      GLuint a = r * (COLS + 1) + c, b = a + 1, d = a + COLS + 1, e = d + 1;
+      tris[n++] = a; tris[n++] = d; tris[n++] = b;
+      tris[n++] = b; tris[n++] = d; tris[n++] = e;
+    }
+}
+
+static int check(const char *what, GLuint expected)
+{
+  GLuint error = glodGetError();
+
+  if (error == expected)
+    return (0);
+  fprintf(stderr, "instancetest: %s gave error 0x%x\n", what, error);
+  return (1);
+}
+
+int main(void)
+{
+  GLuint formats[3] = {GLOD_DISCRETE, GLOD_CONTINUOUS,
+                       GLOD_MULTI_TRIANGULATION};
+  GLfloat specs[2] = {0.01f, 0.1f};
+  GLuint names[2] = {11, 12};
+  GLuint repeated[3] = {21, 22, 21};
+  glodVBO vbo;
+  int i, errors = 0;
+
+  make_sphere();
+  memset(&vbo, 0, sizeof(vbo));
+  vbo.mV.p = verts;
+  vbo.mV.size = 3;
+  vbo.mV.type = GL_FLOAT;
+  glodInit();
+
+  for (i = 0; i < 3; i++) {
+    glodNewObject(1, 0, formats[i]);
+    glodObjectParameterfv(1, GLOD_BUILD_ERROR_SPECS, 2, specs);
+    glodInsertElements(1, 0, GL_TRIANGLES, ROWS * COLS * 6, GL_UNSIGNED_INT,
+                       tris, 0, 0, &vbo);
+    glodBuildObject(1);
+    errors += check("build", GLOD_NO_ERROR);
+
+    /* a name repeated in the list creates no instance at all */
+    glodInstanceObjects(1, 3, repeated, 0);
+    errors += check("repeated names", GLOD_INVALID_NAME);
+    glodDeleteObject(21);
+    errors += check("instance made before a repeated name",
+                    GLOD_INVALID_NAME);
+
+    glodInstanceObjects(1, 2, names, 0);
+    errors += check("instancing", GLOD_NO_ERROR);
+    glodDeleteObject(names[0]);
+    glodDeleteObject(1);
+    glodDeleteObject(names[1]);
+    errors += check("delete", GLOD_NO_ERROR);
+  }
+
+  glodShutdown();
+  printf("instancetest: %s\n", errors ? "FAILED" : "passed");
+  return (errors ? 1 : 0);
+}
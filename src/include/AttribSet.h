@@ -122,6 +122,8 @@ public:
    
    int getAttribSize(int attribNum) { return m_AttribSizes[attribNum]; }
    int getAttribOffset(int attribNum) { return m_AttribOffsets[attribNum]; }
+   int getAttribType(int attribNum) { return m_AttribTypes[attribNum]; }
+   int getAttribCount(int attribNum) { return m_AttribCount[attribNum]; }
    
    void setAttrib(void* data, int attribNum, void* src) {
        memcpy(((char*)data) + m_AttribOffsets[attribNum], src,
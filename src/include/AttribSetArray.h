@@ -34,6 +34,12 @@ class AttribSetArray : public AttribSet {
     }
 
     int getSize() { return numVerts; }
+
+    // drop the vertices but keep the storage for reuse
+    void clear() { numVerts = 0; }
+
+    // the interleaved vertex storage, getVertexSize() bytes per vertex
+    unsigned char* getData() { return verts; }
     
     void create(bool has_color, bool has_normal, bool has_texcoord,
            int nverts = 4) {
@@ -62,6 +68,16 @@ class AttribSetArray : public AttribSet {
         return numVerts++;
     }
 
+    // append count uninitialized vertices, returning the first's index
+    int addVerts(int count) {
+        if(numVerts + count > maxVerts) {
+            int newsize = (int)ceil(1.25f * (float)maxVerts);
+            setSize((newsize < numVerts + count) ? numVerts + count : newsize);
+        }
+        numVerts += count;
+        return numVerts - count;
+    }
+
     void setSize(int newsize) { /* grow the array ... */
         assert(newsize >= numVerts);
         if(newsize == numVerts) return;
@@ -71,27 +87,27 @@ class AttribSetArray : public AttribSet {
     }
 
     void getVertex(unsigned int idx, void* dst) {
-        assert(idx < numVerts);
+        assert(idx < (unsigned int)numVerts);
         memcpy(dst,
                verts + getVertexSize() * idx,
                getVertexSize());
     }
     
     void setVertex(unsigned int idx, void* src) {
-        assert(idx < numVerts);
+        assert(idx < (unsigned int)numVerts);
         memcpy(verts + getVertexSize() * idx,
                src,
                getVertexSize());
     }
     
     float* getCoord(unsigned int idx) {
-        assert(idx < numVerts);
+        assert(idx < (unsigned int)numVerts);
         return (float*) getAttribAddress(verts + getVertexSize() * idx, 
                                 AS_POSITION);
     }
     
     void setCoord(unsigned int idx, float* coord) {
-        assert(idx < numVerts);
+        assert(idx < (unsigned int)numVerts);
         AttribSet::setAttrib(verts + getVertexSize() * idx, 
                   AS_POSITION,
                   coord);
@@ -136,7 +152,6 @@ class AttribSetArray : public AttribSet {
    int copyState(void* vdst) {
        char* dst = (char*)vdst;
 #define APPEND(value,amount) {memcpy(dst,(value),(amount)); dst+=(amount);}
-       int size = 0;
        dst += AttribSet::copyState(vdst);
        
        APPEND(&numVerts, sizeof(numVerts));
@@ -150,7 +165,6 @@ class AttribSetArray : public AttribSet {
    int create(void* vsrc) {
        char* src = (char*)vsrc;
 #define APPEND(value,amount) {memcpy((value),src,(amount)); src+=(amount);}
-       int size = 0;
        
        src += AttribSet::create(vsrc);
        APPEND(&numVerts, sizeof(numVerts));
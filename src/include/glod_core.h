@@ -90,6 +90,70 @@ class GLOD_Group;
 class GLOD_Cut;
 class GLOD_Object_Status ;
 
+/*
+ * The parts of an object that never change once it has been built. An
+ * object and every instance made from it point at the same copy, so
+ * instancing costs a reference rather than a duplicate table. Reference
+ * counted the same way as Hierarchy.
+ */
+class GLOD_ObjectShared
+{
+public:
+    HashTable* patch_id_map; // NOTE: the ids in this table are all +1 of their real because HashTable uses 0 as its "empty" value
+
+    GLuint* patch_names;     // patch index -> user patch name; built on first use
+
+    GLint* level_ranges;     // (index offset, count) per level and patch of
+                             // glodFillObjectBuffers' output; built on first use
+    GLint* level_bases;      // first vertex of each of those ranges
+    GLint buffer_sizes[2];   // indices, vertices in that output
+
+    GLOD_ObjectShared()
+    {
+        ref_count = 1;
+        patch_id_map = AllocHashtableBySize(PATCH_HASH_BUCKET_SIZE);
+        patch_names = NULL;
+        level_ranges = NULL;
+        level_bases = NULL;
+        buffer_sizes[0] = buffer_sizes[1] = 0;
+    }
+
+    // Only valid once the object is built, when the patch set is final.
+    GLuint patchName(int index)
+    {
+        if (patch_names == NULL)
+        {
+            patch_names = new GLuint[HashtableNumElements(patch_id_map)];
+            HASHTABLE_WALK(patch_id_map, node);
+            patch_names[node->data.uData.nValue - 1] = node->key - 1;
+            HASHTABLE_WALK_END(patch_id_map);
+        }
+        return patch_names[index];
+    }
+
+    void LockInstance() {
+        ref_count++;
+    }
+
+    void ReleaseInstance() {
+        ref_count--;
+        if(ref_count == 0) {
+            delete this;
+        }
+    }
+
+private:
+    ~GLOD_ObjectShared()
+    {
+        FreeHashtableCautious(patch_id_map); // the mappings are ints, not pointers
+        delete [] patch_names;
+        delete [] level_ranges;
+        delete [] level_bases;
+    }
+
+    int ref_count;
+};
+
 class GLOD_Object_Status
 {
 public:
@@ -124,13 +188,16 @@ public:
     // LockInstance/ReleaseInstance
 
     GLOD_Cut* cut;                 // Not a great word. Any better ideas?
-    int *inArea;
+    const float* attachedXform;    // app-owned matrix read on every adapt, or NULL
+    int *patchLevels;              // per-patch cut level after the last adapt
+    int *inArea;                   // only allocated with GLOD_USE_TILES
     //unsigned int numAreas;
     QueueMode queueMode;
     OperationType opType;
     float shareTolerance;
     int borderLock;
     int errorMetric;
+    int nodeLayout;
     float importance;
     SnapshotMode snapMode;
     float reductionPercent;
@@ -140,8 +207,11 @@ public:
     GLfloat *snapshotErrorSpecs;
     float pgPrecision;
     float quadricMultiplier;
+    int buildMicroseconds;         // time the build took, for GLOD_BUILD_TIME
+    GLuint buildError;             // raised during the build, reported after it
+    const char* buildErrorMessage;
     
-    HashTable* patch_id_map; // NOTE: the ids in this table are all +1 of their real because HashTable uses 0 as its "empty" value
+    GLOD_ObjectShared* shared;     // patch mappings; shared with instances
 
 
     HeapElement budgetCoarsenHeapData;
@@ -154,12 +224,16 @@ public:
         group = NULL;
         hierarchy = NULL;
         cut = NULL;
+        attachedXform = NULL;
+        patchLevels = NULL;
+        shared = NULL;
         prebuild_buffer = NULL;
         queueMode = Greedy;
         opType = Half_Edge_Collapse;
         shareTolerance = 0.0;
         borderLock = 0;
         errorMetric = GLOD_METRIC_SPHERES;
+        nodeLayout = GLOD_LAYOUT_DEPTH_FIRST;
         importance = 1.0;
         snapMode = PercentReduction;
         reductionPercent = 0.5;
@@ -167,8 +241,15 @@ public:
         snapshotTriSpecs = NULL;
         numSnapshotErrorSpecs = 0;
         snapshotErrorSpecs = NULL;
+#ifdef GLOD_USE_TILES
         inArea=new int[GLOD_NUM_TILES];
+#else
+        inArea=NULL;
+#endif
         quadricMultiplier=1;
+        buildMicroseconds=0;
+        buildError=GLOD_NO_ERROR;
+        buildErrorMessage=NULL;
         //numAreas=0;
         //budgetCoarsenHeapData = new HeapElement[GLOD_NUM_TILES](this);
         //budgetRefineHeapData = new HeapElement[GLOD_NUM_TILES](this);
@@ -199,6 +280,8 @@ public:
 
 #include "glod_group.h"
 
+double GLOD_GetMicroseconds();
+
 static void inline GLOD_SetError(int num, const char* message) {
 #ifdef DEBUG
     fprintf(stderr, "GLOD: %s.\n", message);
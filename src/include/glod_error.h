@@ -28,6 +28,7 @@ protected:
     float error;
 public:
     GLOD_Error() {error=0;};
+    virtual ~GLOD_Error() {};
     virtual float calculateError(Model *model, Operation *op) = 0;
     virtual xbsVertex *genVertex(Model *model, xbsVertex *v1, xbsVertex *v2, Operation *op,
                                  int forceGen) = 0;
@@ -20,8 +20,6 @@
 
 #define GLOD_BUILD_WITH_VBO
 
-static inline bool glodHasVBO();
-
 /******************************************************************************/
 
 #ifdef _WIN32
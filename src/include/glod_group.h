@@ -20,6 +20,20 @@
 
 //#define GLOD_USE_TILES
 
+// What the most recent adapt() did. Filled in on every adapt; the cost is
+// a timer read and a pass over the objects.
+typedef struct {
+    int microseconds;
+    int iterations;      // budget loop passes, or objects visited
+    int coarsenOps;
+    int refineOps;
+    int heapOps;         // coarsen/refine queue operations
+    int errorEvals;      // screen-space error computations
+    int objectsTouched;  // objects whose triangle count changed
+    int trisBefore;
+    int trisAfter;
+} GLOD_AdaptStats;
+
 class GLOD_Group
 {
 private:
@@ -42,12 +56,23 @@ private:
 	std::vector<GLOD_Object_Status> RefinedStatusList[2] ;
 	std::vector<GLOD_Object_Status> CoarsenedStatusList[2] ;
 
+    // (object name, patch name, triangle count) for every patch whose
+    // level changed in the last commit()
+    std::vector<GLuint> changedPatches;
+
+    // when set, adapt() leaves the new cuts unpublished until commit()
+    bool deferCommit;
+
+    GLOD_AdaptStats stats;
+    std::vector<int> trisBefore; // per object, scratch for stats
+
 private:
     void adaptErrorThreshold();
     void adaptTriangleBudget();
     void initQueues();
     void clearQueues();
 	bool isEndlessLoop() ;
+    void recordChanges();
     
     //
     // triangle budget mode stuff
@@ -93,6 +118,8 @@ public:
         coarsenQueue = new Heap;
         //currentNumTris = 0;
         viewFrustumSimp = true;
+        deferCommit = false;
+        memset(&stats, 0, sizeof(stats));
 #ifndef GLOD_USE_TILES
         currentNumTris=0;
         triBudget=1000;
@@ -149,15 +176,18 @@ public:
             currentNumTris[i]=0;
         }
         for (int i=0; i<numObjects; i++){
-            delete objects[i]->inArea;
+            delete [] objects[i]->inArea;
             objects[i]->inArea=new int[GLOD_NUM_TILES];
         }
+        // the tiles bound the screen-space error, so VDS errors go stale
+        mpSimplifier->InvalidateNodeErrors();
 #endif
     }
     
     int getNumObjects() { return numObjects; }
     GLOD_Object* getObject(int index) { return objects[index];}
     void addObject(GLOD_Object*);
+    void reserveObjects(int count);
     void removeObject(int index);
     
     void setTriBudget(int budget)
@@ -181,6 +211,8 @@ public:
         errorMode = mode;
         if (mpSimplifier != NULL)
         {
+            // a new error function makes every queued VDS error stale
+            mpSimplifier->InvalidateNodeErrors();
             switch (errorMode)
             {
             case ObjectSpace:
@@ -206,8 +238,18 @@ public:
     {
         objectSpaceErrorThreshold = threshold;
     }
+    void setErrorUpdateTolerance(float tolerance)
+    {
+        mpSimplifier->mErrorUpdateTolerance = tolerance;
+    }
     
     void adapt();
+    void commit();
+    void setDeferCommit(bool defer) { deferCommit = defer; }
+    
+    const GLOD_AdaptStats& getStats() { return stats; }
+    int getNumChangedPatches() { return changedPatches.size() / 3; }
+    const GLuint* getChangedPatches() { return &changedPatches[0]; }
     
     AdaptMode GetAdaptMode() { return adaptMode; }
     ErrorMode GetErrorMode() { return errorMode; }
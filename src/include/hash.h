@@ -3,7 +3,7 @@
  *
  * See the file LICENSE.txt for information on redistributing this software.
  */
-/* Stolen from CR at the moment */
+/* Originally stolen from CR; now an open-addressing table. */
 
 #ifndef HASH_H
 #define HASH_H
@@ -12,7 +12,9 @@
 extern "C" {
 #endif
 
-#define HASH_DEFAULT_NUM_BUCKETS 1047
+/* Initial slot count for AllocHashtable. Tables grow on demand, so this is
+ * only a starting point; it is rounded up to a power of two. */
+#define HASH_DEFAULT_NUM_BUCKETS 64
 
 
 typedef struct HashData
@@ -32,39 +34,58 @@ typedef struct HashData
 
 } HashData;
 
+/* One slot of the table. Slots live in a single flat array and are probed
+ * linearly, so a lookup touches a handful of adjacent slots rather than
+ * chasing a list of separately malloc'd nodes. */
 typedef struct HashNode {
         unsigned int key;
+        unsigned int used;
         HashData data;
-        struct HashNode *next;
 } HashNode;
 
 typedef struct HashTable {
-        unsigned int num_buckets;
+        unsigned int num_buckets;   /* slot count, always a power of two */
+        unsigned int hash_shift;    /* 32 - log2(num_buckets) */
         unsigned int num_elements;
-        HashNode **buckets;
+        HashNode *buckets;
 } HashTable;
 
+/* Walks the occupied slots of a table. The table must not be modified
+ * while an iteration is in progress. */
+typedef struct HashIterator {
+        HashTable *h;
+        unsigned int slot;
+} HashIterator;
+
 HashTable *AllocHashtable( void );
 HashTable *AllocHashtableBySize( int num_buckets );
 void FreeHashtable( HashTable *hash );
 void FreeHashtableCautious ( HashTable *hash ); // does not free data pointer
 void HashtableAddData( HashTable *h, unsigned int key, HashData *data );
-void HashtableAddPtr( HashTable *h, unsigned int key, void *data );
+/* Adding a key that is already present replaces its value. The pointer it
+ * held, if any, is returned and is not freed; the caller owns it. */
+void *HashtableAddPtr( HashTable *h, unsigned int key, void *data );
 void HashtableAddInt( HashTable *h, unsigned int key, int data );
 void HashtableDelete( HashTable *h, unsigned int key );
 void HashtableDeleteCautious( HashTable *h, unsigned int key);
 void *HashtableSearchPtr( HashTable *h, unsigned int key );
 int HashtableSearchInt(HashTable* h, unsigned int key);
+HashNode *HashtableSearchNode( HashTable *h, unsigned int key );
 
 bool HashtableKeyExists( HashTable *h, unsigned int key );
 
 unsigned int HashtableNumElements( HashTable *h) ;
 
+void HashtableReserve( HashTable *h, unsigned int num_elements );
+
+HashNode *HashtableIterFirst( HashTable *h, HashIterator *it );
+HashNode *HashtableIterNext( HashIterator *it );
+
 #define HASHTABLE_WALK( h, t ) {         \
   HashNode *t;                            \
-  int _;                                        \
-  for (_ = 0 ; _ < h->num_buckets ; _++) {  \
-    for (t = h->buckets[_] ; t; t = t->next)   {
+  HashIterator _it;                             \
+  for (t = HashtableIterFirst(h, &_it); t; t = HashtableIterNext(&_it)) {  \
+    {
 
 
 #define HASHTABLE_WALK_END( h )          \
@@ -73,13 +94,8 @@ unsigned int HashtableNumElements( HashTable *h) ;
 }
 
 #define HASHTABLE_FIRST_NODE( h, t ) \
-   HashNode *t = NULL; \
-   int _; \
-   for (_ = 0 ; _ < h->num_buckets ; _++) {  \
-		if(h->buckets[_] != NULL)	    \
-			break; \
-   } \
-   t = h->buckets[_];
+   HashIterator _it; \
+   HashNode *t = HashtableIterFirst(h, &_it);
 
 
 #ifdef __cplusplus
@@ -28,4 +28,6 @@ VDS::Float StdErrorScreenSpaceNoFrustum(VDS::BudgetItem *pItem, const VDS::Cut *
 VDS::Float StdErrorObjectSpace(VDS::BudgetItem *pItem, const VDS::Cut *pCut);
 VDS::Float StdErrorObjectSpaceNoFrustum(VDS::BudgetItem *pItem, const VDS::Cut *pCut);
 
+void ClientMemoryRenderCallback(VDS::Renderer &renderer, VDS::PatchIndex PatchID);
+
 #endif // #ifndef VDS_CALLBACKS
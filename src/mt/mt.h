@@ -22,6 +22,8 @@
 #include <stdio.h>
 #include <math.h>
 #include <ply.h>
+#include <queue>
+#include <vector>
 
 #if !defined(_WIN32) && !defined(__APPLE__)
 #include <values.h>
@@ -44,6 +46,14 @@ enum mtDimension {MT_X=0, MT_Y=1, MT_Z=2};
 
 #define MAX_POINT_SIZE  20
 
+/* FIFO post-transform vertex cache size assumed by mtArc::orderTris() */
+#define MT_CACHE_SIZE   16
+
+/* vertex attributes, as returned by mtVertex::getFormat() */
+#define MT_VERTEX_NORMAL    0x1
+#define MT_VERTEX_COLOR     0x2
+#define MT_VERTEX_TEXCOORD  0x4
+
 class mtVec3
 {
   public:
@@ -431,6 +441,7 @@ class mtVertex
     {
 	coord = crd;
     };
+    virtual ~mtVertex() {};
     mtVertex &operator = (const mtVertex &v)
     {
 	coord = v.coord;
@@ -446,8 +457,20 @@ class mtVertex
         coord.print();
     };
     virtual int size() const { return sizeof(mtVertex); };
+    virtual mtVec3  *getNormal()   { return NULL; };
+    virtual mtColor *getColor()    { return NULL; };
+    virtual mtVec2  *getTexcoord() { return NULL; };
+    int getFormat()
+    {
+	return ((getNormal() ? MT_VERTEX_NORMAL : 0) |
+		(getColor() ? MT_VERTEX_COLOR : 0) |
+		(getTexcoord() ? MT_VERTEX_TEXCOORD : 0));
+    };
+    static mtVertex *makeFormat(int format);
     virtual mtVertex *makeNew() const { return new mtVertex; };
     virtual mtVertex *makeNew(int num) const { return new mtVertex[num]; };
+    // frees an array from makeNew(num), with the subclass's element size
+    virtual void deleteArray() { delete [] this; };
     virtual void copySame(mtVertex *destVert) const 
     { 
 	*((mtVertex *)(destVert)) = *this;
@@ -491,8 +514,10 @@ class mtNVertex : public mtVertex
 	normal.print();
     };
     virtual int size() const { return sizeof(mtNVertex); };
+    virtual mtVec3 *getNormal() { return &normal; };
     virtual mtVertex *makeNew() const { return new mtNVertex; };
     virtual mtVertex *makeNew(int num) const { return new mtNVertex[num]; };
+    virtual void deleteArray() { delete [] this; };
     virtual void copySame(mtVertex *destVert) const 
     { 
 	*((mtNVertex *)(destVert)) = *this;
@@ -528,8 +553,10 @@ class mtTVertex : public mtVertex
 	texcoord.print();
     };
     virtual int size() const { return sizeof(mtTVertex); };
+    virtual mtVec2 *getTexcoord() { return &texcoord; };
     virtual mtVertex *makeNew() const { return new mtTVertex; };
     virtual mtVertex *makeNew(int num) const { return new mtTVertex[num]; };
+    virtual void deleteArray() { delete [] this; };
     virtual void copySame(mtVertex *destVert) const 
     { 
 	*((mtTVertex *)(destVert)) = *this;
@@ -565,8 +592,10 @@ class mtCVertex : public mtVertex
 	color.print();
     };
     virtual int size() const { return sizeof(mtCVertex); };
+    virtual mtColor *getColor() { return &color; };
     virtual mtVertex *makeNew() const { return new mtCVertex; };
     virtual mtVertex *makeNew(int num) const { return new mtCVertex[num]; };
+    virtual void deleteArray() { delete [] this; };
     virtual void copySame(mtVertex *destVert) const 
     { 
 	*((mtCVertex *)(destVert)) = *this;
@@ -609,8 +638,11 @@ class mtCNVertex : public mtVertex
 	normal.print();
     };
     virtual int size() const { return sizeof(mtCNVertex); };
+    virtual mtVec3  *getNormal() { return &normal; };
+    virtual mtColor *getColor()  { return &color; };
     virtual mtVertex *makeNew() const { return new mtCNVertex; };
     virtual mtVertex *makeNew(int num) const { return new mtCNVertex[num]; };
+    virtual void deleteArray() { delete [] this; };
     virtual void copySame(mtVertex *destVert) const 
     { 
 	*((mtCNVertex *)(destVert)) = *this;
@@ -653,8 +685,11 @@ class mtCTVertex : public mtVertex
 	texcoord.print();
     };
     virtual int size() const { return sizeof(mtCTVertex); };
+    virtual mtColor *getColor()    { return &color; };
+    virtual mtVec2  *getTexcoord() { return &texcoord; };
     virtual mtVertex *makeNew() const { return new mtCTVertex; };
     virtual mtVertex *makeNew(int num) const { return new mtCTVertex[num]; };
+    virtual void deleteArray() { delete [] this; };
     virtual void copySame(mtVertex *destVert) const 
     { 
 	*((mtCTVertex *)(destVert)) = *this;
@@ -697,8 +732,11 @@ class mtNTVertex : public mtVertex
 	texcoord.print();
     };
     virtual int size() const { return sizeof(mtNTVertex); };
+    virtual mtVec3 *getNormal()   { return &normal; };
+    virtual mtVec2 *getTexcoord() { return &texcoord; };
     virtual mtVertex *makeNew() const { return new mtNTVertex; };
     virtual mtVertex *makeNew(int num) const { return new mtNTVertex[num]; };
+    virtual void deleteArray() { delete [] this; };
     virtual void copySame(mtVertex *destVert) const 
     { 
 	*((mtNTVertex *)(destVert)) = *this;
@@ -746,8 +784,12 @@ class mtCNTVertex : public mtVertex
 	texcoord.print();
     };
     virtual int size() const { return sizeof(mtCNTVertex); };
+    virtual mtVec3  *getNormal()   { return &normal; };
+    virtual mtColor *getColor()    { return &color; };
+    virtual mtVec2  *getTexcoord() { return &texcoord; };
     virtual mtVertex *makeNew() const { return new mtCNTVertex; };
     virtual mtVertex *makeNew(int num) const { return new mtCNTVertex[num]; };
+    virtual void deleteArray() { delete [] this; };
     virtual void copySame(mtVertex *destVert) const 
     { 
 	*((mtCNTVertex *)(destVert)) = *this;
@@ -871,6 +913,7 @@ class mtArc
 	numPoints = 0;
 	patchNumber = 0;
 	borderFlag = 0;
+	radius = 0.0;
     };
     mtArc(int tri)
     {
@@ -882,6 +925,7 @@ class mtArc
 	numPoints = 0;
 	patchNumber = 0;
 	borderFlag = 0;
+	radius = 0.0;
     }
     
     void setStart(int s) { start = s; };
@@ -905,12 +949,20 @@ class mtArc
     mtReal getError(MT *mt, mtCut *cut, float *ret_d=NULL);
     void computeSPH(MT *mt);
     void makeStrips(MT *mt);
+    void orderTris(MT *mt, int cacheSize=MT_CACHE_SIZE);
     int  getFrame() { return frameno; }
     void setPatchNumber(int patchNum) { patchNumber=patchNum; };
     int  getPatchNumber() const { return patchNumber; };
+    mtReal getRadius() const { return radius; };
+    const mtVec3 &getCenter() const { return center; };
     void setBorder() { borderFlag = 1; };
     void clearBorder() { borderFlag = 0; };
     char isBorder() const { return borderFlag; };
+
+    // binary form, see MT::writeBinaryMTToBuffer()
+    int   getBinarySize() const;
+    char *writeBinary(char *dst) const;
+    char *readBinary(char *src, char *bufferEnd); // NULL if it runs past
 };
 
 class mtNode
@@ -963,6 +1015,11 @@ class mtNode
     int getNumChildren() { return numChildren; };
     int getParent(int i) { return parents[i]; };
     int getChild(int i)  { return children[i]; };
+
+    // binary form, see MT::writeBinaryMTToBuffer()
+    int   getBinarySize() const;
+    char *writeBinary(char *dst) const;
+    char *readBinary(char *src, char *end); // NULL if it runs past end
 };
 
 class mtView
@@ -1059,6 +1116,35 @@ class mtCut
     void raiseErrorCut(MT *mt, mtReal error);
     void lowerErrorCut(MT *mt, mtReal error);
 
+    // Triangle budget adaptation. The refine queue holds the nodes just
+    // below the cut, keyed by the largest error of their arcs on the cut;
+    // the coarsen queue holds the nodes just above it whose children are
+    // all below, keyed by the error their parent arcs would bring back.
+    // Entries are checked when they reach the top, so nodes that have
+    // moved or changed keys since they were queued are simply skipped.
+    struct QueueEntry
+    {
+	mtReal key;
+	int    node;
+	bool operator < (const QueueEntry &e) const { return key < e.key; };
+    };
+    struct BudgetQueue : public std::priority_queue<QueueEntry>
+    {
+	// the queued entries, in heap order
+	std::vector<QueueEntry> &entries() { return c; };
+    };
+    BudgetQueue refineQueue;   // largest error first
+    BudgetQueue coarsenQueue;  // key negated
+    char   *nodeRekeyed;   // marks for rekeyBudget(), cleared after use
+    int     numTris;       // maintained by the budget adaptation
+
+    int  getFrontierError(MT *mt, int nodeID, mtReal *error);
+    int  getRaisedTris(MT *mt, int nodeID);
+    void queueRefine(MT *mt, int nodeID);
+    void queueCoarsen(MT *mt, int nodeID);
+    void raiseBudgetNode(MT *mt, int nodeID);
+    void lowerBudgetNode(MT *mt, int nodeID);
+
   public:
     char    dumpMode;
     char    errorMode;
@@ -1072,12 +1158,44 @@ class mtCut
 	arcs = NULL;
 	depths = NULL;
 	nodeAboveCut = NULL;
+	nodeRekeyed = NULL;
 	dumpMode = 0;
 	errorMode = OBJERROR;
 	renderMode = 0;
+	numTris = 0;
+    };
+    virtual ~mtCut()
+    {
+	delete [] arcs;
+	delete [] depths;
+	delete [] nodeAboveCut;
+	delete [] nodeRekeyed;
     };
     void newErrorCut(MT *mt, mtReal error);
     void adaptErrorCut(MT *mt, mtReal error);
+
+    // error of an arc on the cut; by default arc->getError() under
+    // errorMode and the cut's view
+    virtual mtReal getArcError(MT *mt, int arcID);
+
+    // Budget-driven adaptation: start from the coarsest cut, then move
+    // single nodes across the cut, greatest error first, until the cut
+    // reaches the triangle or error limit. resetBudget() rebuilds the
+    // queues from every node and must be called when the cut was moved by
+    // the error-threshold calls. rekeyBudget() only requeues the nodes
+    // already queued, under their current keys, and is enough when arc
+    // errors change (a new view in screen space) but the cut did not move.
+    void newBudgetCut(MT *mt);
+    void resetBudget(MT *mt);
+    void rekeyBudget(MT *mt);
+    void refineBudget(MT *mt, int triLimit, mtReal errorLimit);
+    void coarsenBudget(MT *mt, int triLimit, mtReal errorLimit);
+    int refineTop(MT *mt, mtReal *error);   // next node to raise, or -1
+    int coarsenTop(MT *mt, mtReal *error);  // next node to lower, or -1
+    mtReal getRefineError(MT *mt);  // largest error on the cut, 0 if none
+    mtReal getCoarsenError(MT *mt); // MAXFLOAT if at the root
+    int getRefineTris(MT *mt);      // MAXINT if fully refined
+    int getBudgetTris() const { return numTris; };
     int getNumArcs() const {return numArcs;};
     int getNumTris(MT *mt) const;
     int *getArc(int arcno) { return &arcs[arcno]; }
@@ -1181,6 +1299,7 @@ class MT
         }
 	retainedMode = 0;
 	numPatches = 1;
+	bvnodes = NULL;
     };
 	        
     void setOtherElements(PlyOtherElems *other_elements)
@@ -1246,6 +1365,15 @@ class MT
     void cachePoint(mtPoint *pt, int pointSize);
     void enableRetainedMode() { retainedMode = 1; };
     int getNumPatches() const { return numPatches; };
+    void countPatches();
+    void orderArcTris(int cacheSize=MT_CACHE_SIZE);
+
+    // Flat binary copy of the whole MT, vertices through bounding volume
+    // hierarchy, for hierarchy readback and load. Strips, display lists
+    // and cuts are not part of it and must be rebuilt after a load.
+    int  getBinaryMTSize();
+    void writeBinaryMTToBuffer(char *dst);
+    int  readBinaryMTFromBuffer(char *src); // returns 0 on fail
 };
 
 /* Protection from multiple includes. */
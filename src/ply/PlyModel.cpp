@@ -0,0 +1,514 @@
+/******************************************************************************
+ * Copyright 2003 Jonathan Cohen, Nat Duca, David Luebke, Brenden Schubert    *
+ *                Johns Hopkins University and University of Virginia         *
+ ******************************************************************************
+ * This file is distributed as part of the GLOD library, and as such, falls   *
+ * under the terms of the GLOD public license. GLOD is distributed without    *
+ * any warranty, implied or otherwise. See the GLOD license for more details. *
+ *                                                                            *
+ * You should have recieved a copy of the GLOD Open-Source License with this  *
+ * copy of GLOD; if not, please visit the GLOD web page,                      *
+ * http://www.cs.jhu.edu/~graphics/GLOD/license for more information          *
+ ******************************************************************************/
+/* PLY model loading for the samples and tools
+ ****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <float.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#include "glod.h"
+#include "PlyModel.h"
+
+/***************************************************************************/
+// the properties read_plyfile understands; the file decides which of them
+// are there, so the external types here are only placeholders
+
+static PlyProperty vert_props[] = {
+    {(char*) "x", PLY_FLOAT, PLY_FLOAT, offsetof(Vertex,coord[0]), 0, 0, 0, 0},
+    {(char*) "y", PLY_FLOAT, PLY_FLOAT, offsetof(Vertex,coord[1]), 0, 0, 0, 0},
+    {(char*) "z", PLY_FLOAT, PLY_FLOAT, offsetof(Vertex,coord[2]), 0, 0, 0, 0},
+    {(char*) "nx", PLY_FLOAT, PLY_FLOAT, offsetof(Vertex,normal[0]), 0, 0, 0, 0},
+    {(char*) "ny", PLY_FLOAT, PLY_FLOAT, offsetof(Vertex,normal[1]), 0, 0, 0, 0},
+    {(char*) "nz", PLY_FLOAT, PLY_FLOAT, offsetof(Vertex,normal[2]), 0, 0, 0, 0},
+    {(char*) "red", PLY_UCHAR, PLY_UCHAR, offsetof(Vertex,color[0]), 0, 0, 0, 0},
+    {(char*) "green", PLY_UCHAR, PLY_UCHAR, offsetof(Vertex,color[1]), 0, 0, 0, 0},
+    {(char*) "blue", PLY_UCHAR, PLY_UCHAR, offsetof(Vertex,color[2]), 0, 0, 0, 0},
+    {(char*) "alpha", PLY_UCHAR, PLY_UCHAR, offsetof(Vertex,color[3]), 0, 0, 0, 0},
+    {(char*) "u", PLY_FLOAT, PLY_FLOAT, offsetof(Vertex,texcoord[0]), 0, 0, 0, 0},
+    {(char*) "v", PLY_FLOAT, PLY_FLOAT, offsetof(Vertex,texcoord[1]), 0, 0, 0, 0},
+    {(char*) "s", PLY_FLOAT, PLY_FLOAT, offsetof(Vertex,texcoord[0]), 0, 0, 0, 0},
+    {(char*) "t", PLY_FLOAT, PLY_FLOAT, offsetof(Vertex,texcoord[1]), 0, 0, 0, 0},
+};
+enum { VP_X = 0, VP_NX = 3, VP_RED = 6, VP_ALPHA = 9, VP_U = 10, VP_S = 12 };
+
+static PlyProperty face_props[] = {
+    {(char*) "vertex_indices", PLY_INT, PLY_INT, offsetof(Face,verts),
+     1, PLY_UCHAR, PLY_INT, offsetof(Face,nverts)},
+    {(char*) "vertex_index", PLY_INT, PLY_INT, offsetof(Face,verts),
+     1, PLY_UCHAR, PLY_INT, offsetof(Face,nverts)},
+    {(char*) "patch_num", PLY_INT, PLY_INT, offsetof(Face,patch_num), 0, 0, 0, 0},
+};
+
+static char s_VertexName[] = "vertex";
+static char s_FaceName[] = "face";
+
+static int HasProperties(PlyFile *ply, char *elem_name, PlyProperty *props, int nprops)
+{
+    int i;
+    for(i = 0; i < nprops; i++)
+        if(ply_get_property(ply, elem_name, &props[i]) != PLY_OKAY)
+            return 0;
+    return 1;
+}
+
+static bool HasElement(int nelems, char **elem_names, const char *name)
+{
+    int i;
+    for(i = 0; i < nelems; i++)
+        if(strcmp(elem_names[i], name) == 0)
+            return true;
+    return false;
+}
+
+/***************************************************************************/
+// Splits the faces into triangle fans, one index list per patch.  Patch
+// numbers are compacted to 0..npatches-1 (in increasing order) and the
+// faces are renumbered to match.
+static int BuildPatches(PlyModel *model)
+{
+    int i, j, p;
+    int max_patch = 0;
+    int *tris_per_patch;
+    int *patch_ids;
+    int *filled;
+
+    for(i = 0; i < model->nfaces; i++) {
+        Face *f = &model->flist[i];
+        if(f->patch_num < 0) {
+            fprintf(stderr, "read_plyfile: face %i has negative patch %i\n", i, f->patch_num);
+            return PLY_ERROR;
+        }
+        if(f->patch_num > max_patch)
+            max_patch = f->patch_num;
+        for(j = 0; j < f->nverts; j++)
+            if(f->verts[j] < 0 || f->verts[j] >= model->nverts) {
+                fprintf(stderr, "read_plyfile: face %i uses missing vertex %i\n", i, f->verts[j]);
+                return PLY_ERROR;
+            }
+    }
+
+    tris_per_patch = (int*) calloc(max_patch + 1, sizeof(int));
+    patch_ids = (int*) malloc((max_patch + 1) * sizeof(int));
+    for(i = 0; i < model->nfaces; i++)
+        if(model->flist[i].nverts >= 3)
+            tris_per_patch[model->flist[i].patch_num] += model->flist[i].nverts - 2;
+
+    model->npatches = 0;
+    for(p = 0; p <= max_patch; p++)
+        patch_ids[p] = (tris_per_patch[p] > 0) ? model->npatches++ : -1;
+
+    model->plist = (PatchList*) calloc(model->npatches > 0 ? model->npatches : 1, sizeof(PatchList));
+    filled = (int*) calloc(model->npatches > 0 ? model->npatches : 1, sizeof(int));
+    for(p = 0; p <= max_patch; p++) {
+        if(patch_ids[p] < 0)
+            continue;
+        PatchList *patch = &model->plist[patch_ids[p]];
+        patch->nindices = 3 * tris_per_patch[p];
+        patch->indices = (unsigned int*) malloc(patch->nindices * sizeof(unsigned int));
+    }
+
+    for(i = 0; i < model->nfaces; i++) {
+        Face *f = &model->flist[i];
+        p = patch_ids[f->patch_num];
+        f->patch_num = (p >= 0) ? p : 0;
+        if(f->nverts < 3)
+            continue;
+        unsigned int *idx = model->plist[p].indices + filled[p];
+        for(j = 2; j < f->nverts; j++) {
+            *idx++ = f->verts[0];
+            *idx++ = f->verts[j-1];
+            *idx++ = f->verts[j];
+        }
+        filled[p] += 3 * (f->nverts - 2);
+    }
+
+    free(filled);
+    free(patch_ids);
+    free(tris_per_patch);
+    return PLY_OKAY;
+}
+
+int read_plyfile(char *filename, PlyModel *model)
+{
+    return read_plyfile_threads(filename, model, 0);
+}
+
+int read_plyfile_threads(char *filename, PlyModel *model, int num_threads)
+{
+    PlyFile *ply;
+    int nelems, file_type;
+    char **elem_names;
+    float version;
+    int i, j;
+
+    memset(model, 0, sizeof(PlyModel));
+    model->solid_color[0] = model->solid_color[1] = model->solid_color[2] = 200;
+    model->solid_color[3] = 255;
+
+    ply = ply_open_for_reading(filename, &nelems, &elem_names, &file_type, &version);
+    if(ply == NULL) {
+        fprintf(stderr, "read_plyfile: could not read %s\n", filename);
+        return PLY_ERROR;
+    }
+    if(! HasElement(nelems, elem_names, "vertex") ||
+       ! HasProperties(ply, s_VertexName, &vert_props[VP_X], 3)) {
+        fprintf(stderr, "read_plyfile: %s has no vertex positions\n", filename);
+        goto error;
+    }
+
+    // vertices
+    model->has_vertex_normals = HasProperties(ply, s_VertexName, &vert_props[VP_NX], 3);
+    model->has_vertex_colors = HasProperties(ply, s_VertexName, &vert_props[VP_RED], 3);
+    HasProperties(ply, s_VertexName, &vert_props[VP_ALPHA], 1);
+    model->has_texcoords = HasProperties(ply, s_VertexName, &vert_props[VP_U], 2) ||
+                           HasProperties(ply, s_VertexName, &vert_props[VP_S], 2);
+    ply_get_element_setup(ply, s_VertexName, 0, NULL);
+
+    model->nverts = ply->which_elem->num;
+    model->vlist = (Vertex*) calloc(model->nverts > 0 ? model->nverts : 1, sizeof(Vertex));
+    if(model->vlist == NULL ||
+       ply_get_elements(ply, model->vlist, sizeof(Vertex), num_threads, NULL) == PLY_ERROR)
+        goto error;
+
+    // faces
+    if(HasElement(nelems, elem_names, "face")) {
+        if(! HasProperties(ply, s_FaceName, &face_props[0], 1) &&
+           ! HasProperties(ply, s_FaceName, &face_props[1], 1)) {
+            fprintf(stderr, "read_plyfile: %s has faces without vertex indices\n", filename);
+            goto error;
+        }
+        HasProperties(ply, s_FaceName, &face_props[2], 1);
+        ply_get_element_setup(ply, s_FaceName, 0, NULL);
+
+        model->nfaces = ply->which_elem->num;
+        model->flist = (Face*) calloc(model->nfaces > 0 ? model->nfaces : 1, sizeof(Face));
+        if(model->flist == NULL ||
+           ply_get_elements(ply, model->flist, sizeof(Face), num_threads, &model->face_lists) == PLY_ERROR)
+            goto error;
+    }
+
+    free(elem_names);
+    ply_close(ply);
+
+    // bounds, and the defaults for what the file doesn't have
+    for(j = 0; j < 3; j++) {
+        model->min[j] = FLT_MAX;
+        model->max[j] = -FLT_MAX;
+    }
+    for(i = 0; i < model->nverts; i++) {
+        Vertex *v = &model->vlist[i];
+        for(j = 0; j < 3; j++) {
+            if(v->coord[j] < model->min[j]) model->min[j] = v->coord[j];
+            if(v->coord[j] > model->max[j]) model->max[j] = v->coord[j];
+        }
+        if(! model->has_vertex_colors) {
+            v->color[0] = model->solid_color[0];
+            v->color[1] = model->solid_color[1];
+            v->color[2] = model->solid_color[2];
+        }
+        if(v->color[3] == 0)
+            v->color[3] = 255;
+    }
+    if(model->nverts == 0)
+        for(j = 0; j < 3; j++)
+            model->min[j] = model->max[j] = 0;
+
+    if(BuildPatches(model) != PLY_OKAY) {
+        DeleteModel(model);
+        return PLY_ERROR;
+    }
+    return PLY_OKAY;
+
+error:
+    free(elem_names);
+    ply_close(ply);
+    DeleteModel(model);
+    return PLY_ERROR;
+}
+
+void DeleteModel(PlyModel *model)
+{
+    int i;
+
+    if(model->has_texture)
+        glDeleteTextures(1, (GLuint*) &model->texture_id);
+    for(i = 0; i < model->npatches; i++) {
+        free(model->plist[i].indices);
+        free(model->plist[i].va);
+    }
+    free(model->plist);
+    ply_free_lists(model->face_lists);
+    free(model->flist);
+    free(model->vlist);
+    memset(model, 0, sizeof(PlyModel));
+}
+
+/***************************************************************************/
+float CenterOnOrigin(PlyModel *model)
+{
+    float center[3], diag = 0;
+    int i, j;
+
+    for(j = 0; j < 3; j++) {
+        center[j] = (model->min[j] + model->max[j]) * .5f;
+        model->min[j] -= center[j];
+        model->max[j] -= center[j];
+        diag += (model->max[j] - model->min[j]) * (model->max[j] - model->min[j]);
+    }
+    for(i = 0; i < model->nverts; i++)
+        for(j = 0; j < 3; j++)
+            model->vlist[i].coord[j] -= center[j];
+    return (float) sqrt(diag);
+}
+
+// area-weighted face normals, summed at each vertex
+void ComputeVertexNormals(PlyModel *model, int inv)
+{
+    int i, j, k;
+    float sign = inv ? -1.0f : 1.0f;
+
+    for(i = 0; i < model->nverts; i++)
+        for(k = 0; k < 3; k++)
+            model->vlist[i].normal[k] = 0;
+
+    for(i = 0; i < model->nfaces; i++) {
+        Face *f = &model->flist[i];
+        if(f->nverts < 3)
+            continue;
+        float *a = model->vlist[f->verts[0]].coord;
+        for(j = 2; j < f->nverts; j++) {
+            float *b = model->vlist[f->verts[j-1]].coord;
+            float *c = model->vlist[f->verts[j]].coord;
+            float ab[3], ac[3], n[3];
+            for(k = 0; k < 3; k++) {
+                ab[k] = b[k] - a[k];
+                ac[k] = c[k] - a[k];
+            }
+            n[0] = ab[1]*ac[2] - ab[2]*ac[1];
+            n[1] = ab[2]*ac[0] - ab[0]*ac[2];
+            n[2] = ab[0]*ac[1] - ab[1]*ac[0];
+            for(k = 0; k < 3; k++) {
+                model->vlist[f->verts[0]].normal[k] += n[k];
+                model->vlist[f->verts[j-1]].normal[k] += n[k];
+                model->vlist[f->verts[j]].normal[k] += n[k];
+            }
+        }
+    }
+
+    for(i = 0; i < model->nverts; i++) {
+        float *n = model->vlist[i].normal;
+        float len = (float) sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        if(len > 0)
+            for(k = 0; k < 3; k++)
+                n[k] *= sign / len;
+    }
+    model->has_vertex_normals = 1;
+}
+
+void InvertVertexNormals(PlyModel *model)
+{
+    int i, k;
+    for(i = 0; i < model->nverts; i++)
+        for(k = 0; k < 3; k++)
+            model->vlist[i].normal[k] = -model->vlist[i].normal[k];
+}
+
+/***************************************************************************/
+void GetPatchVBO(PlyModel *model, int patch, glodVBO *pVBO)
+{
+    Vertex *base = model->vlist;
+    if(model->va_mode == VERTEX_ARRAY_ARRAYS)
+        base = model->plist[patch].va;
+
+    memset(pVBO, 0, sizeof(glodVBO));
+    pVBO->mV.p = base->coord;
+    pVBO->mV.size = 3;
+    pVBO->mV.type = GL_FLOAT;
+    pVBO->mV.stride = sizeof(Vertex);
+    if(model->has_vertex_normals) {
+        pVBO->mN.p = base->normal;
+        pVBO->mN.type = GL_FLOAT;
+        pVBO->mN.stride = sizeof(Vertex);
+    }
+    if(model->has_vertex_colors) {
+        pVBO->mC.p = base->color;
+        pVBO->mC.size = 3;
+        pVBO->mC.type = GL_UNSIGNED_BYTE;
+        pVBO->mC.stride = sizeof(Vertex);
+    }
+    if(model->has_texcoords) {
+        pVBO->mT.p = base->texcoord;
+        pVBO->mT.size = 2;
+        pVBO->mT.type = GL_FLOAT;
+        pVBO->mT.stride = sizeof(Vertex);
+    }
+}
+
+void SetupVertexArray(PlyModel *model, int mode)
+{
+    int i, j;
+
+    for(i = 0; i < model->npatches; i++) {
+        free(model->plist[i].va);
+        model->plist[i].va = NULL;
+    }
+    model->va_mode = mode;
+    if(mode != VERTEX_ARRAY_ARRAYS)
+        return; // the vertex list already is the shared array
+
+    for(i = 0; i < model->npatches; i++) {
+        PatchList *patch = &model->plist[i];
+        patch->va = (VertexArray*) malloc(patch->nindices * sizeof(VertexArray));
+        for(j = 0; j < patch->nindices; j++)
+            patch->va[j] = model->vlist[patch->indices[j]];
+    }
+}
+
+void BindVertexArray(PlyModel *model, int patch)
+{
+    glodVBO vbo;
+    GetPatchVBO(model, patch, &vbo);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(vbo.mV.size, vbo.mV.type, vbo.mV.stride, vbo.mV.p);
+    if(vbo.mN.p != NULL) {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(vbo.mN.type, vbo.mN.stride, vbo.mN.p);
+    } else
+        glDisableClientState(GL_NORMAL_ARRAY);
+    if(vbo.mC.p != NULL) {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(vbo.mC.size, vbo.mC.type, vbo.mC.stride, vbo.mC.p);
+    } else
+        glDisableClientState(GL_COLOR_ARRAY);
+    if(vbo.mT.p != NULL) {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(vbo.mT.size, vbo.mT.type, vbo.mT.stride, vbo.mT.p);
+    } else
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
+void DrawModelVA(PlyModel *model, int patch)
+{
+    PatchList *p = &model->plist[patch];
+    if(model->va_mode == VERTEX_ARRAY_ARRAYS)
+        glDrawArrays(GL_TRIANGLES, 0, p->nindices);
+    else
+        glDrawElements(GL_TRIANGLES, p->nindices, GL_UNSIGNED_INT, p->indices);
+}
+
+/***************************************************************************/
+// Reads a binary (P6) or ascii (P3) PPM with a maxval of 255 at most.
+static unsigned char *ReadPPM(const char *filename, int *width, int *height)
+{
+    FILE *fp = fopen(filename, "rb");
+    char magic[3] = {0, 0, 0};
+    int header[3], i, c, maxval;
+    unsigned char *pixels;
+
+    if(fp == NULL)
+        return NULL;
+    if(fread(magic, 1, 2, fp) != 2 || magic[0] != 'P' || (magic[1] != '6' && magic[1] != '3')) {
+        fclose(fp);
+        return NULL;
+    }
+    for(i = 0; i < 3; i++) {
+        // skip white space and comments
+        while((c = fgetc(fp)) != EOF) {
+            if(c == '#')
+                while((c = fgetc(fp)) != EOF && c != '\n')
+                    ;
+            else if(c != ' ' && c != '\t' && c != '\r' && c != '\n')
+                break;
+        }
+        ungetc(c, fp);
+        if(fscanf(fp, "%d", &header[i]) != 1) {
+            fclose(fp);
+            return NULL;
+        }
+    }
+    *width = header[0]; *height = header[1]; maxval = header[2];
+    if(*width <= 0 || *height <= 0 || maxval <= 0 || maxval > 255) {
+        fclose(fp);
+        return NULL;
+    }
+    fgetc(fp); // the single white space after maxval
+
+    pixels = (unsigned char*) malloc(*width * *height * 3);
+    if(magic[1] == '6') {
+        if(fread(pixels, 3, *width * *height, fp) != (size_t) (*width * *height)) {
+            free(pixels);
+            pixels = NULL;
+        }
+    } else {
+        for(i = 0; i < *width * *height * 3; i++) {
+            if(fscanf(fp, "%d", &c) != 1) {
+                free(pixels);
+                pixels = NULL;
+                break;
+            }
+            pixels[i] = (unsigned char) c;
+        }
+    }
+    fclose(fp);
+    return pixels;
+}
+
+// Loads the given PPM as the model's texture, or a checkerboard if there
+// isn't one.  Needs a current GL context.
+void SetupTexture(PlyModel *model, char *filename)
+{
+    unsigned char *pixels = NULL;
+    int width = 0, height = 0;
+    int i, j;
+
+    if(filename != NULL) {
+        pixels = ReadPPM(filename, &width, &height);
+        if(pixels == NULL)
+            fprintf(stderr, "SetupTexture: could not read %s; using a checkerboard\n", filename);
+    }
+    if(pixels == NULL) {
+        width = height = 64;
+        pixels = (unsigned char*) malloc(width * height * 3);
+        for(i = 0; i < height; i++)
+            for(j = 0; j < width; j++)
+                memset(&pixels[3 * (i * width + j)], (((i >> 3) ^ (j >> 3)) & 1) ? 255 : 64, 3);
+    }
+
+    if(model->has_texture)
+        glDeleteTextures(1, (GLuint*) &model->texture_id);
+    glGenTextures(1, (GLuint*) &model->texture_id);
+    glBindTexture(GL_TEXTURE_2D, model->texture_id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    free(pixels);
+    model->has_texture = 1;
+}
@@ -33,3 +33,1986 @@ WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
 */
 
 
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ply.h>
+#include "threads.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static const char *type_names[] = {      /* names of scalar types */
+"invalid",
+"char", "short", "int",
+"uchar", "ushort", "uint",
+"float", "double",
+};
+
+static const char *sized_type_names[] = { /* the same types, as newer files name them */
+"invalid",
+"int8", "int16", "int32",
+"uint8", "uint16", "uint32",
+"float32", "float64",
+};
+
+static int ply_type_size[] = {
+  0, 1, 2, 4, 1, 2, 4, 4, 8
+};
+
+#define DONT_STORE_PROP  0
+#define STORE_PROP       1
+
+#define NAMED_PROP       1
+
+/* how PlyFile::map was obtained */
+#define PLY_MAP_NONE     0
+#define PLY_MAP_MAPPED   1
+#define PLY_MAP_HEAP     2
+
+/* fewest elements worth handing to a thread of their own */
+#define PLY_MIN_PER_THREAD  65536
+
+/* bytes in each block of a list pool, unless one list needs more */
+#define PLY_LIST_BLOCK_SIZE 65536
+
+/* block of a list pool; the lists of an element type are carved out of a
+   chain of these so that a face list doesn't cost a malloc per face */
+typedef struct PlyListBlock {
+  struct PlyListBlock *next;
+  size_t size;
+  size_t used;
+  double data[1];               /* keeps the items suitably aligned */
+} PlyListBlock;
+
+/* one contiguous run of elements parsed by one thread */
+typedef struct PlyChunk {
+  PlyFile *plyfile;
+  PlyElement *elem;
+  char *start;                  /* first byte of the run */
+  char *next;                   /* byte after the run, once parsed */
+  int count;                    /* elements in the run */
+  char *elems;                  /* where the first of them is stored */
+  int elem_size;
+  int use_pool;                 /* lists go in pool rather than malloc */
+  PlyListBlock *pool;            /* first block of the chunk's lists */
+  PlyListBlock *pool_last;       /* block lists are being carved from */
+  int error;
+} PlyChunk;
+
+/* local routines */
+
+static PlyElement *find_element(PlyFile *, char *);
+static int find_property(PlyElement *, char *);
+static int get_prop_type(char *);
+static int native_binary_type(void);
+static void get_stored_item(void *, int, int *, unsigned int *, double *);
+static void store_item(char *, int, int, unsigned int, double);
+static void get_binary_item(char *, int, int, int *, unsigned int *, double *);
+static char *get_ascii_item(char *, char *, int *, unsigned int *, double *);
+static void write_binary_item(FILE *, int, int, unsigned int, double, int);
+static void write_ascii_item(FILE *, int, unsigned int, double, int);
+static char *copy_string(char *);
+static char *skip_elements(PlyFile *, PlyElement *, char *, int);
+static int seek_element(PlyFile *, PlyElement *);
+static char *parse_element(PlyFile *, PlyElement *, char *, char *, PlyChunk *);
+static void parse_chunk(PlyChunk *);
+static void parse_chunks(void *, int, int);
+
+
+/*************/
+/*  Writing  */
+/*************/
+
+
+/******************************************************************************
+Given a file pointer, get ready to write PLY data to the file.
+
+Entry:
+  fp         - the given file pointer
+  nelems     - number of elements in object
+  elem_names - list of element names
+  file_type  - file type, either ascii or binary
+
+Exit:
+  returns a pointer to a PlyFile, used to refer to this file, or NULL if error
+******************************************************************************/
+
+PlyFile *ply_write(FILE *fp, int nelems, char **elem_names, int file_type)
+{
+  int i;
+  PlyFile *plyfile;
+  PlyElement *elem;
+
+  /* check for NULL file pointer */
+  if (fp == NULL)
+    return (NULL);
+
+  /* create a record for this object */
+
+  ALLOCN(plyfile, PlyFile, 1);
+  if (file_type == PLY_BINARY_NATIVE)
+    file_type = native_binary_type();
+  plyfile->file_type = file_type;
+  plyfile->version = 1.0;
+  plyfile->fp = fp;
+  plyfile->swap = (file_type != PLY_ASCII) && (file_type != native_binary_type());
+
+  /* tuck aside the names of the elements */
+
+  plyfile->nelems = nelems;
+  ALLOCN(plyfile->elems, PlyElement *, nelems);
+  for (i = 0; i < nelems; i++) {
+    ALLOCN(elem, PlyElement, 1);
+    plyfile->elems[i] = elem;
+    elem->name = copy_string(elem_names[i]);
+    elem->num = 0;
+    elem->size = -1;
+    elem->nprops = 0;
+  }
+
+  /* return pointer to the file descriptor */
+  return (plyfile);
+}
+
+
+/******************************************************************************
+Open a polygon file for writing.
+
+Entry:
+  filename   - name of file to read from
+  nelems     - number of elements in object
+  elem_names - list of element names
+  file_type  - file type, either ascii or binary
+
+Exit:
+  version - version number of PLY file
+  returns a file identifier, used to refer to this file, or NULL if error
+******************************************************************************/
+
+PlyFile *ply_open_for_writing(char *filename, int nelems, char **elem_names,
+                              int file_type, float *version)
+{
+  PlyFile *plyfile;
+  char *name;
+  FILE *fp;
+
+  /* tack on the extension .ply, if necessary */
+
+  ALLOCN(name, char, strlen(filename) + 5);
+  strcpy(name, filename);
+  if (strlen(name) < 4 ||
+      strcmp(name + strlen(name) - 4, ".ply") != 0)
+      strcat(name, ".ply");
+
+  /* open the file for writing */
+
+  fp = fopen(name, "wb");
+  free(name);
+  if (fp == NULL) {
+    return (NULL);
+  }
+
+  /* create the actual PlyFile structure */
+
+  plyfile = ply_write(fp, nelems, elem_names, file_type);
+  if (plyfile == NULL) {
+    fclose(fp);
+    return (NULL);
+  }
+
+  /* say what PLY file version number we're writing */
+  if (version != NULL)
+    *version = plyfile->version;
+
+  /* return pointer to the file descriptor */
+  return (plyfile);
+}
+
+
+/******************************************************************************
+Describe an element, including its properties and how many will be written
+to the file.
+
+Entry:
+  plyfile   - file identifier
+  elem_name - name of element that information is being specified about
+  nelems    - number of elements of this type to be written
+  nprops    - number of properties contained in the element
+  prop_list - list of properties
+******************************************************************************/
+
+void ply_describe_element(PlyFile *plyfile, char *elem_name, int nelems,
+                          int nprops, PlyProperty *prop_list)
+{
+  int i;
+  PlyElement *elem;
+
+  /* look for appropriate element */
+  elem = find_element(plyfile, elem_name);
+  if (elem == NULL) {
+    fprintf(stderr,"ply_describe_element: can't find element '%s'\n",elem_name);
+    return;
+  }
+
+  elem->num = nelems;
+
+  /* copy the list of properties */
+
+  for (i = 0; i < nprops; i++)
+    ply_describe_property(plyfile, elem_name, &prop_list[i]);
+}
+
+
+/******************************************************************************
+Describe a property of an element.
+
+Entry:
+  plyfile   - file identifier
+  elem_name - name of element that information is being specified about
+  prop      - the new property
+******************************************************************************/
+
+void ply_describe_property(PlyFile *plyfile, char *elem_name,
+                           PlyProperty *prop)
+{
+  PlyElement *elem;
+  PlyProperty *elem_prop;
+
+  /* look for appropriate element */
+  elem = find_element(plyfile, elem_name);
+  if (elem == NULL) {
+    fprintf(stderr, "ply_describe_property: can't find element '%s'\n",
+            elem_name);
+    return;
+  }
+
+  /* create room for new property */
+
+  if (elem->nprops == 0) {
+    ALLOCN(elem->props, PlyProperty *, 1);
+    ALLOCN(elem->store_prop, char, 1);
+    elem->nprops = 1;
+  }
+  else {
+    REALLOCN(elem->props, PlyProperty *, elem->nprops, elem->nprops + 1);
+    REALLOCN(elem->store_prop, char, elem->nprops, elem->nprops + 1);
+    elem->nprops++;
+  }
+
+  /* copy the new property */
+
+  ALLOCN(elem_prop, PlyProperty, 1);
+  elem->props[elem->nprops - 1] = elem_prop;
+  elem->store_prop[elem->nprops - 1] = NAMED_PROP;
+  *elem_prop = *prop;
+  elem_prop->name = copy_string(prop->name);
+}
+
+
+/******************************************************************************
+State how many of a given element will be written.
+
+Entry:
+  plyfile   - file identifier
+  elem_name - name of element that information is being specified about
+  nelems    - number of elements of this type to be written
+******************************************************************************/
+
+void ply_element_count(PlyFile *plyfile, char *elem_name, int nelems)
+{
+  PlyElement *elem;
+
+  /* look for appropriate element */
+  elem = find_element(plyfile, elem_name);
+  if (elem == NULL) {
+    fprintf(stderr,"ply_element_count: can't find element '%s'\n",elem_name);
+    return;
+  }
+
+  elem->num = nelems;
+}
+
+
+/******************************************************************************
+Add a comment or a piece of object information to the header of a file
+that is being written.
+******************************************************************************/
+
+void ply_put_comment(PlyFile *plyfile, char *comment)
+{
+  if (plyfile->num_comments == 0)
+    ALLOCN(plyfile->comments, char *, 1)
+  else
+    REALLOCN(plyfile->comments, char *,
+             plyfile->num_comments, plyfile->num_comments + 1);
+
+  plyfile->comments[plyfile->num_comments] = copy_string(comment);
+  plyfile->num_comments++;
+}
+
+void ply_put_obj_info(PlyFile *plyfile, char *obj_info)
+{
+  if (plyfile->num_obj_info == 0)
+    ALLOCN(plyfile->obj_info, char *, 1)
+  else
+    REALLOCN(plyfile->obj_info, char *,
+             plyfile->num_obj_info, plyfile->num_obj_info + 1);
+
+  plyfile->obj_info[plyfile->num_obj_info] = copy_string(obj_info);
+  plyfile->num_obj_info++;
+}
+
+
+/******************************************************************************
+Signal that we've described everything a PLY file's header and that the
+header should be written to the file.
+
+Entry:
+  plyfile - file identifier
+******************************************************************************/
+
+void ply_header_complete(PlyFile *plyfile)
+{
+  int i,j;
+  FILE *fp = plyfile->fp;
+  PlyElement *elem;
+  PlyProperty *prop;
+
+  fprintf(fp, "ply\n");
+
+  switch (plyfile->file_type) {
+    case PLY_ASCII:
+      fprintf(fp, "format ascii 1.0\n");
+      break;
+    case PLY_BINARY_BE:
+      fprintf(fp, "format binary_big_endian 1.0\n");
+      break;
+    case PLY_BINARY_LE:
+      fprintf(fp, "format binary_little_endian 1.0\n");
+      break;
+    default:
+      fprintf(stderr, "ply_header_complete: bad file type = %d\n",
+              plyfile->file_type);
+      return;
+  }
+
+  /* write out the comments */
+
+  for (i = 0; i < plyfile->num_comments; i++)
+    fprintf(fp, "comment %s\n", plyfile->comments[i]);
+
+  /* write out object information */
+
+  for (i = 0; i < plyfile->num_obj_info; i++)
+    fprintf(fp, "obj_info %s\n", plyfile->obj_info[i]);
+
+  /* write out information about each element */
+
+  for (i = 0; i < plyfile->nelems; i++) {
+
+    elem = plyfile->elems[i];
+    fprintf(fp, "element %s %d\n", elem->name, elem->num);
+
+    /* write out each property */
+    for (j = 0; j < elem->nprops; j++) {
+      prop = elem->props[j];
+      if (prop->is_list) {
+        fprintf(fp, "property list %s %s %s\n",
+                type_names[prop->count_external],
+                type_names[prop->external_type],
+                prop->name);
+      }
+      else
+        fprintf(fp, "property %s %s\n",
+                type_names[prop->external_type], prop->name);
+    }
+  }
+
+  fprintf(fp, "end_header\n");
+}
+
+
+/******************************************************************************
+Specify which elements are going to be written.  This should be called
+before a call to the routine ply_put_element().
+
+Entry:
+  plyfile   - file identifier
+  elem_name - name of element we're talking about
+******************************************************************************/
+
+void ply_put_element_setup(PlyFile *plyfile, char *elem_name)
+{
+  PlyElement *elem;
+
+  elem = find_element(plyfile, elem_name);
+  if (elem == NULL)
+    fprintf(stderr, "ply_put_element_setup: can't find element '%s'\n",
+            elem_name);
+
+  plyfile->which_elem = elem;
+}
+
+
+/******************************************************************************
+Write an element to the file.  This routine assumes that we're
+writing the type of element specified in the last call to the routine
+ply_put_element_setup().
+
+Entry:
+  plyfile  - file identifier
+  elem_ptr - pointer to the element
+******************************************************************************/
+
+void ply_put_element(PlyFile *plyfile, void *elem_ptr)
+{
+  int j,k;
+  FILE *fp = plyfile->fp;
+  PlyElement *elem = plyfile->which_elem;
+  PlyProperty *prop;
+  char *elem_data,*item;
+  char **item_ptr;
+  int list_count;
+  int item_size;
+  int int_val;
+  unsigned int uint_val;
+  double double_val;
+
+  if (elem == NULL)
+    return;
+
+  elem_data = (char *) elem_ptr;
+
+  for (j = 0; j < elem->nprops; j++) {
+    prop = elem->props[j];
+    if (prop->is_list) {
+      item = elem_data + prop->count_offset;
+      get_stored_item((void *) item, prop->count_internal,
+                      &int_val, &uint_val, &double_val);
+      list_count = uint_val;
+      if (plyfile->file_type == PLY_ASCII)
+        write_ascii_item(fp, int_val, uint_val, double_val,
+                         prop->count_external);
+      else
+        write_binary_item(fp, plyfile->swap, int_val, uint_val, double_val,
+                          prop->count_external);
+      item_ptr = (char **) (elem_data + prop->offset);
+      item = item_ptr[0];
+      item_size = ply_type_size[prop->internal_type];
+      for (k = 0; k < list_count; k++) {
+        get_stored_item((void *) item, prop->internal_type,
+                        &int_val, &uint_val, &double_val);
+        if (plyfile->file_type == PLY_ASCII)
+          write_ascii_item(fp, int_val, uint_val, double_val,
+                           prop->external_type);
+        else
+          write_binary_item(fp, plyfile->swap, int_val, uint_val, double_val,
+                            prop->external_type);
+        item += item_size;
+      }
+    }
+    else {
+      item = elem_data + prop->offset;
+      get_stored_item((void *) item, prop->internal_type,
+                      &int_val, &uint_val, &double_val);
+      if (plyfile->file_type == PLY_ASCII)
+        write_ascii_item(fp, int_val, uint_val, double_val,
+                         prop->external_type);
+      else
+        write_binary_item(fp, plyfile->swap, int_val, uint_val, double_val,
+                          prop->external_type);
+    }
+  }
+
+  if (plyfile->file_type == PLY_ASCII)
+    fprintf(fp, "\n");
+}
+
+
+/******************************************************************************
+Write out the "other" elements specified for this PLY file.  "Other"
+elements are not carried along by this implementation, so this only
+exists for the benefit of writers that call it unconditionally.
+******************************************************************************/
+
+void ply_put_other_elements(PlyFile *plyfile)
+{
+}
+
+
+/*************/
+/*  Reading  */
+/*************/
+
+
+/******************************************************************************
+Map a PLY file into memory and read its header.
+
+Entry:
+  filename - name of file to read from
+
+Exit:
+  nelems     - number of elements in object
+  elem_names - list of element names, to be freed (but not its strings)
+  file_type  - file type, either ascii or binary
+  version    - version number of PLY file
+  returns a file identifier, used to refer to this file, or NULL if error
+******************************************************************************/
+
+PlyFile *ply_open_for_reading(char *filename, int *nelems, char ***elem_names,
+                              int *file_type, float *version)
+{
+  PlyFile *plyfile;
+  PlyElement *elem;
+  PlyProperty *prop;
+  char *p,*end,*line_start,*line_end,*next;
+  char *line;
+  char *words[8];
+  int nwords;
+  int i;
+  int found_format = 0;
+
+  ALLOCN(plyfile, PlyFile, 1);
+  plyfile->map_kind = PLY_MAP_NONE;
+
+  /* map the file, or read it into memory if it can't be mapped */
+
+#ifdef _WIN32
+  {
+    HANDLE file, mapping;
+    LARGE_INTEGER size;
+
+    file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                       OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file != INVALID_HANDLE_VALUE) {
+      if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) {
+          plyfile->map = (char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+          if (plyfile->map != NULL) {
+            plyfile->map_size = (size_t) size.QuadPart;
+            plyfile->map_kind = PLY_MAP_MAPPED;
+            plyfile->map_handles[0] = (void *) file;
+            plyfile->map_handles[1] = (void *) mapping;
+          }
+          else
+            CloseHandle(mapping);
+        }
+      }
+      if (plyfile->map_kind == PLY_MAP_NONE)
+        CloseHandle(file);
+    }
+  }
+#else
+  {
+    int fd;
+    struct stat st;
+    void *map;
+
+    fd = open(filename, O_RDONLY);
+    if (fd >= 0) {
+      if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+          plyfile->map = (char *) map;
+          plyfile->map_size = (size_t) st.st_size;
+          plyfile->map_kind = PLY_MAP_MAPPED;
+#ifdef MADV_WILLNEED
+          madvise(map, plyfile->map_size, MADV_WILLNEED);
+#endif
+        }
+      }
+      close(fd);
+    }
+  }
+#endif
+
+  if (plyfile->map_kind == PLY_MAP_NONE) {
+    FILE *fp;
+    size_t size = 0, got;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) {
+      free(plyfile);
+      return (NULL);
+    }
+    if (fseek(fp, 0, SEEK_END) == 0) {
+      size = (size_t) ftell(fp);
+      fseek(fp, 0, SEEK_SET);
+    }
+    plyfile->map = (char *) malloc(size > 0 ? size : 1);
+    got = (plyfile->map != NULL) ? fread(plyfile->map, 1, size, fp) : 0;
+    fclose(fp);
+    if (size == 0 || got != size) {
+      free(plyfile->map);
+      free(plyfile);
+      return (NULL);
+    }
+    plyfile->map_size = size;
+    plyfile->map_kind = PLY_MAP_HEAP;
+  }
+
+  /* read the header one line at a time */
+
+  p = plyfile->map;
+  end = plyfile->map + plyfile->map_size;
+  line = NULL;
+
+  for (i = 0; ; i++) {
+
+    if (p >= end) {
+      fprintf(stderr, "ply_open_for_reading: %s has no end_header\n", filename);
+      goto error;
+    }
+    line_end = (char *) memchr(p, '\n', end - p);
+    if (line_end == NULL)
+      line_end = end;
+    next = (line_end < end) ? line_end + 1 : end;
+    if (line_end > p && line_end[-1] == '\r')
+      line_end--;
+
+    /* split a copy of the line into words */
+    line_start = p;
+    free(line);
+    ALLOCN(line, char, line_end - p + 1);
+    memcpy(line, p, line_end - p);
+    line[line_end - p] = '\0';
+    nwords = 0;
+    {
+      char *w = line;
+      while (*w != '\0' && nwords < 8) {
+        while (*w == ' ' || *w == '\t')
+          *w++ = '\0';
+        if (*w == '\0')
+          break;
+        words[nwords++] = w;
+        while (*w != '\0' && *w != ' ' && *w != '\t')
+          w++;
+      }
+    }
+    p = next;
+
+    if (i == 0) {
+      if (nwords != 1 || strcmp(words[0], "ply") != 0) {
+        fprintf(stderr, "ply_open_for_reading: %s is not a PLY file\n",
+                filename);
+        goto error;
+      }
+      continue;
+    }
+    if (nwords == 0)
+      continue;
+
+    if (strcmp(words[0], "format") == 0) {
+      if (nwords != 3)
+        goto bad_line;
+      if (strcmp(words[1], "ascii") == 0)
+        plyfile->file_type = PLY_ASCII;
+      else if (strcmp(words[1], "binary_big_endian") == 0)
+        plyfile->file_type = PLY_BINARY_BE;
+      else if (strcmp(words[1], "binary_little_endian") == 0)
+        plyfile->file_type = PLY_BINARY_LE;
+      else
+        goto bad_line;
+      plyfile->version = (float) atof(words[2]);
+      found_format = 1;
+    }
+    else if (strcmp(words[0], "element") == 0) {
+      if (nwords != 3)
+        goto bad_line;
+      if (plyfile->nelems == 0)
+        ALLOCN(plyfile->elems, PlyElement *, 1)
+      else
+        REALLOCN(plyfile->elems, PlyElement *,
+                 plyfile->nelems, plyfile->nelems + 1);
+      ALLOCN(elem, PlyElement, 1);
+      plyfile->elems[plyfile->nelems++] = elem;
+      elem->name = copy_string(words[1]);
+      elem->num = atoi(words[2]);
+      elem->nprops = 0;
+      if (elem->num < 0)
+        goto bad_line;
+    }
+    else if (strcmp(words[0], "property") == 0) {
+      if (plyfile->nelems == 0)
+        goto bad_line;
+      elem = plyfile->elems[plyfile->nelems - 1];
+      ALLOCN(prop, PlyProperty, 1);
+      if (nwords == 5 && strcmp(words[1], "list") == 0) {
+        prop->is_list = 1;
+        prop->count_external = get_prop_type(words[2]);
+        prop->external_type = get_prop_type(words[3]);
+        prop->name = copy_string(words[4]);
+        if (prop->count_external == 0 ||
+            prop->count_external == PLY_FLOAT ||
+            prop->count_external == PLY_DOUBLE ||
+            prop->external_type == 0) {
+          free(prop->name);
+          free(prop);
+          goto bad_line;
+        }
+      }
+      else if (nwords == 3) {
+        prop->is_list = 0;
+        prop->external_type = get_prop_type(words[1]);
+        prop->name = copy_string(words[2]);
+        if (prop->external_type == 0) {
+          free(prop->name);
+          free(prop);
+          goto bad_line;
+        }
+      }
+      else {
+        free(prop);
+        goto bad_line;
+      }
+      if (elem->nprops == 0) {
+        ALLOCN(elem->props, PlyProperty *, 1);
+        ALLOCN(elem->store_prop, char, 1);
+      }
+      else {
+        REALLOCN(elem->props, PlyProperty *, elem->nprops, elem->nprops + 1);
+        REALLOCN(elem->store_prop, char, elem->nprops, elem->nprops + 1);
+      }
+      elem->props[elem->nprops] = prop;
+      elem->store_prop[elem->nprops] = DONT_STORE_PROP;
+      elem->nprops++;
+    }
+    else if (strcmp(words[0], "comment") == 0 ||
+             strcmp(words[0], "obj_info") == 0) {
+      /* keep the text after the keyword, spacing and all */
+      char *text = line_start + (words[0] - line) + strlen(words[0]);
+      char *copy;
+      if (text < line_end && (*text == ' ' || *text == '\t'))
+        text++;
+      ALLOCN(copy, char, line_end - text + 1);
+      memcpy(copy, text, line_end - text);
+      copy[line_end - text] = '\0';
+      if (words[0][0] == 'c')
+        ply_put_comment(plyfile, copy);
+      else
+        ply_put_obj_info(plyfile, copy);
+      free(copy);
+    }
+    else if (strcmp(words[0], "end_header") == 0) {
+      break;
+    }
+    else {
+      /* unknown keywords are ignored */
+    }
+    continue;
+
+  bad_line:
+    fprintf(stderr, "ply_open_for_reading: bad header line in %s: %s\n",
+            filename, line);
+    goto error;
+  }
+  free(line);
+  line = NULL;
+
+  if (!found_format) {
+    fprintf(stderr, "ply_open_for_reading: %s has no format line\n", filename);
+    goto error;
+  }
+
+  plyfile->swap = (plyfile->file_type != PLY_ASCII) &&
+                  (plyfile->file_type != native_binary_type());
+
+  /* binary elements without lists have a fixed size */
+
+  for (i = 0; i < plyfile->nelems; i++) {
+    int j;
+    elem = plyfile->elems[i];
+    elem->size = 0;
+    for (j = 0; j < elem->nprops; j++) {
+      if (elem->props[j]->is_list || plyfile->file_type == PLY_ASCII) {
+        elem->size = -1;
+        break;
+      }
+      elem->size += ply_type_size[elem->props[j]->external_type];
+    }
+  }
+
+  plyfile->cursor = p;
+  plyfile->cursor_elem = 0;
+  plyfile->cursor_count = 0;
+
+  /* tell the caller what's in the file */
+
+  if (nelems != NULL)
+    *nelems = plyfile->nelems;
+  if (elem_names != NULL) {
+    ALLOCN(*elem_names, char *, plyfile->nelems > 0 ? plyfile->nelems : 1);
+    for (i = 0; i < plyfile->nelems; i++)
+      (*elem_names)[i] = plyfile->elems[i]->name;
+  }
+  if (file_type != NULL)
+    *file_type = plyfile->file_type;
+  if (version != NULL)
+    *version = plyfile->version;
+
+  return (plyfile);
+
+error:
+  free(line);
+  ply_close(plyfile);
+  return (NULL);
+}
+
+
+/******************************************************************************
+Get information about a particular element.
+
+Entry:
+  plyfile   - file identifier
+  elem_name - name of element to get information about
+
+Exit:
+  nelems   - number of elements of this type in the file
+  nprops   - number of properties
+  returns a list of properties, or NULL if the file doesn't contain that elem
+******************************************************************************/
+
+PlyProperty **ply_get_element_description(PlyFile *plyfile, char *elem_name,
+                                          int *nelems, int *nprops)
+{
+  int i;
+  PlyElement *elem;
+  PlyProperty *prop;
+  PlyProperty **prop_list;
+
+  /* find information about the element */
+  elem = find_element(plyfile, elem_name);
+  if (elem == NULL)
+    return (NULL);
+
+  *nelems = elem->num;
+  *nprops = elem->nprops;
+
+  /* make a copy of the element's property list */
+  ALLOCN(prop_list, PlyProperty *, elem->nprops > 0 ? elem->nprops : 1);
+  for (i = 0; i < elem->nprops; i++) {
+    ALLOCN(prop, PlyProperty, 1);
+    *prop = *elem->props[i];
+    prop->name = copy_string(elem->props[i]->name);
+    prop_list[i] = prop;
+  }
+
+  /* return this duplicate property list */
+  return (prop_list);
+}
+
+
+/******************************************************************************
+Specify a property of an element that is to be returned.  This should be
+called (usually multiple times) before a call to the routine ply_get_element().
+This routine should be used in preference to the less flexible old routine
+called ply_get_element_setup().
+
+Entry:
+  plyfile   - file identifier
+  elem_name - which element we're talking about
+  prop      - property to add to those that will be returned
+
+Exit:
+  returns PLY_OKAY, or PLY_ERROR if the file has no such property, which
+  makes this the way to ask whether an optional property is present
+******************************************************************************/
+
+int ply_get_property(PlyFile *plyfile, char *elem_name, PlyProperty *prop)
+{
+  PlyElement *elem;
+  PlyProperty *prop_ptr;
+  int index;
+
+  /* find information about the element */
+  elem = find_element(plyfile, elem_name);
+  plyfile->which_elem = elem;
+  if (elem == NULL)
+    return (PLY_ERROR);
+
+  /* deposit the property information into the element's description */
+
+  index = find_property(elem, prop->name);
+  if (index == -1)
+    return (PLY_ERROR);
+  prop_ptr = elem->props[index];
+  prop_ptr->internal_type  = prop->internal_type;
+  prop_ptr->offset         = prop->offset;
+  prop_ptr->count_internal = prop->count_internal;
+  prop_ptr->count_offset   = prop->count_offset;
+
+  /* specify that the user wants this property */
+  elem->store_prop[index] = STORE_PROP;
+  return (PLY_OKAY);
+}
+
+
+/******************************************************************************
+Specify which properties of an element are to be returned.  This should be
+called before a call to the routine ply_get_element().  Properties that the
+file doesn't have are left alone in the caller's elements.
+
+Entry:
+  plyfile   - file identifier
+  elem_name - which element we're talking about
+  nprops    - number of properties
+  prop_list - list of properties
+******************************************************************************/
+
+void ply_get_element_setup(PlyFile *plyfile, char *elem_name, int nprops,
+                           PlyProperty *prop_list)
+{
+  int i;
+
+  for (i = 0; i < nprops; i++)
+    ply_get_property(plyfile, elem_name, &prop_list[i]);
+
+  plyfile->which_elem = find_element(plyfile, elem_name);
+}
+
+
+/******************************************************************************
+Read one element from the file.  This routine assumes that we're reading
+the type of element specified in the last call to the routine
+ply_get_element_setup() or ply_get_property().  Each list property gets a
+list of its own from malloc().
+
+Entry:
+  plyfile  - file identifier
+  elem_ptr - pointer to location where the element information should be put
+
+Exit:
+  returns PLY_OKAY, or PLY_ERROR if there are no more such elements or the
+  element can't be parsed
+******************************************************************************/
+
+int ply_get_element(PlyFile *plyfile, void *elem_ptr)
+{
+  PlyElement *elem = plyfile->which_elem;
+  char *next;
+
+  if (elem == NULL || plyfile->map == NULL)
+    return (PLY_ERROR);
+  if (seek_element(plyfile, elem) != PLY_OKAY)
+    return (PLY_ERROR);
+  if (plyfile->cursor_count >= elem->num)
+    return (PLY_ERROR);
+
+  next = parse_element(plyfile, elem, plyfile->cursor, (char *) elem_ptr, NULL);
+  if (next == NULL) {
+    fprintf(stderr, "ply_get_element: bad or truncated '%s' element %d\n",
+            elem->name, plyfile->cursor_count);
+    return (PLY_ERROR);
+  }
+  plyfile->cursor = next;
+  plyfile->cursor_count++;
+  return (PLY_OKAY);
+}
+
+
+/******************************************************************************
+Read all the remaining elements of the type specified in the last call to
+ply_get_element_setup() or ply_get_property() into an array.  Long runs of
+elements are split into chunks that are parsed on separate threads.
+
+Entry:
+  plyfile     - file identifier
+  elems       - array with room for all the remaining elements
+  elem_size   - bytes from one element of elems to the next
+  num_threads - most threads to use, or 0 for one per processor
+  lists       - if non-NULL, list properties are stored in one pool that is
+                returned here and must be released with ply_free_lists();
+                if NULL, each list gets its own malloc() as in
+                ply_get_element()
+
+Exit:
+  returns the number of elements read, or PLY_ERROR
+******************************************************************************/
+
+int ply_get_elements(PlyFile *plyfile, void *elems, int elem_size,
+                     int num_threads, void **lists)
+{
+  PlyElement *elem = plyfile->which_elem;
+  PlyChunk *chunks;
+  PlyListBlock *pool, *tail;
+  char *p;
+  int remaining, nchunks, first, i;
+  int result;
+
+  if (lists != NULL)
+    *lists = NULL;
+  if (elem == NULL || plyfile->map == NULL)
+    return (PLY_ERROR);
+  if (seek_element(plyfile, elem) != PLY_OKAY)
+    return (PLY_ERROR);
+
+  remaining = elem->num - plyfile->cursor_count;
+  if (remaining <= 0)
+    return (0);
+
+  if (num_threads <= 0)
+    num_threads = GetNumSystemProcessors();
+  nchunks = remaining / PLY_MIN_PER_THREAD;
+  if (nchunks > num_threads)
+    nchunks = num_threads;
+  if (nchunks < 1)
+    nchunks = 1;
+
+  /* find where each chunk starts; a binary element of fixed size can be
+     jumped to directly, anything else costs a quick scan of the elements
+     in between (a memchr per line for ascii, the list counts for binary) */
+
+  ALLOCN(chunks, PlyChunk, nchunks);
+  p = plyfile->cursor;
+  for (i = 0; i < nchunks; i++) {
+    first = (int) (((long long) remaining * i) / nchunks);
+    chunks[i].plyfile = plyfile;
+    chunks[i].elem = elem;
+    chunks[i].start = p;
+    chunks[i].count = (int) (((long long) remaining * (i + 1)) / nchunks) - first;
+    chunks[i].elems = (char *) elems + (size_t) first * elem_size;
+    chunks[i].elem_size = elem_size;
+    chunks[i].use_pool = (lists != NULL);
+    chunks[i].pool = NULL;
+    chunks[i].pool_last = NULL;
+    chunks[i].error = 0;
+    if (i < nchunks - 1) {
+      p = skip_elements(plyfile, elem, p, chunks[i].count);
+      if (p == NULL) {
+        nchunks = i + 1;
+        chunks[i].error = 1;
+        break;
+      }
+    }
+  }
+
+  if (!chunks[nchunks - 1].error)
+    ParallelFor(0, nchunks - 1, nchunks, 1, parse_chunks, chunks);
+
+  /* chain the chunks' list pools together, in order */
+
+  result = remaining;
+  pool = NULL;
+  tail = NULL;
+  for (i = 0; i < nchunks; i++) {
+    if (chunks[i].error)
+      result = PLY_ERROR;
+    if (chunks[i].pool == NULL)
+      continue;
+    if (tail == NULL)
+      pool = chunks[i].pool;
+    else
+      tail->next = chunks[i].pool;
+    tail = chunks[i].pool_last;
+  }
+
+  if (result == PLY_ERROR) {
+    fprintf(stderr, "ply_get_elements: bad or truncated '%s' elements\n",
+            elem->name);
+    ply_free_lists(pool);
+  }
+  else {
+    plyfile->cursor = chunks[nchunks - 1].next;
+    plyfile->cursor_count += remaining;
+    if (lists != NULL)
+      *lists = pool;
+  }
+
+  free(chunks);
+  return (result);
+}
+
+
+/******************************************************************************
+Release a pool of lists returned by ply_get_elements().
+******************************************************************************/
+
+void ply_free_lists(void *lists)
+{
+  PlyListBlock *block = (PlyListBlock *) lists;
+  PlyListBlock *next;
+
+  while (block != NULL) {
+    next = block->next;
+    free(block);
+    block = next;
+  }
+}
+
+
+/******************************************************************************
+Extract the comments and object information from the header.  The strings
+belong to the PlyFile.
+******************************************************************************/
+
+char **ply_get_comments(PlyFile *plyfile, int *num_comments)
+{
+  *num_comments = plyfile->num_comments;
+  return (plyfile->comments);
+}
+
+char **ply_get_obj_info(PlyFile *plyfile, int *num_obj_info)
+{
+  *num_obj_info = plyfile->num_obj_info;
+  return (plyfile->obj_info);
+}
+
+
+/******************************************************************************
+Close a PLY file, unmapping it if it was being read.
+
+Entry:
+  plyfile - identifier of file to close
+******************************************************************************/
+
+void ply_close(PlyFile *plyfile)
+{
+  int i,j;
+  PlyElement *elem;
+
+  if (plyfile == NULL)
+    return;
+
+  if (plyfile->fp != NULL)
+    fclose(plyfile->fp);
+
+  if (plyfile->map_kind == PLY_MAP_MAPPED) {
+#ifdef _WIN32
+    UnmapViewOfFile(plyfile->map);
+    CloseHandle((HANDLE) plyfile->map_handles[1]);
+    CloseHandle((HANDLE) plyfile->map_handles[0]);
+#else
+    munmap(plyfile->map, plyfile->map_size);
+#endif
+  }
+  else if (plyfile->map_kind == PLY_MAP_HEAP)
+    free(plyfile->map);
+
+  for (i = 0; i < plyfile->nelems; i++) {
+    elem = plyfile->elems[i];
+    for (j = 0; j < elem->nprops; j++) {
+      free(elem->props[j]->name);
+      free(elem->props[j]);
+    }
+    free(elem->props);
+    free(elem->store_prop);
+    free(elem->name);
+    free(elem);
+  }
+  free(plyfile->elems);
+
+  for (i = 0; i < plyfile->num_comments; i++)
+    free(plyfile->comments[i]);
+  free(plyfile->comments);
+  for (i = 0; i < plyfile->num_obj_info; i++)
+    free(plyfile->obj_info[i]);
+  free(plyfile->obj_info);
+
+  free(plyfile);
+}
+
+
+/*******************/
+/*  Miscellaneous  */
+/*******************/
+
+
+/******************************************************************************
+Find an element from the element list of a given PLY object.
+
+Entry:
+  plyfile - file id for PLY file
+  element - name of element we're looking for
+
+Exit:
+  returns the element, or NULL if not found
+******************************************************************************/
+
+static PlyElement *find_element(PlyFile *plyfile, char *element)
+{
+  int i;
+
+  for (i = 0; i < plyfile->nelems; i++)
+    if (strcmp(element, plyfile->elems[i]->name) == 0)
+      return (plyfile->elems[i]);
+
+  return (NULL);
+}
+
+
+/******************************************************************************
+Find a property in the list of properties of a given element.
+
+Entry:
+  elem      - pointer to element in which we want to find the property
+  prop_name - name of property to find
+
+Exit:
+  returns the index to position in list, or -1 if not found
+******************************************************************************/
+
+static int find_property(PlyElement *elem, char *prop_name)
+{
+  int i;
+
+  for (i = 0; i < elem->nprops; i++)
+    if (strcmp(prop_name, elem->props[i]->name) == 0)
+      return (i);
+
+  return (-1);
+}
+
+
+/******************************************************************************
+Get a property type from a type name, in either the old or the sized
+spelling.  Returns 0 for an unknown type name.
+******************************************************************************/
+
+static int get_prop_type(char *type_name)
+{
+  int i;
+
+  for (i = PLY_START_TYPE + 1; i < PLY_END_TYPE; i++) {
+    if (strcmp(type_name, type_names[i]) == 0)
+      return (i);
+    if (strcmp(type_name, sized_type_names[i]) == 0)
+      return (i);
+  }
+
+  /* if we get here, we didn't find the type */
+  return (0);
+}
+
+
+/******************************************************************************
+PLY_BINARY_BE or PLY_BINARY_LE, whichever this machine is.
+******************************************************************************/
+
+static int native_binary_type(void)
+{
+  union {
+    int int_value;
+    char byte_values[sizeof(int)];
+  } test;
+
+  test.int_value = 1;
+  return (test.byte_values[0] == 1) ? PLY_BINARY_LE : PLY_BINARY_BE;
+}
+
+
+/******************************************************************************
+Extract the value of an item, given a pointer to it and its type.
+
+Entry:
+  item - pointer to item
+  type - data type that "item" points to
+
+Exit:
+  int_val    - integer value
+  uint_val   - unsigned integer value
+  double_val - double-precision floating point value
+******************************************************************************/
+
+static void get_stored_item(void *ptr, int type, int *int_val,
+                            unsigned int *uint_val, double *double_val)
+{
+  switch (type) {
+    case PLY_CHAR:
+      *int_val = *((char *) ptr);
+      *uint_val = *int_val;
+      *double_val = *int_val;
+      break;
+    case PLY_UCHAR:
+      *uint_val = *((unsigned char *) ptr);
+      *int_val = *uint_val;
+      *double_val = *uint_val;
+      break;
+    case PLY_SHORT:
+      *int_val = *((short int *) ptr);
+      *uint_val = *int_val;
+      *double_val = *int_val;
+      break;
+    case PLY_USHORT:
+      *uint_val = *((unsigned short int *) ptr);
+      *int_val = *uint_val;
+      *double_val = *uint_val;
+      break;
+    case PLY_INT:
+      *int_val = *((int *) ptr);
+      *uint_val = *int_val;
+      *double_val = *int_val;
+      break;
+    case PLY_UINT:
+      *uint_val = *((unsigned int *) ptr);
+      *int_val = *uint_val;
+      *double_val = *uint_val;
+      break;
+    case PLY_FLOAT:
+      *double_val = *((float *) ptr);
+      *int_val = (int) *double_val;
+      *uint_val = (unsigned int) *double_val;
+      break;
+    case PLY_DOUBLE:
+      *double_val = *((double *) ptr);
+      *int_val = (int) *double_val;
+      *uint_val = (unsigned int) *double_val;
+      break;
+    default:
+      fprintf(stderr, "get_stored_item: bad type = %d\n", type);
+      exit(-1);
+  }
+}
+
+
+/******************************************************************************
+Store a value into a place being pointed to, guided by a data type.
+
+Entry:
+  item       - place to store value
+  type       - data type
+  int_val    - integer version of value
+  uint_val   - unsigned integer version of value
+  double_val - double version of value
+******************************************************************************/
+
+static void store_item(char *item, int type, int int_val,
+                       unsigned int uint_val, double double_val)
+{
+  unsigned char *puchar;
+  short int *pshort;
+  unsigned short int *pushort;
+  int *pint;
+  unsigned int *puint;
+  float *pfloat;
+  double *pdouble;
+
+  switch (type) {
+    case PLY_CHAR:
+      *item = int_val;
+      break;
+    case PLY_UCHAR:
+      puchar = (unsigned char *) item;
+      *puchar = uint_val;
+      break;
+    case PLY_SHORT:
+      pshort = (short *) item;
+      *pshort = int_val;
+      break;
+    case PLY_USHORT:
+      pushort = (unsigned short *) item;
+      *pushort = uint_val;
+      break;
+    case PLY_INT:
+      pint = (int *) item;
+      *pint = int_val;
+      break;
+    case PLY_UINT:
+      puint = (unsigned int *) item;
+      *puint = uint_val;
+      break;
+    case PLY_FLOAT:
+      pfloat = (float *) item;
+      *pfloat = (float) double_val;
+      break;
+    case PLY_DOUBLE:
+      pdouble = (double *) item;
+      *pdouble = double_val;
+      break;
+    default:
+      fprintf(stderr, "store_item: bad type = %d\n", type);
+      exit(-1);
+  }
+}
+
+
+/******************************************************************************
+Get the value of an item from a binary file.  The caller has checked that
+the item lies inside the file.
+
+Entry:
+  ptr  - the item in the file
+  type - data type to read
+  swap - non-zero if the file's byte order is not this machine's
+
+Exit:
+  int_val    - integer value
+  uint_val   - unsigned integer value
+  double_val - double-precision floating point value
+******************************************************************************/
+
+static void get_binary_item(char *ptr, int type, int swap, int *int_val,
+                            unsigned int *uint_val, double *double_val)
+{
+  union {
+    char bytes[8];
+    char c;
+    unsigned char uc;
+    short s;
+    unsigned short us;
+    int i;
+    unsigned int ui;
+    float f;
+    double d;
+  } value;
+  int size = ply_type_size[type];
+  int k;
+
+  /* copy rather than dereference: elements needn't be aligned in the file */
+  if (swap)
+    for (k = 0; k < size; k++)
+      value.bytes[k] = ptr[size - 1 - k];
+  else
+    memcpy(value.bytes, ptr, size);
+
+  switch (type) {
+    case PLY_CHAR:
+      *int_val = value.c;
+      *uint_val = *int_val;
+      *double_val = *int_val;
+      break;
+    case PLY_UCHAR:
+      *uint_val = value.uc;
+      *int_val = *uint_val;
+      *double_val = *uint_val;
+      break;
+    case PLY_SHORT:
+      *int_val = value.s;
+      *uint_val = *int_val;
+      *double_val = *int_val;
+      break;
+    case PLY_USHORT:
+      *uint_val = value.us;
+      *int_val = *uint_val;
+      *double_val = *uint_val;
+      break;
+    case PLY_INT:
+      *int_val = value.i;
+      *uint_val = *int_val;
+      *double_val = *int_val;
+      break;
+    case PLY_UINT:
+      *uint_val = value.ui;
+      *int_val = *uint_val;
+      *double_val = *uint_val;
+      break;
+    case PLY_FLOAT:
+      *double_val = value.f;
+      *int_val = (int) *double_val;
+      *uint_val = (unsigned int) *double_val;
+      break;
+    case PLY_DOUBLE:
+      *double_val = value.d;
+      *int_val = (int) *double_val;
+      *uint_val = (unsigned int) *double_val;
+      break;
+    default:
+      fprintf(stderr, "get_binary_item: bad type = %d\n", type);
+      exit(-1);
+  }
+}
+
+
+/******************************************************************************
+Parse one number from an ascii file.  This stands in for strtod(), which
+is slow and, since the file isn't NUL-terminated, could run off its end.
+
+Entry:
+  p   - where to start looking for the number
+  end - end of the file
+
+Exit:
+  int_val    - integer value
+  uint_val   - unsigned integer value
+  double_val - double-precision floating point value
+  returns the byte after the number, or NULL if there's no number there
+******************************************************************************/
+
+static char *get_ascii_item(char *p, char *end, int *int_val,
+                            unsigned int *uint_val, double *double_val)
+{
+  static const double powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  unsigned long long mantissa = 0;
+  int digits = 0, exponent = 0, exp_value = 0;
+  int negative = 0, exp_negative = 0;
+  int is_integer = 1;
+  double value;
+
+  /* skip white space, including the ends of lines */
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+    p++;
+  if (p >= end)
+    return (NULL);
+
+  if (*p == '-' || *p == '+') {
+    negative = (*p == '-');
+    p++;
+  }
+
+  /* up to 19 significant digits fit in the mantissa; later ones only
+     scale it */
+  for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+    if (mantissa < 1000000000000000000ULL)
+      mantissa = mantissa * 10 + (*p - '0');
+    else
+      exponent++;
+  }
+  if (p < end && *p == '.') {
+    is_integer = 0;
+    for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+      if (mantissa < 1000000000000000000ULL) {
+        mantissa = mantissa * 10 + (*p - '0');
+        exponent--;
+      }
+    }
+  }
+  if (digits == 0)
+    return (NULL);
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    is_integer = 0;
+    p++;
+    if (p < end && (*p == '-' || *p == '+')) {
+      exp_negative = (*p == '-');
+      p++;
+    }
+    if (p >= end || *p < '0' || *p > '9')
+      return (NULL);
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+      if (exp_value < 10000)
+        exp_value = exp_value * 10 + (*p - '0');
+    exponent += exp_negative ? -exp_value : exp_value;
+  }
+
+  /* the number must end at white space */
+  if (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+    return (NULL);
+
+  value = (double) mantissa;
+  if (exponent > 0)
+    value *= (exponent <= 22) ? powers_of_ten[exponent] : pow(10.0, exponent);
+  else if (exponent < 0)
+    value /= (-exponent <= 22) ? powers_of_ten[-exponent] : pow(10.0, -exponent);
+  if (negative)
+    value = -value;
+
+  *double_val = value;
+  if (is_integer && exponent == 0) {
+    *int_val = negative ? -(int) mantissa : (int) mantissa;
+    *uint_val = (unsigned int) *int_val;
+  }
+  else {
+    *int_val = (int) value;
+    *uint_val = (unsigned int) value;
+  }
+  return (p);
+}
+
+
+/******************************************************************************
+Write out an item to a file as raw binary bytes, or as ascii text.
+
+Entry:
+  fp         - file to write to
+  swap       - write in the opposite of this machine's byte order
+  int_val    - integer version of item
+  uint_val   - unsigned integer version of item
+  double_val - double-precision float version of item
+  type       - data type to write out
+******************************************************************************/
+
+static void write_binary_item(FILE *fp, int swap, int int_val,
+                              unsigned int uint_val, double double_val,
+                              int type)
+{
+  char bytes[8], swapped[8];
+  unsigned char uchar_val;
+  char char_val;
+  unsigned short ushort_val;
+  short short_val;
+  float float_val;
+  int size = ply_type_size[type];
+  int k;
+
+  switch (type) {
+    case PLY_CHAR:
+      char_val = int_val;
+      memcpy(bytes, &char_val, 1);
+      break;
+    case PLY_SHORT:
+      short_val = int_val;
+      memcpy(bytes, &short_val, 2);
+      break;
+    case PLY_INT:
+      memcpy(bytes, &int_val, 4);
+      break;
+    case PLY_UCHAR:
+      uchar_val = uint_val;
+      memcpy(bytes, &uchar_val, 1);
+      break;
+    case PLY_USHORT:
+      ushort_val = uint_val;
+      memcpy(bytes, &ushort_val, 2);
+      break;
+    case PLY_UINT:
+      memcpy(bytes, &uint_val, 4);
+      break;
+    case PLY_FLOAT:
+      float_val = (float) double_val;
+      memcpy(bytes, &float_val, 4);
+      break;
+    case PLY_DOUBLE:
+      memcpy(bytes, &double_val, 8);
+      break;
+    default:
+      fprintf(stderr, "write_binary_item: bad type = %d\n", type);
+      exit(-1);
+  }
+
+  if (swap) {
+    for (k = 0; k < size; k++)
+      swapped[k] = bytes[size - 1 - k];
+    fwrite(swapped, size, 1, fp);
+  }
+  else
+    fwrite(bytes, size, 1, fp);
+}
+
+static void write_ascii_item(FILE *fp, int int_val, unsigned int uint_val,
+                             double double_val, int type)
+{
+  switch (type) {
+    case PLY_CHAR:
+    case PLY_SHORT:
+    case PLY_INT:
+      fprintf(fp, "%d ", int_val);
+      break;
+    case PLY_UCHAR:
+    case PLY_USHORT:
+    case PLY_UINT:
+      fprintf(fp, "%u ", uint_val);
+      break;
+    case PLY_FLOAT:
+      fprintf(fp, "%.9g ", double_val);
+      break;
+    case PLY_DOUBLE:
+      fprintf(fp, "%.17g ", double_val);
+      break;
+    default:
+      fprintf(stderr, "write_ascii_item: bad type = %d\n", type);
+      exit(-1);
+  }
+}
+
+
+/******************************************************************************
+Return a copy of a string, allocated with malloc().
+******************************************************************************/
+
+static char *copy_string(char *str)
+{
+  char *new_str;
+
+  ALLOCN(new_str, char, strlen(str) + 1);
+  strcpy(new_str, str);
+  return (new_str);
+}
+
+
+/******************************************************************************
+Step over elements without parsing them.
+
+Entry:
+  plyfile - file identifier
+  elem    - type of the elements
+  p       - first byte of the first element; for ascii this may also be
+            just past the last token of the element before it
+  count   - number of elements to step over
+
+Exit:
+  returns the byte after the last of them, or NULL if the file ends first
+******************************************************************************/
+
+static char *skip_elements(PlyFile *plyfile, PlyElement *elem, char *p,
+                           int count)
+{
+  char *end = plyfile->map + plyfile->map_size;
+  PlyProperty *prop;
+  int i,j;
+  int int_val;
+  unsigned int uint_val;
+  double double_val;
+
+  if (plyfile->file_type == PLY_ASCII) {
+    /* a cursor left mid-line by the last parse still has that line's
+       trailing blanks and newline ahead of it; they aren't an element */
+    if (p > plyfile->map && p[-1] != '\n') {
+      p = (char *) memchr(p, '\n', end - p);
+      p = (p == NULL) ? end : p + 1;
+    }
+
+    /* one element per line; blank lines don't count */
+    for (i = 0; i < count; i++) {
+      while (p < end && (*p == '\n' || *p == '\r'))
+        p++;
+      if (p >= end)
+        return (NULL);
+      p = (char *) memchr(p, '\n', end - p);
+      p = (p == NULL) ? end : p + 1;
+    }
+    return (p);
+  }
+
+  if (elem->size >= 0) {
+    if ((size_t) (end - p) < (size_t) elem->size * count)
+      return (NULL);
+    return (p + (size_t) elem->size * count);
+  }
+
+  for (i = 0; i < count; i++) {
+    for (j = 0; j < elem->nprops; j++) {
+      prop = elem->props[j];
+      if (prop->is_list) {
+        if (end - p < ply_type_size[prop->count_external])
+          return (NULL);
+        get_binary_item(p, prop->count_external, plyfile->swap,
+                        &int_val, &uint_val, &double_val);
+        p += ply_type_size[prop->count_external];
+        if ((size_t) (end - p) < (size_t) uint_val * ply_type_size[prop->external_type])
+          return (NULL);
+        p += (size_t) uint_val * ply_type_size[prop->external_type];
+      }
+      else {
+        if (end - p < ply_type_size[prop->external_type])
+          return (NULL);
+        p += ply_type_size[prop->external_type];
+      }
+    }
+  }
+  return (p);
+}
+
+
+/******************************************************************************
+Move the cursor to the next unread element of the given type, stepping
+over any element types that come before it in the file.
+
+Exit:
+  returns PLY_OKAY, or PLY_ERROR if the type was already passed or the
+  file is truncated
+******************************************************************************/
+
+static int seek_element(PlyFile *plyfile, PlyElement *elem)
+{
+  PlyElement *current;
+  char *next;
+
+  while (plyfile->elems[plyfile->cursor_elem] != elem) {
+    if (plyfile->cursor_elem == plyfile->nelems - 1) {
+      fprintf(stderr, "ply: '%s' elements must be read in file order\n",
+              elem->name);
+      return (PLY_ERROR);
+    }
+    current = plyfile->elems[plyfile->cursor_elem];
+    next = skip_elements(plyfile, current, plyfile->cursor,
+                         current->num - plyfile->cursor_count);
+    if (next == NULL) {
+      fprintf(stderr, "ply: truncated '%s' elements\n", current->name);
+      return (PLY_ERROR);
+    }
+    plyfile->cursor = next;
+    plyfile->cursor_elem++;
+    plyfile->cursor_count = 0;
+  }
+  return (PLY_OKAY);
+}
+
+
+/******************************************************************************
+Find room for a list in a chunk's list pool.
+******************************************************************************/
+
+static char *allocate_list(PlyChunk *chunk, size_t bytes)
+{
+  PlyListBlock *block = chunk->pool_last;
+  size_t size;
+  char *list;
+
+  bytes = (bytes + sizeof(double) - 1) & ~(sizeof(double) - 1);
+  if (block == NULL || block->size - block->used < bytes) {
+    size = (bytes > PLY_LIST_BLOCK_SIZE) ? bytes : PLY_LIST_BLOCK_SIZE;
+    block = (PlyListBlock *) malloc(offsetof(PlyListBlock, data) + size);
+    if (block == NULL)
+      return (NULL);
+    block->size = size;
+    block->used = 0;
+    block->next = NULL;
+
+    /* the newest block goes last, keeping the chain in file order */
+    if (chunk->pool == NULL)
+      chunk->pool = block;
+    else
+      chunk->pool_last->next = block;
+    chunk->pool_last = block;
+  }
+  list = (char *) block->data + block->used;
+  block->used += bytes;
+  return (list);
+}
+
+
+/******************************************************************************
+Parse one element, storing the properties the user asked for.
+
+Entry:
+  plyfile  - file identifier
+  elem     - type of the element
+  p        - first byte of the element
+  elem_ptr - where to store the element
+  chunk    - chunk whose pool should hold the lists, or NULL to malloc them
+
+Exit:
+  returns the byte after the element, or NULL if it can't be parsed
+******************************************************************************/
+
+static char *parse_element(PlyFile *plyfile, PlyElement *elem, char *p,
+                           char *elem_ptr, PlyChunk *chunk)
+{
+  char *end = plyfile->map + plyfile->map_size;
+  int ascii = (plyfile->file_type == PLY_ASCII);
+  PlyProperty *prop;
+  char *item;
+  int item_size, ext_size;
+  int list_count;
+  int store_it;
+  int j,k;
+  int int_val;
+  unsigned int uint_val;
+  double double_val;
+
+  for (j = 0; j < elem->nprops; j++) {
+    prop = elem->props[j];
+    store_it = elem->store_prop[j];
+
+    /* get the property, or the count of a list */
+    {
+      int type = prop->is_list ? prop->count_external : prop->external_type;
+      if (ascii) {
+        p = get_ascii_item(p, end, &int_val, &uint_val, &double_val);
+        if (p == NULL)
+          return (NULL);
+      }
+      else {
+        if (end - p < ply_type_size[type])
+          return (NULL);
+        get_binary_item(p, type, plyfile->swap, &int_val, &uint_val, &double_val);
+        p += ply_type_size[type];
+      }
+    }
+
+    if (!prop->is_list) {
+      if (store_it)
+        store_item(elem_ptr + prop->offset, prop->internal_type,
+                   int_val, uint_val, double_val);
+      continue;
+    }
+
+    list_count = int_val;
+    if (list_count < 0)
+      return (NULL);
+    item = NULL;
+    item_size = ply_type_size[prop->internal_type];
+    ext_size = ply_type_size[prop->external_type];
+
+    if (store_it) {
+      store_item(elem_ptr + prop->count_offset, prop->count_internal,
+                 int_val, uint_val, double_val);
+      if (list_count > 0) {
+        if (chunk != NULL)
+          item = allocate_list(chunk, (size_t) item_size * list_count);
+        else
+          item = (char *) malloc((size_t) item_size * list_count);
+        if (item == NULL)
+          return (NULL);
+      }
+      *((char **) (elem_ptr + prop->offset)) = item;
+    }
+    else if (!ascii) {
+      /* binary lists that aren't wanted can be stepped over whole */
+      if ((size_t) (end - p) < (size_t) ext_size * list_count)
+        return (NULL);
+      p += (size_t) ext_size * list_count;
+      continue;
+    }
+
+    for (k = 0; k < list_count; k++) {
+      if (ascii) {
+        p = get_ascii_item(p, end, &int_val, &uint_val, &double_val);
+        if (p == NULL)
+          return (NULL);
+      }
+      else {
+        if (end - p < ext_size)
+          return (NULL);
+        get_binary_item(p, prop->external_type, plyfile->swap,
+                        &int_val, &uint_val, &double_val);
+        p += ext_size;
+      }
+      if (item != NULL) {
+        store_item(item, prop->internal_type, int_val, uint_val, double_val);
+        item += item_size;
+      }
+    }
+  }
+
+  return (p);
+}
+
+
+/******************************************************************************
+Parse the elements of one chunk; run on a thread of its own.
+******************************************************************************/
+
+static void parse_chunk(PlyChunk *chunk)
+{
+  char *p = chunk->start;
+  char *elem_ptr = chunk->elems;
+  int i;
+
+  for (i = 0; i < chunk->count; i++) {
+    p = parse_element(chunk->plyfile, chunk->elem, p, elem_ptr,
+                      chunk->use_pool ? chunk : NULL);
+    if (p == NULL) {
+      chunk->error = 1;
+      return;
+    }
+    elem_ptr += chunk->elem_size;
+  }
+  chunk->next = p;
+}
+
+
+/******************************************************************************
+ParallelFor body: parse chunks first through last, one chunk per thread.
+******************************************************************************/
+
+static void parse_chunks(void *chunks, int first, int last)
+{
+  int i;
+
+  for (i = first; i <= last; i++)
+    parse_chunk(&((PlyChunk *) chunks)[i]);
+}
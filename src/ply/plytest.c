@@ -0,0 +1,115 @@
+/*
+  Regression check for ply_get_elements(): writes an ascii file whose lines
+  end in a blank, the way write_ascii_item() leaves them, and reads it back
+  in several chunks.  Run with "make -C src check".
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <ply.h>
+
+#define NUM_ELEMS  140000
+#define NUM_THREADS  4
+
+typedef struct TestVertex {
+  float x,y,z;
+} TestVertex;
+
+typedef struct TestFace {
+  int nverts;
+  int *verts;
+} TestFace;
+
+static PlyProperty vert_props[] = {
+  {(char *) "x", PLY_FLOAT, PLY_FLOAT, offsetof(TestVertex,x), 0, 0, 0, 0},
+  {(char *) "y", PLY_FLOAT, PLY_FLOAT, offsetof(TestVertex,y), 0, 0, 0, 0},
+  {(char *) "z", PLY_FLOAT, PLY_FLOAT, offsetof(TestVertex,z), 0, 0, 0, 0},
+};
+
+static PlyProperty face_props[] = {
+  {(char *) "vertex_indices", PLY_INT, PLY_INT, offsetof(TestFace,verts),
+   1, PLY_UCHAR, PLY_INT, offsetof(TestFace,nverts)},
+};
+
+static int write_file(const char *name)
+{
+  FILE *fp = fopen(name, "w");
+  int i;
+
+  if (fp == NULL)
+    return (0);
+  fprintf(fp, "ply\nformat ascii 1.0\n");
+  fprintf(fp, "element vertex %d\n", NUM_ELEMS);
+  fprintf(fp, "property float x\nproperty float y\nproperty float z\n");
+  fprintf(fp, "element face %d\n", NUM_ELEMS);
+  fprintf(fp, "property list uchar int vertex_indices\nend_header\n");
+  for (i = 0; i < NUM_ELEMS; i++)
+    fprintf(fp, "%d %d %d \n", i, i + 1, i + 2);
+  for (i = 0; i < NUM_ELEMS; i++)
+    fprintf(fp, "3 %d %d %d \n", i, (i + 1) % NUM_ELEMS, (i + 2) % NUM_ELEMS);
+  return (fclose(fp) == 0);
+}
+
+int main(int argc, char *argv[])
+{
+  const char *name = (argc > 1) ? argv[1] : "plytest.ply";
+  PlyFile *ply;
+  TestVertex *verts;
+  TestFace *faces;
+  void *lists = NULL;
+  char **elem_names;
+  int nelems, file_type;
+  float version;
+  int i, errors = 0;
+
+  if (!write_file(name)) {
+    fprintf(stderr, "plytest: can't write %s\n", name);
+    return (1);
+  }
+
+  ply = ply_open_for_reading((char *) name, &nelems, &elem_names,
+                             &file_type, &version);
+  if (ply == NULL) {
+    fprintf(stderr, "plytest: can't read %s\n", name);
+    return (1);
+  }
+  for (i = 0; i < 3; i++)
+    ply_get_property(ply, (char *) "vertex", &vert_props[i]);
+  ply_get_property(ply, (char *) "face", &face_props[0]);
+
+  verts = (TestVertex *) calloc(NUM_ELEMS, sizeof(TestVertex));
+  faces = (TestFace *) calloc(NUM_ELEMS, sizeof(TestFace));
+
+  ply_get_element_setup(ply, (char *) "vertex", 0, NULL);
+  if (ply_get_elements(ply, verts, sizeof(TestVertex), NUM_THREADS, NULL)
+      != NUM_ELEMS)
+    errors++;
+  ply_get_element_setup(ply, (char *) "face", 0, NULL);
+  if (ply_get_elements(ply, faces, sizeof(TestFace), NUM_THREADS, &lists)
+      != NUM_ELEMS)
+    errors++;
+
+  for (i = 0; i < NUM_ELEMS && !errors; i++) {
+    if (verts[i].x != i || verts[i].y != i + 1 || verts[i].z != i + 2) {
+      fprintf(stderr, "plytest: vertex %d is wrong\n", i);
+      errors++;
+    }
+    if (faces[i].nverts != 3 || faces[i].verts[0] != i ||
+        faces[i].verts[1] != (i + 1) % NUM_ELEMS ||
+        faces[i].verts[2] != (i + 2) % NUM_ELEMS) {
+      fprintf(stderr, "plytest: face %d is wrong\n", i);
+      errors++;
+    }
+  }
+
+  ply_free_lists(lists);
+  free(faces);
+  free(verts);
+  free(elem_names);
+  ply_close(ply);
+  remove(name);
+
+  printf("plytest: %s\n", errors ? "FAILED" : "passed");
+  return (errors ? 1 : 0);
+}
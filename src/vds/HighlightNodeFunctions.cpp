@@ -13,7 +13,7 @@
  ******************************************************************************/
 void Cut::HighlightFirstLiveTri()
 {
-	miHighlightedTri = mpNodeRefs[miHighlightedNode]->miFirstLiveTri;
+	miHighlightedTri = mNodeRefs[miHighlightedNode]->miFirstLiveTri;
 	if (miHighlightedTri != 0)
 		PrintHighlightedTriInfo();
 }
@@ -75,8 +75,8 @@ void Cut::HighlightParent()
 {
 	if (miHighlightedNode != 0)
 	{
-		if (mpForest->mpNodes[miHighlightedNode].GetParent() >= Forest::iROOT_NODE)
-			miHighlightedNode = mpForest->mpNodes[miHighlightedNode].GetParent();
+		if (mpForest->mpNodes[miHighlightedNode].miParent >= Forest::iROOT_NODE)
+			miHighlightedNode = mpForest->mpNodes[miHighlightedNode].miParent;
 		PrintHighlightedNodeInfo();
 	}
 }
@@ -87,7 +87,7 @@ void Cut::HighlightFirstChild()
 	{
 		if (mpForest->mpNodes[miHighlightedNode].miFirstChild != Forest::iNIL_NODE)
 		{
-			if (mpNodeRefs[mpForest->mpNodes[miHighlightedNode].miFirstChild] != NULL)
+			if (mNodeRefs[mpForest->mpNodes[miHighlightedNode].miFirstChild] != NULL)
 			{
 				miHighlightedNode = mpForest->mpNodes[miHighlightedNode].miFirstChild;
 				PrintHighlightedNodeInfo();
@@ -102,7 +102,7 @@ void Cut::HighlightRightSibling()
 	{
 		if (mpForest->mpNodes[miHighlightedNode].miRightSibling != Forest::iNIL_NODE)
 		{
-			if (mpNodeRefs[mpForest->mpNodes[miHighlightedNode].miRightSibling] != NULL)
+			if (mNodeRefs[mpForest->mpNodes[miHighlightedNode].miRightSibling] != NULL)
 			{
 				miHighlightedNode = mpForest->mpNodes[miHighlightedNode].miRightSibling;
 				PrintHighlightedNodeInfo();
@@ -117,7 +117,7 @@ void Cut::HighlightLeftSibling()
 	{
 		if (mpForest->mpNodes[miHighlightedNode].miLeftSibling != Forest::iNIL_NODE)
 		{
-			if (mpNodeRefs[mpForest->mpNodes[miHighlightedNode].miLeftSibling] != NULL)
+			if (mNodeRefs[mpForest->mpNodes[miHighlightedNode].miLeftSibling] != NULL)
 			{
 				miHighlightedNode = mpForest->mpNodes[miHighlightedNode].miLeftSibling;
 				PrintHighlightedNodeInfo();
@@ -133,7 +133,7 @@ void Cut::FoldHighlightedNode()
 
 	if (miHighlightedNode != 0)
 	{
-		mpSimplifier->Fold(mpNodeRefs[miHighlightedNode], NumTris, BytesUsed);
+		mpSimplifier->Fold(mNodeRefs[miHighlightedNode], NumTris, BytesUsed);
 	}
 }
 
@@ -159,7 +159,7 @@ void Cut::FullyFoldNode(NodeIndex node, unsigned int &NumTris, unsigned int &Byt
 		child = mpForest->mpNodes[child].miRightSibling;
 	}
 	if (mpForest->mpNodes[node].miFirstChild != Forest::iNIL_NODE)
-		mpSimplifier->Fold(mpNodeRefs[node], NumTris, BytesUsed);
+		mpSimplifier->Fold(mNodeRefs[node], NumTris, BytesUsed);
 }
 
 void Cut::FullyUnfoldHighlightedNode()
@@ -177,7 +177,7 @@ void Cut::FullyUnfoldNode(NodeIndex node, unsigned int &NumTris, unsigned int &B
 {
 	NodeIndex child;
 	if (mpForest->mpNodes[node].miFirstChild != Forest::iNIL_NODE)
-		mpSimplifier->Unfold(mpNodeRefs[node], NumTris, BytesUsed);
+		mpSimplifier->Unfold(mNodeRefs[node], NumTris, BytesUsed);
 
 	child = mpForest->mpNodes[node].miFirstChild;
 	
@@ -191,6 +191,6 @@ void Cut::FullyUnfoldNode(NodeIndex node, unsigned int &NumTris, unsigned int &B
 void Cut::UnfoldHighlightedNode()
 {
 	unsigned int NumTris, BytesUsed;
-	mpSimplifier->Unfold(mpNodeRefs[miHighlightedNode], NumTris, BytesUsed);
+	mpSimplifier->Unfold(mNodeRefs[miHighlightedNode], NumTris, BytesUsed);
 }
 
@@ -29,8 +29,6 @@ Cut::Cut()
 	mpForest = NULL;
 	mpRenderer = NULL;
 	mpSimplifier = NULL;
-	mpNodeRefs = NULL;
-    mpTriRefs = NULL;
 	mIsValid = false;
 	mNumActiveNodes = 0;
 	mNumActiveTris = 0;
@@ -40,6 +38,8 @@ Cut::Cut()
 								0, 0, 1, 0,
 								0, 0, 0, 1};
 	mTransformMatrix.Set(identitymatrix);
+	mErrorMatrix.Set(identitymatrix);
+	mViewMotion = 0.0;
 	miHighlightedNode = 0;
 	miHighlightedTri = 0;
 	mpExternalViewClass = NULL;
@@ -47,30 +47,32 @@ Cut::Cut()
 
 Cut::~Cut()
 {
-    if (mpNodeRefs != NULL)
+    if (mNodeRefs.IsInitialized())
     {
 		int i;
-        unsigned int j;
+        NodeIndex j;
+        BudgetItem *pItem;
 
-        // nullify the mpNodeRefs that are in the fold queue ... they're already free'd
+        // nullify the mNodeRefs that are in the fold queue ... they're already free'd
         NodeQueue* q = mpSimplifier->mpFoldQueue;
         for(i = 0; i <= q->Size; i++)
-            mpNodeRefs[q->GetElement(i)->miNode] = NULL;
+        {
+            pItem = q->GetElement(i);
+            if (mNodeRefs.Get(pItem->miNode) == pItem)
+                mNodeRefs.Set(pItem->miNode, NULL);
+        }
         
         q = mpSimplifier->mpUnfoldQueue;
-        for(i = 0; i <= q->Size; i++) {
-            mpNodeRefs[q->GetElement(i)->miNode] = NULL;
+        for(i = 0; i <= q->Size; i++)
+        {
+            pItem = q->GetElement(i);
+            if (mNodeRefs.Get(pItem->miNode) == pItem)
+                mNodeRefs.Set(pItem->miNode, NULL);
         }
 
-        for(j = 0; j < mpForest->mNumNodes+1; j++)
-            if(mpNodeRefs[j] != NULL)
-                delete mpNodeRefs[j];
-        
-        delete[] mpNodeRefs;
-    }
-    if (mpTriRefs != NULL)
-    {
-        delete[] mpTriRefs;
+        for(j = mNodeRefs.NextAllocated(0); j < mNodeRefs.GetNumEntries(); j = mNodeRefs.NextAllocated(j+1))
+            if(mNodeRefs.Get(j) != NULL)
+                delete mNodeRefs.Get(j);
     }
 }
 
@@ -82,6 +84,8 @@ void Cut::GiveContents(Cut *pCut)
 	pCut->mpSimplifier = mpSimplifier;
 	pCut->mNumActiveTris = mNumActiveTris;
 	pCut->mTransformMatrix = mTransformMatrix;
+	pCut->mErrorMatrix = mErrorMatrix;
+	pCut->mViewMotion = mViewMotion;
 }
 
 void Cut::SetRenderer(Renderer *pRenderer)
@@ -242,25 +246,19 @@ void Cut::SetViewPoint(const Point3 &rViewpoint)
 
 void Cut::InitializeRefs()
 {
-	unsigned int i;
 	if (mpForest == NULL)
 	{
 		cerr << "Error - must set mpForest pointer before initializing refs in cut" << endl;
 		return;
 	}
 
-	mpNodeRefs = new BudgetItem*[mpForest->mNumNodes+1];
+	mNodeRefs.Initialize(mpForest->mNumNodes+1);
 
 	// refs actuallly are of type pointer to TriProxyBackRef because they point to the triangle's
 	// location in the array of backrefs.  this location is needed more often than the triangle's
 	// location in the array of proxies, which can be calcuated by finding the index of the location
 	// in the array of backrefs and using that to index into the array of proxies
-	mpTriRefs = new TriProxyBackRef*[mpForest->mNumTris+1];
-
-	for (i = 0; i <mpForest->mNumNodes+1; ++i)
-		mpNodeRefs[i] = NULL;
-	for (i = 0; i <mpForest->mNumTris+1; ++i)
-		mpTriRefs[i] = NULL;
+	mTriRefs.Initialize(mpForest->mNumTris+1);
 }
 
 void Cut::CheckForDuplicateNodeRefs()
@@ -268,15 +266,15 @@ void Cut::CheckForDuplicateNodeRefs()
 	NodeIndex i,j;
 	for (i = 1; i <= mpForest->mNumNodes; ++i)
 	{
-		if (mpNodeRefs[i] != NULL)
+		if (mNodeRefs.Get(i) != NULL)
 		{
 			for (j = 1; j <= mpForest->mNumNodes; ++j)
 			{
-				if ((mpNodeRefs[i] == mpNodeRefs[j]) && (i != j))
+				if ((mNodeRefs.Get(i) == mNodeRefs.Get(j)) && (i != j))
 					cout << "error: nodes " << i << " and " << j << " have identical NodeRefs" << endl;
-				if (mpNodeRefs[j] != NULL)
+				if (mNodeRefs.Get(j) != NULL)
 				{
-					if ((mpNodeRefs[i]->pVertexRenderDatum == mpNodeRefs[j]->pVertexRenderDatum) && (i != j))
+					if ((mNodeRefs.Get(i)->pVertexRenderDatum == mNodeRefs.Get(j)->pVertexRenderDatum) && (i != j))
 						cout << "error: nodes " << i << " and " << j << " have identical pVertexRenderDatums" << endl;
 				}
 			}
@@ -18,6 +18,7 @@
 #include "renderer.h"
 #include "simplifier.h"
 #include "forest.h"
+#include "reftable.h"
 
 class VDS::Cut
 {
@@ -46,7 +47,7 @@ public: // PUBLIC FUNCTIONS
 	// Call after SetTransformationMatrix() to update the view-dependent simplification parameters using the new matrix
 //	void UpdateViewParametersFromMatrix();
 
-	// initializes NodeRefs and TriRefs
+	// (re)initializes NodeRefs and TriRefs, all NULL
 	void InitializeRefs();
 	
 // DEBUG FUNCTIONS
@@ -83,9 +84,16 @@ public: // PUBLIC DATA
 	unsigned int mBytesPerNode;
 	Mat4 mTransformMatrix; // object-to-eye transformation matrix
 
-	// Refs
-	BudgetItem **mpNodeRefs;
-	TriProxyBackRef **mpTriRefs;
+	// view motion tracking for Simplifier::UpdateNodeErrors(): mErrorMatrix is
+	// the transform at the last update, mViewMotion the sum of the largest
+	// matrix entry changes between updates since the cut was created
+	Mat4 mErrorMatrix;
+	double mViewMotion;
+
+	// Refs; paged so that a cut only holds refs for the part of the forest
+	// it has reached - the forest itself is shared by every cut on it
+	RefTable<BudgetItem> mNodeRefs;
+	RefTable<TriProxyBackRef> mTriRefs;
 
 	// view information:
 //	Point3 mViewpoint;
@@ -113,7 +121,6 @@ public: // PUBLIC DATA
 
 	//Friends
 	friend class Tree;
-	friend class Tri;
 	friend class ForestBuilder;
 };
 
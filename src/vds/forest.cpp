@@ -20,6 +20,14 @@
 #pragma warning(disable: 4530)
 
 #include <windows.h>
+#define fseeko _fseeki64
+#define ftello _ftelli64
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 #include <cassert>
@@ -45,18 +53,14 @@ using namespace VDS;
 const NodeIndex Forest::iNIL_NODE  = 0;
 const NodeIndex Forest::iNIL_TRI   = 0;
 const NodeIndex Forest::iROOT_NODE = 1;
-const unsigned int Forest::VDS_FILE_FORMAT_MAJOR = 1;
-const unsigned int Forest::VDS_FILE_FORMAT_MINOR = 4;
+const unsigned int Forest::VDS_FILE_FORMAT_MAJOR = 3;
+const unsigned int Forest::VDS_FILE_FORMAT_MINOR = 0;
+const unsigned int Forest::VDS_FILE_ALIGNMENT = 64;
 const unsigned int Forest::VIF_FILE_FORMAT_MAJOR = 2;
 const unsigned int Forest::VIF_FILE_FORMAT_MINOR = 1;
 
 // utility function prototypes
 void sort_three(NodeIndex &rA, NodeIndex &rB, NodeIndex &rC);
-#ifdef _WIN32
-void WriteArray(void *pArray, unsigned int Length, HANDLE FileHandle);
-#else
-void WriteArray(void *pArray, unsigned int Length, int FileHandle);
-#endif
 
 Forest::Forest()
 {
@@ -69,6 +73,9 @@ Forest::Forest()
     mIsValid = false;
     mIsMMapped = false;
 	mMMapFile = NULL;
+#ifndef _WIN32
+	mMMapSize = 0;
+#endif
     mNumNodes = 0;
 	mNumNodePositions = 0;
 	mNumPatches = 0;
@@ -80,6 +87,12 @@ Forest::Forest()
 	mNumErrorParams = 0;
 	mErrorParamSize = 0;
 	mpErrorParams = NULL;
+	mpPreorderRanks = NULL;
+	mNumDirectPositionsAllocated = 0;
+	mNumDirectNodesAllocated = 0;
+	mNumDirectTrisAllocated = 0;
+	mNumDirectMerges = 0;
+	mDirectBuildFailed = false;
 }
 
 Forest::~Forest()
@@ -95,8 +108,10 @@ void Forest::GiveContents(Forest &rForest)
 	rForest.mpTris = mpTris;
     rForest.mNumNodes = mNumNodes;
 	rForest.mNumTris = mNumTris;
+	rForest.mpPreorderRanks = mpPreorderRanks;
     mpNodes = NULL;
     mpTris = NULL;
+	mpPreorderRanks = NULL;
     mIsValid = false;
     mNumNodes = 0;
 	mNumTris = 0;
@@ -104,6 +119,9 @@ void Forest::GiveContents(Forest &rForest)
     {
         rForest.mIsMMapped = true;
         rForest.mMMapFile = mMMapFile;
+#ifndef _WIN32
+        rForest.mMMapSize = mMMapSize;
+#endif
 #ifdef _WIN32
 	UnmapViewOfFile(mMMapFile);
 #endif
@@ -114,12 +132,6 @@ void Forest::GiveContents(Forest &rForest)
 bool Forest::GetDataFromVif(const Vif &v)
 {
 	unsigned int i,j;
-//    Point2 *tex_coords;
-	Float mAvgEdgeLength;
-	NodeIndex root;
-	TriIndex tri;
-    NodeIndex a, b, c;
-    NodeIndex ab_first_ancestor, bc_first_ancestor;
 
 	Reset();
 
@@ -135,6 +147,7 @@ bool Forest::GetDataFromVif(const Vif &v)
 	{
 		mErrorParamSize = v.ErrorParamSize;
 		mpErrorParams = new float[mNumErrorParams * mErrorParamSize];
+		memcpy(mpErrorParams, v.ErrorParams, mNumErrorParams * mErrorParamSize * sizeof(float));
 	}
 	else
 	{
@@ -142,8 +155,6 @@ bool Forest::GetDataFromVif(const Vif &v)
 		mpErrorParams = NULL;
 	}
 
-	mAvgEdgeLength = 0.0;
-
 	mpNodeRenderData = new VertexRenderDatum[mNumNodePositions];
 	for (i = 0; i < mNumNodePositions; ++i)
 	{
@@ -157,26 +168,7 @@ bool Forest::GetDataFromVif(const Vif &v)
 		}
 	}
 
-	mpNodes = new Node[mNumNodes + 1];
-	TriIndex *FirstLiveTris = new TriIndex[mNumNodes + 1];
-	for (i = 0; i <= mNumNodes; ++i)
-	{
-		mpNodes[i].miParent = iNIL_NODE;
-		mpNodes[i].miLeftSibling = iNIL_NODE;
-		mpNodes[i].miRightSibling = iNIL_NODE;
-		mpNodes[i].miFirstChild = iNIL_NODE;
-		mpNodes[i].miFirstSubTri = iNIL_TRI;
-//		mpNodes[i].mRadius = 0.0f;
-		mpNodes[i].mXBBoxOffset = 0;
-		mpNodes[i].mYBBoxOffset = 0;
-		mpNodes[i].mZBBoxOffset = 0;
-		mpNodes[i].mBBoxCenter.X = 0;
-		mpNodes[i].mBBoxCenter.Y = 0;
-		mpNodes[i].mBBoxCenter.Z = 0;
-		mpNodes[i].mCoincidentVertex = iNIL_NODE;
-		FirstLiveTris[i] = iNIL_TRI;
-	}
-
+	mpNodes = new Node[mNumNodes + 1]();
 	for (i = 1; i <= mNumNodes; ++i)
 	{
 		mpNodes[i].mpRenderData = &(mpNodeRenderData[v.Vertices[i-1].VertexPosition]);
@@ -189,68 +181,229 @@ bool Forest::GetDataFromVif(const Vif &v)
 		{
 			mpNodes[i].mCoincidentVertex = iNIL_NODE;
 		}
+	}
+
+	mpTris = new Tri[mNumTris + 1]();
+	for (i = 1; i <= mNumTris; ++i)
+	{
+		mpTris[i].miCorners[0] = v.Triangles[i-1].Corners[0] + 1;
+		mpTris[i].miCorners[1] = v.Triangles[i-1].Corners[1] + 1;
+		mpTris[i].miCorners[2] = v.Triangles[i-1].Corners[2] + 1;
+		mpTris[i].mPatchID = v.Triangles[i-1].PatchID - 1;
+	}
+
+	for (i = 0; i < v.NumMerges; ++i)
+	{
+		mpNodes[v.Merges[i].ParentNode+1].miErrorParamIndex = v.Merges[i].ErrorParamIndex;
+		if (v.Merges[i].NumNodesInMerge <= 0)
+		{
+			cerr << "Error - Merge " << i << " has NumNodesInMerge = " << v.Merges[i].NumNodesInMerge << endl;
+			return false;
+		}
+		mpNodes[v.Merges[i].ParentNode+1].miFirstChild = v.Merges[i].NodesBeingMerged[0]+1;
+		for (j = 0; j < v.Merges[i].NumNodesInMerge; ++j)
+		{
+			mpNodes[v.Merges[i].NodesBeingMerged[j]+1].miParent = v.Merges[i].ParentNode+1;
+			if (j != (v.Merges[i].NumNodesInMerge - 1))
+				mpNodes[v.Merges[i].NodesBeingMerged[j]+1].miRightSibling = v.Merges[i].NodesBeingMerged[j+1]+1;
+			if (j != 0)
+				mpNodes[v.Merges[i].NodesBeingMerged[j]+1].miLeftSibling = v.Merges[i].NodesBeingMerged[j-1]+1;
+		}
+		mpNodes[v.Merges[i].NodesBeingMerged[v.Merges[i].NumNodesInMerge-1]+1].miRightSibling = iNIL_NODE;
+		mpNodes[v.Merges[i].NodesBeingMerged[0]+1].miLeftSibling = iNIL_NODE;
+	}
+	if (v.NumMerges == 0)
+	{
+		// TODO: need to put nodes in node vector and call cluster_octtree
+		fprintf(stderr, "Error - Hierarchy not found or unusable; Forest::GetDataFromVif() hierarchy generation not implemented yet.\n");
+		return false;
+	}
+
+	return FinishBuild();
+}
 
+void Forest::BeginDirectBuild(PatchIndex NumPatches, bool ColorsPresent, bool NormalsPresent, unsigned int NumTextures)
+{
+	Reset();
+
+	mColorsPresent = ColorsPresent;
+	mNormalsPresent = NormalsPresent;
+	mNumTextures = NumTextures;
+	mNumPatches = NumPatches;
+	mNumNodePositions = 0;
+	mErrorParamSize = 0;
+
+	mNumDirectPositionsAllocated = 1024;
+	mNumDirectNodesAllocated = 1024;
+	mNumDirectTrisAllocated = 1024;
+	mNumDirectMerges = 0;
+	mDirectBuildFailed = false;
+	mpNodeRenderData = new VertexRenderDatum[mNumDirectPositionsAllocated];
+	mpNodes = new Node[mNumDirectNodesAllocated + 1]();
+	mpTris = new Tri[mNumDirectTrisAllocated + 1]();
+}
+
+NodeIndex Forest::AddDirectNodePosition(const VertexRenderDatum &rDatum)
+{
+	assert(mNumDirectPositionsAllocated > 0);
+	if (mNumNodePositions == mNumDirectPositionsAllocated)
+	{
+		VertexRenderDatum *new_render_data = new VertexRenderDatum[mNumDirectPositionsAllocated * 2];
+		memcpy(new_render_data, mpNodeRenderData, mNumNodePositions * sizeof(VertexRenderDatum));
+		delete[] mpNodeRenderData;
+		mpNodeRenderData = new_render_data;
+		mNumDirectPositionsAllocated *= 2;
+	}
+	mpNodeRenderData[mNumNodePositions] = rDatum;
+	if (mNumTextures == 0)
+		mpNodeRenderData[mNumNodePositions].TexCoords.Set(0.0f, 0.0f);
+	mpNodeRenderData[mNumNodePositions].Node = iNIL_NODE;
+	return mNumNodePositions++;
+}
+
+// Until EndDirectBuild() a node's mpRenderData holds its position's index,
+// as in a binary VDS file, since mpNodeRenderData moves as it grows.
+NodeIndex Forest::AddDirectNode(NodeIndex iPosition, PatchIndex PatchID)
+{
+	assert(mNumDirectNodesAllocated > 0);
+	assert(iPosition < mNumNodePositions);
+	if (mNumNodes == mNumDirectNodesAllocated)
+	{
+		Node *new_nodes = new Node[mNumDirectNodesAllocated * 2 + 1]();
+		memcpy(new_nodes, mpNodes, (mNumNodes + 1) * sizeof(Node));
+		delete[] mpNodes;
+		mpNodes = new_nodes;
+		mNumDirectNodesAllocated *= 2;
+	}
+	++mNumNodes;
+	mpNodes[mNumNodes].mpRenderData = (VertexRenderDatum *) (uintptr_t) iPosition;
+	mpNodes[mNumNodes].mPatchID = PatchID;
+	return mNumNodes;
+}
+
+NodeIndex Forest::CloneDirectNode(NodeIndex iNode)
+{
+	assert((iNode >= iROOT_NODE) && (iNode <= mNumNodes));
+	return AddDirectNode((NodeIndex) (uintptr_t) mpNodes[iNode].mpRenderData, mpNodes[iNode].mPatchID);
+}
+
+void Forest::SetDirectCoincidentVertex(NodeIndex iNode, NodeIndex iNext)
+{
+	assert((iNode >= iROOT_NODE) && (iNode <= mNumNodes));
+	assert((iNext >= iROOT_NODE) && (iNext <= mNumNodes));
+	mpNodes[iNode].mCoincidentVertex = iNext;
+}
+
+TriIndex Forest::AddDirectTri(NodeIndex iCorner0, NodeIndex iCorner1, NodeIndex iCorner2, PatchIndex PatchID)
+{
+	assert(mNumDirectTrisAllocated > 0);
+	if (mNumTris == mNumDirectTrisAllocated)
+	{
+		Tri *new_tris = new Tri[mNumDirectTrisAllocated * 2 + 1]();
+		memcpy(new_tris, mpTris, (mNumTris + 1) * sizeof(Tri));
+		delete[] mpTris;
+		mpTris = new_tris;
+		mNumDirectTrisAllocated *= 2;
+	}
+	++mNumTris;
+	mpTris[mNumTris].miCorners[0] = iCorner0;
+	mpTris[mNumTris].miCorners[1] = iCorner1;
+	mpTris[mNumTris].miCorners[2] = iCorner2;
+	mpTris[mNumTris].mPatchID = PatchID;
+	return mNumTris;
+}
+
+void Forest::AddDirectMerge(NodeIndex iParent, unsigned int NumChildren, const NodeIndex *piChildren)
+{
+	unsigned int j;
+
+	if (NumChildren == 0)
+	{
+		cerr << "Error - Merge " << mNumDirectMerges << " has no nodes." << endl;
+		mDirectBuildFailed = true;
+		return;
+	}
+	mpNodes[iParent].miFirstChild = piChildren[0];
+	for (j = 0; j < NumChildren; ++j)
+	{
+		mpNodes[piChildren[j]].miParent = iParent;
+		mpNodes[piChildren[j]].miLeftSibling = (j == 0) ? iNIL_NODE : piChildren[j-1];
+		mpNodes[piChildren[j]].miRightSibling = (j == NumChildren - 1) ? iNIL_NODE : piChildren[j+1];
+	}
+	++mNumDirectMerges;
+}
+
+bool Forest::EndDirectBuild()
+{
+	assert(mNumDirectPositionsAllocated > 0);
+
+	// nodes and tris are copied to their exact size when they are put in
+	// depth-first order; the render data is trimmed here
+	if (mNumNodePositions < mNumDirectPositionsAllocated)
+	{
+		VertexRenderDatum *new_render_data = new VertexRenderDatum[mNumNodePositions];
+		memcpy(new_render_data, mpNodeRenderData, mNumNodePositions * sizeof(VertexRenderDatum));
+		delete[] mpNodeRenderData;
+		mpNodeRenderData = new_render_data;
+	}
+	VertexRenderDataIndicesToPointers();
+
+	mNumDirectPositionsAllocated = 0;
+	mNumDirectNodesAllocated = 0;
+	mNumDirectTrisAllocated = 0;
+
+	if (mDirectBuildFailed)
+		return false;
+	if (mNumDirectMerges == 0)
+	{
+		cerr << "Error - Forest::EndDirectBuild() called without any merges." << endl;
+		return false;
+	}
+	return FinishBuild();
+}
+
+bool Forest::FinishBuild()
+{
+	unsigned int i;
+	NodeIndex root;
+	NodeIndex node;
+	TriIndex tri;
+    NodeIndex a, b, c;
+    NodeIndex ab_first_ancestor, bc_first_ancestor;
+
+	for (i = 1; i <= mNumNodes; ++i)
+	{
 		if (mpNodes[i].mPatchID >= mNumPatches)
 		{
 			cerr << "Error - node " << i << " has PatchID out of range." << endl;
 			return false;
 		}
-
 	}
 
-	unsigned int node;
-    for (node = 0; node < v.NumVerts; node++)
+    for (node = 1; node <= mNumNodes; node++)
     {
-		if (v.Vertices[node].CoincidentVertexFlag)
+		if (mpNodes[node].mCoincidentVertex != iNIL_NODE)
 		{
 			i = node;
-			if (v.Vertices[i].CoincidentVertex == i)
+			if (mpNodes[i].mCoincidentVertex == i)
 			{
 				cerr << "Error - Coincident vertex points to self." << endl;
 				return false;
 			}
-			while (v.Vertices[i].CoincidentVertex != node)
+			while (mpNodes[i].mCoincidentVertex != node)
 			{
-				if (!v.Vertices[i].CoincidentVertexFlag)
+				if (mpNodes[i].mCoincidentVertex == iNIL_NODE)
 				{
 					cerr << "Error - Coincident vertex doesn't have coincident vertex flag set." << endl;
 					return false;
 				}
-				i = v.Vertices[i].CoincidentVertex;
+				i = mpNodes[i].mCoincidentVertex;
 			}
 		}
 	}
 
-	mpTris = new Tri[mNumTris + 1];
-	TriIndex **NextLiveTris = new TriIndex*[mNumTris + 1];
-	for (i = 1; i <= mNumTris; ++i)
-	{
-		mpTris[i].miNextSubTri = iNIL_TRI;
-		mpTris[i].miCorners[0] = iNIL_TRI;
-		mpTris[i].miCorners[1] = iNIL_TRI;
-		mpTris[i].miCorners[2] = iNIL_TRI;
-
-		NextLiveTris[i] = new TriIndex[3];
-		NextLiveTris[i][0] = iNIL_TRI;
-		NextLiveTris[i][1] = iNIL_TRI;
-		NextLiveTris[i][2] = iNIL_TRI;
-	}
-
 	for (i = 1; i <= mNumTris; ++i)
 	{
-		mpTris[i].miCorners[0] = v.Triangles[i-1].Corners[0] + 1;
-		mpTris[i].miCorners[1] = v.Triangles[i-1].Corners[1] + 1;
-		mpTris[i].miCorners[2] = v.Triangles[i-1].Corners[2] + 1;
-		mpTris[i].mPatchID = v.Triangles[i-1].PatchID - 1;
-		mpTris[i].AddToLiveTriListUsingCorners(i, 0, *this, FirstLiveTris, NextLiveTris);
-		mpTris[i].AddToLiveTriListUsingCorners(i, 1, *this, FirstLiveTris, NextLiveTris);
-		mpTris[i].AddToLiveTriListUsingCorners(i, 2, *this, FirstLiveTris, NextLiveTris);
-
-		for (j = 0; j < 3; j++)
-		{
-			mAvgEdgeLength += mpNodes[mpTris[i].miCorners[j]].mpRenderData->Position.DistanceTo(mpNodes[mpTris[i].miCorners[(j + 1) % 3]].mpRenderData->Position);
-		}
-
 		if ((mpTris[i].mPatchID != mpNodes[mpTris[i].miCorners[0]].mPatchID)
 			|| (mpTris[i].mPatchID != mpNodes[mpTris[i].miCorners[1]].mPatchID)
 			|| (mpTris[i].mPatchID != mpNodes[mpTris[i].miCorners[2]].mPatchID))
@@ -266,32 +419,21 @@ bool Forest::GetDataFromVif(const Vif &v)
 		}
 	}
 
-	mAvgEdgeLength /= ((Float) mNumTris * 3.0);
-	for (i = 0; i < v.NumMerges; ++i)
+	TriIndex *FirstLiveTris = new TriIndex[mNumNodes + 1];
+	for (i = 0; i <= mNumNodes; ++i)
 	{
-		mpNodes[v.Merges[i].ParentNode+1].miErrorParamIndex = v.Merges[i].ErrorParamIndex;
-		if (v.Merges[i].NumNodesInMerge <= 0)
-		{
-			cerr << "Error - Merge " << i << " has NumNodesInMerge = " << v.Merges[i].NumNodesInMerge << endl;
-			return false;
-		}
-		mpNodes[v.Merges[i].ParentNode+1].miFirstChild = v.Merges[i].NodesBeingMerged[0]+1;
-		for (j = 0; j < v.Merges[i].NumNodesInMerge; ++j)
-		{
-			mpNodes[v.Merges[i].NodesBeingMerged[j]+1].miParent = v.Merges[i].ParentNode+1;
-			if (j != (v.Merges[i].NumNodesInMerge - 1))
-				mpNodes[v.Merges[i].NodesBeingMerged[j]+1].miRightSibling = v.Merges[i].NodesBeingMerged[j+1]+1;
-			if (j != 0)
-				mpNodes[v.Merges[i].NodesBeingMerged[j]+1].miLeftSibling = v.Merges[i].NodesBeingMerged[j-1]+1;
-		}
-		mpNodes[v.Merges[i].NodesBeingMerged[v.Merges[i].NumNodesInMerge-1]+1].miRightSibling = iNIL_NODE;
-		mpNodes[v.Merges[i].NodesBeingMerged[0]+1].miLeftSibling = iNIL_NODE;
+		FirstLiveTris[i] = iNIL_TRI;
 	}
-	if (v.NumMerges == 0)
+	TriIndex **NextLiveTris = new TriIndex*[mNumTris + 1];
+	for (i = 1; i <= mNumTris; ++i)
 	{
-		// TODO: need to put nodes in node vector and call cluster_octtree
-		fprintf(stderr, "Error - Hierarchy not found or unusable; Forest::GetDataFromVif() hierarchy generation not implemented yet.\n");
-		return false;
+		NextLiveTris[i] = new TriIndex[3];
+		NextLiveTris[i][0] = iNIL_TRI;
+		NextLiveTris[i][1] = iNIL_TRI;
+		NextLiveTris[i][2] = iNIL_TRI;
+		TriAddToLiveTriListUsingCorners(i, 0, *this, FirstLiveTris, NextLiveTris);
+		TriAddToLiveTriListUsingCorners(i, 1, *this, FirstLiveTris, NextLiveTris);
+		TriAddToLiveTriListUsingCorners(i, 2, *this, FirstLiveTris, NextLiveTris);
 	}
 
 	root = 1;
@@ -320,7 +462,7 @@ bool Forest::GetDataFromVif(const Vif &v)
         
         if (bc_first_ancestor >= a) //found node tri is subtri of
         {
-            mpTris[tri].AddToSubTriList(tri, bc_first_ancestor, *this);
+            TriAddToSubTriList(tri, bc_first_ancestor, *this);
         }
         else //the node the tri is a subtri of is ancestor of a,b
         {       
@@ -329,7 +471,7 @@ bool Forest::GetDataFromVif(const Vif &v)
             {        
                 ab_first_ancestor = mpNodes[ab_first_ancestor].miParent;
 			}
-            mpTris[tri].AddToSubTriList(tri, ab_first_ancestor, *this);
+            TriAddToSubTriList(tri, ab_first_ancestor, *this);
         }
     }	
 
@@ -340,10 +482,6 @@ bool Forest::GetDataFromVif(const Vif &v)
 			if (mpNodes[i].miFirstChild == iNIL_NODE)
 				mpNodes[i].miErrorParamIndex = 0;
 		}
-		if (mpErrorParams != NULL)
-			delete[] mpErrorParams;
-		mpErrorParams = new float[mNumErrorParams * mErrorParamSize];
-		memcpy(mpErrorParams, v.ErrorParams, mNumErrorParams * mErrorParamSize * sizeof(float));
 	}
 	else
 	{
@@ -507,334 +645,361 @@ bool Forest::GiveDataToVif(Vif &v)
 	return true;
 }
 
-int Forest::ReadBinaryVDSfromBuffer(char* buffer)
+static const char VDS_FILE_MAGIC[4] = { 'V', 'D', 'S', 'F' };
+static const uint32_t VDS_FILE_BYTE_ORDER = 0x01020304;
+
+static uint64_t AlignFileOffset(uint64_t Offset)
 {
-  char* cur_buf = buffer;
-  DWORD num_bytes_read = 0;
-  unsigned int major, minor;
+	uint64_t a = Forest::VDS_FILE_ALIGNMENT;
+	return (Offset + a - 1) / a * a;
+}
 
-  Reset();
-  mIsMMapped = false;
-	
-#define READ(a,b,c,d,e) memcpy((void*)b, cur_buf, c); cur_buf += c; *d += c;
-  READ(hFile, &major, sizeof(VDS_FILE_FORMAT_MAJOR), &num_bytes_read, NULL);
-  READ(hFile, &minor, sizeof(VDS_FILE_FORMAT_MINOR), &num_bytes_read, NULL);
-  if (major != VDS_FILE_FORMAT_MAJOR || minor != VDS_FILE_FORMAT_MINOR)
-  {
-    cerr << "Incompatible VDS file version." << endl;
-    return 0;
-  }    
-  
-  READ(hFile, &mColorsPresent, sizeof(mColorsPresent), &num_bytes_read, NULL);
-  READ(hFile, &mNormalsPresent, sizeof(mNormalsPresent), &num_bytes_read, NULL);
-  READ(hFile, &mNumTextures, sizeof(mNumTextures), &num_bytes_read, NULL);
-  READ(hFile, &mNumNodes, sizeof(NodeIndex), &num_bytes_read, NULL);
-  READ(hFile, &mNumNodePositions, sizeof(NodeIndex), &num_bytes_read, NULL);
-  READ(hFile, &mNumTris, sizeof(NodeIndex), &num_bytes_read, NULL);
-  READ(hFile, &mNumPatches, sizeof(PatchIndex), &num_bytes_read, NULL);
-  READ(hFile, &mNumErrorParams, sizeof(NodeIndex), &num_bytes_read, NULL);
-  READ(hFile, &mErrorParamSize, sizeof(int), &num_bytes_read, NULL);
-  
-  mpErrorParams = new float[mNumErrorParams * mErrorParamSize];
-  READ(hFile, mpErrorParams, mErrorParamSize * mNumErrorParams * sizeof(float), &num_bytes_read, NULL);
-  
-  mpNodes = new Node[mNumNodes + 1];
-  READ(hFile, mpNodes, sizeof(Node) * (mNumNodes + 1), &num_bytes_read, NULL);
-
-  mpNodeRenderData = new VertexRenderDatum[mNumNodePositions];
-  READ(hFile, mpNodeRenderData, sizeof(VertexRenderDatum) * (mNumNodePositions), &num_bytes_read, NULL);
-  
-  mpTris = new Tri[mNumTris + 1];
-  READ(hFile, mpTris, sizeof(Tri) * (mNumTris + 1), &num_bytes_read,NULL);
-    
-  VertexRenderDataIndicesToPointers();
-
-  SetValid();
-  return 1;
+void Forest::FillFileHeader(VDSFileHeader &rHeader)
+{
+	memset(&rHeader, 0, sizeof(rHeader));
+	memcpy(rHeader.Magic, VDS_FILE_MAGIC, sizeof(rHeader.Magic));
+	rHeader.Major = VDS_FILE_FORMAT_MAJOR;
+	rHeader.Minor = VDS_FILE_FORMAT_MINOR;
+	rHeader.HeaderSize = sizeof(VDSFileHeader);
+	rHeader.ByteOrder = VDS_FILE_BYTE_ORDER;
+	rHeader.NodeSize = sizeof(Node);
+	rHeader.TriSize = sizeof(Tri);
+	rHeader.RenderDatumSize = sizeof(VertexRenderDatum);
+	rHeader.ColorsPresent = mColorsPresent;
+	rHeader.NormalsPresent = mNormalsPresent;
+	rHeader.NumTextures = mNumTextures;
+	rHeader.NumPatches = mNumPatches;
+	rHeader.ErrorParamSize = mErrorParamSize;
+	rHeader.NumNodes = mNumNodes;
+	rHeader.NumNodePositions = mNumNodePositions;
+	rHeader.NumTris = mNumTris;
+	rHeader.NumErrorParams = mNumErrorParams;
+
+	rHeader.ErrorParamsOffset = AlignFileOffset(sizeof(VDSFileHeader));
+	rHeader.NodesOffset = AlignFileOffset(rHeader.ErrorParamsOffset +
+		rHeader.NumErrorParams * mErrorParamSize * sizeof(float));
+	rHeader.RenderDataOffset = AlignFileOffset(rHeader.NodesOffset +
+		(rHeader.NumNodes + 1) * sizeof(Node));
+	rHeader.TrisOffset = AlignFileOffset(rHeader.RenderDataOffset +
+		rHeader.NumNodePositions * sizeof(VertexRenderDatum));
+	rHeader.FileSize = rHeader.TrisOffset + (rHeader.NumTris + 1) * sizeof(Tri);
 }
 
-bool Forest::ReadBinaryVDS(const char *Filename)
+// true if Count elements of ElementSize bytes at Offset lie in [Start, End)
+static bool FileSectionFits(uint64_t Offset, uint64_t Count, uint64_t ElementSize,
+	uint64_t Start, uint64_t End)
 {
-#ifdef _WIN32
-    HANDLE hFile; 
-#else
-    int hFile;
-#endif
-    DWORD num_bytes_read;
-    unsigned int major, minor;
+	if (Offset < Start || Offset > End)
+		return false;
+	return ElementSize == 0 || Count <= (End - Offset) / ElementSize;
+}
 
-    Reset();
-    mIsMMapped = false;
-#ifdef _WIN32	
-    hFile = CreateFile(Filename,       // create Filename
-		GENERIC_READ,                // open for reading 
-		0,                            // do not share
-		NULL,                         // no security 
-		OPEN_EXISTING,                // open existing file only 
-		FILE_ATTRIBUTE_NORMAL,        // normal file
-		NULL);                        // no attr. template 
+// Size is how many bytes are actually there, or 0 if unknown
+bool Forest::CheckFileHeader(const VDSFileHeader &rHeader, uint64_t Size)
+{
+	if (memcmp(rHeader.Magic, VDS_FILE_MAGIC, sizeof(rHeader.Magic)) != 0)
+	{
+		cerr << "Not a binary VDS file." << endl;
+		return false;
+	}
+	if (rHeader.Major != VDS_FILE_FORMAT_MAJOR || rHeader.Minor > VDS_FILE_FORMAT_MINOR)
+	{
+		cerr << "Incompatible VDS file version." << endl;
+		return false;
+	}
+	if (rHeader.HeaderSize != sizeof(VDSFileHeader) ||
+		rHeader.ByteOrder != VDS_FILE_BYTE_ORDER ||
+		rHeader.NodeSize != sizeof(Node) ||
+		rHeader.TriSize != sizeof(Tri) ||
+		rHeader.RenderDatumSize != sizeof(VertexRenderDatum))
+	{
+		cerr << "VDS file was written by an incompatible build." << endl;
+		return false;
+	}
+	if ((Size != 0 && rHeader.FileSize > Size) ||
+		(uint64_t)(NodeIndex)rHeader.NumNodes != rHeader.NumNodes ||
+		(uint64_t)(TriIndex)rHeader.NumTris != rHeader.NumTris ||
+		(uint64_t)(size_t)rHeader.FileSize != rHeader.FileSize)
+	{
+		cerr << "VDS file is truncated or too large." << endl;
+		return false;
+	}
+	if (rHeader.ErrorParamSize < 0 ||
+		!FileSectionFits(rHeader.ErrorParamsOffset, rHeader.NumErrorParams,
+			(uint64_t)rHeader.ErrorParamSize * sizeof(float), sizeof(VDSFileHeader), rHeader.FileSize) ||
+		!FileSectionFits(rHeader.NodesOffset, rHeader.NumNodes + 1,
+			sizeof(Node), sizeof(VDSFileHeader), rHeader.FileSize) ||
+		!FileSectionFits(rHeader.RenderDataOffset, rHeader.NumNodePositions,
+			sizeof(VertexRenderDatum), sizeof(VDSFileHeader), rHeader.FileSize) ||
+		!FileSectionFits(rHeader.TrisOffset, rHeader.NumTris + 1,
+			sizeof(Tri), sizeof(VDSFileHeader), rHeader.FileSize))
+	{
+		cerr << "VDS file has a section outside the file." << endl;
+		return false;
+	}
+	return true;
+}
 
-    if (hFile == INVALID_HANDLE_VALUE) 
-    {
-        return false;
-    } 
-	
-    ReadFile(hFile, &major, sizeof(VDS_FILE_FORMAT_MAJOR), &num_bytes_read, NULL);
-    ReadFile(hFile, &minor, sizeof(VDS_FILE_FORMAT_MINOR), &num_bytes_read, NULL);
-    if (major != VDS_FILE_FORMAT_MAJOR || minor != VDS_FILE_FORMAT_MINOR)
-    {
-        cerr << "Incompatible VDS file version." << endl;
-        CloseHandle(hFile);
-        return false;
-    }    
-	
-    ReadFile(hFile, &mColorsPresent, sizeof(mColorsPresent), &num_bytes_read, NULL);
-    ReadFile(hFile, &mNormalsPresent, sizeof(mNormalsPresent), &num_bytes_read, NULL);
-    ReadFile(hFile, &mNumTextures, sizeof(mNumTextures), &num_bytes_read, NULL);
-    ReadFile(hFile, &mNumNodes, sizeof(NodeIndex), &num_bytes_read, NULL);
-	ReadFile(hFile, &mNumNodePositions, sizeof(NodeIndex), &num_bytes_read, NULL);
-    ReadFile(hFile, &mNumTris, sizeof(NodeIndex), &num_bytes_read, NULL);
-	ReadFile(hFile, &mNumPatches, sizeof(PatchIndex), &num_bytes_read, NULL);
-	ReadFile(hFile, &mNumErrorParams, sizeof(NodeIndex), &num_bytes_read, NULL);
-	ReadFile(hFile, &mErrorParamSize, sizeof(int), &num_bytes_read, NULL);
-    
-	mpErrorParams = new float[mNumErrorParams * mErrorParamSize];
-    ReadFile(hFile, mpErrorParams, mNumErrorParams * mErrorParamSize * sizeof(float), &num_bytes_read, NULL);
+void Forest::SetCountsFromFileHeader(const VDSFileHeader &rHeader)
+{
+	mColorsPresent = rHeader.ColorsPresent != 0;
+	mNormalsPresent = rHeader.NormalsPresent != 0;
+	mNumTextures = rHeader.NumTextures;
+	mNumPatches = rHeader.NumPatches;
+	mErrorParamSize = rHeader.ErrorParamSize;
+	mNumNodes = rHeader.NumNodes;
+	mNumNodePositions = rHeader.NumNodePositions;
+	mNumTris = rHeader.NumTris;
+	mNumErrorParams = rHeader.NumErrorParams;
+}
 
+void Forest::AllocateArrays()
+{
+	mpErrorParams = new float[mNumErrorParams * mErrorParamSize];
 	mpNodes = new Node[mNumNodes + 1];
-    ReadFile(hFile, mpNodes, sizeof(Node) * (mNumNodes + 1), &num_bytes_read, NULL);
-
 	mpNodeRenderData = new VertexRenderDatum[mNumNodePositions];
-	ReadFile(hFile, mpNodeRenderData, sizeof(VertexRenderDatum) * (mNumNodePositions), &num_bytes_read, NULL);
+	mpTris = new Tri[mNumTris + 1];
+}
+
+int Forest::ReadBinaryVDSfromBuffer(char* buffer, uint64_t Length)
+{
+	VDSFileHeader header;
+
+	Reset();
+	mIsMMapped = false;
+
+	if (Length != 0 && Length < sizeof(header))
+		return 0;
+	memcpy(&header, buffer, sizeof(header));
+	if (!CheckFileHeader(header, Length))
+		return 0;
+
+	SetCountsFromFileHeader(header);
+	AllocateArrays();
+	memcpy(mpErrorParams, buffer + header.ErrorParamsOffset, mNumErrorParams * mErrorParamSize * sizeof(float));
+	memcpy(mpNodes, buffer + header.NodesOffset, sizeof(Node) * (mNumNodes + 1));
+	memcpy(mpNodeRenderData, buffer + header.RenderDataOffset, sizeof(VertexRenderDatum) * mNumNodePositions);
+	memcpy(mpTris, buffer + header.TrisOffset, sizeof(Tri) * (mNumTris + 1));
 
-    mpTris = new Tri[mNumTris + 1];
-    ReadFile(hFile, mpTris, sizeof(Tri) * (mNumTris + 1), &num_bytes_read,NULL);
-    
-    CloseHandle(hFile);
-	
 	VertexRenderDataIndicesToPointers();
 
-    SetValid();
-    return true;
-#else
-    hFile = 0;
-    num_bytes_read = major = minor = 0;
-    fprintf(stderr, "file i/o not implemented for non-win32");
-    return false;
-#endif
+	SetValid();
+	return 1;
 }
 
+static bool ReadFileArray(FILE *pFile, uint64_t Offset, void *pArray, size_t Length)
+{
+	if (Length == 0)
+		return true;
+	if (fseeko(pFile, Offset, SEEK_SET) != 0)
+		return false;
+	return fread(pArray, 1, Length, pFile) == Length;
+}
+
+bool Forest::ReadBinaryVDS(const char *Filename)
+{
+	VDSFileHeader header;
+	FILE *pFile;
+	int64_t size;
+	bool ok;
+
+	Reset();
+	mIsMMapped = false;
+
+	pFile = fopen(Filename, "rb");
+	if (pFile == NULL)
+		return false;
+
+	if (fseeko(pFile, 0, SEEK_END) != 0 || (size = ftello(pFile)) < 0 ||
+		fseeko(pFile, 0, SEEK_SET) != 0 ||
+		fread(&header, sizeof(header), 1, pFile) != 1 ||
+		!CheckFileHeader(header, (uint64_t)size))
+	{
+		fclose(pFile);
+		return false;
+	}
+
+	SetCountsFromFileHeader(header);
+	AllocateArrays();
+	ok = ReadFileArray(pFile, header.ErrorParamsOffset, mpErrorParams, mNumErrorParams * mErrorParamSize * sizeof(float)) &&
+		ReadFileArray(pFile, header.NodesOffset, mpNodes, sizeof(Node) * (mNumNodes + 1)) &&
+		ReadFileArray(pFile, header.RenderDataOffset, mpNodeRenderData, sizeof(VertexRenderDatum) * mNumNodePositions) &&
+		ReadFileArray(pFile, header.TrisOffset, mpTris, sizeof(Tri) * (mNumTris + 1));
+	fclose(pFile);
+
+	if (!ok)
+	{
+		cerr << "VDS file is truncated." << endl;
+		Reset();
+		return false;
+	}
+
+	VertexRenderDataIndicesToPointers();
+
+	SetValid();
+	return true;
+}
+
+// The mapping is private and writable: node render data pointers are
+// patched in place, which copies only the node pages. Everything else
+// is paged in from the file as it is touched.
 bool Forest::MemoryMapVDS(const char *Filename)
 {
+	VDSFileHeader header;
+	uint64_t size;
+
+	Reset();
+
 #ifdef _WIN32
-    HANDLE hFile;
-    HANDLE hFileMapping;
-    unsigned int major, minor;
-    unsigned int offset;
-//    unsigned int i;
-    Reset();
-    
-    hFile = CreateFile(Filename,       // create Filename 
-		GENERIC_READ | GENERIC_WRITE,                // open for reading 
-		0,                            // do not share 
-		NULL,                         // no security 
-		OPEN_ALWAYS,                // open existing file only 
+	HANDLE hFile;
+	HANDLE hFileMapping;
+	LARGE_INTEGER file_size;
+
+	hFile = CreateFile(Filename,       // open Filename
+		GENERIC_READ,                 // open for reading
+		FILE_SHARE_READ,              // others may read too
+		NULL,                         // no security
+		OPEN_EXISTING,                // open existing file only
 		FILE_ATTRIBUTE_NORMAL,        // normal file
-		NULL);                        // no attr. template 
-	
-    if (hFile == INVALID_HANDLE_VALUE) 
-    { 
-        return false;
-    } 
-    
-    hFileMapping = CreateFileMapping(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
-    if (hFileMapping == INVALID_HANDLE_VALUE || hFileMapping == NULL)
-    {      
-        CloseHandle(hFile);        
-        return false;
-    }
-    mMMapFile = (PBYTE) MapViewOfFile(hFileMapping, FILE_MAP_COPY, 0, 0, 0);
-    offset = 0;
-    major = *((unsigned int *)mMMapFile);
-    offset += sizeof(VDS_FILE_FORMAT_MAJOR + offset);
-    minor = *((unsigned int *)(mMMapFile + offset));
-    offset += sizeof(VDS_FILE_FORMAT_MINOR);
-	
-    if (major != VDS_FILE_FORMAT_MAJOR || minor != VDS_FILE_FORMAT_MINOR)
-    {
-        cerr << "Incompatible VDS file version." << endl;
-        CloseHandle(hFileMapping);
-        CloseHandle(hFile);
-        UnmapViewOfFile(mMMapFile);
-        return false;
-    }
-    mIsMMapped = true;
-    mColorsPresent = *((bool *) (mMMapFile + offset));
-    offset += sizeof(mColorsPresent);
-    mNormalsPresent = *((bool *) (mMMapFile + offset));
-    offset += sizeof(mNormalsPresent);
-    mNumTextures = *((unsigned int *) (mMMapFile + offset));
-    offset += sizeof(mNumTextures);
-    mNumNodes = *((NodeIndex *) (mMMapFile + offset));
-    offset += sizeof(mNumNodes);
-	mNumNodePositions = *((NodeIndex *) (mMMapFile + offset));
-	offset += sizeof(mNumNodePositions);
-    mNumTris = *((TriIndex *) (mMMapFile + offset));
-    offset += sizeof(mNumTris);
-	mNumPatches = *((PatchIndex *) (mMMapFile + offset));
-	offset += sizeof(mNumPatches);
-	mNumErrorParams = *((NodeIndex *) (mMMapFile + offset));
-	offset += sizeof(mNumErrorParams);
-	mErrorParamSize = *((int *) (mMMapFile + offset));
-	offset += sizeof(mErrorParamSize);
-	
-	// TODO: set up memory mapping to use interleaved render data instead of parallel arrays
-	
-	mpErrorParams = (float *) (mMMapFile + offset);
-	offset += (mNumErrorParams * mErrorParamSize * sizeof(float));
-    mpNodes = (Node *) (mMMapFile + offset);
-    offset += (mNumNodes + 1) * sizeof(Node);
-    mpNodeRenderData = (VertexRenderDatum *) (mMMapFile + offset);
-    offset += (mNumNodePositions) * sizeof(VertexRenderDatum);
-    mpTris = (Tri *) (mMMapFile + offset);
-    offset += (mNumTris + 1) * sizeof(Tri);
-	
-	VertexRenderDataIndicesToPointers();
+		NULL);                        // no attr. template
+
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	if (!GetFileSizeEx(hFile, &file_size))
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+	size = file_size.QuadPart;
 
-    CloseHandle(hFileMapping);
-    CloseHandle(hFile);
-    SetValid();
-    return true;
+	hFileMapping = CreateFileMapping(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if (hFileMapping == INVALID_HANDLE_VALUE || hFileMapping == NULL)
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+	mMMapFile = (PBYTE) MapViewOfFile(hFileMapping, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(hFileMapping);
+	CloseHandle(hFile);
+	if (mMMapFile == NULL)
+		return false;
 #else
-    fprintf(stderr, "memory mapping not implemented for non-win32");
-    return false;
+	struct stat file_stat;
+	int fd;
+
+	fd = open(Filename, O_RDONLY);
+	if (fd < 0)
+		return false;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t)sizeof(header))
+	{
+		close(fd);
+		return false;
+	}
+	size = file_stat.st_size;
+	mMMapSize = file_stat.st_size;
+	mMMapFile = (char *) mmap(NULL, mMMapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mMMapFile == (char *) MAP_FAILED)
+	{
+		mMMapFile = NULL;
+		return false;
+	}
 #endif
+
+	mIsMMapped = true;
+	memcpy(&header, mMMapFile, sizeof(header));
+	if (size < sizeof(header) || !CheckFileHeader(header, size))
+	{
+		Reset();
+		return false;
+	}
+
+	SetCountsFromFileHeader(header);
+	mpErrorParams = (float *) (mMMapFile + header.ErrorParamsOffset);
+	mpNodes = (Node *) (mMMapFile + header.NodesOffset);
+	mpNodeRenderData = (VertexRenderDatum *) (mMMapFile + header.RenderDataOffset);
+	mpTris = (Tri *) (mMMapFile + header.TrisOffset);
+
+	VertexRenderDataIndicesToPointers();
+
+	SetValid();
+	return true;
 }
 
 int Forest::GetBinaryVDSSize() // added by Nat for GLOD compatibility on 8/29/03
                                // GLOD must know in-advance the size of the VDS file that will be created.
 {
-    DWORD num_bytes_written = 0;
-//    unsigned int i;
-	
-    assert(mIsValid);
-#define COUNT_BYTE(a,b,c,d,e) num_bytes_written += c;
-#define COUNT_ARRAY(a,b,c) num_bytes_written += b;
-    
-    COUNT_BYTE(hFile, &VDS_FILE_FORMAT_MAJOR, sizeof(VDS_FILE_FORMAT_MAJOR), &num_bytes_written,NULL);
-    COUNT_BYTE(hFile, &VDS_FILE_FORMAT_MINOR, sizeof(VDS_FILE_FORMAT_MINOR), &num_bytes_written,NULL);
-    
-    COUNT_BYTE(hFile, &mColorsPresent, sizeof(mColorsPresent), &num_bytes_written, NULL);
-    COUNT_BYTE(hFile, &mNormalsPresent, sizeof(mNormalsPresent), &num_bytes_written, NULL);
-    COUNT_BYTE(hFile, &mNumTextures, sizeof(mNumTextures), &num_bytes_written, NULL);
-    COUNT_BYTE(hFile, &mNumNodes, sizeof(NodeIndex), &num_bytes_written, NULL);
-    COUNT_BYTE(hFile, &mNumNodePositions, sizeof(NodeIndex), &num_bytes_written, NULL);
-    COUNT_BYTE(hFile, &mNumTris, sizeof(NodeIndex), &num_bytes_written, NULL);
-    COUNT_BYTE(hFile, &mNumPatches, sizeof(PatchIndex), &num_bytes_written, NULL);
-	COUNT_BYTE(hFile, &mNumErrorParams, sizeof(NodeIndex), &num_bytes_written, NULL);
-	COUNT_BYTE(hFile, &mErrorParamSize, sizeof(int), &num_bytes_written, NULL);
-    
-	COUNT_ARRAY(mpErrorParams, mNumErrorParams * mErrorParamSize * sizeof(float), hFile);
-
-    VertexRenderDataPointersToIndices();
-    COUNT_ARRAY(mpNodes, sizeof(Node) * (mNumNodes + 1), hFile);
-    VertexRenderDataIndicesToPointers();
-
-    COUNT_ARRAY(mpNodeRenderData, sizeof(VertexRenderDatum) * (mNumNodePositions), hFile);
-
-    COUNT_ARRAY(mpTris, sizeof(Tri) * (mNumTris + 1), hFile);
-
-    return num_bytes_written;
+	VDSFileHeader header;
+
+	assert(mIsValid);
+	FillFileHeader(header);
+	return (int) header.FileSize;
 }
 
 int Forest::WriteBinaryVDStoBuffer(char* buffer) { /* Added by Nat for GLOD compat on 8/29/03 */
-  char* cur_buf = buffer;
-  DWORD num_bytes_written=0;
-//  unsigned int i;
-	
-  assert(mIsValid);
-
-#define WRITE(a,b,c,d,e) memcpy(cur_buf, b, c); cur_buf += c; *d += c;
-#define WRITE_A(a,b,c) memcpy(cur_buf, a, b); cur_buf += b;
-
-  WRITE(hFile, &VDS_FILE_FORMAT_MAJOR, sizeof(VDS_FILE_FORMAT_MAJOR), &num_bytes_written,NULL);
-  WRITE(hFile, &VDS_FILE_FORMAT_MINOR, sizeof(VDS_FILE_FORMAT_MINOR), &num_bytes_written,NULL);
-  
-  WRITE(hFile, &mColorsPresent, sizeof(mColorsPresent), &num_bytes_written, NULL);
-  WRITE(hFile, &mNormalsPresent, sizeof(mNormalsPresent), &num_bytes_written, NULL);
-  WRITE(hFile, &mNumTextures, sizeof(mNumTextures), &num_bytes_written, NULL);
-  WRITE(hFile, &mNumNodes, sizeof(NodeIndex), &num_bytes_written, NULL);
-  WRITE(hFile, &mNumNodePositions, sizeof(NodeIndex), &num_bytes_written, NULL);
-  WRITE(hFile, &mNumTris, sizeof(NodeIndex), &num_bytes_written, NULL);
-  WRITE(hFile, &mNumPatches, sizeof(PatchIndex), &num_bytes_written, NULL);
-  WRITE(hFile, &mNumErrorParams, sizeof(NodeIndex), &num_bytes_written, NULL);
-  WRITE(hFile, &mErrorParamSize, sizeof(int), &num_bytes_written, NULL);
-
-  WRITE_A(mpErrorParams, mNumErrorParams * mErrorParamSize * sizeof(float), hFile);
-  
-  VertexRenderDataPointersToIndices();
-  WRITE_A(mpNodes, sizeof(Node) * (mNumNodes + 1), hFile);
-  VertexRenderDataIndicesToPointers();
-  
-  WRITE_A(mpNodeRenderData, sizeof(VertexRenderDatum) * (mNumNodePositions), hFile);
-  
-  WRITE_A(mpTris, sizeof(Tri) * (mNumTris + 1), hFile);
-  
-  return true;
+	VDSFileHeader header;
+
+	assert(mIsValid);
+	FillFileHeader(header);
+
+	// zero the padding too, so that equal forests give equal bytes
+	memset(buffer, 0, header.FileSize);
+	memcpy(buffer, &header, sizeof(header));
+	memcpy(buffer + header.ErrorParamsOffset, mpErrorParams, mNumErrorParams * mErrorParamSize * sizeof(float));
+
+	VertexRenderDataPointersToIndices();
+	memcpy(buffer + header.NodesOffset, mpNodes, sizeof(Node) * (mNumNodes + 1));
+	VertexRenderDataIndicesToPointers();
+
+	memcpy(buffer + header.RenderDataOffset, mpNodeRenderData, sizeof(VertexRenderDatum) * mNumNodePositions);
+	memcpy(buffer + header.TrisOffset, mpTris, sizeof(Tri) * (mNumTris + 1));
+
+	return true;
+}
+
+// Pads pFile with zeros up to Offset, then writes the array there.
+static bool WriteFileArray(FILE *pFile, uint64_t Offset, const void *pArray, size_t Length)
+{
+	static const char zeros[64] = { 0 };
+	uint64_t pos = (uint64_t) ftello(pFile);
+	while (pos < Offset)
+	{
+		size_t n = (size_t) (Offset - pos < sizeof(zeros) ? Offset - pos : sizeof(zeros));
+		if (fwrite(zeros, 1, n, pFile) != n)
+			return false;
+		pos += n;
+	}
+	return Length == 0 || fwrite(pArray, 1, Length, pFile) == Length;
 }
 
-/***************** NOTE: KEEP the above two functions in SYNC
- *****************       with this function!                   */
 bool Forest::WriteBinaryVDS(const char *Filename)
 {
-#ifdef _WIN32
-    HANDLE hFile; 
-    DWORD num_bytes_written;
-//    unsigned int i;
-	
-    assert(mIsValid);
-    hFile = CreateFile(Filename,       // create
-		GENERIC_WRITE,                // open for writing 
-		0,                            // do not share 
-		NULL,                         // no security 
-		CREATE_ALWAYS,                // overwrite existing 
-		FILE_ATTRIBUTE_NORMAL,        // normal file
-		NULL);                        // no attr. template 
-    
-    if (hFile == INVALID_HANDLE_VALUE)
-    {
-        return false;
-    }
-    
-    WriteFile(hFile, &VDS_FILE_FORMAT_MAJOR, sizeof(VDS_FILE_FORMAT_MAJOR), &num_bytes_written,NULL);
-    WriteFile(hFile, &VDS_FILE_FORMAT_MINOR, sizeof(VDS_FILE_FORMAT_MINOR), &num_bytes_written,NULL);
-    
-    WriteFile(hFile, &mColorsPresent, sizeof(mColorsPresent), &num_bytes_written, NULL);
-    WriteFile(hFile, &mNormalsPresent, sizeof(mNormalsPresent), &num_bytes_written, NULL);
-    WriteFile(hFile, &mNumTextures, sizeof(mNumTextures), &num_bytes_written, NULL);
-    WriteFile(hFile, &mNumNodes, sizeof(NodeIndex), &num_bytes_written, NULL);
-    WriteFile(hFile, &mNumNodePositions, sizeof(NodeIndex), &num_bytes_written, NULL);
-    WriteFile(hFile, &mNumTris, sizeof(NodeIndex), &num_bytes_written, NULL);
-    WriteFile(hFile, &mNumPatches, sizeof(PatchIndex), &num_bytes_written, NULL);
-	WriteFile(hFile, &mNumErrorParams, sizeof(NodeIndex), &num_bytes_written, NULL);
-	WriteFile(hFile, &mErrorParamSize, sizeof(int), &num_bytes_written, NULL);
-
-	WriteArray(mpErrorParams, mNumErrorParams * mErrorParamSize * sizeof(float), hFile);
-    
-    VertexRenderDataPointersToIndices();
-    WriteArray(mpNodes, sizeof(Node) * (mNumNodes + 1), hFile);
-    VertexRenderDataIndicesToPointers();
-
-    WriteArray(mpNodeRenderData, sizeof(VertexRenderDatum) * (mNumNodePositions), hFile);
-
-    WriteArray(mpTris, sizeof(Tri) * (mNumTris + 1), hFile);
-    CloseHandle(hFile);
-
-    return true;
-#else
-    fprintf(stderr, "vds binary writing not implemented for non-win32");
-    return false;
-#endif
+	VDSFileHeader header;
+	FILE *pFile;
+	bool ok;
+
+	assert(mIsValid);
+	FillFileHeader(header);
+
+	pFile = fopen(Filename, "wb");
+	if (pFile == NULL)
+		return false;
+
+	ok = WriteFileArray(pFile, 0, &header, sizeof(header)) &&
+		WriteFileArray(pFile, header.ErrorParamsOffset, mpErrorParams, mNumErrorParams * mErrorParamSize * sizeof(float));
+
+	VertexRenderDataPointersToIndices();
+	ok = ok && WriteFileArray(pFile, header.NodesOffset, mpNodes, sizeof(Node) * (mNumNodes + 1));
+	VertexRenderDataIndicesToPointers();
+
+	ok = ok && WriteFileArray(pFile, header.RenderDataOffset, mpNodeRenderData, sizeof(VertexRenderDatum) * mNumNodePositions) &&
+		WriteFileArray(pFile, header.TrisOffset, mpTris, sizeof(Tri) * (mNumTris + 1));
+
+	if (fclose(pFile) != 0)
+		ok = false;
+	return ok;
 }
 
 void Forest::VertexRenderDataIndicesToPointers()
@@ -859,11 +1024,11 @@ void Forest::Reset()
 {
     if (mIsMMapped)
 	{
+		// the mapping is a private copy, so nothing goes back to the file
 #ifdef _WIN32
-		VertexRenderDataPointersToIndices();
         UnmapViewOfFile(mMMapFile);
 #else
-		(void) 1;
+		munmap(mMMapFile, mMMapSize);
 #endif
 	}
     else
@@ -885,6 +1050,8 @@ void Forest::Reset()
 			delete[] mpErrorParams;
 		}
     }
+	delete[] mpPreorderRanks;
+	mpPreorderRanks = NULL;
     mpNodes = NULL;
 	mpNodeRenderData = NULL;
 	mpTris = NULL;
@@ -899,8 +1066,16 @@ void Forest::Reset()
 	mErrorParamSize = 0;
     mIsMMapped = false;
 	mMMapFile = NULL;
+#ifndef _WIN32
+	mMMapSize = 0;
+#endif
 	miHighlightedNode = iNIL_NODE;
 	miHighlightedTri = iNIL_TRI;
+	mNumDirectPositionsAllocated = 0;
+	mNumDirectNodesAllocated = 0;
+	mNumDirectTrisAllocated = 0;
+	mNumDirectMerges = 0;
+	mDirectBuildFailed = false;
 }
 
 void Forest::GetBoundingBox(float &minx, float &maxx, float &miny, float &maxy, float &minz, float &maxz)
@@ -969,6 +1144,7 @@ void Forest::SetValid()
     if (!(mNumNodes == 0 || mNumTris == 0))
     {
         mIsValid = true;
+		ComputePreorderRanks();
     }
     else
     {
@@ -1236,7 +1412,7 @@ void Forest::ReorderNodesDepthFirst(TriIndex *FirstLiveTris, TriIndex **NextLive
 
 	DepthFirstArray = new NodeIndex[mNumNodes+1];
 	LocInArray = new NodeIndex[mNumNodes+1];
-	Node* new_node_array = new Node[mNumNodes+1];
+	Node* new_node_array = new Node[mNumNodes+1]();
 	TriIndex *NewFirstLiveTris = new TriIndex[mNumNodes+1];
 	if (!DepthFirstArray || !LocInArray || !new_node_array || !NewFirstLiveTris)
 	{
@@ -1253,7 +1429,7 @@ void Forest::ReorderNodesDepthFirst(TriIndex *FirstLiveTris, TriIndex **NextLive
 		NewFirstLiveTris[i] = iNIL_TRI;
 	}
 
-	Tri* new_tri_array = new Tri[mNumTris+1];
+	Tri* new_tri_array = new Tri[mNumTris+1]();
 	TriIndex **NewNextLiveTris = new TriIndex*[mNumTris+1];
 	// we actually don't change NextLiveTris right now, because we don't sort
 	// tris.  if we start sorting tris, then we will need to use this array.
@@ -1366,6 +1542,309 @@ void Forest::DFSvisit(NodeIndex i)
 	}
 }
 
+// iterative, since hierarchies built by edge collapses can be very deep
+NodeIndex Forest::PreorderNodes(NodeIndex *Order)
+{
+	NodeIndex Count = 0;
+	NodeIndex i = iROOT_NODE;
+
+	while (i != iNIL_NODE)
+	{
+		Order[++Count] = i;
+		if (mpNodes[i].miFirstChild != iNIL_NODE)
+		{
+			i = mpNodes[i].miFirstChild;
+			continue;
+		}
+		while ((i != iNIL_NODE) && (mpNodes[i].miRightSibling == iNIL_NODE))
+			i = mpNodes[i].miParent;
+		if (i != iNIL_NODE)
+			i = mpNodes[i].miRightSibling;
+	}
+	return Count;
+}
+
+// Grows each block breadth-first from its root until it holds NodesPerBlock
+// nodes; the children left over become the roots of later blocks, which are
+// laid out in breadth-first order too.
+NodeIndex Forest::BreadthFirstBlockedNodes(NodeIndex *Order, NodeIndex NodesPerBlock)
+{
+	NodeIndex Count = 0;
+	NodeIndex child;
+	size_t iBlockRoot, iBlock;
+	vector<NodeIndex> BlockRoots;
+	vector<NodeIndex> Block;
+
+	BlockRoots.push_back(iROOT_NODE);
+	for (iBlockRoot = 0; iBlockRoot < BlockRoots.size(); ++iBlockRoot)
+	{
+		Block.clear();
+		Block.push_back(BlockRoots[iBlockRoot]);
+		for (iBlock = 0; iBlock < Block.size(); ++iBlock)
+		{
+			Order[++Count] = Block[iBlock];
+			for (child = mpNodes[Block[iBlock]].miFirstChild; child != iNIL_NODE; child = mpNodes[child].miRightSibling)
+			{
+				if (Block.size() < NodesPerBlock)
+					Block.push_back(child);
+				else
+					BlockRoots.push_back(child);
+			}
+		}
+	}
+	return Count;
+}
+
+NodeIndex Forest::VanEmdeBoasNodes(NodeIndex *Order)
+{
+	NodeIndex i, Count;
+	NodeIndex *Heights = new NodeIndex[mNumNodes + 1];
+
+	// subtree heights, children before parents
+	Count = PreorderNodes(Order);
+	for (i = 0; i <= mNumNodes; ++i)
+		Heights[i] = 1;
+	for (i = Count; i > 1; --i)
+	{
+		NodeIndex iParent = mpNodes[Order[i]].miParent;
+		if (Heights[iParent] < Heights[Order[i]] + 1)
+			Heights[iParent] = Heights[Order[i]] + 1;
+	}
+
+	Count = 0;
+	VanEmdeBoasVisit(iROOT_NODE, Heights[iROOT_NODE], Heights, Order, Count);
+	delete[] Heights;
+	return Count;
+}
+
+// Lays out the top Levels levels of iNode's subtree: the top half of those
+// levels first, then each subtree hanging below it, each recursively.
+void Forest::VanEmdeBoasVisit(NodeIndex iNode, NodeIndex Levels, const NodeIndex *Heights, NodeIndex *Order, NodeIndex &rCount)
+{
+	NodeIndex TopLevels, Depth, i;
+	vector<NodeIndex> BottomRoots;
+	size_t b;
+
+	if (Levels > Heights[iNode])
+		Levels = Heights[iNode];
+	if (Levels == 1)
+	{
+		Order[++rCount] = iNode;
+		return;
+	}
+
+	TopLevels = Levels / 2;
+	VanEmdeBoasVisit(iNode, TopLevels, Heights, Order, rCount);
+
+	// collect the nodes TopLevels below iNode, left to right
+	i = iNode;
+	Depth = 0;
+	while (true)
+	{
+		if (Depth == TopLevels)
+			BottomRoots.push_back(i);
+		else if (mpNodes[i].miFirstChild != iNIL_NODE)
+		{
+			i = mpNodes[i].miFirstChild;
+			++Depth;
+			continue;
+		}
+		while ((Depth > 0) && (mpNodes[i].miRightSibling == iNIL_NODE))
+		{
+			i = mpNodes[i].miParent;
+			--Depth;
+		}
+		if (Depth == 0)
+			break;
+		i = mpNodes[i].miRightSibling;
+	}
+
+	for (b = 0; b < BottomRoots.size(); ++b)
+		VanEmdeBoasVisit(BottomRoots[b], Levels - TopLevels, Heights, Order, rCount);
+}
+
+bool Forest::ReorderNodesForCache(NodeLayout Layout, NodeIndex NodesPerBlock)
+{
+	NodeIndex i, NumOrdered, iOld;
+	TriIndex t, NumTrisOrdered;
+	NodeIndex p, NumPositionsOrdered;
+	unsigned int e, NumErrorParamsOrdered;
+
+	if (!mIsValid || mIsMMapped)
+	{
+		cerr << "Error - can only reorder a valid forest that is not memory mapped." << endl;
+		return false;
+	}
+
+	// NewOrder[new index] = old index, NewIndex[old index] = new index
+	NodeIndex *NewOrder = new NodeIndex[mNumNodes + 1];
+	switch (Layout)
+	{
+	case BREADTH_FIRST_BLOCKED:
+		if (NodesPerBlock == 0)
+			NodesPerBlock = (4096 > sizeof(Node)) ? 4096 / sizeof(Node) : 1;
+		NumOrdered = BreadthFirstBlockedNodes(NewOrder, NodesPerBlock);
+		break;
+	case VAN_EMDE_BOAS:
+		NumOrdered = VanEmdeBoasNodes(NewOrder);
+		break;
+	default:
+		NumOrdered = PreorderNodes(NewOrder);
+		break;
+	}
+	if (NumOrdered != mNumNodes)
+	{
+		cerr << "Error - " << (mNumNodes - NumOrdered) << " nodes are not below the root node; not reordering." << endl;
+		delete[] NewOrder;
+		return false;
+	}
+
+	NodeIndex *NewIndex = new NodeIndex[mNumNodes + 1];
+	NewOrder[0] = iNIL_NODE;
+	for (i = 0; i <= mNumNodes; ++i)
+		NewIndex[NewOrder[i]] = i;
+
+	// tris in the order their nodes introduce them, so a node's subtris are
+	// adjacent; any tri on no subtri list keeps its relative order at the end
+	TriIndex *NewTriIndex = new TriIndex[mNumTris + 1];
+	TriIndex *NewTriOrder = new TriIndex[mNumTris + 1];
+	for (t = 0; t <= mNumTris; ++t)
+		NewTriIndex[t] = iNIL_TRI;
+	NewTriOrder[0] = iNIL_TRI;
+	NumTrisOrdered = 0;
+	for (i = 1; i <= mNumNodes; ++i)
+	{
+		for (t = mpNodes[NewOrder[i]].miFirstSubTri; t != iNIL_TRI; t = mpTris[t].miNextSubTri)
+		{
+			NewTriIndex[t] = ++NumTrisOrdered;
+			NewTriOrder[NumTrisOrdered] = t;
+		}
+	}
+	for (t = 1; t <= mNumTris; ++t)
+	{
+		if (NewTriIndex[t] == iNIL_TRI)
+		{
+			NewTriIndex[t] = ++NumTrisOrdered;
+			NewTriOrder[NumTrisOrdered] = t;
+		}
+	}
+
+	// render data and error params in order of first use; index 0 of the
+	// error params is shared by all leaves and stays put
+	NodeIndex *NewPosition = new NodeIndex[mNumNodePositions];
+	for (p = 0; p < mNumNodePositions; ++p)
+		NewPosition[p] = mNumNodePositions;
+	NumPositionsOrdered = 0;
+	unsigned int *NewErrorParam = new unsigned int[mNumErrorParams + 1];
+	for (e = 0; e <= mNumErrorParams; ++e)
+		NewErrorParam[e] = 0;
+	NumErrorParamsOrdered = (mNumErrorParams > 0) ? 1 : 0;
+	for (i = 1; i <= mNumNodes; ++i)
+	{
+		p = mpNodes[NewOrder[i]].mpRenderData - mpNodeRenderData;
+		if (NewPosition[p] == mNumNodePositions)
+			NewPosition[p] = NumPositionsOrdered++;
+		e = mpNodes[NewOrder[i]].miErrorParamIndex;
+		if ((e != 0) && (e < mNumErrorParams) && (NewErrorParam[e] == 0))
+			NewErrorParam[e] = NumErrorParamsOrdered++;
+	}
+	for (p = 0; p < mNumNodePositions; ++p)
+	{
+		if (NewPosition[p] == mNumNodePositions)
+			NewPosition[p] = NumPositionsOrdered++;
+	}
+	for (e = 1; e < mNumErrorParams; ++e)
+	{
+		if (NewErrorParam[e] == 0)
+			NewErrorParam[e] = NumErrorParamsOrdered++;
+	}
+
+	VertexRenderDatum *NewRenderData = new VertexRenderDatum[mNumNodePositions];
+	for (p = 0; p < mNumNodePositions; ++p)
+		memcpy(&NewRenderData[NewPosition[p]], &mpNodeRenderData[p], sizeof(VertexRenderDatum));
+
+	float *NewErrorParams = new float[mNumErrorParams * mErrorParamSize];
+	for (e = 0; e < mNumErrorParams; ++e)
+		memcpy(&NewErrorParams[NewErrorParam[e] * mErrorParamSize], &mpErrorParams[e * mErrorParamSize], mErrorParamSize * sizeof(float));
+
+	Node *NewNodes = new Node[mNumNodes + 1]();
+	memcpy(&NewNodes[0], &mpNodes[0], sizeof(Node));
+	for (i = 1; i <= mNumNodes; ++i)
+	{
+		iOld = NewOrder[i];
+		memcpy(&NewNodes[i], &mpNodes[iOld], sizeof(Node));
+		NewNodes[i].miParent = NewIndex[mpNodes[iOld].miParent];
+		NewNodes[i].miLeftSibling = NewIndex[mpNodes[iOld].miLeftSibling];
+		NewNodes[i].miRightSibling = NewIndex[mpNodes[iOld].miRightSibling];
+		NewNodes[i].miFirstChild = NewIndex[mpNodes[iOld].miFirstChild];
+		NewNodes[i].mCoincidentVertex = NewIndex[mpNodes[iOld].mCoincidentVertex];
+		NewNodes[i].miFirstSubTri = NewTriIndex[mpNodes[iOld].miFirstSubTri];
+		NewNodes[i].mpRenderData = &NewRenderData[NewPosition[mpNodes[iOld].mpRenderData - mpNodeRenderData]];
+		if (mpNodes[iOld].miErrorParamIndex < mNumErrorParams)
+			NewNodes[i].miErrorParamIndex = NewErrorParam[mpNodes[iOld].miErrorParamIndex];
+	}
+
+	Tri *NewTris = new Tri[mNumTris + 1]();
+	memcpy(&NewTris[0], &mpTris[0], sizeof(Tri));
+	for (t = 1; t <= mNumTris; ++t)
+	{
+		memcpy(&NewTris[t], &mpTris[NewTriOrder[t]], sizeof(Tri));
+		NewTris[t].miNextSubTri = NewTriIndex[mpTris[NewTriOrder[t]].miNextSubTri];
+		NewTris[t].miCorners[0] = NewIndex[mpTris[NewTriOrder[t]].miCorners[0]];
+		NewTris[t].miCorners[1] = NewIndex[mpTris[NewTriOrder[t]].miCorners[1]];
+		NewTris[t].miCorners[2] = NewIndex[mpTris[NewTriOrder[t]].miCorners[2]];
+	}
+
+	delete[] mpNodes;
+	mpNodes = NewNodes;
+	delete[] mpTris;
+	mpTris = NewTris;
+	delete[] mpNodeRenderData;
+	mpNodeRenderData = NewRenderData;
+	delete[] mpErrorParams;
+	mpErrorParams = NewErrorParams;
+
+	delete[] NewOrder;
+	delete[] NewIndex;
+	delete[] NewTriOrder;
+	delete[] NewTriIndex;
+	delete[] NewPosition;
+	delete[] NewErrorParam;
+
+	ComputePreorderRanks();
+	return true;
+}
+
+void Forest::ComputePreorderRanks()
+{
+	NodeIndex i, Count;
+	NodeIndex *Order = new NodeIndex[mNumNodes + 1];
+	bool InPreorder = true;
+
+	delete[] mpPreorderRanks;
+	mpPreorderRanks = NULL;
+
+	Count = PreorderNodes(Order);
+	for (i = 1; i <= Count; ++i)
+	{
+		if (Order[i] != i)
+		{
+			InPreorder = false;
+			break;
+		}
+	}
+
+	if (!InPreorder)
+	{
+		mpPreorderRanks = new NodeIndex[mNumNodes + 1];
+		for (i = 0; i <= mNumNodes; ++i)
+			mpPreorderRanks[i] = i;
+		for (i = 1; i <= Count; ++i)
+			mpPreorderRanks[Order[i]] = i;
+	}
+	delete[] Order;
+}
+
 void Forest::ForestComputeBBoxes(NodeIndex iNode, TriIndex *FirstLiveTris, TriIndex **NextLiveTris)
 {
     NodeIndex child;
@@ -1420,7 +1899,7 @@ void Forest::ForestComputeBBoxes(NodeIndex iNode, TriIndex *FirstLiveTris, TriIn
 				mpNodes[mpTris[livetri].miCorners[2]].mpRenderData->Position[1],
 				mpNodes[mpTris[livetri].miCorners[2]].mpRenderData->Position[2]);
 			point_vector.push_back(v2);
-			k = mpTris[livetri].GetNodeIndexC(livetri, iNode, *this);
+			k = TriGetNodeIndexC(livetri, iNode, *this);
 			livetri = NextLiveTris[livetri][k];
 		}
 	}
@@ -1467,35 +1946,6 @@ void Forest::ForestComputeBBoxes(NodeIndex iNode, TriIndex *FirstLiveTris, TriIn
 	mpNodes[iNode].mZBBoxOffset = (zmax - zmin) / 2.0f;
 }
 
-#ifdef _WIN32
-void WriteArray(void *pArray, unsigned int Length, HANDLE FileHandle)
-#else
-void WriteArray(void *pArray, unsigned int Length, int FileHandle)
-#endif
-{
-#ifdef _WIN32 
-    volatile static const unsigned int max_chars_to_write = 50000000 / sizeof(char);
-    unsigned char *p;
-    DWORD num_bytes_written;
-	
-    p = (unsigned char *) pArray;
-    while (p < (unsigned char *) pArray + Length)
-    {
-        if (p + max_chars_to_write < (unsigned char *) pArray + Length)
-        {
-            WriteFile(FileHandle, p, sizeof(unsigned char) * max_chars_to_write, &num_bytes_written, NULL);
-        }
-        else
-        {
-            WriteFile(FileHandle, p, sizeof(unsigned char) * (Length % max_chars_to_write), &num_bytes_written, NULL);
-        }
-        p += max_chars_to_write;
-    }
-#else
-    fprintf(stderr, "array writing not implemented for non-win32");
-#endif
-}
-
 //function for sorting corners in BuildSubTriLists
 void sort_three(NodeIndex &rA, NodeIndex &rB, NodeIndex &rC)
 {
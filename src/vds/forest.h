@@ -14,6 +14,8 @@
 #ifndef FOREST_H
 #define FOREST_H
 
+#include <stdint.h>
+
 #include "vds.h"
 #include "renderer.h"
 #include "vif.h"
@@ -21,8 +23,49 @@
 namespace VDS
 {
 
+// Leads a binary VDS file, and GLOD's readback of a forest, which is the
+// same image. Counts and offsets are 64 bits wide whatever the index types
+// are; the record sizes let a reader refuse a file written with a
+// different build. Every array starts on a VDS_FILE_ALIGNMENT boundary, so
+// a memory-mapped file is used in place.
+struct VDSFileHeader
+{
+	char Magic[4];
+	uint32_t Major;
+	uint32_t Minor;
+	uint32_t HeaderSize;
+	uint32_t ByteOrder;
+	uint32_t NodeSize;
+	uint32_t TriSize;
+	uint32_t RenderDatumSize;
+	uint32_t ColorsPresent;
+	uint32_t NormalsPresent;
+	uint32_t NumTextures;
+	uint32_t NumPatches;
+	int32_t ErrorParamSize;
+	uint32_t Reserved;
+	uint64_t NumNodes;
+	uint64_t NumNodePositions;
+	uint64_t NumTris;
+	uint64_t NumErrorParams;
+	uint64_t ErrorParamsOffset;
+	uint64_t NodesOffset;
+	uint64_t RenderDataOffset;
+	uint64_t TrisOffset;
+	uint64_t FileSize;
+};
+
 class Forest
 {
+public: // PUBLIC TYPES
+	// node orders for ReorderNodesForCache()
+	enum NodeLayout
+	{
+		DEPTH_FIRST,			// preorder; the order forests are built in
+		BREADTH_FIRST_BLOCKED,	// subtrees cut into breadth-first blocks of a page or so
+		VAN_EMDE_BOAS			// recursively split at half height
+	};
+
 public: // PUBLIC FUNCTIONS
 	Forest();
 	virtual ~Forest();
@@ -38,6 +81,26 @@ public: // PUBLIC FUNCTIONS
 	// Returns true if successful, false if error occurred
 	bool GetDataFromVif(const Vif &v);
 
+	// Builds the forest straight from a merge sequence held in memory, as
+	// GetDataFromVif() does from a Vif but without the intermediate copy.
+	// Between BeginDirectBuild() and EndDirectBuild() positions, nodes, tris
+	// and merges are added in any order in which a merge's nodes already
+	// exist. Nodes and tris number from iROOT_NODE, positions from 0, and
+	// patches from 0. EndDirectBuild() renumbers the nodes depth-first,
+	// builds the subtri lists and error params, and returns false if the
+	// hierarchy is unusable.
+	void BeginDirectBuild(PatchIndex NumPatches, bool ColorsPresent, bool NormalsPresent, unsigned int NumTextures);
+	NodeIndex AddDirectNodePosition(const VertexRenderDatum &rDatum);
+	NodeIndex AddDirectNode(NodeIndex iPosition, PatchIndex PatchID);
+	// adds a node with iNode's position and patch
+	NodeIndex CloneDirectNode(NodeIndex iNode);
+	// iNext follows iNode round the ring of nodes coincident with it
+	void SetDirectCoincidentVertex(NodeIndex iNode, NodeIndex iNext);
+	TriIndex AddDirectTri(NodeIndex iCorner0, NodeIndex iCorner1, NodeIndex iCorner2, PatchIndex PatchID);
+	// makes the NumChildren nodes in piChildren the children of iParent
+	void AddDirectMerge(NodeIndex iParent, unsigned int NumChildren, const NodeIndex *piChildren);
+	bool EndDirectBuild();
+
 	// Dumps contents of Forest into given Vif
 	// Returns true if successful, false if error occurred
 	bool GiveDataToVif(Vif &v);
@@ -48,10 +111,11 @@ public: // PUBLIC FUNCTIONS
 	// Memory maps a binary VDS file instead of reading it into memory
 	bool MemoryMapVDS(const char *Filename);
 
-	// GLOD Readback Functions --- these are hacked copies of the Read/WriteBinaryVDS functions
+	// GLOD Readback Functions --- the same image as a binary VDS file, in memory
 	int GetBinaryVDSSize();
         int WriteBinaryVDStoBuffer(char* buffer);
-        int ReadBinaryVDSfromBuffer(char* buffer);
+        // Length is the size of buffer, or 0 if unknown
+        int ReadBinaryVDSfromBuffer(char* buffer, uint64_t Length);
 
 	// Writes All VDSdata structure data to a binary VDS file
 	bool WriteBinaryVDS(const char *Filename);
@@ -71,6 +135,22 @@ public: // PUBLIC FUNCTIONS
 	// returns true if iNode1 and iNode2 are coincident or if iNode1 == iNode2
 	bool NodesAreCoincidentOrEqual(NodeIndex iNode1, NodeIndex iNode2);
 
+	// Renumbers the nodes into the given layout, and the tris, node render
+	// data and error params in the order the new node order first uses them,
+	// so that nodes folded and unfolded together share cache lines and
+	// pages. NodesPerBlock is the BREADTH_FIRST_BLOCKED block size; 0 picks
+	// one page's worth. Must be called before any cut uses the forest.
+	// Returns false (leaving the forest as it was) for a memory-mapped forest.
+	bool ReorderNodesForCache(NodeLayout Layout, NodeIndex NodesPerBlock = 0);
+
+	// position of iNode in a depth-first traversal of the forest; a node's
+	// subtree is the nodes ranked from its own rank up to its right
+	// sibling's (or its parent's right sibling's, and so on)
+	NodeIndex GetPreorderRank(NodeIndex iNode) const
+	{
+		return (mpPreorderRanks == NULL) ? iNode : mpPreorderRanks[iNode];
+	}
+
 protected: // PRIVATE FUNCTIONS
 		
 	//Initializes Refs if needed and checks for existence of nodes and tris
@@ -82,13 +162,32 @@ protected: // PRIVATE FUNCTIONS
 
 	void SwapNodeMemory(NodeIndex iNode1, NodeIndex iNode2);
 
+	// validates and completes a forest whose arrays hold the nodes, tris and
+	// merges in creation order; shared by GetDataFromVif() and EndDirectBuild()
+	bool FinishBuild();
+
 	//Reorders nodes in data structure to depth first
 	void ReorderNodesDepthFirst(TriIndex *FirstLiveTris, TriIndex **NextLiveTris);
 	void DFSvisit(NodeIndex i);
+
+	// fill Order[1..] with node indices in the named order and return how many
+	NodeIndex PreorderNodes(NodeIndex *Order);
+	NodeIndex BreadthFirstBlockedNodes(NodeIndex *Order, NodeIndex NodesPerBlock);
+	NodeIndex VanEmdeBoasNodes(NodeIndex *Order);
+	void VanEmdeBoasVisit(NodeIndex iNode, NodeIndex Levels, const NodeIndex *Heights, NodeIndex *Order, NodeIndex &rCount);
+
+	// sets mpPreorderRanks, or leaves it NULL when the nodes are in preorder
+	void ComputePreorderRanks();
 	void ForestComputeBBoxes(NodeIndex iNode, TriIndex *FirstLiveTris, TriIndex **NextLiveTris);
 
 	NodeIndex first_ancestor_of(NodeIndex a, NodeIndex b);
 
+	// binary VDS layout helpers
+	void FillFileHeader(VDSFileHeader &rHeader);
+	bool CheckFileHeader(const VDSFileHeader &rHeader, uint64_t Size);
+	void SetCountsFromFileHeader(const VDSFileHeader &rHeader);
+	void AllocateArrays();
+
 public: // DEBUG FUNCTIONS
 	void PrintForestInfo(Cut *pCut);
 	void PrintForestStructure();
@@ -114,6 +213,7 @@ public:	// PUBLIC DATA
 	BYTE *mMMapFile;
 #else
 	char *mMMapFile;
+	size_t mMMapSize;
 #endif
 	NodeIndex mNumNodes;
 	NodeIndex mNumNodePositions;
@@ -122,10 +222,22 @@ public:	// PUBLIC DATA
 	NodeIndex mNumErrorParams;
 	int mErrorParamSize;
 
+	// depth-first rank of each node, NULL if every node's index is its rank;
+	// TriMoveProxyDown() needs the ranks to find which child's subtree
+	// holds a corner
+	NodeIndex *mpPreorderRanks;
+
 protected: // PRIVATE DATA
 	NodeIndex DFSindex;
 	NodeIndex *DepthFirstArray;
 	NodeIndex *LocInArray;
+
+	// array sizes during a direct build, 0 otherwise
+	NodeIndex mNumDirectPositionsAllocated;
+	NodeIndex mNumDirectNodesAllocated;
+	TriIndex mNumDirectTrisAllocated;
+	unsigned int mNumDirectMerges;
+	bool mDirectBuildFailed;
         
 public: // DEBUG DATA
 	NodeIndex miHighlightedNode;
@@ -137,12 +249,9 @@ public: //STATIC DATA
 	static const NodeIndex iNIL_TRI;  
 	static const unsigned int VDS_FILE_FORMAT_MAJOR;
 	static const unsigned int VDS_FILE_FORMAT_MINOR;
+	static const unsigned int VDS_FILE_ALIGNMENT;
 	static const unsigned int VIF_FILE_FORMAT_MAJOR;
 	static const unsigned int VIF_FILE_FORMAT_MINOR;
-		
-	//Friends
-	friend class Node;
-	friend class Tri;
 };
 
 void StdViewIndependentError(NodeIndex iNode, const Forest &Forest);
@@ -46,8 +46,8 @@ void Forest::PrintNodeInfo(NodeIndex i, Cut *pCut, int tabs)
 	NodeIndex iChild;
 
 	if (pCut != NULL)
-		if (pCut->mpNodeRefs != NULL)
-			if (pCut->mpNodeRefs[i] == NULL)
+		if (pCut->mNodeRefs.IsInitialized())
+			if (pCut->mNodeRefs.Get(i) == NULL)
 				return;
 
 	for (j = 0; j < tabs; ++j)
@@ -79,26 +79,26 @@ void Forest::PrintNodeInfo(NodeIndex i, Cut *pCut, int tabs)
 
 	if (pCut != NULL)
 	{
-		if (pCut->mpNodeRefs != NULL)
+		if (pCut->mNodeRefs.IsInitialized())
 		{
-			if (pCut->mpNodeRefs[i] != NULL)
-				cout << " - UC: " << pCut->mpRenderer->GetVertexUseCount(pCut->mpNodeRefs[i]->pVertexRenderDatum) << flush;
+			if (pCut->mNodeRefs.Get(i) != NULL)
+				cout << " - UC: " << pCut->mpRenderer->GetVertexUseCount(pCut->mNodeRefs.Get(i)->pVertexRenderDatum) << flush;
 
 			unsigned int numlivetris = 0;
-			if (pCut->mpNodeRefs[i]->miFirstLiveTri != iNIL_TRI)
+			if (pCut->mNodeRefs.Get(i)->miFirstLiveTri != iNIL_TRI)
 				cout << " - LTrs: " << flush;
-			for (iTri = pCut->mpNodeRefs[i]->miFirstLiveTri; iTri != iNIL_TRI; iTri = iNextTri)
+			for (iTri = pCut->mNodeRefs.Get(i)->miFirstLiveTri; iTri != iNIL_TRI; iTri = iNextTri)
 			{
-				k = mpTris[iTri].GetNodeIndex(iTri, i, this, pCut->mpRenderer);
+				k = TriGetNodeIndex(iTri, i, this, pCut->mpRenderer);
 
 				cout << iTri << " ";
 				++numlivetris;
 
-				iNextTri = pCut->mpTriRefs[iTri]->miNextLiveTris[k];
+				iNextTri = pCut->mTriRefs.Get(iTri)->miNextLiveTris[k];
 			}
-			if (pCut->mpNodeRefs[i] != NULL)
+			if (pCut->mNodeRefs.Get(i) != NULL)
 			{
-				if (numlivetris != pCut->mpRenderer->GetVertexUseCount(pCut->mpNodeRefs[i]->pVertexRenderDatum))
+				if (numlivetris != pCut->mpRenderer->GetVertexUseCount(pCut->mNodeRefs.Get(i)->pVertexRenderDatum))
 					cout << "FUGG" << endl;
 			}
 
@@ -136,26 +136,26 @@ void Forest::PrintTriInfo(Cut *pCut)
 		
 		if (pCut != NULL)
 		{
-			if (pCut->mpTriRefs != NULL)
+			if (pCut->mTriRefs.IsInitialized())
 			{
-				if (pCut->mpTriRefs[iTri] != NULL)
+				if (pCut->mTriRefs.Get(iTri) != NULL)
 				{
-					cout << pCut->mpTriRefs[iTri]->backrefs[0] << " "
-						<< pCut->mpTriRefs[iTri]->backrefs[1] << " "
-						<< pCut->mpTriRefs[iTri]->backrefs[2];
+					cout << pCut->mTriRefs.Get(iTri)->backrefs[0] << " "
+						<< pCut->mTriRefs.Get(iTri)->backrefs[1] << " "
+						<< pCut->mTriRefs.Get(iTri)->backrefs[2];
 				}
 			}
 		}
 		cout << " - NLTs: " << flush;
 		if (pCut != NULL)
 		{
-			if (pCut->mpTriRefs != NULL)
+			if (pCut->mTriRefs.IsInitialized())
 			{
-				if (pCut->mpTriRefs[iTri] != NULL)
+				if (pCut->mTriRefs.Get(iTri) != NULL)
 				{
-					cout << pCut->mpTriRefs[iTri]->miNextLiveTris[0] << " "
-						<< pCut->mpTriRefs[iTri]->miNextLiveTris[1] << " "
-						<< pCut->mpTriRefs[iTri]->miNextLiveTris[2];
+					cout << pCut->mTriRefs.Get(iTri)->miNextLiveTris[0] << " "
+						<< pCut->mTriRefs.Get(iTri)->miNextLiveTris[1] << " "
+						<< pCut->mTriRefs.Get(iTri)->miNextLiveTris[2];
 				}
 			}
 		}
@@ -173,22 +173,22 @@ bool Forest::CheckIfProxiesMatchProxyBackRefs(Renderer *pRenderer)
 	for (i = 1; i <= mNumTris; ++i)
 	{
 // TODO: need to pass renderer in to index into backrefs array
-/*		if ((mpTriRefs[i] != NULL) && (mpTriRefs[i]->miProxyBackRefs[0] != iNIL_NODE))
+/*		if ((mTriRefs[i] != NULL) && (mTriRefs[i]->miProxyBackRefs[0] != iNIL_NODE))
 		{
 			for (k = 0; k < 3; ++k)
 			{
-				if (pRenderer->GetProxy(i, k) != pRenderer->GetVertexRenderDatumIndex(mpNodeRefs[mpTriRefs[i]->miProxyBackRefs[k]]->pVertexRenderDatum))
+				if (pRenderer->GetProxy(i, k) != pRenderer->GetVertexRenderDatumIndex(mNodeRefs[mTriRefs[i]->miProxyBackRefs[k]]->pVertexRenderDatum))
 				{
 					Ok = false;
 					cout << "Tri " << i << " Proxies (" << pRenderer->GetProxy(i, 0) << " " 
 						<< pRenderer->GetProxy(i, 1) << " "
 						<< pRenderer->GetProxy(i, 2) << ") don't match vertex cache entries of ProxyBackRefs ("
-						<< pRenderer->GetVertexRenderDatumIndex(mpNodeRefs[mpTriRefs[i]->miProxyBackRefs[0]]->pVertexRenderDatum) << " " 
-						<< pRenderer->GetVertexRenderDatumIndex(mpNodeRefs[mpTriRefs[i]->miProxyBackRefs[1]]->pVertexRenderDatum) << " " 
-						<< pRenderer->GetVertexRenderDatumIndex(mpNodeRefs[mpTriRefs[i]->miProxyBackRefs[2]]->pVertexRenderDatum) << ")" << endl;
-					cout << "ProxyBackRefs: " << mpTriRefs[i]->miProxyBackRefs[0] << " "
-						<< mpTriRefs[i]->miProxyBackRefs[1] << " "
-						<< mpTriRefs[i]->miProxyBackRefs[2] << " - Proxies point to nodes: "
+						<< pRenderer->GetVertexRenderDatumIndex(mNodeRefs[mTriRefs[i]->miProxyBackRefs[0]]->pVertexRenderDatum) << " " 
+						<< pRenderer->GetVertexRenderDatumIndex(mNodeRefs[mTriRefs[i]->miProxyBackRefs[1]]->pVertexRenderDatum) << " " 
+						<< pRenderer->GetVertexRenderDatumIndex(mNodeRefs[mTriRefs[i]->miProxyBackRefs[2]]->pVertexRenderDatum) << ")" << endl;
+					cout << "ProxyBackRefs: " << mTriRefs[i]->miProxyBackRefs[0] << " "
+						<< mTriRefs[i]->miProxyBackRefs[1] << " "
+						<< mTriRefs[i]->miProxyBackRefs[2] << " - Proxies point to nodes: "
 						<< pRenderer->GetVertexCacheBackRef(pRenderer->GetProxy(i, 0), this) << " "
 						<< pRenderer->GetVertexCacheBackRef(pRenderer->GetProxy(i, 1), this) << " "
 						<< pRenderer->GetVertexCacheBackRef(pRenderer->GetProxy(i, 2), this) << endl;
@@ -223,7 +223,7 @@ void Forest::CheckLiveTriListsC(TriIndex *FirstLiveTris, TriIndex **NextLiveTris
 				cerr << endl;
 				cerr << "Tri " << LiveTri << " is a livetri of node " << i << " but does not have it as a corner." << endl;
 			}
-			k = mpTris[LiveTri].GetNodeIndexC(LiveTri, i, *this);
+			k = TriGetNodeIndexC(LiveTri, i, *this);
 			LiveTri = NextLiveTris[LiveTri][k];
 		}
 //		cout << endl;
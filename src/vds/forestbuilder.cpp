@@ -294,7 +294,7 @@ void ForestBuilder::ReorderNodesBreadthFirst()
 		
         SwapNodes(SwapTargetIndex, SwapSourceIndex, mFirstLiveTris);
 		
-        ChildIndex = mpNodes[SwapTargetIndex].GetFirstChild();
+        ChildIndex = mpNodes[SwapTargetIndex].miFirstChild;
         SwapTargetIndex++;
         
         while(ChildIndex != iNIL_NODE)
@@ -317,7 +317,7 @@ void ForestBuilder::ReorderNodesBreadthFirst()
 				QueueTail = Next;
 			}
 			
-			ChildIndex = mpNodes[ChildIndex].GetRightSibling();
+			ChildIndex = mpNodes[ChildIndex].miRightSibling;
         }
     }
 }
@@ -360,7 +360,7 @@ bool ForestBuilder::ReallocateNodes(NodeIndex NewSize)
 		mpNodes[i].mpRenderData = &mpNodeRenderData[i-1];
 	}
 
-    new_node_array = new Node[NewSize];
+    new_node_array = new Node[NewSize]();
     if ((NULL == new_node_array))
 	{
 		return false;
@@ -409,7 +409,7 @@ bool ForestBuilder::ReallocateTris(NodeIndex NewSize)
 		return false;
 	}
 #endif
-    new_tri_array = new Tri[NewSize];
+    new_tri_array = new Tri[NewSize]();
 	if (NULL != new_tri_array)
 	{
         if (NULL != mpTris)
@@ -673,9 +673,9 @@ TriIndex ForestBuilder::AddTri(NodeIndex iNode1, NodeIndex iNode2, NodeIndex iNo
 	mpTris[mNumTris].mPatchID = 0;
     
     // During hierarchy generation, the live tri lists are used to store triangles that each vertex supports
-    mpTris[mNumTris].AddToLiveTriListUsingCorners(mNumTris, 0, *this, mFirstLiveTris, mNextLiveTris);
-    mpTris[mNumTris].AddToLiveTriListUsingCorners(mNumTris, 1, *this, mFirstLiveTris, mNextLiveTris);
-    mpTris[mNumTris].AddToLiveTriListUsingCorners(mNumTris, 2, *this, mFirstLiveTris, mNextLiveTris);
+    TriAddToLiveTriListUsingCorners(mNumTris, 0, *this, mFirstLiveTris, mNextLiveTris);
+    TriAddToLiveTriListUsingCorners(mNumTris, 1, *this, mFirstLiveTris, mNextLiveTris);
+    TriAddToLiveTriListUsingCorners(mNumTris, 2, *this, mFirstLiveTris, mNextLiveTris);
 
     for (i = 0; i < 3; i++)
     {
@@ -1105,7 +1105,7 @@ void ForestBuilder::BuildSubTriLists()
         
         if (bc_first_ancestor >= a) //found node tri is subtri of
         {
-            mpTris[tri].AddToSubTriList(tri, bc_first_ancestor, *this);
+            TriAddToSubTriList(tri, bc_first_ancestor, *this);
         }
         else //the node the tri is a subtri of is ancestor of a,b
         {       
@@ -1114,7 +1114,7 @@ void ForestBuilder::BuildSubTriLists()
             {        
                 ab_first_ancestor = mpNodes[ab_first_ancestor].miParent;
 			}
-            mpTris[tri].AddToSubTriList(tri, ab_first_ancestor, *this);
+            TriAddToSubTriList(tri, ab_first_ancestor, *this);
         }
     }
 }
@@ -1247,7 +1247,7 @@ Float ForestBuilder::LongestNodeEdge(NodeIndex iNode) const
     tri = mFirstLiveTris[iNode];
 	while (iNIL_TRI != tri) 
     {
-        i = mpTris[tri].GetNodeIndexC(tri, iNode, *this);
+        i = TriGetNodeIndexC(tri, iNode, *this);
    	    dx = mpNodes[iNode].mpRenderData->Position[0] - mpNodes[mpTris[tri].miCorners[(i + 1) % 3]].mpRenderData->Position[0];
         dy = mpNodes[iNode].mpRenderData->Position[1] - mpNodes[mpTris[tri].miCorners[(i + 1) % 3]].mpRenderData->Position[1];
         dz = mpNodes[iNode].mpRenderData->Position[2] - mpNodes[mpTris[tri].miCorners[(i + 1) % 3]].mpRenderData->Position[2];
@@ -1304,7 +1304,7 @@ Float ForestBuilder::GreatestFaceAngle(NodeIndex iNode) const
         normal = (v1 - v0) % (v2 - v1);
         normal.Normalize();
         normals.push_back(normal);
-        tri = mNextLiveTris[tri][mpTris[tri].GetNodeIndexC(tri, iNode, *this)];
+        tri = mNextLiveTris[tri][TriGetNodeIndexC(tri, iNode, *this)];
     }
     num_tris = normals.size();
     max_angle = 0.0;
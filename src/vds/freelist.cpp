@@ -15,46 +15,218 @@
 #pragma warning(disable: 4530)
 #endif
 
+#include <stdlib.h>
+#include <string.h>
 #include "freelist.h"
 
 using namespace VDS;
 
+#define BITS_PER_WORD 32
+#define WORD_OF(i) ((i) / BITS_PER_WORD)
+#define BIT_OF(i) (1u << ((i) % BITS_PER_WORD))
+
+const NodeIndex FreeList::iNIL_SLOT = 0xFFFFFFFF;
+
 FreeList::FreeList()
 {
+	mNumSlots = 0;
+	mNumFreeSlots = 0;
+	mpUsedBits = NULL;
+	mNumBitWords = 0;
+	mpTop = NULL;
+	mpSpare = NULL;
 	Reset();
 }
 
 FreeList::~FreeList()
 {
+	FreeChunks();
+	free(mpSpare);
+	free(mpUsedBits);
+}
+
+void FreeList::FreeChunks()
+{
+	Chunk *pChunk;
+	while (mpTop != NULL)
+	{
+		pChunk = mpTop;
+		mpTop = pChunk->pNext;
+		if (mpSpare == NULL)
+			mpSpare = pChunk;
+		else
+			free(pChunk);
+	}
+}
+
+bool FreeList::PushFreeSlot(NodeIndex slot)
+{
+	if ((mpTop == NULL) || (mpTop->Count == FREELIST_CHUNK_SIZE))
+	{
+		Chunk *pChunk = mpSpare;
+		if (pChunk != NULL)
+			mpSpare = NULL;
+		else
+		{
+			pChunk = (Chunk *) malloc(sizeof(Chunk));
+			if (pChunk == NULL)
+				return false;
+		}
+		pChunk->Count = 0;
+		pChunk->pNext = mpTop;
+		mpTop = pChunk;
+	}
+	mpTop->Slots[mpTop->Count++] = slot;
+	return true;
+}
+
+NodeIndex FreeList::PopFreeSlot()
+{
+	NodeIndex slot = mpTop->Slots[--mpTop->Count];
+	if (mpTop->Count == 0)
+	{
+		Chunk *pEmpty = mpTop;
+		mpTop = pEmpty->pNext;
+		if (mpSpare == NULL)
+			mpSpare = pEmpty;
+		else
+			free(pEmpty);
+	}
+	return slot;
 }
 
 NodeIndex FreeList::GetFreeSlot()
 {	
-	int retslot = tail;
-	tail = (tail + 1) % FREELISTSIZE;
-	--mSlotsCached;
-	return mFreeList[retslot];
+	if (mNumFreeSlots == 0)
+		return iNIL_SLOT;
+
+	NodeIndex slot = PopFreeSlot();
+	mpUsedBits[WORD_OF(slot)] |= BIT_OF(slot);
+	--mNumFreeSlots;
+	if (mNumSlots - mNumFreeSlots > mMaxUsedSlots)
+		mMaxUsedSlots = mNumSlots - mNumFreeSlots;
+	return slot;
 }
 
 void FreeList::AddFreeSlot(NodeIndex slot)
 {
-//	unsigned int i;
-	if (mSlotsCached < FREELISTSIZE)
+	if (!IsSlotUsed(slot) || !PushFreeSlot(slot))
+		return;
+	mpUsedBits[WORD_OF(slot)] &= ~BIT_OF(slot);
+	++mNumFreeSlots;
+}
+
+bool FreeList::IsSlotUsed(NodeIndex slot) const
+{
+	return (slot < mNumSlots) && ((mpUsedBits[WORD_OF(slot)] & BIT_OF(slot)) != 0);
+}
+
+void FreeList::Reset(NodeIndex NumSlots)
+{
+	FreeChunks();
+	mNumSlots = 0;
+	mNumFreeSlots = 0;
+	if (mNumBitWords > 0)
+		memset(mpUsedBits, 0, mNumBitWords * sizeof(unsigned int));
+	mMaxUsedSlots = 0;
+	Grow(NumSlots);
+	mNumGrows = 0;
+}
+
+bool FreeList::Grow(NodeIndex NewNumSlots)
+{
+	NodeIndex i;
+	NodeIndex NumWords = WORD_OF(NewNumSlots + BITS_PER_WORD - 1);
+
+	if (NewNumSlots <= mNumSlots)
+		return true;
+
+	if (NumWords > mNumBitWords)
+	{
+		// the bitmap grows at least geometrically so repeated Grow() calls
+		// do not copy it every time
+		if (NumWords < 2 * mNumBitWords)
+			NumWords = 2 * mNumBitWords;
+		unsigned int *pNewBits = (unsigned int *) realloc(mpUsedBits, NumWords * sizeof(unsigned int));
+		if (pNewBits == NULL)
+			return false;
+		memset(pNewBits + mNumBitWords, 0, (NumWords - mNumBitWords) * sizeof(unsigned int));
+		mpUsedBits = pNewBits;
+		mNumBitWords = NumWords;
+	}
+
+	// pushed from the top down so the lowest slots are handed out first
+	for (i = NewNumSlots; i > mNumSlots; --i)
 	{
-		++mSlotsCached;
-		mFreeList[head] = slot;
-		head = (head + 1) % FREELISTSIZE;
+		if (!PushFreeSlot(i - 1))
+		{
+			// take back the slots pushed so far; the bigger bitmap is kept
+			for (++i; i <= NewNumSlots; ++i)
+				PopFreeSlot();
+			return false;
+		}
 	}
+	mNumFreeSlots += NewNumSlots - mNumSlots;
+	mNumSlots = NewNumSlots;
+	++mNumGrows;
+	return true;
 }
 
-void FreeList::Reset()
+NodeIndex FreeList::GetHighestUsedSlot() const
 {
-	unsigned int i;
-	for (i = 0; i < FREELISTSIZE; ++i)
-		mFreeList[i] = 0xFFFFFFFF;
-	mSlotsCached = 0;
-	head = 0;
-	tail = 0;
-	mLargest = 0;
-	mIndexOfLargest = 0;
+	NodeIndex w, b;
+
+	if (mNumSlots == 0)
+		return iNIL_SLOT;
+	for (w = WORD_OF(mNumSlots - 1) + 1; w > 0; --w)
+	{
+		if (mpUsedBits[w - 1] != 0)
+		{
+			for (b = BITS_PER_WORD; b > 0; --b)
+				if (mpUsedBits[w - 1] & (1u << (b - 1)))
+					return (w - 1) * BITS_PER_WORD + (b - 1);
+		}
+	}
+	return iNIL_SLOT;
+}
+
+float FreeList::GetFragmentation() const
+{
+	NodeIndex Highest = GetHighestUsedSlot();
+	if (Highest == iNIL_SLOT)
+		return 0.0f;
+	return (float) (Highest + 1 - GetNumUsedSlots()) / (float) (Highest + 1);
+}
+
+NodeIndex FreeList::Compact(MoveSlotFunc fMove, void *pContext)
+{
+	NodeIndex NumUsed = GetNumUsedSlots();
+	NodeIndex Low = 0;
+	NodeIndex High = GetHighestUsedSlot();
+	NodeIndex NumMoved = 0;
+	NodeIndex i;
+
+	if (High == iNIL_SLOT)
+		return 0;
+
+	while (true)
+	{
+		while ((Low < High) && IsSlotUsed(Low))
+			++Low;
+		while ((High > Low) && !IsSlotUsed(High))
+			--High;
+		if (Low >= High)
+			break;
+
+		fMove(pContext, High, Low);
+		mpUsedBits[WORD_OF(Low)] |= BIT_OF(Low);
+		mpUsedBits[WORD_OF(High)] &= ~BIT_OF(High);
+		++NumMoved;
+	}
+
+	// the free slots are now exactly NumUsed..mNumSlots-1
+	FreeChunks();
+	for (i = mNumSlots; i > NumUsed; --i)
+		PushFreeSlot(i - 1);
+	return NumMoved;
 }
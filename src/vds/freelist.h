@@ -16,30 +16,75 @@
 
 #include "vds.h"
 
-#define FREELISTSIZE 5000
+// number of free slot indices held by one chunk of a FreeList
+#define FREELIST_CHUNK_SIZE 1024
 
+// Allocator for the slot indices of a growable array (renderer vertex and
+// triangle slots).  A bitmap records which of the mNumSlots slots are in
+// use, and every free slot sits exactly once on a stack kept in fixed-size
+// chunks, so getting and releasing a slot are O(1) and the list grows along
+// with the array it manages.
 class VDS::FreeList
 {
 public:
+	// called by Compact() for each used slot it moves down into a free one
+	typedef void (*MoveSlotFunc) (void *pContext, NodeIndex From, NodeIndex To);
+
 	FreeList();
 	~FreeList();
 
+	// returns a free slot and marks it used, or iNIL_SLOT if none is free
 	NodeIndex GetFreeSlot();
+	// marks a used slot free again; the slot stays used if there is no
+	// memory to record it as free
 	void AddFreeSlot(NodeIndex slot);
-	void Reset();
+	// makes NumSlots slots, all free
+	void Reset(NodeIndex NumSlots = 0);
+	// adds free slots up to NewNumSlots after the managed array has grown;
+	// returns false and leaves the list as it was if out of memory
+	bool Grow(NodeIndex NewNumSlots);
+
+	bool IsSlotUsed(NodeIndex slot) const;
+	NodeIndex GetNumSlots() const { return mNumSlots; }
+	NodeIndex GetNumFreeSlots() const { return mNumFreeSlots; }
+	NodeIndex GetNumUsedSlots() const { return mNumSlots - mNumFreeSlots; }
+
+	// highest used slot, or iNIL_SLOT when no slot is used
+	NodeIndex GetHighestUsedSlot() const;
+	// share of the slots up to the highest used one that are free (0 = packed)
+	float GetFragmentation() const;
 
-	int mSlotsCached;
+	// moves the highest used slots into the lowest free ones until the used
+	// slots are exactly 0..GetNumUsedSlots()-1, calling fMove for each move;
+	// returns the number of slots moved
+	NodeIndex Compact(MoveSlotFunc fMove, void *pContext);
 
-	int head;
-	int tail;
+	static const NodeIndex iNIL_SLOT;
 
-	int mIndexOfLargest;
-	NodeIndex mLargest;
+	// statistics
+	NodeIndex mMaxUsedSlots;	// high-water mark of used slots since Reset()
+	unsigned int mNumGrows;		// Grow() calls since Reset()
 
-	NodeIndex mFreeList[FREELISTSIZE];
+protected:
+	struct Chunk
+	{
+		NodeIndex Slots[FREELIST_CHUNK_SIZE];
+		int Count;
+		Chunk *pNext;
+	};
+
+	bool PushFreeSlot(NodeIndex slot);
+	NodeIndex PopFreeSlot();
+	void FreeChunks();
+
+	NodeIndex mNumSlots;
+	NodeIndex mNumFreeSlots;
+	unsigned int *mpUsedBits;	// one bit per slot, set while the slot is used
+	NodeIndex mNumBitWords;		// words allocated for mpUsedBits
+	Chunk *mpTop;				// chunk on top of the free slot stack
+	Chunk *mpSpare;				// emptied chunk kept to avoid malloc churn
 
 	friend class Renderer;
 };
 
 #endif //#ifndef FREELIST_H
-
@@ -156,7 +156,7 @@ void Manager::RemoveRenderer(Renderer *pRenderer) {
     for(i = 0; i < mNumRenderers; i++) {
         if(mpMemoryBlocks[i].pRenderer == pRenderer) {
             pRenderer->mpMemoryManager = NULL;
-            memmove(&mpMemoryBlocks[i], &mpMemoryBlocks[i+1], sizeof(RenderMemoryBlock) * mNumRenderers - i);
+            memmove(&mpMemoryBlocks[i], &mpMemoryBlocks[i+1], sizeof(RenderMemoryBlock) * (mNumRenderers - i - 1));
             mNumRenderers--;
             return;
         }
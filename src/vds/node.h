@@ -15,46 +15,29 @@
 #define NODE_H
 #include "vds.h"
 
+// A Node is a plain record: no constructor, destructor or virtuals, so the
+// node array can be written out and memory-mapped back as it stands (see
+// Forest::MemoryMapVDS()). Arrays are value-initialized with new Node[n](),
+// which leaves every link NIL and every pointer NULL. Members are ordered
+// largest first to keep padding out of the record.
 class VDS::Node
 {
 public:
-    Node();
-    Node(const Node &); //not implemented
-    virtual ~Node();
-	
-	// Following access functions simply return a data member
-    NodeIndex GetParent() const;
-	NodeIndex GetLeftSibling() const;
-	NodeIndex GetRightSibling() const;
-	NodeIndex GetFirstChild() const;
-	TriIndex GetFirstSubTri() const;
-//	Float GetRadius() const;
-	
-private:
-	Node &operator =(const Node &);//not implemented
-	
-public:		// making these public for "debugging convenience"
 	NodeIndex miParent;
 	NodeIndex miLeftSibling;
 	NodeIndex miRightSibling;
 	NodeIndex miFirstChild;
 	TriIndex miFirstSubTri;
-//	Float mRadius;
-	PatchIndex mPatchID;
 	NodeIndex mCoincidentVertex;
-//	ViewIndependentError mViewIndependentError;
-	unsigned int miErrorParamIndex;
 	VertexRenderDatum *mpRenderData;
 
 	Point3 mBBoxCenter;
 	Float mXBBoxOffset;
 	Float mYBBoxOffset;
 	Float mZBBoxOffset;
-	
-	// Friends
-	friend class VDS::Forest;
-	friend class VDS::Tri;
-	friend class VDS::ForestBuilder;
+
+	unsigned int miErrorParamIndex;
+	PatchIndex mPatchID;
 };
 
 #endif
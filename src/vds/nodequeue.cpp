@@ -33,11 +33,18 @@ using namespace VDS;
 NodeQueue::NodeQueue(Simplifier *pSimplifier)
 {
 	mpSimplifier = pSimplifier;
+	mpHeap = NULL;
+	mpItems = NULL;
+	mpPositions = NULL;
+	mpFreeItems = NULL;
 }
 
 NodeQueue::~NodeQueue()
 {
-	free(Elements);
+	free(mpHeap);
+	free(mpItems);
+	free(mpPositions);
+	free(mpFreeItems);
 }
 
 void NodeQueue::Initialize(int MaxElements, float MinData)
@@ -46,70 +53,87 @@ void NodeQueue::Initialize(int MaxElements, float MinData)
 #ifdef VERBOSE_MEM_MANAGEMENT
 	cerr << "NodeQueue allocating " << (MaxElements+1) << " BudgetItems." << endl;
 #endif
-	Elements = (VDS::BudgetItem *) malloc((MaxElements+1) * sizeof(BudgetItem));
+	mpHeap = (HeapEntry *) malloc((MaxElements+1) * sizeof(HeapEntry));
+	mpItems = (VDS::BudgetItem *) malloc((MaxElements+1) * sizeof(BudgetItem));
+	mpPositions = (int *) malloc((MaxElements+1) * sizeof(int));
+	mpFreeItems = (int *) malloc((MaxElements+1) * sizeof(int));
 
 	Capacity = MaxElements;
 	Size = 0;
-	Elements[0].mError = MinData;
-	Elements[0].miNode = 0;
-	Elements[0].PQindex = -666;
-	Elements[0].pVertexRenderDatum = NULL;
 
-	for (i = 1; i <= Capacity; ++i)
+	// heap slot 0 and item slot 0 form the sentinel
+	mpHeap[0].mKey = MinData;
+	mpHeap[0].miItem = 0;
+	mpItems[0].mError = MinData;
+	mpItems[0].miNode = 0;
+	mpItems[0].pVertexRenderDatum = NULL;
+	mpItems[0].miFirstLiveTri = Forest::iNIL_TRI;
+	mpPositions[0] = 0;
+
+	// hand out item slots in increasing order
+	mNumFreeItems = 0;
+	for (i = Capacity; i >= 1; --i)
 	{
-		Elements[i].mError = MinData;
-		Elements[i].miNode = 0;
-		Elements[i].PQindex = -666;
-		Elements[i].pVertexRenderDatum = NULL;
-		Elements[i].miFirstLiveTri = Forest::iNIL_TRI;
+		mpPositions[i] = 0;
+		mpFreeItems[mNumFreeItems++] = i;
 	}
 }
 
-void NodeQueue::_PQupheap(BudgetItem *moving, int i)
+bool NodeQueue::SetNodeRef(int iItem)
+{
+	BudgetItem *pItem = &mpItems[iItem];
+	return mpSimplifier->mpCuts[pItem->CutID]->mNodeRefs.Set(pItem->miNode, pItem);
+}
+
+void NodeQueue::_PQupheap(HeapEntry moving, int i)
 {
     int parent;
-    for (parent=i/2; ( (Elements[parent].mError > moving->mError) && (parent >=1) );
+    for (parent=i/2; ( (mpHeap[parent].mKey > moving.mKey) && (parent >=1) );
          i=parent, parent/=2)
     {
-        Elements[i] = Elements[parent];
-        Elements[i].PQindex = i;
-		mpSimplifier->mpCuts[Elements[i].CutID]->mpNodeRefs[Elements[i].miNode] = &Elements[i];
+        mpHeap[i] = mpHeap[parent];
+        mpPositions[mpHeap[i].miItem] = i;
     }
 
-    Elements[i] = *moving;
-    Elements[i].PQindex = i;
-	mpSimplifier->mpCuts[Elements[i].CutID]->mpNodeRefs[Elements[i].miNode] = &Elements[i];
+    mpHeap[i] = moving;
+    mpPositions[moving.miItem] = i;
 }
 
 
-void NodeQueue::_PQdownheap(BudgetItem *moving, int i)
+void NodeQueue::_PQdownheap(HeapEntry moving, int i)
 {
     int child;
     for (child=i*2; child <= Size; i=child, child*=2) {
         if ((child != Size) &&
-            (Elements[child+1].mError < Elements[child].mError))
+            (mpHeap[child+1].mKey < mpHeap[child].mKey))
         {
             child++;
         }
 
-        if (moving->mError > Elements[child].mError) 
+        if (moving.mKey > mpHeap[child].mKey) 
 		{
-            Elements[i] = Elements[child];
-            Elements[i].PQindex = i;
-			mpSimplifier->mpCuts[Elements[i].CutID]->mpNodeRefs[Elements[i].miNode] = &Elements[i];
+            mpHeap[i] = mpHeap[child];
+            mpPositions[mpHeap[i].miItem] = i;
         }
         else
             break;
     }
 
-    Elements[i] = *moving;
-    Elements[i].PQindex = i;
-	mpSimplifier->mpCuts[Elements[i].CutID]->mpNodeRefs[Elements[i].miNode] = &Elements[i];
+    mpHeap[i] = moving;
+    mpPositions[moving.miItem] = i;
 }
 
 void NodeQueue::MakeEmpty()
 {
+	int i;
+
 	Size = 0;
+	mNumFreeItems = 0;
+	for (i = Capacity; i >= 1; --i)
+	{
+		mpPositions[i] = 0;
+		mpFreeItems[mNumFreeItems++] = i;
+	}
 }
 
 void NodeQueue::DoubleCapacity()
@@ -118,63 +142,79 @@ void NodeQueue::DoubleCapacity()
 	int oldcapacity = Capacity;
 	
 	Capacity *= 2;
-	BudgetItem* OldElements = Elements;
 
 #ifdef VERBOSE_MEM_MANAGEMENT
 	cerr << "Reallocating NodeQueue; capacity doubled to " << (Capacity+1) << " BudgetItems." << endl;
 #endif
-	Elements = (VDS::BudgetItem *) realloc(Elements, (Capacity+1) * sizeof(BudgetItem));
-	if (Elements == NULL)
+	HeapEntry *NewHeap = (HeapEntry *) realloc(mpHeap, (Capacity+1) * sizeof(HeapEntry));
+	BudgetItem *NewItems = (VDS::BudgetItem *) realloc(mpItems, (Capacity+1) * sizeof(BudgetItem));
+	int *NewPositions = (int *) realloc(mpPositions, (Capacity+1) * sizeof(int));
+	int *NewFreeItems = (int *) realloc(mpFreeItems, (Capacity+1) * sizeof(int));
+	if (NewHeap != NULL) mpHeap = NewHeap;
+	if (NewItems != NULL) mpItems = NewItems;
+	if (NewPositions != NULL) mpPositions = NewPositions;
+	if (NewFreeItems != NULL) mpFreeItems = NewFreeItems;
+	if ((NewHeap == NULL) || (NewItems == NULL) || (NewPositions == NULL) || (NewFreeItems == NULL))
 	{
 		cerr << "Error - realloc returned null block when increasing nodequeue capacity";
+		Capacity = oldcapacity;
 		return;
 	}
 
+	// the payloads may have moved; only queued items have NodeRefs into them
+	for (i = 1; i <= Size; ++i)
+		SetNodeRef(mpHeap[i].miItem);
 
-	for (i = 1; i <= oldcapacity; ++i)
-	{
-		if (Elements[i].miNode != 0)
-			mpSimplifier->mpCuts[Elements[i].CutID]->mpNodeRefs[Elements[i].miNode] = &Elements[i];
-	}
-
-	for (i = oldcapacity + 1; i <= Capacity; ++i)
+	for (i = Capacity; i > oldcapacity; --i)
 	{
-		Elements[i].miNode = 0;
-		Elements[i].PQindex = -666;
-		Elements[i].pVertexRenderDatum = NULL;
-		Elements[i].mError = Elements[0].mError;
-		Elements[i].miFirstLiveTri = Forest::iNIL_TRI;
+		mpPositions[i] = 0;
+		mpFreeItems[mNumFreeItems++] = i;
 	}
 }
 
 void NodeQueue::Insert(BudgetItem* pItem)
 {
-	if (Size >= Capacity)
+	if (mNumFreeItems == 0)
+	{
 		DoubleCapacity();
+		if (mNumFreeItems == 0)
+			return;
+	}
 
-	_PQupheap(pItem, ++Size);
+	HeapEntry entry;
+	entry.miItem = mpFreeItems[--mNumFreeItems];
+	entry.mKey = pItem->mError;
+	mpItems[entry.miItem] = *pItem;
+	if (!SetNodeRef(entry.miItem))
+	{
+		cerr << "Memory Error - unable to allocate the NodeRef for a queued node." << endl;
+		mpFreeItems[mNumFreeItems++] = entry.miItem;
+		return;
+	}
+
+	_PQupheap(entry, ++Size);
 }
 
 
 BudgetItem *NodeQueue::FindMin()
 {
 	if (Size > 0)
-	    return &Elements[1];
+	    return &mpItems[mpHeap[1].miItem];
 	else
 		return NULL;
 }
 
+// queued BudgetItems no longer move, so this is only kept for the callers
+// that used to chase an item across the heap
 BudgetItem *NodeQueue::Find(BudgetItem *pItem)
 {
-	return &Elements[pItem->PQindex];
+	return pItem;
 }
 
 void NodeQueue::RemoveMin()
 {
-    BudgetItem *Element;
-
-    Element = &Elements[Size--];
-    _PQdownheap(Element, 1);
+	if (Size > 0)
+		Remove(&mpItems[mpHeap[1].miItem]);
 }
 
 /***************************************************
@@ -182,55 +222,68 @@ description: after Remove(), PQ is maintained.
 ****************************************************/
 void NodeQueue::Remove(BudgetItem *pItem)
 {
-    int i;
+	int iItem = pItem - mpItems;
+    int i = mpPositions[iItem];
 
-	i = pItem - Elements;
-	int parent = i/2;
-    pItem = &Elements[Size--];
+	mpPositions[iItem] = 0;
+	mpFreeItems[mNumFreeItems++] = iItem;
 
-	if (pItem->mError < Elements[parent].mError)
-			 _PQupheap(pItem, i);
-	else	_PQdownheap(pItem, i); 
+	HeapEntry moving = mpHeap[Size--];
+	if (moving.miItem == iItem) // removed the last heap slot
+		return;
+
+	if (moving.mKey < mpHeap[i/2].mKey)
+			 _PQupheap(moving, i);
+	else	_PQdownheap(moving, i); 
 }
 
 
-void NodeQueue::GiveElementTo(BudgetItem *pElement, NodeQueue *pReceivingQueue)
+/***************************************************
+description: sifts an element whose error changed in
+place up or down to its new position.
+****************************************************/
+void NodeQueue::Update(BudgetItem *pItem)
 {
-	BudgetItem *tmpElement = pElement;
-	int tmpCutID = pElement->CutID;
-	unsigned int tmpIndex = pElement->miNode;
+	int iItem = pItem - mpItems;
+	int i = mpPositions[iItem];
+	HeapEntry moving;
+
+	moving.miItem = iItem;
+	moving.mKey = pItem->mError;
+	if ((i > 1) && (moving.mKey < mpHeap[PARENT(i)].mKey))
+		_PQupheap(moving, i);
+	else
+		_PQdownheap(moving, i);
+}
 
-	BudgetItem *tmp = new BudgetItem;
-	memcpy(tmp, pElement, sizeof(BudgetItem));
-	tmp->mError = (-1) * pElement->mError;
 
-	pReceivingQueue->Insert(tmp);
-	
-	tmpElement = mpSimplifier->mpCuts[tmpCutID]->mpNodeRefs[tmpIndex];
-	if (tmpElement == NULL)
-		cerr << " giveElementto : NodeRef is null after insert" << endl;
+void NodeQueue::GiveElementTo(BudgetItem *pElement, NodeQueue *pReceivingQueue)
+{
+	BudgetItem tmp = *pElement;
+	tmp.mError = (-1) * pElement->mError;
 
- 	Remove(pElement); 	
-	mpSimplifier->mpCuts[tmpCutID]->mpNodeRefs[tmpIndex] = tmpElement;
+	// Insert() points the node's NodeRef at the receiving queue's copy
+	pReceivingQueue->Insert(&tmp);
+ 	Remove(pElement);
 }
 
 
 BudgetItem *NodeQueue::GetElement(int i)
 {
-	return &Elements[i];
+	return &mpItems[mpHeap[i].miItem];
 }
 
 void NodeQueue::heapify(int i)
 {
 	int l,r,smallest = -1;
-	BudgetItem tmp;
+	HeapEntry tmp;
 
 	while (1)
 	{
 		l = LEFT(i);
 		r = RIGHT(i);
 		
-		if (l <= Size && Elements[l].mError <= Elements[i].mError)
+		if (l <= Size && mpHeap[l].mKey <= mpHeap[i].mKey)
 		{
 			smallest = l;
 		}
@@ -238,21 +291,19 @@ void NodeQueue::heapify(int i)
 		{
 			smallest = i;
 		}
-		if (r <= Size && Elements[r].mError <= Elements[smallest].mError)
+		if (r <= Size && mpHeap[r].mKey <= mpHeap[smallest].mKey)
 		{
 			smallest = r;
 		}
 		if (smallest != i)
 		{
-			tmp = Elements[i];
+			tmp = mpHeap[i];
 
-			Elements[i] = Elements[smallest];
-			Elements[i].PQindex = i;
-			mpSimplifier->mpCuts[Elements[i].CutID]->mpNodeRefs[Elements[i].miNode] = &Elements[i];
+			mpHeap[i] = mpHeap[smallest];
+			mpPositions[mpHeap[i].miItem] = i;
 
-			Elements[smallest] = tmp;
-			Elements[smallest].PQindex = smallest;
-			mpSimplifier->mpCuts[Elements[smallest].CutID]->mpNodeRefs[Elements[smallest].miNode] = &Elements[smallest];
+			mpHeap[smallest] = tmp;
+			mpPositions[tmp.miItem] = smallest;
 			i = smallest;
 		}
 		else
@@ -267,7 +318,8 @@ void NodeQueue::heapify(int i)
 void NodeQueue::buildheap()
 {
 	int i;
-	BudgetItem * pItem;
+	for (i = 1; i <= Size; ++i)
+		mpHeap[i].mKey = mpItems[mpHeap[i].miItem].mError;
 	for (i = Size / 2; i > 0; --i)
 	{
 		heapify(i);
@@ -281,7 +333,7 @@ description: For DEBUG only. to check is the array maintains PQ property.
 void NodeQueue::checkProperty()
 {
 	int i;
-	int l,r,smallest = -1;
+	int l,r;
 
 	cout<<"check:";
 	for (i = Size / 2; i > 0; --i)
@@ -290,8 +342,8 @@ void NodeQueue::checkProperty()
 		l = LEFT(i);
 		r = RIGHT(i);
 		
-		if (  (l <= Size && Elements[l].mError < Elements[i].mError )
-			||  (r <= Size && Elements[r].mError < Elements[i].mError))
+		if (  (l <= Size && mpHeap[l].mKey < mpHeap[i].mKey )
+			||  (r <= Size && mpHeap[r].mKey < mpHeap[i].mKey))
 		{
 			cout<<"    Priority Q's properties are violated"<<endl;
 			break;
@@ -302,16 +354,17 @@ void NodeQueue::checkProperty()
 
 
 /****************************************************************************************
-description: For DEBUG only. to check NodeRef and PQindex's consistency.
+description: For DEBUG only. to check NodeRef, key and position consistency.
 *****************************************************************************************/
 void NodeQueue::checkqueue()
 {
-	int temp;
+	BudgetItem *pItem;
 	for (int i = 1; i <= Size; ++i)
 	{
-		if (mpSimplifier->mpCuts[Elements[i].CutID]->mpNodeRefs[Elements[i].miNode] == NULL)
-			temp = 1;
-		if (mpSimplifier->mpCuts[Elements[i].CutID]->mpNodeRefs[Elements[i].miNode]->PQindex != i)
+		pItem = GetElement(i);
+		if ((mpSimplifier->mpCuts[pItem->CutID]->mNodeRefs.Get(pItem->miNode) != pItem) ||
+			(mpPositions[mpHeap[i].miItem] != i) ||
+			(mpHeap[i].mKey != pItem->mError))
 		{
 			cout << "NodeQueue element " << i << " failed node check test." << endl;
 			return;
@@ -320,11 +373,3 @@ void NodeQueue::checkqueue()
 	}
 	cout << "check queue correct"<< endl;
 }
-
-
-
-
-
-
-
-
@@ -16,6 +16,12 @@
 
 // this class is used as a queue of the nodes to be folded and a queue of
 // the nodes to be unfolded
+//
+// The heap itself only holds (error, item index) pairs, so sifting touches
+// a small contiguous array; the BudgetItems live in a separate array and
+// stay where they are while queued, with mpPositions mapping an item back
+// to its heap slot.  A BudgetItem's mError is the authoritative error - the
+// heap key is a copy of it, refreshed by Insert(), Update() and buildheap().
 
 #include "vds.h"
 #include "vdsaux.h"
@@ -27,6 +33,8 @@ public:
 	~NodeQueue();
 	void Initialize(int MaxElements, float MinData);
 	void MakeEmpty();
+
+	// Copies *pItem into the queue and points its NodeRef at the copy
 	void Insert(BudgetItem *pItem);
 	BudgetItem *FindMin();
 	BudgetItem *Find(BudgetItem *pItem);
@@ -37,21 +45,40 @@ public:
 	void Remove(BudgetItem *pItem);
 	
 	void RemoveMin();
+
+	// Restores heap order after pItem->mError has been changed in place;
+	// the element at pItem's heap slot afterwards may be a different BudgetItem
 	void Update(BudgetItem *pItem);
 	int Size;
 	void GiveElementTo(BudgetItem *pElement, NodeQueue *pReceivingQueue);
+
+	// BudgetItem in heap slot i (1..Size; slot 0 is a sentinel)
 	BudgetItem *GetElement(int i);
 	void heapify(int i);
+
+	// re-reads every key from its BudgetItem and rebuilds the heap
 	void buildheap();
 	void checkqueue();
 	void DoubleCapacity();
 	void checkProperty();
 	
 protected:	
+	struct HeapEntry
+	{
+		Float mKey;	// copy of the item's mError
+		int miItem;	// index into mpItems
+	};
+
 	int Capacity;
-	BudgetItem *Elements;
-	void _PQupheap(BudgetItem *moving, int i);
-	void _PQdownheap(BudgetItem *moving, int i);
+	HeapEntry *mpHeap;		// 1-based binary heap, Size entries
+	BudgetItem *mpItems;	// BudgetItem payloads, Capacity+1 slots
+	int *mpPositions;		// heap slot of each item, 0 if the item slot is free
+	int *mpFreeItems;		// stack of unused item slots
+	int mNumFreeItems;
+
+	void _PQupheap(HeapEntry moving, int i);
+	void _PQdownheap(HeapEntry moving, int i);
+	bool SetNodeRef(int iItem);
 
 	Simplifier *mpSimplifier;
 
@@ -59,4 +86,3 @@ friend class Simplifier;
 };
 
 #endif
-
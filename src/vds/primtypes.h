@@ -121,13 +121,8 @@ namespace VDS
         Float X, Y, Z;
         Point3() {}
         Point3(Float x, Float y, Float z)  : X(x), Y(y), Z(z) {}
-        Point3(const Point3 &p) : X(p.X), Y(p.Y), Z(p.Z) { }
         explicit Point3(const Vec3 &vec);
         explicit Point3(const Vec4 &vec);
-        Point3 &operator =(const Point3 &p) {
-            X = p.X, Y = p.Y, Z = p.Z;
-            return *this;
-        }
         Point3& operator +=(const Vec3& v);
         Point3& operator -=(const Vec3& v);
         
@@ -0,0 +1,146 @@
+/******************************************************************************
+ * Copyright 2004 David Luebke, Brenden Schubert                              *
+ *                University of Virginia                                      *
+ ******************************************************************************
+ * This file is distributed as part of the VDSlib library, and, as such,      *
+ * falls under the terms of the VDSlib public license. VDSlib is distributed  *
+ * without any warranty, implied or otherwise. See the VDSlib license for     *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have recieved a copy of the VDSlib Open-Source License with     *
+ * this copy of VDSlib; if not, please visit the VDSlib web page,             *
+ * http://vdslib.virginia.edu/license for more information.                   *
+ ******************************************************************************/
+#ifndef REFTABLE_H
+#define REFTABLE_H
+
+#include <stdlib.h>
+#include "vds.h"
+
+// log2 of the number of refs held by one page of a RefTable
+#define REFTABLE_PAGE_BITS 10
+#define REFTABLE_PAGE_SIZE (1 << REFTABLE_PAGE_BITS)
+
+// Per-cut table of pointers indexed by forest node or tri index (a cut's
+// NodeRefs and TriRefs).  Only a directory of page pointers is sized to the
+// forest; the pages themselves are allocated NULL-filled the first time
+// Set() stores a ref in them, so a cut costs memory in proportion to the
+// part of the forest it has reached rather than to the whole forest.  Get()
+// and operator[] read a ref without allocating; refs in untouched pages are
+// NULL.
+template <class T>
+class VDS::RefTable
+{
+public:
+	RefTable()
+	{
+		mppPages = NULL;
+		mNumEntries = 0;
+		mNumPages = 0;
+		mNumPagesAllocated = 0;
+	}
+	~RefTable() { Free(); }
+
+	// makes refs 0..NumEntries-1, all NULL
+	void Initialize(unsigned long NumEntries)
+	{
+		Free();
+		mNumEntries = NumEntries;
+		mNumPages = (NumEntries + REFTABLE_PAGE_SIZE - 1) >> REFTABLE_PAGE_BITS;
+		mppPages = (T ***) calloc(mNumPages > 0 ? mNumPages : 1, sizeof(T **));
+	}
+
+	// releases the directory and every page
+	void Free()
+	{
+		unsigned long p;
+		if (mppPages != NULL)
+		{
+			for (p = 0; p < mNumPages; ++p)
+				free(mppPages[p]);
+			free(mppPages);
+		}
+		mppPages = NULL;
+		mNumEntries = 0;
+		mNumPages = 0;
+		mNumPagesAllocated = 0;
+	}
+
+	bool IsInitialized() const { return mppPages != NULL; }
+
+	// stores ref i; returns false, leaving the table unchanged, if the page
+	// holding it could not be allocated
+	bool Set(unsigned long i, T *pRef)
+	{
+		T **pPage = mppPages[i >> REFTABLE_PAGE_BITS];
+		if (pPage == NULL)
+		{
+			// untouched pages already read as NULL
+			if (pRef == NULL)
+				return true;
+			pPage = AllocatePage(i >> REFTABLE_PAGE_BITS);
+			if (pPage == NULL)
+				return false;
+		}
+		pPage[i & (REFTABLE_PAGE_SIZE - 1)] = pRef;
+		return true;
+	}
+
+	// allocates the page holding ref i up front, so that a caller can make
+	// sure a run of Set() calls will succeed before changing anything else
+	bool Reserve(unsigned long i)
+	{
+		unsigned long p = i >> REFTABLE_PAGE_BITS;
+		return (mppPages[p] != NULL) || (AllocatePage(p) != NULL);
+	}
+
+	T *operator[](unsigned long i) const { return Get(i); }
+
+	T *Get(unsigned long i) const
+	{
+		T **pPage = mppPages[i >> REFTABLE_PAGE_BITS];
+		return (pPage == NULL) ? NULL : pPage[i & (REFTABLE_PAGE_SIZE - 1)];
+	}
+
+	// smallest index >= i that lies in an allocated page, or GetNumEntries()
+	// if there is none; scans over every ref step with this to skip the
+	// untouched parts of the forest
+	unsigned long NextAllocated(unsigned long i) const
+	{
+		unsigned long p = i >> REFTABLE_PAGE_BITS;
+		if ((p < mNumPages) && (mppPages[p] != NULL))
+			return i;
+		for (++p; p < mNumPages; ++p)
+			if (mppPages[p] != NULL)
+				return p << REFTABLE_PAGE_BITS;
+		return mNumEntries;
+	}
+
+	unsigned long GetNumEntries() const { return mNumEntries; }
+	unsigned long GetBytesUsed() const
+	{
+		return mNumPages * sizeof(T **) + mNumPagesAllocated * REFTABLE_PAGE_SIZE * sizeof(T *);
+	}
+
+protected:
+	// returns NULL, leaving the page untouched, if calloc fails
+	T **AllocatePage(unsigned long p)
+	{
+		mppPages[p] = (T **) calloc(REFTABLE_PAGE_SIZE, sizeof(T *));
+		if (mppPages[p] != NULL)
+			++mNumPagesAllocated;
+		return mppPages[p];
+	}
+
+	T ***mppPages;
+	unsigned long mNumEntries;
+	unsigned long mNumPages;
+	unsigned long mNumPagesAllocated;
+
+private:
+	// a cut's refs are never copied
+	RefTable(const RefTable &);
+	RefTable &operator=(const RefTable &);
+};
+
+#endif // #ifndef REFTABLE_H
@@ -83,14 +83,14 @@ Renderer::Renderer(unsigned int NumInitialVerticesToAllocate, unsigned int NumIn
 	{
 		mpSystemVertexRenderData[i].Node = 0;
 	}
-	mNumVertexSlotsFree = 0;
-	PopulateVertexSlotsCache();
+	mVertexFreeSlots.Reset(mNumVerticesAllocated);
 }
 
 Renderer::~Renderer()
 {
     // detatch from memory manager...
-    mpMemoryManager->RemoveRenderer(this);
+    if (mpMemoryManager != NULL)
+        mpMemoryManager->RemoveRenderer(this);
     
     unsigned int i;
 	if (mpPatchTriData != NULL)
@@ -127,7 +127,6 @@ void Renderer::FlushRenderData()
 
 	for (i = 0; i < mNumPatches; ++i)
 	{
-		mpPatchTriData[i].TriFreeSlots.Reset();
 		mpPatchTriData[i].NumTris = 0;
 		mpPatchTriData[i].LastActiveTri = 0;
 
@@ -141,14 +140,12 @@ void Renderer::FlushRenderData()
 			mpPatchTriData[i].TriProxiesArray[j][1] = 0;
 			mpPatchTriData[i].TriProxiesArray[j][2] = 0;
 		}
-		mpPatchTriData[i].NumTriSlotsFree = mpPatchTriData[i].NumTrisAllocated;
-		mpPatchTriData[i].TriFreeSlots.Reset();
-		PopulateTriSlotsCache(i);
+		mpPatchTriData[i].TriFreeSlots.Reset(mpPatchTriData[i].NumTrisAllocated);
+		mpPatchTriData[i].NumSlackTriSlots = mpPatchTriData[i].NumTrisAllocated;
 	}
 
 	mNumVertices = 0;
 	mLastActiveVertex = 0;
-	mNumVertexSlotsFree = 0;
 	mNumTris = 0;
 	mpCut->mNumActiveTris = 0;
 	for (i = 0; i < mNumVerticesAllocated; ++i)
@@ -157,8 +154,7 @@ void Renderer::FlushRenderData()
 		mpVertexAboveParentsOfBoundaryFlags[i] = false;
 		mpVertexUseCounts[i] = 0;
 	}
-	mVertexFreeSlots.Reset();
-	PopulateVertexSlotsCache();
+	mVertexFreeSlots.Reset(mNumVerticesAllocated);
 
 	mpCut->mBytesUsed = 0;
 }
@@ -177,7 +173,10 @@ void Renderer::AddCut(Cut *pCut)
 		return;
 	}
 
-	mNumInitialTrisToAllocate = pCut->mpForest->mNumTris;
+	// the tri arrays grow on demand, so a renderer need not start out with
+	// room for every tri in the forest
+	if ((mNumInitialTrisToAllocate == 0) || (mNumInitialTrisToAllocate > pCut->mpForest->mNumTris))
+		mNumInitialTrisToAllocate = pCut->mpForest->mNumTris;
 	mpVertexRenderData = mpSystemVertexRenderData;
 
 	mpCut = pCut;
@@ -191,6 +190,8 @@ void Renderer::AddCut(Cut *pCut)
 	mNumPatches = pCut->mpForest->mNumPatches;
 	mpPatchTriData = new PatchRenderTris[mNumPatches];
 	unsigned int TrisAllocatedPerPatch = mNumInitialTrisToAllocate / mNumPatches;
+	if (TrisAllocatedPerPatch == 0)
+		TrisAllocatedPerPatch = 1;
 	
 	unsigned int MemoryPerPatch;
 		MemoryPerPatch = (TrisAllocatedPerPatch) * (sizeof(TriProxy) + sizeof(TriProxyBackRef));
@@ -220,8 +221,8 @@ void Renderer::AddCut(Cut *pCut)
 			mpPatchTriData[i].TriProxiesArray[j][1] = 0;
 			mpPatchTriData[i].TriProxiesArray[j][2] = 0;
 		}
-		mpPatchTriData[i].NumTriSlotsFree = mpPatchTriData[i].NumTrisAllocated;
-		PopulateTriSlotsCache(i);
+		mpPatchTriData[i].TriFreeSlots.Reset(mpPatchTriData[i].NumTrisAllocated);
+		mpPatchTriData[i].NumSlackTriSlots = mpPatchTriData[i].NumTrisAllocated;
 	}
 
 	mpVertexActiveFlags = new bool[mNumVerticesAllocated];
@@ -246,38 +247,23 @@ void Renderer::RemoveCut(Cut *pCut)
 
 VertexRenderDatum *Renderer::AddVertexRenderDatum(NodeIndex iNode)
 {
-	NodeIndex CacheLocation;
-	if (mVertexFreeSlots.mSlotsCached > 0)
+	NodeIndex CacheLocation = mVertexFreeSlots.GetFreeSlot();
+	if (CacheLocation == FreeList::iNIL_SLOT)
 	{
-		mNumVertexSlotsFree--;
-		CacheLocation = mVertexFreeSlots.GetFreeSlot();
-		mSlackBytes -= mpCut->mBytesPerNode;
-	}
-	else
-	{
-		if (mNumVertexSlotsFree > 0)
+		NodeIndex newVerticesAllocated = 2 * mNumVerticesAllocated;
+		if (newVerticesAllocated > VertexIndexSizeLimit)
+			newVerticesAllocated = VertexIndexSizeLimit;
+		if ((newVerticesAllocated <= mNumVerticesAllocated) || !ReallocateVertexRenderData(newVerticesAllocated))
 		{
-			PopulateVertexSlotsCache();
-			assert(mVertexFreeSlots.mSlotsCached > 0);
-			mNumVertexSlotsFree--;
-			CacheLocation = mVertexFreeSlots.GetFreeSlot();
-			mSlackBytes -= mpCut->mBytesPerNode;
-		}
-		else
-		{
-			if (mNumVertices == mNumVerticesAllocated)
-			{
-// TODO: fix for new memory allocation scheme
-//				if (!ReallocateMemoryForRenderData(2 * mNumVerticesAllocated, 2 * mNumTrisAllocated))
-//				{
-					cerr << "Error - couldn't reallocate renderdata memory; AddVertexRenderDatum failed" << endl;
-					return NULL;
-//				}
-			}
-			CacheLocation = mNumVertices;
-			++mNumVertices;
+			cerr << "Error - couldn't reallocate renderdata memory; AddVertexRenderDatum failed" << endl;
+			return NULL;
 		}
+		CacheLocation = mVertexFreeSlots.GetFreeSlot();
 	}
+	if (CacheLocation < mNumVertices)
+		mSlackBytes -= mpCut->mBytesPerNode;
+	else
+		mNumVertices = CacheLocation + 1;
 	if (mpVertexActiveFlags[CacheLocation])
 	{
 		cerr << "we got an active one" << endl;
@@ -328,7 +314,6 @@ void Renderer::RemoveVertexRenderDatum(VertexRenderDatum *pVertexRenderDatum)
 
 	mpVertexActiveFlags[index] = false;
 	mVertexFreeSlots.AddFreeSlot(index);
-	mNumVertexSlotsFree++;
 
 	if (index == mLastActiveVertex)
 	{
@@ -343,42 +328,32 @@ void Renderer::RemoveVertexRenderDatum(VertexRenderDatum *pVertexRenderDatum)
 
 void Renderer::AddTriRenderDatum(TriIndex iTri, PatchIndex PatchID)
 {
-	unsigned int NextFreeSlot = 0xFFFFFFFF;
 	TriIndex iTriArrayLocation;
 	Forest *pForest = mpCut->mpForest;
 	
-	if (mpPatchTriData[PatchID].TriFreeSlots.mSlotsCached > 0)
+	iTriArrayLocation = mpPatchTriData[PatchID].TriFreeSlots.GetFreeSlot();
+	if (iTriArrayLocation == FreeList::iNIL_SLOT)
 	{
-		mpPatchTriData[PatchID].NumTriSlotsFree--;
-		NextFreeSlot = mpPatchTriData[PatchID].TriFreeSlots.GetFreeSlot();
-		mSlackBytes -= mpCut->mBytesPerTri;
-	}
-	else
-	{
-		if (mpPatchTriData[PatchID].NumTriSlotsFree > 0)
+		// (1.5 * 1) would not grow at all
+		unsigned int newTrisAllocated = (unsigned int) (1.5 * mpPatchTriData[PatchID].NumTrisAllocated) + 1;
+		if (!ReallocateTriRenderData(PatchID, newTrisAllocated))
 		{
-			PopulateTriSlotsCache(PatchID);
-			assert(mpPatchTriData[PatchID].TriFreeSlots.mSlotsCached > 0);
-			mpPatchTriData[PatchID].NumTriSlotsFree--;
-			NextFreeSlot = mpPatchTriData[PatchID].TriFreeSlots.GetFreeSlot();
-			mSlackBytes -= mpCut->mBytesPerTri;
-		}
-		else
-		{
-			if (mpPatchTriData[PatchID].NumTris == mpPatchTriData[PatchID].NumTrisAllocated)
-			{
-				if (!ReallocateTriRenderData(PatchID, (unsigned int) (1.5 * mpPatchTriData[PatchID].NumTrisAllocated)))
-				{
-					cerr << "Error - unable to reallocate memory for renderdata; AddTriRenderDatum failed" << endl;
-					return;
-				}
-			}
-			NextFreeSlot = mpPatchTriData[PatchID].NumTris;
+			cerr << "Error - unable to reallocate memory for renderdata; AddTriRenderDatum failed" << endl;
+			return;
 		}
+		iTriArrayLocation = mpPatchTriData[PatchID].TriFreeSlots.GetFreeSlot();
 	}
-	iTriArrayLocation = NextFreeSlot;
-	mpCut->mpTriRefs[iTri] = &mpPatchTriData[PatchID].TriProxyBackRefs[iTriArrayLocation];
-	pForest->mpTris[iTri].InitializeProxiesAndLiveTris(iTri, *pForest, this, pForest->mpTris[iTri].mPatchID);
+	if (!mpCut->mTriRefs.Set(iTri, &mpPatchTriData[PatchID].TriProxyBackRefs[iTriArrayLocation]))
+	{
+		cerr << "Error - unable to allocate memory for TriRefs; AddTriRenderDatum failed" << endl;
+		mpPatchTriData[PatchID].TriFreeSlots.AddFreeSlot(iTriArrayLocation);
+		return;
+	}
+	if (iTriArrayLocation < mpPatchTriData[PatchID].NumSlackTriSlots)
+		mSlackBytes -= mpCut->mBytesPerTri;
+	else
+		mpPatchTriData[PatchID].NumSlackTriSlots = iTriArrayLocation + 1;
+	TriInitializeProxiesAndLiveTris(iTri, *pForest, this, pForest->mpTris[iTri].mPatchID);
 #ifdef _DEBUG
 	int k;
 	for (k = 0; k < 3; ++k)
@@ -387,7 +362,7 @@ void Renderer::AddTriRenderDatum(TriIndex iTri, PatchIndex PatchID)
 		{
 			cerr << "proxy out of range" << endl;
 		}
-		if (mpCut->mpNodeRefs[mpPatchTriData[PatchID].TriProxyBackRefs[iTriArrayLocation][k]] == NULL)
+		if (mpCut->mNodeRefs.Get(mpPatchTriData[PatchID].TriProxyBackRefs[iTriArrayLocation][k]) == NULL)
 		{
 			cerr << "proxy is inactive node" << endl;
 		}
@@ -415,7 +390,6 @@ void Renderer::RemoveTriRenderDatum(TriIndex iTri, PatchIndex PatchID)
 	mpCut->mBytesUsed -= mpCut->mBytesPerTri;
 
 	mpPatchTriData[PatchID].TriFreeSlots.AddFreeSlot(iTri);
-	mpPatchTriData[PatchID].NumTriSlotsFree++;
 	--mpPatchTriData[PatchID].NumTris;
 	--mNumTris;
 	if (iTri == mpPatchTriData[PatchID].LastActiveTri)
@@ -444,11 +418,11 @@ NodeIndex Renderer::GetVertexRenderDatumIndex(VertexRenderDatum *pVRD)
 NodeIndex Renderer::GetVertexCacheBackRef(NodeIndex iVertexCacheIndex, Forest *pForest)
 {
 	NodeIndex i;
-	for (i = pForest->iROOT_NODE; i <= pForest->mNumNodes; ++i)
+	for (i = mpCut->mNodeRefs.NextAllocated(pForest->iROOT_NODE); i <= pForest->mNumNodes; i = mpCut->mNodeRefs.NextAllocated(i + 1))
 	{
-		if (mpCut->mpNodeRefs[i] != NULL)
+		if (mpCut->mNodeRefs.Get(i) != NULL)
 		{
-			if (GetVertexRenderDatumIndex(mpCut->mpNodeRefs[i]->pVertexRenderDatum) == iVertexCacheIndex)
+			if (GetVertexRenderDatumIndex(mpCut->mNodeRefs.Get(i)->pVertexRenderDatum) == iVertexCacheIndex)
 				return i;
 		}
 	}
@@ -488,23 +462,133 @@ bool Renderer::ReallocateTriRenderData(PatchIndex PatchID, unsigned int newTrisA
 		newTriProxiesArray[i].proxies[2] = 0;
 	}
 	
-	for (i = 1; i <= mpCut->mpForest->mNumTris; ++i)
+	for (i = mpCut->mTriRefs.NextAllocated(1); i <= mpCut->mpForest->mNumTris; i = mpCut->mTriRefs.NextAllocated(i + 1))
 	{
-		if (mpCut->mpTriRefs[i] != NULL)
+		if (mpCut->mTriRefs.Get(i) != NULL)
 		{
-			index = mpCut->mpTriRefs[i] - mpPatchTriData[PatchID].TriProxyBackRefs;
+			index = mpCut->mTriRefs.Get(i) - mpPatchTriData[PatchID].TriProxyBackRefs;
 			if ((index >= 0) && (index < mpPatchTriData[PatchID].NumTrisAllocated))
 			{
-				mpCut->mpTriRefs[i] = &newTriProxyBackRefs[index];
+				mpCut->mTriRefs.Set(i, &newTriProxyBackRefs[index]);
 			}
 		}
 	}
 
-	free(mpPatchTriData[PatchID].TriProxiesArray);
+	free(mpPatchTriData[PatchID].TriMemoryAllocated);
+	mpPatchTriData[PatchID].TriMemoryAllocated = newTriMemory;
 	mpPatchTriData[PatchID].TriProxiesArray = newTriProxiesArray;
 	mpPatchTriData[PatchID].TriProxyBackRefs = newTriProxyBackRefs;
 	mpPatchTriData[PatchID].NumTrisAllocated = newTrisAllocated;
-	return true;
+	return mpPatchTriData[PatchID].TriFreeSlots.Grow(newTrisAllocated);
+}
+
+bool Renderer::ReallocateVertexRenderData(NodeIndex newVerticesAllocated)
+{
+	NodeIndex i, index;
+
+	// vertices adapted in place in fast memory would need the manager to hand
+	// out a bigger block
+	if (mpVertexRenderData != mpSystemVertexRenderData)
+		return false;
+
+	VertexRenderDatum *newVertexRenderData = new VertexRenderDatum[newVerticesAllocated];
+	bool *newActiveFlags = new bool[newVerticesAllocated];
+	bool *newAboveParentsOfBoundaryFlags = new bool[newVerticesAllocated];
+	unsigned int *newUseCounts = new unsigned int[newVerticesAllocated];
+#ifdef VERBOSE_MEM_MANAGEMENT
+	cerr << "Reallocating vertex RenderData; capacity increased to " << newVerticesAllocated << " vertices." << endl;
+#endif
+
+	memcpy(newVertexRenderData, mpSystemVertexRenderData, mNumVerticesAllocated * sizeof(VertexRenderDatum));
+	memcpy(newActiveFlags, mpVertexActiveFlags, mNumVerticesAllocated * sizeof(bool));
+	memcpy(newAboveParentsOfBoundaryFlags, mpVertexAboveParentsOfBoundaryFlags, mNumVerticesAllocated * sizeof(bool));
+	memcpy(newUseCounts, mpVertexUseCounts, mNumVerticesAllocated * sizeof(unsigned int));
+	for (i = mNumVerticesAllocated; i < newVerticesAllocated; ++i)
+	{
+		newVertexRenderData[i].Node = 0;
+		newActiveFlags[i] = false;
+		newAboveParentsOfBoundaryFlags[i] = false;
+		newUseCounts[i] = 0;
+	}
+
+	for (i = mpCut->mNodeRefs.NextAllocated(1); i <= mpCut->mpForest->mNumNodes; i = mpCut->mNodeRefs.NextAllocated(i + 1))
+	{
+		if (mpCut->mNodeRefs.Get(i) != NULL)
+		{
+			index = mpCut->mNodeRefs.Get(i)->pVertexRenderDatum - mpSystemVertexRenderData;
+			mpCut->mNodeRefs.Get(i)->pVertexRenderDatum = &newVertexRenderData[index];
+		}
+	}
+
+	delete[] mpSystemVertexRenderData;
+	delete[] mpVertexActiveFlags;
+	delete[] mpVertexAboveParentsOfBoundaryFlags;
+	delete[] mpVertexUseCounts;
+	mpSystemVertexRenderData = newVertexRenderData;
+	mpVertexRenderData = newVertexRenderData;
+	mpVertexActiveFlags = newActiveFlags;
+	mpVertexAboveParentsOfBoundaryFlags = newAboveParentsOfBoundaryFlags;
+	mpVertexUseCounts = newUseCounts;
+	mNumVerticesAllocated = newVerticesAllocated;
+	return mVertexFreeSlots.Grow(newVerticesAllocated);
+}
+
+struct TriSlotMoveContext
+{
+	PatchRenderTris *pPatch;
+	RefTable<TriProxyBackRef> *pTriRefs;
+	TriIndex *pSlotTris;	// forest tri held by each slot
+};
+
+void Renderer::MoveTriSlot(void *pContext, NodeIndex From, NodeIndex To)
+{
+	TriSlotMoveContext *pMove = (TriSlotMoveContext *) pContext;
+	PatchRenderTris *pPatch = pMove->pPatch;
+	TriIndex iTri = pMove->pSlotTris[From];
+
+	pPatch->TriProxiesArray[To] = pPatch->TriProxiesArray[From];
+	pPatch->TriProxyBackRefs[To] = pPatch->TriProxyBackRefs[From];
+	pPatch->TriProxyBackRefs[From][0] = Forest::iNIL_NODE;
+	pPatch->TriProxyBackRefs[From].miNextLiveTris[0] = Forest::iNIL_TRI;
+	pPatch->TriProxyBackRefs[From].miNextLiveTris[1] = Forest::iNIL_TRI;
+	pPatch->TriProxyBackRefs[From].miNextLiveTris[2] = Forest::iNIL_TRI;
+	pPatch->TriProxiesArray[From][0] = 0;
+	pPatch->TriProxiesArray[From][1] = 0;
+	pPatch->TriProxiesArray[From][2] = 0;
+
+	pMove->pTriRefs->Set(iTri, &pPatch->TriProxyBackRefs[To]);
+	pMove->pSlotTris[To] = iTri;
+}
+
+TriIndex Renderer::CompactTriRenderData(PatchIndex PatchID)
+{
+	TriIndex i, index, NumMoved;
+	PatchRenderTris *pPatch = &mpPatchTriData[PatchID];
+	TriSlotMoveContext Move;
+
+	if (pPatch->TriFreeSlots.GetFragmentation() == 0.0f)
+		return 0;
+
+	// the backrefs name a tri's vertices, not the tri itself, so map slots
+	// back to forest tris through the cut's TriRefs
+	Move.pPatch = pPatch;
+	Move.pTriRefs = &mpCut->mTriRefs;
+	Move.pSlotTris = new TriIndex[pPatch->NumTrisAllocated];
+	for (i = mpCut->mTriRefs.NextAllocated(1); i <= mpCut->mpForest->mNumTris; i = mpCut->mTriRefs.NextAllocated(i + 1))
+	{
+		if (mpCut->mTriRefs.Get(i) != NULL)
+		{
+			index = mpCut->mTriRefs.Get(i) - pPatch->TriProxyBackRefs;
+			if (index < pPatch->NumTrisAllocated)
+				Move.pSlotTris[index] = i;
+		}
+	}
+
+	NumMoved = pPatch->TriFreeSlots.Compact(MoveTriSlot, &Move);
+	delete[] Move.pSlotTris;
+
+	pPatch->LastActiveTri = (pPatch->NumTris > 0) ? pPatch->NumTris - 1 : 0;
+	return NumMoved;
 }
 
 /*
@@ -540,7 +624,6 @@ bool Renderer::AllocateSystemMemoryForRenderData()
 //			mpTriProxyBackRefs[i][1] = Forest::iNIL_NODE;
 //			mpTriProxyBackRefs[i][2] = Forest::iNIL_NODE;
 //		}
-		PopulateVertexSlotsCache();
 	}
 	else
 	{
@@ -639,12 +722,12 @@ void Renderer::UseSystemMemoryVertexData()
 		return;
 
 	memcpy(mpSystemVertexRenderData, mpFastVertexRenderData, mNumVertices * sizeof(VertexRenderDatum));
-	for (j = 1; j <= mpCut->mpForest->mNumNodes; ++j)
+	for (j = mpCut->mNodeRefs.NextAllocated(1); j <= mpCut->mpForest->mNumNodes; j = mpCut->mNodeRefs.NextAllocated(j + 1))
 	{
-		if (mpCut->mpNodeRefs[j] != NULL)
+		if (mpCut->mNodeRefs.Get(j) != NULL)
 		{
-			index = mpCut->mpNodeRefs[j]->pVertexRenderDatum - mpFastVertexRenderData;
-			mpCut->mpNodeRefs[j]->pVertexRenderDatum = &mpSystemVertexRenderData[index];
+			index = mpCut->mNodeRefs.Get(j)->pVertexRenderDatum - mpFastVertexRenderData;
+			mpCut->mNodeRefs.Get(j)->pVertexRenderDatum = &mpSystemVertexRenderData[index];
 		}
 	}
 	mpVertexRenderData = mpSystemVertexRenderData;
@@ -658,45 +741,17 @@ void Renderer::UseFastMemoryVertexData()
 		return;
 
 	memcpy(mpFastVertexRenderData, mpSystemVertexRenderData, mNumVertices * sizeof(VertexRenderDatum));
-	for (j = 1; j <= mpCut->mpForest->mNumNodes; ++j)
+	for (j = mpCut->mNodeRefs.NextAllocated(1); j <= mpCut->mpForest->mNumNodes; j = mpCut->mNodeRefs.NextAllocated(j + 1))
 	{
-		if (mpCut->mpNodeRefs[j] != NULL)
+		if (mpCut->mNodeRefs.Get(j) != NULL)
 		{
-			index = mpCut->mpNodeRefs[j]->pVertexRenderDatum - mpSystemVertexRenderData;
-			mpCut->mpNodeRefs[j]->pVertexRenderDatum = &mpFastVertexRenderData[index];
+			index = mpCut->mNodeRefs.Get(j)->pVertexRenderDatum - mpSystemVertexRenderData;
+			mpCut->mNodeRefs.Get(j)->pVertexRenderDatum = &mpFastVertexRenderData[index];
 		}
 	}
 	mpVertexRenderData = mpFastVertexRenderData;
 }
 
-void Renderer::PopulateVertexSlotsCache()
-{
-	unsigned int k;
-	for (k = 0; k < mNumVertices; ++k)
-	{
-		if (mpVertexActiveFlags[k] == false)
-		{
-			mVertexFreeSlots.AddFreeSlot(k);
-			if ((mVertexFreeSlots.mSlotsCached >= mNumVertexSlotsFree) || (mVertexFreeSlots.mSlotsCached == FREELISTSIZE))
-				return;
-		}
-	}
-}
-
-void Renderer::PopulateTriSlotsCache(VDS::PatchIndex PatchID)
-{
-	unsigned int k;
-	for (k = 0; k < mpPatchTriData[PatchID].NumTrisAllocated; ++k)
-	{
-		if (mpPatchTriData[PatchID].TriProxyBackRefs[k][0] == Forest::iNIL_NODE)
-		{
-			mpPatchTriData[PatchID].TriFreeSlots.AddFreeSlot(k);
-			if (mpPatchTriData[PatchID].TriFreeSlots.mSlotsCached >= mpPatchTriData[PatchID].NumTriSlotsFree)
-				return;
-		}
-	}
-}
-
 void Renderer::SetVertexRenderDatumAboveParentsOfBoundary(VertexRenderDatum *pVRD, bool newflag)
 {
 	unsigned int index = pVRD - mpVertexRenderData;
@@ -55,8 +55,10 @@ struct PatchRenderTris
 	
 	// number of triangles whose proxies can fit in TriProxiesArray
 	TriIndex NumTrisAllocated;
-	int NumTriSlotsFree;
-	FreeList TriFreeSlots;
+	FreeList TriFreeSlots;	// tracks which of the NumTrisAllocated slots are used
+	// slots below this come out of mSlackBytes when used: those allocated at
+	// the last reset and any used since; slots added by a reallocation do not
+	TriIndex NumSlackTriSlots;
 
 	bool NormalsPresent;
 	bool ColorsPresent;
@@ -87,11 +89,16 @@ public: // PUBLIC FUNCTIONS
 	unsigned int GetVertexUseCount(VertexRenderDatum *pVRD);
 	void ZeroVertexUseCount(VertexRenderDatum *pVRD);
 
+	// moves a patch's live triangles down into its free slots so they occupy
+	// slots 0..NumTris-1 and LastActiveTri == NumTris-1; returns the number of
+	// triangles moved.  Worth calling when the patch's TriFreeSlots reports
+	// high fragmentation, since renderers walk the slots up to LastActiveTri.
+	TriIndex CompactTriRenderData(PatchIndex PatchID);
+
 protected: // PRIVATE FUNCTIONS
 	bool ReallocateTriRenderData(PatchIndex PatchID, unsigned int newTrisAllocated);
-
-	void PopulateVertexSlotsCache();
-	void PopulateTriSlotsCache(VDS::PatchIndex PatchID);
+	bool ReallocateVertexRenderData(NodeIndex newVerticesAllocated);
+	static void MoveTriSlot(void *pContext, NodeIndex From, NodeIndex To);
 	VertexRenderDatum *CacheVertex(NodeIndex iVertexArrayLocation, Node *pNode);
 	void UseSystemMemoryVertexData();
 	void UseFastMemoryVertexData();
@@ -110,7 +117,7 @@ public:	// PUBLIC DATA
 	TriProxy *mpTriProxyData;
 	bool mUseFastMemory;
 	bool mCopyDataToFastMemoryPerFrame;
-	NodeIndex mNumVertices;
+	NodeIndex mNumVertices;	// one past the highest vertex slot used since the last flush
 	NodeIndex mLastActiveVertex;
 	NodeIndex *mpVertexNodeIDs;
 	unsigned int mVertexDataStride;
@@ -180,9 +187,7 @@ public: // MEMORY MANAGEMENT FUNCTIONS AND DATA
 
 protected: // PRIVATE DATA
 public:
-	FreeList mVertexFreeSlots;
-
-	int mNumVertexSlotsFree;
+	FreeList mVertexFreeSlots;	// tracks which of the mNumVerticesAllocated slots are used
 
 public: // DEBUG DATA
 	float *ACMR;
@@ -18,10 +18,12 @@
 #endif
 
 #include <cassert>
+#include <cmath>
 #include <iostream>
 #include "simplifier.h"
 #include "forest.h"
 #include "cut.h"
+#include "threads.h"
 
 using namespace std;
 using namespace VDS;
@@ -37,12 +39,19 @@ Simplifier::Simplifier()
 	mIsValid = false;
 	mBudgetTolerance = 0;
 	mSimplificationBreakCount = 0;
+	mErrorUpdateTolerance = 0.0f;
+	mNumThreads = GetNumSystemProcessors();
+	mNumErrorEvaluations = 0;
 
 // private data initialization
 	mpCuts = NULL;
 	mNumCuts = 0;
 	miCurrentCut = -666666;
 	mpCurrentForest = NULL;
+	mNodeErrorsCurrent = true;
+	mRecomputeNodeErrors = false;
+	mpThreadPool = NULL;
+	mThreadPoolSize = 0;
 	mpFoldQueue = new NodeQueue(this);
 	mpFoldQueue->Initialize(48, -FLT_MAX);
 	mpUnfoldQueue = new NodeQueue(this);
@@ -69,6 +78,7 @@ Simplifier::~Simplifier()
 		delete[] mpCuts;
 	delete mpFoldQueue;
 	delete mpUnfoldQueue;
+	delete mpThreadPool;
 }
 
 void Simplifier::AddCut(Cut *pCut)
@@ -96,12 +106,17 @@ void Simplifier::AddCut(Cut *pCut)
 	RootNode.mYBBoxOffset = pCut->mpForest->mpNodes[RootNode.miNode].mYBBoxOffset;
 	RootNode.mZBBoxOffset = pCut->mpForest->mpNodes[RootNode.miNode].mZBBoxOffset;
 	RootNode.mBBoxCenter = pCut->mpForest->mpNodes[RootNode.miNode].mBBoxCenter;
-	RootNode.mError = -mfErrorFunc(&RootNode, pCut);
+	RootNode.mError = -EvaluateError(&RootNode, pCut);
+	RootNode.mViewMotion = pCut->mViewMotion;
 
 	RootNode.pVertexRenderDatum = pCut->mpRenderer->AddVertexRenderDatum(RootNode.miNode);
 	RootNode.pVertexRenderDatum->Node = RootNode.miNode;
 
-	pCut->mpNodeRefs[RootNode.miNode] = &RootNode;
+	if (!pCut->mNodeRefs.Set(RootNode.miNode, &RootNode))
+	{
+		cerr << "Memory Error - unable to allocate the root NodeRef for a new cut." << endl;
+		return;
+	}
 	mpUnfoldQueue->Insert(&RootNode);
 	pCut->mNumActiveNodes = 1;
 }
@@ -111,60 +126,199 @@ void Simplifier::RemoveCut(Cut *pCut)
 	cerr << "Simplifier::RemoveCut not implemented yet." << endl;
 }
 
-void Simplifier::UpdateNodeErrors()
+// largest change of any entry between two transforms; a point p moves by at
+// most this times (|p.X| + |p.Y| + |p.Z| + 1) in each transformed coordinate
+static double MatrixDistance(const Mat4 &A, const Mat4 &B)
+{
+	double dist = 0.0;
+	for (int i = 0; i < 4; ++i)
+		for (int j = 0; j < 4; ++j)
+		{
+			double d = fabs((double) A.cells[i][j] - (double) B.cells[i][j]);
+			if (d > dist)
+				dist = d;
+		}
+	return dist;
+}
+
+// bound on how far any corner of pItem's bounding box can have moved (in the
+// cut's transformed coordinates) since pItem's error was last computed
+static inline double NodeMotionBound(const BudgetItem *pItem, const Cut *pCut)
+{
+	double motion = pCut->mViewMotion - pItem->mViewMotion;
+	if (motion <= 0.0)
+		return 0.0;
+	return motion * (1.0 + fabs(pItem->mBBoxCenter.X) + pItem->mXBBoxOffset
+						 + fabs(pItem->mBBoxCenter.Y) + pItem->mYBBoxOffset
+						 + fabs(pItem->mBBoxCenter.Z) + pItem->mZBBoxOffset);
+}
+
+// fewest queue elements worth handing to a thread of their own
+static const int MIN_ERRORS_PER_THREAD = 4096;
+
+struct QueueErrorPass
+{
+	Simplifier *pSimplifier;
+	NodeQueue *pQueue;
+	Float Sign;
+	bool All;
+};
+
+// ParallelFor body: re-evaluates the stale errors in a range of queue slots;
+// each element is written by one thread only and the heap is left alone
+static void EvaluateQueueErrors(void *pContext, int First, int Last)
+{
+	QueueErrorPass *pPass = (QueueErrorPass *) pContext;
+	Simplifier *pSimplifier = pPass->pSimplifier;
+	BudgetItem *element;
+	Cut *pCut;
+
+	for (int i = First; i <= Last; ++i)
+	{
+		element = pPass->pQueue->GetElement(i);
+		pCut = pSimplifier->mpCuts[element->CutID];
+		if (pPass->All || (NodeMotionBound(element, pCut) > pSimplifier->mErrorUpdateTolerance))
+		{
+			element->mError = pPass->Sign * pSimplifier->mfErrorFunc(element, pCut);
+			element->mViewMotion = pCut->mViewMotion;
+		}
+	}
+}
+
+bool Simplifier::UpdateQueueErrors(NodeQueue *pQueue, Float Sign, bool All)
 {
 	int i;
-	int PQsize;
+	int NumStale = 0;
+	bool Drifted = false;
 	BudgetItem *element;
+	Cut *pCut;
+	Float NewError;
+	double bound;
 
-#ifdef TIMING_LEVEL_2
-	LARGE_INTEGER time_1, time_2, time_3, time_4, time_5;
-	QueryPerformanceCounter(&time_1);
-#endif
+	if (All)
+		NumStale = pQueue->Size;
+	else
+	{
+		for (i = 1; i <= pQueue->Size; ++i)
+		{
+			element = pQueue->GetElement(i);
+			bound = NodeMotionBound(element, mpCuts[element->CutID]);
+			if (bound > mErrorUpdateTolerance)
+				++NumStale;
+			else if (bound > 0.0)
+				Drifted = true;
+		}
+	}
+
+	if (NumStale == 0)
+		return Drifted;
 
-	PQsize = mpFoldQueue->Size;
-	for (i = 1; i <= PQsize; ++i)
+	// when a large part of the queue changed, rebuilding the whole heap is
+	// cheaper than sifting each changed element into place; the errors are
+	// independent of each other and are evaluated in parallel, the rebuild
+	// stays on this thread
+	if (NumStale > pQueue->Size / 4)
 	{
-		element = mpFoldQueue->GetElement(i);
-		element->mError = mfErrorFunc(element, mpCuts[element->CutID]);
+		QueueErrorPass Pass;
+		Pass.pSimplifier = this;
+		Pass.pQueue = pQueue;
+		Pass.Sign = Sign;
+		Pass.All = All;
+		// the threads are kept for later passes; they are only replaced
+		// when mNumThreads has been changed since they were started
+		if (mpThreadPool == NULL || mThreadPoolSize != mNumThreads)
+		{
+			delete mpThreadPool;
+			mpThreadPool = new ThreadPool(mNumThreads);
+			mThreadPoolSize = mNumThreads;
+		}
+		mpThreadPool->ParallelFor(1, pQueue->Size, MIN_ERRORS_PER_THREAD,
+								  EvaluateQueueErrors, &Pass);
+		// the threads evaluate exactly the stale elements counted above
+		mNumErrorEvaluations += NumStale;
+		pQueue->buildheap();
+		return Drifted;
 	}
 
+	// an Update() can pull an element not yet looked at into slot i, so slot i
+	// is looked at again until it holds an element that needs no work
+	i = 1;
+	while (i <= pQueue->Size)
+	{
+		element = pQueue->GetElement(i);
+		pCut = mpCuts[element->CutID];
+		if (NodeMotionBound(element, pCut) <= mErrorUpdateTolerance)
+		{
+			++i;
+			continue;
+		}
+
+		element->mViewMotion = pCut->mViewMotion;
+		NewError = Sign * EvaluateError(element, pCut);
+		if (NewError == element->mError)
+		{
+			++i;
+			continue;
+		}
+		element->mError = NewError;
+		pQueue->Update(element);
+	}
+	return Drifted;
+}
+
+void Simplifier::UpdateNodeErrors()
+{
+	int i;
+	bool ViewMoved = false;
+	bool Drifted;
+	Cut *pCut;
+	double motion;
+
 #ifdef TIMING_LEVEL_2
-	QueryPerformanceCounter(&time_2);
+	LARGE_INTEGER time_1, time_2, time_3;
+	QueryPerformanceCounter(&time_1);
 #endif
 
-	PQsize = mpUnfoldQueue->Size;
-	for (i = 1; i <= PQsize; ++i)
+	for (i = 0; i < mNumCuts; ++i)
 	{
-		element = mpUnfoldQueue->GetElement(i);
-		element->mError = -mfErrorFunc(element, mpCuts[element->CutID]);
+		pCut = mpCuts[i];
+		motion = MatrixDistance(pCut->mTransformMatrix, pCut->mErrorMatrix);
+		if (motion > 0.0)
+		{
+			pCut->mViewMotion += motion;
+			pCut->mErrorMatrix = pCut->mTransformMatrix;
+			ViewMoved = true;
+		}
 	}
 
-#ifdef TIMING_LEVEL_2
-	QueryPerformanceCounter(&time_3);
-#endif
+	// nothing moved and nothing was left behind last time
+	if (!ViewMoved && mNodeErrorsCurrent && !mRecomputeNodeErrors)
+		return;
 
-	mpFoldQueue->buildheap();
+	Drifted = UpdateQueueErrors(mpFoldQueue, 1.0f, mRecomputeNodeErrors);
 
 #ifdef TIMING_LEVEL_2
-	QueryPerformanceCounter(&time_4);
+	QueryPerformanceCounter(&time_2);
 #endif
 
-	mpUnfoldQueue->buildheap();
+	Drifted = UpdateQueueErrors(mpUnfoldQueue, -1.0f, mRecomputeNodeErrors) || Drifted;
+	mNodeErrorsCurrent = !Drifted;
+	mRecomputeNodeErrors = false;
 
 #ifdef TIMING_LEVEL_2
-	QueryPerformanceCounter(&time_5);
+	QueryPerformanceCounter(&time_3);
 	times_26.LowPart = (time_2.LowPart - time_1.LowPart);
 	times_27.LowPart = (time_3.LowPart - time_2.LowPart);
-	times_28.LowPart = (time_4.LowPart - time_3.LowPart);
-	times_29.LowPart = (time_5.LowPart - time_4.LowPart);
-#endif
-#ifdef TIMING_LEVEL_2
 	foldqueue_size = mpFoldQueue->Size;
 	unfoldqueue_size = mpUnfoldQueue->Size;
 #endif
 }
 
+void Simplifier::InvalidateNodeErrors()
+{
+	mRecomputeNodeErrors = true;
+}
+
 void Simplifier::FlushQueues()
 {
 	BudgetItem *pItem;
@@ -178,7 +332,7 @@ void Simplifier::FlushQueues()
 		node = pItem->miNode;
 		pCurrentCut = mpCuts[pItem->CutID];
 		mpFoldQueue->Remove(pItem);
-		pCurrentCut->mpNodeRefs[node] = NULL;
+		pCurrentCut->mNodeRefs.Set(node, NULL);
 	}
 	while (mpUnfoldQueue->Size > 0)
 	{
@@ -186,20 +340,19 @@ void Simplifier::FlushQueues()
 		node = pItem->miNode;
 		pCurrentCut = mpCuts[pItem->CutID];
 		mpUnfoldQueue->Remove(pItem);
-		pCurrentCut->mpNodeRefs[node] = NULL;
+		pCurrentCut->mNodeRefs.Set(node, NULL);
 	}
 	for (miCurrentCut = 0; miCurrentCut < mNumCuts; ++miCurrentCut)
 	{
 		pCurrentCut = mpCuts[miCurrentCut];
-		for (i = 1; i <= pCurrentCut->mpForest->mNumNodes; ++i)
+		for (i = pCurrentCut->mNodeRefs.NextAllocated(1); i <= pCurrentCut->mpForest->mNumNodes; i = pCurrentCut->mNodeRefs.NextAllocated(i + 1))
 		{
-			if (pCurrentCut->mpNodeRefs[i] != NULL)
-			{
-				delete pCurrentCut->mpNodeRefs[i];
-				pCurrentCut->mpNodeRefs[i] = NULL;
-			}
+			if (pCurrentCut->mNodeRefs.Get(i) != NULL)
+				delete pCurrentCut->mNodeRefs.Get(i);
 		}
 		pCurrentCut->mpRenderer->FlushRenderData();
+		// the cut starts over from the root, so drop the pages it had reached
+		pCurrentCut->InitializeRefs();
 	}
 
 	for (miCurrentCut = 0; miCurrentCut < mNumCuts; ++miCurrentCut)
@@ -217,12 +370,17 @@ void Simplifier::FlushQueues()
 		RootNode.mZBBoxOffset = pCurrentCut->mpForest->mpNodes[RootNode.miNode].mZBBoxOffset;
 		RootNode.mBBoxCenter = pCurrentCut->mpForest->mpNodes[RootNode.miNode].mBBoxCenter;
 
-		RootNode.mError = -mfErrorFunc(&RootNode, pCurrentCut);
+		RootNode.mError = -EvaluateError(&RootNode, pCurrentCut);
+		RootNode.mViewMotion = pCurrentCut->mViewMotion;
 
 		RootNode.pVertexRenderDatum = pCurrentCut->mpRenderer->AddVertexRenderDatum(RootNode.miNode);
 		RootNode.pVertexRenderDatum->Node = RootNode.miNode;
 
-		pCurrentCut->mpNodeRefs[RootNode.miNode] = &RootNode;
+		if (!pCurrentCut->mNodeRefs.Set(RootNode.miNode, &RootNode))
+		{
+			cerr << "Memory Error - unable to allocate the root NodeRef when resetting a cut." << endl;
+			continue;
+		}
 		mpUnfoldQueue->Insert(&RootNode);
 		pCurrentCut->mNumActiveNodes = 1;
 	}
@@ -279,7 +437,12 @@ void Simplifier::SimplifyBudget(unsigned int Budget, bool UseTriBudget)
 			LastUnfold = UnfoldNode->miNode;
 			LastCutUnfolded = UnfoldNode->CutID;
 
-			Unfold(UnfoldNode, NumTris, BytesUsed);
+			if (!Unfold(UnfoldNode, NumTris, BytesUsed))
+			{
+				// out of memory; stop growing the cut
+				UnfoldNode = NULL;
+				break;
+			}
 			curval = UseTriBudget ? NumTris : BytesUsed;
 			if (mSimplificationBreakCount)
 			{
@@ -380,7 +543,8 @@ void Simplifier::SimplifyThreshold(float Threshold)
 		{
 			break;
 		}
-		Unfold(UnfoldNode, NumTris, BytesUsed);
+		if (!Unfold(UnfoldNode, NumTris, BytesUsed))
+			break;
 		if (mSimplificationBreakCount)
 		{
 			++count;
@@ -441,7 +605,12 @@ void Simplifier::SimplifyBudgetAndThreshold(unsigned int Budget, bool UseTriBudg
 			LastUnfold = UnfoldNode->miNode;
 			LastCutUnfolded = UnfoldNode->CutID;
 			
-			Unfold(UnfoldNode, NumTris, BytesUsed);
+			if (!Unfold(UnfoldNode, NumTris, BytesUsed))
+			{
+				// out of memory; stop growing the cut
+				UnfoldNode = NULL;
+				break;
+			}
 			curval = UseTriBudget ? NumTris : BytesUsed;
 			if (mSimplificationBreakCount)
 			{
@@ -566,7 +735,7 @@ const Float& Simplifier::GetInvTanFov(BudgetItem *pItem) const
 }
 */
 
-void Simplifier::Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &BytesUsed)
+bool Simplifier::Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &BytesUsed)
 {
 	NodeIndex iChild;
 	TriIndex iLiveTri, iNextLiveTri;
@@ -579,7 +748,7 @@ void Simplifier::Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &
 	if (pItem == NULL)
 	{
 		cerr << "tried to unfold a null element" << endl;
-		return;
+		return false;
 	}
 
 #ifdef TIMING_LEVEL_3
@@ -594,17 +763,38 @@ void Simplifier::Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &
 	NodeIndex iNode = pItem->miNode;
 	Node *pNodes = mpCurrentForest->mpNodes;
 	Tri *pTris = mpCurrentForest->mpTris;
-	BudgetItem **pNodeRefs = pCurrentCut->mpNodeRefs;
-	TriProxyBackRef **pTriRefs = pCurrentCut->mpTriRefs;
+	RefTable<BudgetItem> &rNodeRefs = pCurrentCut->mNodeRefs;
+	RefTable<TriProxyBackRef> &rTriRefs = pCurrentCut->mTriRefs;
 	Renderer *pRenderer = pCurrentCut->mpRenderer;
 	NodeIndex iParent = pNodes[iNode].miParent;
 
 //cout << " unfolding node " << iNode << endl;
 
-	if ((pNodeRefs[pNodes[iNode].miFirstChild] == NULL) && (pNodes[iNode].miFirstChild != Forest::iNIL_NODE))
+	if ((rNodeRefs.Get(pNodes[iNode].miFirstChild) == NULL) && (pNodes[iNode].miFirstChild != Forest::iNIL_NODE))
 	{
+		// allocate every ref page this unfold stores into before changing
+		// anything, so running out of memory leaves the node folded
+		for (iChild = pNodes[iNode].miFirstChild; iChild != Forest::iNIL_NODE; iChild = pNodes[iChild].miRightSibling)
+		{
+			if (!rNodeRefs.Reserve(iChild))
+			{
+				cerr << "Memory Error - unable to allocate NodeRefs for the children of node " << iNode << "." << endl;
+				miCurrentCut = 0;
+				return false;
+			}
+		}
+		for (iSubTri = pNodes[iNode].miFirstSubTri; iSubTri != Forest::iNIL_TRI; iSubTri = pTris[iSubTri].miNextSubTri)
+		{
+			if (!rTriRefs.Reserve(iSubTri))
+			{
+				cerr << "Memory Error - unable to allocate TriRefs for the subtris of node " << iNode << "." << endl;
+				miCurrentCut = 0;
+				return false;
+			}
+		}
+
 		if (pNodes[iNode].miParent != Forest::iNIL_NODE)
-			pRenderer->SetVertexRenderDatumAboveParentsOfBoundary(pNodeRefs[pNodes[iNode].miParent]->pVertexRenderDatum, true);
+			pRenderer->SetVertexRenderDatumAboveParentsOfBoundary(rNodeRefs.Get(pNodes[iNode].miParent)->pVertexRenderDatum, true);
 
 		// for each child of iNode:
 		iChild = pNodes[iNode].miFirstChild;
@@ -628,12 +818,13 @@ void Simplifier::Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &
 			newBudgetItem.mZBBoxOffset = pCurrentCut->mpForest->mpNodes[iChild].mZBBoxOffset;
 			newBudgetItem.mBBoxCenter = pCurrentCut->mpForest->mpNodes[iChild].mBBoxCenter;
 
-			newBudgetItem.mError = -mfErrorFunc(&newBudgetItem, pCurrentCut);
+			newBudgetItem.mError = -EvaluateError(&newBudgetItem, pCurrentCut);
+			newBudgetItem.mViewMotion = pCurrentCut->mViewMotion;
 
 			// set BudgetItem.RenderData pointer to address of child's RenderData
 			newBudgetItem.pVertexRenderDatum = newVertexRenderDatum;
 
-			pNodeRefs[iChild] = &newBudgetItem;
+			rNodeRefs.Set(iChild, &newBudgetItem);
 
 #ifdef PRUNING
 			// only put child's budgetitem in unfoldqueue if child is not a leaf node
@@ -645,18 +836,18 @@ void Simplifier::Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &
 				mpUnfoldQueue->Insert(&newBudgetItem);
 
 				// this is needed because the location of pItem could have changed if the unfoldqueue was enlarged during the Insert call
-				pItem = pNodeRefs[iNode];
+				pItem = rNodeRefs.Get(iNode);
 #ifdef PRUNING
 			}
 			else
 			{
-				pNodeRefs[iChild] = new BudgetItem;
-				if (pNodeRefs[iChild] == NULL)
+				rNodeRefs.Set(iChild, new BudgetItem);
+				if (rNodeRefs.Get(iChild) == NULL)
 				{
 					cerr << "Memory Error - new returned NULL when creating BudgetItem for pruned child." << endl;
 				}
 				else
-					memcpy(pNodeRefs[iChild], &newBudgetItem, sizeof(BudgetItem));
+					memcpy(rNodeRefs.Get(iChild), &newBudgetItem, sizeof(BudgetItem));
 			}
 #endif			
 			iChild = pNodes[iChild].miRightSibling;
@@ -665,30 +856,30 @@ void Simplifier::Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &
 		BytesUsed += NumChildren * pCurrentCut->mBytesPerNode;
 
 		// for each livetri of iNode:
-		for (iLiveTri = pNodeRefs[iNode]->miFirstLiveTri; iLiveTri != Forest::iNIL_TRI; iLiveTri = iNextLiveTri)
+		for (iLiveTri = rNodeRefs.Get(iNode)->miFirstLiveTri; iLiveTri != Forest::iNIL_TRI; iLiveTri = iNextLiveTri)
 		{
 			// update proxy which currently points to iNode to point to one of iNode's children 
 			// (use children nodeIDs and nodeID of livetri's corner to determine which child)
 
 /* this apparently not needed anymore, but leaving it in until i get around to figuring out why
 			// TODO: why need to call GetNodeIndex twice?
-			k = pTris[iLiveTri].GetNodeIndex(iLiveTri, Forest::iNIL_NODE, mpCurrentForest, pCurrentCut->mpRenderer);
-			if (pTriRefs[iLiveTri]->backrefs[k] != Forest::iNIL_NODE)
+			k = TriGetNodeIndex(iLiveTri, Forest::iNIL_NODE, mpCurrentForest, pCurrentCut->mpRenderer);
+			if (rTriRefs.Get(iLiveTri)->backrefs[k] != Forest::iNIL_NODE)
 			{
-				k = pTris[iLiveTri].GetNodeIndex(iLiveTri, iNode, mpCurrentForest, pCurrentCut->mpRenderer);
+				k = TriGetNodeIndex(iLiveTri, iNode, mpCurrentForest, pCurrentCut->mpRenderer);
 			}
 */
-			k = pTris[iLiveTri].GetNodeIndex(iLiveTri, iNode, mpCurrentForest, pCurrentCut->mpRenderer);
-			iNextLiveTri = pTriRefs[iLiveTri]->miNextLiveTris[k];
+			k = TriGetNodeIndex(iLiveTri, iNode, mpCurrentForest, pCurrentCut->mpRenderer);
+			iNextLiveTri = rTriRefs.Get(iLiveTri)->miNextLiveTris[k];
 			
-			pTris[iLiveTri].RemoveFromLiveTriList(iLiveTri, iNode, *mpCurrentForest, pCurrentCut->mpRenderer);
-			pTris[iLiveTri].MoveProxyDown(iLiveTri, k, *mpCurrentForest, pRenderer);
+			TriRemoveFromLiveTriList(iLiveTri, iNode, *mpCurrentForest, pCurrentCut->mpRenderer);
+			TriMoveProxyDown(iLiveTri, k, *mpCurrentForest, pRenderer);
 
 			// update the proxy - MoveProxyDown actually moves the ProxyBackRef down
-			unsigned int tri_index = pTriRefs[iLiveTri] - pRenderer->mpPatchTriData[pTris[iLiveTri].mPatchID].TriProxyBackRefs;
-			pRenderer->mpPatchTriData[pTris[iLiveTri].mPatchID].TriProxiesArray[tri_index].proxies[k] = pRenderer->GetVertexRenderDatumIndex(pNodeRefs[pTriRefs[iLiveTri]->backrefs[k]]->pVertexRenderDatum);
+			unsigned int tri_index = rTriRefs.Get(iLiveTri) - pRenderer->mpPatchTriData[pTris[iLiveTri].mPatchID].TriProxyBackRefs;
+			pRenderer->mpPatchTriData[pTris[iLiveTri].mPatchID].TriProxiesArray[tri_index].proxies[k] = pRenderer->GetVertexRenderDatumIndex(rNodeRefs.Get(rTriRefs.Get(iLiveTri)->backrefs[k])->pVertexRenderDatum);
 
-			pTris[iLiveTri].AddToLiveTriList(iLiveTri, k, *mpCurrentForest, pRenderer);
+			TriAddToLiveTriList(iLiveTri, k, *mpCurrentForest, pRenderer);
 		}
 
 		// for each subtri of iNode:
@@ -708,12 +899,12 @@ void Simplifier::Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &
 		
 		// because of the addition of the children, pItem likely now points to a different
 		// element of the queue than iNode's, so update it to point to iNode's entry again
-		pItem = mpUnfoldQueue->Find(pNodeRefs[iNode]);
+		pItem = mpUnfoldQueue->Find(rNodeRefs.Get(iNode));
 
 		mpUnfoldQueue->GiveElementTo(pItem, mpFoldQueue);
 
 		// pItem still points to iNode's old element in UnfoldQueue, so update it
-		pItem = mpFoldQueue->Find(pNodeRefs[iNode]);
+		pItem = mpFoldQueue->Find(rNodeRefs.Get(iNode));
 
 	//	pItem->mError = mfErrorFunc(pItem, pCurrentCut);
 
@@ -732,7 +923,7 @@ void Simplifier::Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &
 				{
 					if (pNodes[iChild].miFirstChild != Forest::iNIL_NODE)
 					{
-						if ((pNodeRefs[pNodes[iChild].miFirstChild] != NULL) && (iChild != iNode))
+						if ((rNodeRefs.Get(pNodes[iChild].miFirstChild) != NULL) && (iChild != iNode))
 						{
 							alreadyremoved = true;
 							break;
@@ -751,11 +942,11 @@ void Simplifier::Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &
 				testnode = iParent;
 				do
 				{
-					ParentItem = pNodeRefs[testnode];
+					ParentItem = rNodeRefs.Get(testnode);
 					NewItem = new BudgetItem;
 					memcpy(NewItem, ParentItem, sizeof(BudgetItem));
 					mpFoldQueue->Remove(ParentItem);
-					pNodeRefs[testnode] = NewItem;
+					rNodeRefs.Set(testnode, NewItem);
 					testnode = pNodes[testnode].mCoincidentVertex;
 				}
 				while ((testnode != Forest::iNIL_NODE) && (testnode != iParent));
@@ -781,10 +972,10 @@ void Simplifier::Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &
 #endif
 
 		if (pNodes[iNode].mCoincidentVertex)
-			Unfold(pNodeRefs[pNodes[iNode].mCoincidentVertex], NumTris, BytesUsed);
+			return Unfold(rNodeRefs.Get(pNodes[iNode].mCoincidentVertex), NumTris, BytesUsed);
 	}
 	miCurrentCut = 0;
-
+	return true;
 }
 
 void Simplifier::Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &BytesUsed)
@@ -812,8 +1003,8 @@ void Simplifier::Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &By
 
 	Node *pNodes = pCurrentCut->mpForest->mpNodes;
 	Tri *pTris = pCurrentCut->mpForest->mpTris;
-	BudgetItem **pNodeRefs = pCurrentCut->mpNodeRefs;
-	TriProxyBackRef **pTriRefs = pCurrentCut->mpTriRefs;
+	RefTable<BudgetItem> &rNodeRefs = pCurrentCut->mNodeRefs;
+	RefTable<TriProxyBackRef> &rTriRefs = pCurrentCut->mTriRefs;
 	Renderer *pRenderer = pCurrentCut->mpRenderer;
 	NodeIndex iNode = pItem->miNode;
 	iParent = pNodes[iNode].miParent;
@@ -821,17 +1012,17 @@ void Simplifier::Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &By
 	// check that all of node's children are on boundary
 	for (iChild = pNodes[pItem->miNode].miFirstChild; iChild != Forest::iNIL_NODE; iChild = pNodes[iChild].miRightSibling)
 	{
-		if (pNodeRefs[iChild] == NULL)
+		if (rNodeRefs.Get(iChild) == NULL)
 		{
 //			cout << "Folding node " << pItem->miNode << " failed because child " << iChild << " has null NodeRef." << endl;
 			return;
 		}
 #ifndef REVERSE_PRUNING
-		else if (pNodeRefs[pNodes[iChild].miFirstChild] != NULL)
+		else if (rNodeRefs.Get(pNodes[iChild].miFirstChild) != NULL)
 		{
 			cout << "Folding node " << pItem->miNode << " failed because child " << iChild << " has first child with non-null NodeRef..." << endl;
 			cout << "Forcing fold of node " << iChild << " first." << endl;
-			Fold(pNodeRefs[iChild], NumTris, BytesUsed);
+			Fold(rNodeRefs.Get(iChild), NumTris, BytesUsed);
 			Fold(pItem, NumTris, BytesUsed);
 			return;
 		}
@@ -841,47 +1032,47 @@ void Simplifier::Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &By
 //cout << " folding node " << iNode << endl;
 
 	if (iParent != Forest::iNIL_NODE)
-		pRenderer->SetVertexRenderDatumAboveParentsOfBoundary(pNodeRefs[iParent]->pVertexRenderDatum, false);
+		pRenderer->SetVertexRenderDatumAboveParentsOfBoundary(rNodeRefs.Get(iParent)->pVertexRenderDatum, false);
 
 	// for each child of iNode:
 	for (iChild = pNodes[iNode].miFirstChild; iChild != Forest::iNIL_NODE; iChild = pNodes[iChild].miRightSibling)
 	{
 		// for each livetri of the child
-		for (iLiveTri = pNodeRefs[iChild]->miFirstLiveTri; iLiveTri != Forest::iNIL_TRI; iLiveTri = iNextLiveTri)
+		for (iLiveTri = rNodeRefs.Get(iChild)->miFirstLiveTri; iLiveTri != Forest::iNIL_TRI; iLiveTri = iNextLiveTri)
 		{
-			k = pTris[iLiveTri].GetNodeIndex(iLiveTri, iChild, mpCurrentForest, pCurrentCut->mpRenderer);
-			iNextLiveTri = pTriRefs[iLiveTri]->miNextLiveTris[k];
+			k = TriGetNodeIndex(iLiveTri, iChild, mpCurrentForest, pCurrentCut->mpRenderer);
+			iNextLiveTri = rTriRefs.Get(iLiveTri)->miNextLiveTris[k];
 
 			// move proxy up to parent node
-			unsigned int tri_index = pTriRefs[iLiveTri] - pRenderer->mpPatchTriData[pTris[iLiveTri].mPatchID].TriProxyBackRefs;
-			pRenderer->mpPatchTriData[pTris[iLiveTri].mPatchID].TriProxiesArray[tri_index][k] = pRenderer->GetVertexRenderDatumIndex(pNodeRefs[iNode]->pVertexRenderDatum);
-			pTriRefs[iLiveTri]->backrefs[k] = iNode;
+			unsigned int tri_index = rTriRefs.Get(iLiveTri) - pRenderer->mpPatchTriData[pTris[iLiveTri].mPatchID].TriProxyBackRefs;
+			pRenderer->mpPatchTriData[pTris[iLiveTri].mPatchID].TriProxiesArray[tri_index][k] = pRenderer->GetVertexRenderDatumIndex(rNodeRefs.Get(iNode)->pVertexRenderDatum);
+			rTriRefs.Get(iLiveTri)->backrefs[k] = iNode;
 
 			// add tri to livetri list of parent IF it isn't already a livetri of parent - if it is, then
 			// it's a degenerate triangle now anyway and will be removed as a subtri of iNode
-			if ((*pTriRefs[iLiveTri])[(k+1)%3] == iNode) 
+			if ((*rTriRefs.Get(iLiveTri))[(k+1)%3] == iNode) 
 			{
-				pTriRefs[iLiveTri]->miNextLiveTris[k] = pTriRefs[iLiveTri]->miNextLiveTris[(k+1)%3];
+				rTriRefs.Get(iLiveTri)->miNextLiveTris[k] = rTriRefs.Get(iLiveTri)->miNextLiveTris[(k+1)%3];
 				
-				if ((*pTriRefs[iLiveTri])[(k+2)%3] == iNode)
+				if ((*rTriRefs.Get(iLiveTri))[(k+2)%3] == iNode)
 				{
-					pTriRefs[iLiveTri]->miNextLiveTris[k] = pTriRefs[iLiveTri]->miNextLiveTris[(k+2)%3];
+					rTriRefs.Get(iLiveTri)->miNextLiveTris[k] = rTriRefs.Get(iLiveTri)->miNextLiveTris[(k+2)%3];
 				}
 			}
-			else if ((*pTriRefs[iLiveTri])[(k+2)%3] == iNode)
+			else if ((*rTriRefs.Get(iLiveTri))[(k+2)%3] == iNode)
 			{
-				pTriRefs[iLiveTri]->miNextLiveTris[k] = pTriRefs[iLiveTri]->miNextLiveTris[(k+2)%3];
+				rTriRefs.Get(iLiveTri)->miNextLiveTris[k] = rTriRefs.Get(iLiveTri)->miNextLiveTris[(k+2)%3];
 			}
 			else
 			{
-				pTris[iLiveTri].AddToLiveTriList(iLiveTri, k, *mpCurrentForest, pRenderer);
+				TriAddToLiveTriList(iLiveTri, k, *mpCurrentForest, pRenderer);
 			}
 		}
 		// now that we've moved all proxies up to parent node, iChild has no livetris and thus a usecount of 0
-		pCurrentCut->mpNodeRefs[iChild]->miFirstLiveTri = Forest::iNIL_TRI;
-		pRenderer->ZeroVertexUseCount(pCurrentCut->mpNodeRefs[iChild]->pVertexRenderDatum);
+		pCurrentCut->mNodeRefs.Get(iChild)->miFirstLiveTri = Forest::iNIL_TRI;
+		pRenderer->ZeroVertexUseCount(pCurrentCut->mNodeRefs.Get(iChild)->pVertexRenderDatum);
 
-		pRenderer->RemoveVertexRenderDatum(pNodeRefs[iChild]->pVertexRenderDatum);
+		pRenderer->RemoveVertexRenderDatum(rNodeRefs.Get(iChild)->pVertexRenderDatum);
 		++NumChildren;
 
 #ifdef PRUNING
@@ -890,16 +1081,16 @@ void Simplifier::Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &By
 		{
 #endif
 			// remove child from the unfoldqueue
-			mpUnfoldQueue->Remove(mpUnfoldQueue->Find(pNodeRefs[iChild]));
+			mpUnfoldQueue->Remove(mpUnfoldQueue->Find(rNodeRefs.Get(iChild)));
 
 			// set child's NodeRef to NULL, because NodeQueue->Remove() does not
-			pNodeRefs[iChild] = NULL;
+			rNodeRefs.Set(iChild, NULL);
 #ifdef PRUNING
 		}
 		else // if child is a leaf node, its budgetitem was never put into the unfoldqueue, so just delete it
 		{
-			delete pNodeRefs[iChild];
-			pNodeRefs[iChild] = NULL;
+			delete rNodeRefs.Get(iChild);
+			rNodeRefs.Set(iChild, NULL);
 		}
 #endif
 
@@ -910,15 +1101,15 @@ void Simplifier::Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &By
 
 	for (iSubTri = pNodes[iNode].miFirstSubTri; iSubTri != Forest::iNIL_TRI; iSubTri = pTris[iSubTri].miNextSubTri)
 	{
-		pTris[iSubTri].RemoveFromLiveTriList(iSubTri, pTriRefs[iSubTri]->backrefs[0], *mpCurrentForest, pRenderer);
+		TriRemoveFromLiveTriList(iSubTri, rTriRefs.Get(iSubTri)->backrefs[0], *mpCurrentForest, pRenderer);
 
-		if (pTriRefs[iSubTri]->backrefs[1] != pTriRefs[iSubTri]->backrefs[0])
+		if (rTriRefs.Get(iSubTri)->backrefs[1] != rTriRefs.Get(iSubTri)->backrefs[0])
 		{
-			pTris[iSubTri].RemoveFromLiveTriList(iSubTri, pTriRefs[iSubTri]->backrefs[1], *mpCurrentForest, pRenderer);
+			TriRemoveFromLiveTriList(iSubTri, rTriRefs.Get(iSubTri)->backrefs[1], *mpCurrentForest, pRenderer);
 		}
-		if ((pTriRefs[iSubTri]->backrefs[2] != pTriRefs[iSubTri]->backrefs[0]) && (pTriRefs[iSubTri]->backrefs[2] != pTriRefs[iSubTri]->backrefs[1]))
+		if ((rTriRefs.Get(iSubTri)->backrefs[2] != rTriRefs.Get(iSubTri)->backrefs[0]) && (rTriRefs.Get(iSubTri)->backrefs[2] != rTriRefs.Get(iSubTri)->backrefs[1]))
 		{
-			pTris[iSubTri].RemoveFromLiveTriList(iSubTri, pTriRefs[iSubTri]->backrefs[2], *mpCurrentForest, pRenderer);
+			TriRemoveFromLiveTriList(iSubTri, rTriRefs.Get(iSubTri)->backrefs[2], *mpCurrentForest, pRenderer);
 		}
 	}
 
@@ -930,9 +1121,9 @@ void Simplifier::Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &By
 	{
 		//cout << "\tRemoving Tri " << iSubTri << endl;
 		// remove subtri's Proxies entry from Renderer's Trilist's ProxiesArray
-		unsigned int tri_index = pTriRefs[iSubTri] - pRenderer->mpPatchTriData[pTris[iSubTri].mPatchID].TriProxyBackRefs;
+		unsigned int tri_index = rTriRefs.Get(iSubTri) - pRenderer->mpPatchTriData[pTris[iSubTri].mPatchID].TriProxyBackRefs;
 		pCurrentCut->mpRenderer->RemoveTriRenderDatum(tri_index, pTris[iSubTri].mPatchID);
-		pTriRefs[iSubTri] = NULL;
+		rTriRefs.Set(iSubTri, NULL);
 		++numSubTris;
 	}
 	pCurrentCut->mNumActiveTris -= numSubTris;
@@ -942,12 +1133,12 @@ void Simplifier::Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &By
 
 	// because of the removal of the children, pItem possibly points to an
 	// element of the queue other than iNode's, so update it
-	pItem = mpFoldQueue->Find(pNodeRefs[iNode]);
+	pItem = mpFoldQueue->Find(rNodeRefs.Get(iNode));
 
 	mpFoldQueue->GiveElementTo(pItem, mpUnfoldQueue);
 
 	// pItem still points to iNode's old element in FoldQueue, so update it
-	pItem = mpUnfoldQueue->Find(pNodeRefs[iNode]);
+	pItem = mpUnfoldQueue->Find(rNodeRefs.Get(iNode));
 
 
 #ifdef REVERSE_PRUNING
@@ -963,7 +1154,7 @@ void Simplifier::Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &By
 			{
 				if (pNodes[iChild].miFirstChild != Forest::iNIL_NODE)
 				{
-					if (pNodeRefs[pNodes[iChild].miFirstChild] != NULL)
+					if (rNodeRefs.Get(pNodes[iChild].miFirstChild) != NULL)
 					{
 						lastchildfolded = false;
 						break;
@@ -981,8 +1172,11 @@ void Simplifier::Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &By
 			testnode = iParent;
 			do
 			{
-				BudgetItem *OldParentItem = pNodeRefs[testnode];
-				mpFoldQueue->Insert(pNodeRefs[testnode]);
+				BudgetItem *OldParentItem = rNodeRefs.Get(testnode);
+				// the error was set aside with the item and may be out of date
+				OldParentItem->mError = EvaluateError(OldParentItem, pCurrentCut);
+				OldParentItem->mViewMotion = pCurrentCut->mViewMotion;
+				mpFoldQueue->Insert(rNodeRefs.Get(testnode));
 				delete OldParentItem;
 				testnode = pNodes[testnode].mCoincidentVertex;
 			}
@@ -1009,7 +1203,7 @@ void Simplifier::Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &By
 #endif
 
 	if (pNodes[iNode].mCoincidentVertex)
-		Fold(pNodeRefs[pNodes[iNode].mCoincidentVertex], NumTris, BytesUsed);
+		Fold(rNodeRefs.Get(pNodes[iNode].mCoincidentVertex), NumTris, BytesUsed);
 }
 
 void Simplifier::DisplayQueues()
@@ -1018,10 +1212,10 @@ void Simplifier::DisplayQueues()
 	cout << "Unfold Queue: " << flush;
 	for (i = 1; i <= mpUnfoldQueue->Size; ++i)
 	{
-		cout << mpUnfoldQueue->Elements[i].miNode << "(" << mpUnfoldQueue->Elements[i].mError << ") " << flush;
+		cout << mpUnfoldQueue->GetElement(i)->miNode << "(" << mpUnfoldQueue->GetElement(i)->mError << ") " << flush;
 		for (j = 1; j <= mpUnfoldQueue->Size; ++j)
 		{
-			if ((mpUnfoldQueue->Elements[j].miNode == mpUnfoldQueue->Elements[i].miNode) && (i != j))
+			if ((mpUnfoldQueue->GetElement(j)->miNode == mpUnfoldQueue->GetElement(i)->miNode) && (i != j))
 				cout << " (duplicate queue entry detected) " << flush;
 		}
 	}
@@ -1030,10 +1224,10 @@ void Simplifier::DisplayQueues()
 	cout << "Fold Queue: " << flush;
 	for (i = 1; i <= mpFoldQueue->Size; ++i)
 	{
-		cout << mpFoldQueue->Elements[i].miNode << "(" << mpFoldQueue->Elements[i].mError << ") " << flush;
+		cout << mpFoldQueue->GetElement(i)->miNode << "(" << mpFoldQueue->GetElement(i)->mError << ") " << flush;
 		for (j = 1; j <= mpFoldQueue->Size; ++j)
 		{
-			if ((mpFoldQueue->Elements[j].miNode == mpFoldQueue->Elements[i].miNode) && (i != j))
+			if ((mpFoldQueue->GetElement(j)->miNode == mpFoldQueue->GetElement(i)->miNode) && (i != j))
 				cout << " (duplicate queue entry detected) " << flush;
 		}
 	}
@@ -1052,21 +1246,21 @@ void Simplifier::CheckLiveTrisProxies(Forest *pForest, Renderer *pRenderer)
 	{
 		for (j = 0; j < mNumCuts; ++j)
 		{
-			if (mpCuts[j]->mpTriRefs[i] != NULL)
+			if (mpCuts[j]->mTriRefs.Get(i) != NULL)
 			{
 				for (k = 0; k < 3; ++k)
 				{
-					proxy = mpCuts[j]->mpTriRefs[i]->backrefs[k];
+					proxy = mpCuts[j]->mTriRefs.Get(i)->backrefs[k];
 					proxyfound = false;
 
 if ((i == 6) && (proxy == 37))
 	cout << "break" << endl;
 
-					livetri = pRenderer->mpCut->mpNodeRefs[proxy]->miFirstLiveTri;
+					livetri = pRenderer->mpCut->mNodeRefs.Get(proxy)->miFirstLiveTri;
 					while (livetri != 0)
 					{
-						l = pForest->mpTris[livetri].GetNodeIndex(livetri, proxy, pForest, pRenderer);
-						nextlivetri = pRenderer->mpCut->mpTriRefs[livetri]->miNextLiveTris[l];
+						l = TriGetNodeIndex(livetri, proxy, pForest, pRenderer);
+						nextlivetri = pRenderer->mpCut->mTriRefs.Get(livetri)->miNextLiveTris[l];
 
 						if (livetri == i)
 							proxyfound = true;
@@ -1080,8 +1274,8 @@ if ((i == 6) && (proxy == 37))
 						cerr << "triangle " << i << "was not found in node " << proxy << "'s livetri list." << endl;
 					}
 
-					cached_vertex_index = pRenderer->GetVertexRenderDatumIndex(mpCuts[miCurrentCut]->mpNodeRefs[proxy]->pVertexRenderDatum);
-					cached_tri_index = mpCuts[j]->mpTriRefs[i] - pRenderer->mpPatchTriData[pForest->mpTris[i].mPatchID].TriProxyBackRefs;
+					cached_vertex_index = pRenderer->GetVertexRenderDatumIndex(mpCuts[miCurrentCut]->mNodeRefs.Get(proxy)->pVertexRenderDatum);
+					cached_tri_index = mpCuts[j]->mTriRefs.Get(i) - pRenderer->mpPatchTriData[pForest->mpTris[i].mPatchID].TriProxyBackRefs;
 					if (cached_vertex_index != pRenderer->mpPatchTriData[pForest->mpTris[i].mPatchID].TriProxiesArray[cached_tri_index][k])
 					{
 						cerr << "triangle " << i << "'s proxy index " << k << " is " 
@@ -1099,24 +1293,24 @@ if ((i == 6) && (proxy == 37))
 	{
 		for (j = 0; j < mNumCuts; ++j)
 		{
-			if (mpCuts[j]->mpNodeRefs[i] != NULL)
+			if (mpCuts[j]->mNodeRefs.Get(i) != NULL)
 			{
-				livetri = mpCuts[j]->mpNodeRefs[i]->miFirstLiveTri;
+				livetri = mpCuts[j]->mNodeRefs.Get(i)->miFirstLiveTri;
 				while (livetri != 0)
 				{
-					l = pForest->mpTris[livetri].GetNodeIndex(livetri, i, pForest, pRenderer);
-					nextlivetri = pRenderer->mpCut->mpTriRefs[livetri]->miNextLiveTris[l];
+					l = TriGetNodeIndex(livetri, i, pForest, pRenderer);
+					nextlivetri = pRenderer->mpCut->mTriRefs.Get(livetri)->miNextLiveTris[l];
 
 					if (
-						(pRenderer->mpCut->mpTriRefs[livetri]->backrefs[0] != i) &&
-						(pRenderer->mpCut->mpTriRefs[livetri]->backrefs[1] != i) &&
-						(pRenderer->mpCut->mpTriRefs[livetri]->backrefs[2] != i))
+						(pRenderer->mpCut->mTriRefs.Get(livetri)->backrefs[0] != i) &&
+						(pRenderer->mpCut->mTriRefs.Get(livetri)->backrefs[1] != i) &&
+						(pRenderer->mpCut->mTriRefs.Get(livetri)->backrefs[2] != i))
 					{
 						cerr << "node " << i << "'s livetri, tri " << livetri << "does not have " << i << " as a proxy." << endl;
 						cerr << "\ttri " << livetri << "'s proxies: " 
-							<< pRenderer->mpCut->mpTriRefs[livetri]->backrefs[0] << " "
-							<< pRenderer->mpCut->mpTriRefs[livetri]->backrefs[1] << " "
-							<< pRenderer->mpCut->mpTriRefs[livetri]->backrefs[2] << endl;
+							<< pRenderer->mpCut->mTriRefs.Get(livetri)->backrefs[0] << " "
+							<< pRenderer->mpCut->mTriRefs.Get(livetri)->backrefs[1] << " "
+							<< pRenderer->mpCut->mTriRefs.Get(livetri)->backrefs[2] << endl;
 						cerr << "";
 					}
 
@@ -1134,22 +1328,22 @@ void Simplifier::CheckNodeAndChildrensLiveTrisProxies(NodeIndex iNode, Forest *p
 	unsigned int child, k;
 	TriIndex livetri, nextlivetri;
 
-	livetri = pRenderer->mpCut->mpNodeRefs[iNode]->miFirstLiveTri;
+	livetri = pRenderer->mpCut->mNodeRefs.Get(iNode)->miFirstLiveTri;
 	while (livetri != 0)
 	{
-		k = pForest->mpTris[livetri].GetNodeIndex(livetri, iNode, pForest, pRenderer);
-		nextlivetri = pRenderer->mpCut->mpTriRefs[livetri]->miNextLiveTris[k];
+		k = TriGetNodeIndex(livetri, iNode, pForest, pRenderer);
+		nextlivetri = pRenderer->mpCut->mTriRefs.Get(livetri)->miNextLiveTris[k];
 		livetri = nextlivetri;
 	}
 
 	child = pForest->mpNodes[iNode].miFirstChild;
 	while (child != Forest::iNIL_NODE)
 	{
-		livetri = pRenderer->mpCut->mpNodeRefs[child]->miFirstLiveTri;
+		livetri = pRenderer->mpCut->mNodeRefs.Get(child)->miFirstLiveTri;
 		while (livetri != 0)
 		{
-			k = pForest->mpTris[livetri].GetNodeIndex(livetri, child, pForest, pRenderer);
-			nextlivetri = pRenderer->mpCut->mpTriRefs[livetri]->miNextLiveTris[k];
+			k = TriGetNodeIndex(livetri, child, pForest, pRenderer);
+			nextlivetri = pRenderer->mpCut->mTriRefs.Get(livetri)->miNextLiveTris[k];
 			livetri = nextlivetri;
 		}
 		child = pForest->mpNodes[child].miRightSibling;
@@ -1161,11 +1355,11 @@ void Simplifier::CheckTrisForNullProxy(Forest *pForest, Renderer *pRenderer)
 	unsigned int i;
 	for (i = 1; i <= pForest->mNumTris; ++i)
 	{
-		if (pRenderer->mpCut->mpTriRefs[i] != NULL)
+		if (pRenderer->mpCut->mTriRefs.Get(i) != NULL)
 		{
-			if (pRenderer->mpCut->mpTriRefs[i]->backrefs[0] == Forest::iNIL_NODE)
+			if (pRenderer->mpCut->mTriRefs.Get(i)->backrefs[0] == Forest::iNIL_NODE)
 			{
-				cerr << "Error - tri " << i << " has proxies " << pRenderer->mpCut->mpTriRefs[i]->backrefs[0] << " " << pRenderer->mpCut->mpTriRefs[i]->backrefs[1] << " " << pRenderer->mpCut->mpTriRefs[i]->backrefs[2] << endl;
+				cerr << "Error - tri " << i << " has proxies " << pRenderer->mpCut->mTriRefs.Get(i)->backrefs[0] << " " << pRenderer->mpCut->mTriRefs.Get(i)->backrefs[1] << " " << pRenderer->mpCut->mTriRefs.Get(i)->backrefs[2] << endl;
 				cerr << endl;
 			}
 		}
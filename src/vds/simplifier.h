@@ -19,6 +19,8 @@
 #include "primtypes.h"
 #include "tri.h"
 
+class ThreadPool;
+
 namespace VDS
 {
 
@@ -30,14 +32,24 @@ public: // PUBLIC FUNCTIONS
 
 	void AddCut(Cut *pCut);
 	void RemoveCut(Cut *pCut);
+	// brings the errors of queued nodes up to date with each cut's transform;
+	// nodes whose bounding box cannot have moved more than
+	// mErrorUpdateTolerance since their error was computed keep it, and only
+	// re-evaluated nodes are moved in the heaps.  The motion is measured in
+	// transformed (homogeneous) coordinates, before the perspective divide
 	void UpdateNodeErrors();
 
+	// forces the next UpdateNodeErrors() to re-evaluate every queued node; call
+	// when the error function depends on state other than the cuts' transforms
+	void InvalidateNodeErrors();
+
 	// simplify cut(s) assigned to this simplifier
 	void SimplifyBudget(unsigned int Budget, bool UseTriBudget);
 	void SimplifyThreshold(float Threshold);
 	void SimplifyBudgetAndThreshold(unsigned int Budget, bool UseTriBudget, float Threshold);
 
-	// set budget mode error callback
+	// set budget mode error callback; with mNumThreads > 1 it is called from
+	// several threads at once and must not modify shared state
 	void SetErrorFunc(ErrorFunc fError);
 
 	// get current memory usage by this simplifier's cuts
@@ -57,13 +69,24 @@ public: // PUBLIC FUNCTIONS
 //	const Float& GetInvTanFov(BudgetItem *pItem) const;
 
 protected: // PRIVATE FUNCTIONS
-	void Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &BytesUsed);
+	// returns false, leaving the node folded, if its refs could not be allocated
+	bool Unfold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &BytesUsed);
 	void Fold(BudgetItem *pItem, unsigned int &NumTris, unsigned int &BytesUsed);
 
 	// removes all nodes from fold queue and removes all nodes except root node from unfold queue
 	// deletes BudgetItems of all pruned and reverse-pruned nodes
 	void FlushQueues();
 
+	// re-evaluates stale errors in one queue (Sign is -1 for the unfold queue);
+	// returns true if nodes whose error may have drifted were left alone
+	bool UpdateQueueErrors(NodeQueue *pQueue, Float Sign, bool All);
+	// mfErrorFunc, counted in mNumErrorEvaluations; the calling thread only
+	Float EvaluateError(BudgetItem *pItem, Cut *pCut)
+	{
+		++mNumErrorEvaluations;
+		return mfErrorFunc(pItem, pCut);
+	}
+
 public: // DEBUG FUNCTIONS
 	void DisplayQueues();
 	void CheckLiveTrisProxies(Forest *pForest, Renderer *pRenderer);
@@ -76,6 +99,9 @@ public: // PUBLIC DATA
 //	Float mSin2Threshold;
 	int mBudgetTolerance;
 	unsigned int mSimplificationBreakCount;
+	float mErrorUpdateTolerance;
+	int mNumThreads; // threads used to evaluate node errors, 1 for the calling thread only
+	unsigned int mNumErrorEvaluations; // mfErrorFunc calls, for stats
 	bool mIsValid;
 	Cut **mpCuts;	// dynamically allocated array of pointers to cuts this simplifier simplifies
 
@@ -86,6 +112,10 @@ public: // making these public for access by glod VDSCut
 	Forest *mpCurrentForest;
 	NodeQueue *mpFoldQueue;
 	NodeQueue *mpUnfoldQueue;
+	bool mNodeErrorsCurrent; // every queued error was computed at its cut's current transform
+	ThreadPool *mpThreadPool; // error evaluation threads, started by the first pass that needs them
+	int mThreadPoolSize; // mNumThreads when mpThreadPool was started
+	bool mRecomputeNodeErrors; // set by InvalidateNodeErrors()
 
 public: // profiling information
 #ifdef _WIN32
@@ -121,7 +151,6 @@ public: // profiling information
 
 //Friends
 	friend class Tree;
-	friend class Tri;
 	friend class ForestBuilder;
 	friend class Cut;
 }; // class Simplifier
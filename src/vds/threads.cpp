@@ -11,44 +11,369 @@
  * this copy of VDSlib; if not, please visit the VDSlib web page,             *
  * http://vdslib.virginia.edu/license for more information.                   *
  ******************************************************************************/
+#ifdef _WIN32
 #pragma warning(disable: 4530)
+#endif
 #include "threads.h"
 #include <iostream>
 
-#ifdef WIN32
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
 #endif
 
 int GetNumSystemProcessors()
 {
 	int n = 0;
 //	ztGetNumAvailableProcessors(&n);
-	return n;
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	n = (int) info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	n = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return (n > 0) ? n : 1;
+}
+
+struct ParallelForChunk
+{
+	ParallelForFunc fBody;
+	void *pContext;
+	int First;
+	int Last;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI ParallelForThread(LPVOID pParam)
+#else
+static void *ParallelForThread(void *pParam)
+#endif
+{
+	ParallelForChunk *pChunk = (ParallelForChunk *) pParam;
+	pChunk->fBody(pChunk->pContext, pChunk->First, pChunk->Last);
+	return 0;
+}
+
+void ParallelFor(int First, int Last, int NumThreads, int MinPerThread,
+				 ParallelForFunc fBody, void *pContext)
+{
+	int Count = Last - First + 1;
+	int i;
+
+	if (Count <= 0)
+		return;
+	if (MinPerThread < 1)
+		MinPerThread = 1;
+	if (NumThreads > Count / MinPerThread)
+		NumThreads = Count / MinPerThread;
+	if (NumThreads <= 1)
+	{
+		fBody(pContext, First, Last);
+		return;
+	}
+
+	ParallelForChunk *pChunks = new ParallelForChunk[NumThreads];
+#ifdef _WIN32
+	HANDLE *pThreads = new HANDLE[NumThreads];
+#else
+	pthread_t *pThreads = new pthread_t[NumThreads];
+#endif
+	bool *pStarted = new bool[NumThreads];
+
+	for (i = 0; i < NumThreads; ++i)
+	{
+		pChunks[i].fBody = fBody;
+		pChunks[i].pContext = pContext;
+		pChunks[i].First = First + (int) (((long long) Count * i) / NumThreads);
+		pChunks[i].Last = First + (int) (((long long) Count * (i + 1)) / NumThreads) - 1;
+	}
+
+	// chunk 0 runs on this thread; a chunk whose thread cannot be started
+	// is run here as well once the others are under way
+	pStarted[0] = false;
+	for (i = 1; i < NumThreads; ++i)
+	{
+#ifdef _WIN32
+		pThreads[i] = CreateThread(NULL, 0, ParallelForThread, &pChunks[i], 0, NULL);
+		pStarted[i] = (pThreads[i] != NULL);
+#else
+		pStarted[i] = (pthread_create(&pThreads[i], NULL, ParallelForThread, &pChunks[i]) == 0);
+#endif
+	}
+
+	for (i = 0; i < NumThreads; ++i)
+		if (!pStarted[i])
+			fBody(pContext, pChunks[i].First, pChunks[i].Last);
+
+	for (i = 1; i < NumThreads; ++i)
+	{
+		if (!pStarted[i])
+			continue;
+#ifdef _WIN32
+		WaitForSingleObject(pThreads[i], INFINITE);
+		CloseHandle(pThreads[i]);
+#else
+		pthread_join(pThreads[i], NULL);
+#endif
+	}
+
+	delete[] pStarted;
+	delete[] pThreads;
+	delete[] pChunks;
+}
+
+struct ParallelForEachQueue
+{
+	ParallelForFunc fBody;
+	void *pContext;
+	int Last;
+#ifdef _WIN32
+	volatile LONG Next;
+#else
+	volatile int Next;
+#endif
+};
+
+// ParallelFor body: each thread takes the next index until none are left
+static void ParallelForEachWorker(void *pContext, int, int)
+{
+	ParallelForEachQueue *pQueue = (ParallelForEachQueue *) pContext;
+	int i;
+
+	for (;;)
+	{
+#ifdef _WIN32
+		i = (int) InterlockedIncrement(&pQueue->Next) - 1;
+#else
+		i = __sync_fetch_and_add(&pQueue->Next, 1);
+#endif
+		if (i > pQueue->Last)
+			break;
+		pQueue->fBody(pQueue->pContext, i, i);
+	}
+}
+
+void ParallelForEach(int First, int Last, int NumThreads,
+					 ParallelForFunc fBody, void *pContext)
+{
+	ParallelForEachQueue Queue;
+
+	if (Last < First)
+		return;
+	if (NumThreads > Last - First + 1)
+		NumThreads = Last - First + 1;
+
+	Queue.fBody = fBody;
+	Queue.pContext = pContext;
+	Queue.Last = Last;
+	Queue.Next = First;
+	ParallelFor(0, NumThreads - 1, NumThreads, 1, ParallelForEachWorker, &Queue);
+}
+
+struct ThreadPoolWorker
+{
+	ThreadPoolState *pState;
+	int Index;	// the chunk this worker runs; chunk 0 is the caller's
+};
+
+struct ThreadPoolState
+{
+#ifdef _WIN32
+	CRITICAL_SECTION Lock;
+	CONDITION_VARIABLE WorkReady;
+	CONDITION_VARIABLE WorkDone;
+	HANDLE *pThreads;
+#else
+	pthread_mutex_t Lock;
+	pthread_cond_t WorkReady;
+	pthread_cond_t WorkDone;
+	pthread_t *pThreads;
+#endif
+	ThreadPoolWorker *pWorkers;
+	int NumWorkers;
+	ParallelForChunk *pChunks;	// one per thread
+	int NumChunks;				// chunks handed out by the current call
+	unsigned int Generation;	// counts calls, so workers can tell a new one
+	int NumBusy;				// workers not done with the current call
+	bool Quit;
+};
+
+#ifdef _WIN32
+#define POOL_LOCK(s)	EnterCriticalSection(&(s)->Lock)
+#define POOL_UNLOCK(s)	LeaveCriticalSection(&(s)->Lock)
+#define POOL_WAIT(s,c)	SleepConditionVariableCS(&(s)->c, &(s)->Lock, INFINITE)
+#define POOL_WAKE(s,c)	WakeAllConditionVariable(&(s)->c)
+#else
+#define POOL_LOCK(s)	pthread_mutex_lock(&(s)->Lock)
+#define POOL_UNLOCK(s)	pthread_mutex_unlock(&(s)->Lock)
+#define POOL_WAIT(s,c)	pthread_cond_wait(&(s)->c, &(s)->Lock)
+#define POOL_WAKE(s,c)	pthread_cond_broadcast(&(s)->c)
+#endif
+
+#ifdef _WIN32
+static DWORD WINAPI ThreadPoolThread(LPVOID pParam)
+#else
+static void *ThreadPoolThread(void *pParam)
+#endif
+{
+	ThreadPoolWorker *pWorker = (ThreadPoolWorker *) pParam;
+	ThreadPoolState *pState = pWorker->pState;
+	unsigned int Seen = 0;
+	ParallelForChunk Chunk;
+	bool HasChunk;
+
+	POOL_LOCK(pState);
+	for (;;)
+	{
+		while (pState->Generation == Seen && !pState->Quit)
+			POOL_WAIT(pState, WorkReady);
+		if (pState->Quit)
+			break;
+		Seen = pState->Generation;
+		HasChunk = (pWorker->Index < pState->NumChunks);
+		if (HasChunk)
+			Chunk = pState->pChunks[pWorker->Index];
+		POOL_UNLOCK(pState);
+
+		if (HasChunk)
+			Chunk.fBody(Chunk.pContext, Chunk.First, Chunk.Last);
+
+		POOL_LOCK(pState);
+		if (--pState->NumBusy == 0)
+			POOL_WAKE(pState, WorkDone);
+	}
+	POOL_UNLOCK(pState);
+	return 0;
 }
 
-void StartRenderThread(void (*fSimplifyFunc) (void))
+ThreadPool::ThreadPool(int NumThreads)
 {
-/*	ThreadParams* gParams = new ThreadParams; // KLUDGE: leaked memory
-	gParams->t = t;
-	gParams->tv = tv;
-	ZThreads::ztCreateThread((ZThreads::ztThreadFunc) fSimplifyFunc);
-*/
+	int i;
+
+	mNumThreads = 1;
+	mpState = NULL;
+	if (NumThreads <= 1)
+		return;
+
+	ThreadPoolState *pState = new ThreadPoolState;
+#ifdef _WIN32
+	InitializeCriticalSection(&pState->Lock);
+	InitializeConditionVariable(&pState->WorkReady);
+	InitializeConditionVariable(&pState->WorkDone);
+	pState->pThreads = new HANDLE[NumThreads - 1];
+#else
+	pthread_mutex_init(&pState->Lock, NULL);
+	pthread_cond_init(&pState->WorkReady, NULL);
+	pthread_cond_init(&pState->WorkDone, NULL);
+	pState->pThreads = new pthread_t[NumThreads - 1];
+#endif
+	pState->pWorkers = new ThreadPoolWorker[NumThreads - 1];
+	pState->pChunks = new ParallelForChunk[NumThreads];
+	pState->NumWorkers = 0;
+	pState->NumChunks = 0;
+	pState->Generation = 0;
+	pState->NumBusy = 0;
+	pState->Quit = false;
+
+	// stop at the first thread that can't be started; the pool just ends
+	// up smaller
+	for (i = 0; i < NumThreads - 1; ++i)
+	{
+		pState->pWorkers[i].pState = pState;
+		pState->pWorkers[i].Index = i + 1;
+#ifdef _WIN32
+		pState->pThreads[i] = CreateThread(NULL, 0, ThreadPoolThread, &pState->pWorkers[i], 0, NULL);
+		if (pState->pThreads[i] == NULL)
+			break;
+#else
+		if (pthread_create(&pState->pThreads[i], NULL, ThreadPoolThread, &pState->pWorkers[i]) != 0)
+			break;
+#endif
+		pState->NumWorkers++;
+	}
+
+	mpState = pState;
+	mNumThreads = pState->NumWorkers + 1;
 }
 
-void RenderThreadFunc(void (*fSimplifyFunc) (void))
+ThreadPool::~ThreadPool()
 {
-	printf("Simplifyloop running.\n");
-		if (fSimplifyFunc != NULL)
-		{
-			while(1)
-			{
-				fSimplifyFunc();
-			}
-		}
-		else
-#ifdef WIN32
-			Sleep(0);
+	ThreadPoolState *pState = mpState;
+	int i;
+
+	if (pState == NULL)
+		return;
+
+	POOL_LOCK(pState);
+	pState->Quit = true;
+	POOL_WAKE(pState, WorkReady);
+	POOL_UNLOCK(pState);
+
+	for (i = 0; i < pState->NumWorkers; ++i)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(pState->pThreads[i], INFINITE);
+		CloseHandle(pState->pThreads[i]);
+#else
+		pthread_join(pState->pThreads[i], NULL);
+#endif
+	}
+
+#ifdef _WIN32
+	DeleteCriticalSection(&pState->Lock);
 #else
-			0;// what do we need to include to get linux Sleep()?
+	pthread_cond_destroy(&pState->WorkDone);
+	pthread_cond_destroy(&pState->WorkReady);
+	pthread_mutex_destroy(&pState->Lock);
 #endif
+	delete[] pState->pChunks;
+	delete[] pState->pWorkers;
+	delete[] pState->pThreads;
+	delete pState;
+}
+
+void ThreadPool::ParallelFor(int First, int Last, int MinPerThread,
+							 ParallelForFunc fBody, void *pContext)
+{
+	ThreadPoolState *pState = mpState;
+	int Count = Last - First + 1;
+	int NumChunks = mNumThreads;
+	int i;
+
+	if (Count <= 0)
+		return;
+	if (MinPerThread < 1)
+		MinPerThread = 1;
+	if (NumChunks > Count / MinPerThread)
+		NumChunks = Count / MinPerThread;
+	if (NumChunks <= 1)
+	{
+		fBody(pContext, First, Last);
+		return;
+	}
+
+	for (i = 0; i < NumChunks; ++i)
+	{
+		pState->pChunks[i].fBody = fBody;
+		pState->pChunks[i].pContext = pContext;
+		pState->pChunks[i].First = First + (int) (((long long) Count * i) / NumChunks);
+		pState->pChunks[i].Last = First + (int) (((long long) Count * (i + 1)) / NumChunks) - 1;
+	}
+
+	POOL_LOCK(pState);
+	pState->NumChunks = NumChunks;
+	pState->NumBusy = pState->NumWorkers;
+	pState->Generation++;
+	POOL_WAKE(pState, WorkReady);
+	POOL_UNLOCK(pState);
+
+	fBody(pContext, pState->pChunks[0].First, pState->pChunks[0].Last);
+
+	POOL_LOCK(pState);
+	while (pState->NumBusy > 0)
+		POOL_WAIT(pState, WorkDone);
+	POOL_UNLOCK(pState);
 }
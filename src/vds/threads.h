@@ -19,7 +19,42 @@
 
 //using namespace ZThreads;
 
-void StartRenderThread(void (*fSimplifyFunc) (void));
-void RenderThreadFunc(void (*fSimplifyFunc) (void));
+int GetNumSystemProcessors();
+
+// Calls fBody(pContext, first, last) over disjoint, contiguous sub-ranges
+// covering [First, Last] on up to NumThreads threads (the calling thread
+// takes one of them) and returns once all have finished.  Ranges smaller
+// than MinPerThread per thread use fewer threads.
+typedef void (*ParallelForFunc) (void *pContext, int First, int Last);
+void ParallelFor(int First, int Last, int NumThreads, int MinPerThread,
+				 ParallelForFunc fBody, void *pContext);
+
+// Like ParallelFor, but hands out [First, Last] one index at a time
+// (fBody(pContext, i, i)) in increasing order as threads become free, for
+// work items whose costs differ too much to split into even ranges.
+void ParallelForEach(int First, int Last, int NumThreads,
+					 ParallelForFunc fBody, void *pContext);
+
+// A fixed set of worker threads that wait between calls, for loops that run
+// every frame and can't pay for starting threads each time.  NumThreads
+// counts the calling thread, which always takes a share of the work.
+struct ThreadPoolState;
+class ThreadPool
+{
+public:
+	ThreadPool(int NumThreads);
+	~ThreadPool();
+
+	// threads actually running, the calling thread included
+	int GetNumThreads() const { return mNumThreads; }
+
+	// ParallelFor on this pool's threads; one call at a time per pool
+	void ParallelFor(int First, int Last, int MinPerThread,
+					 ParallelForFunc fBody, void *pContext);
+
+private:
+	int mNumThreads;
+	ThreadPoolState *mpState;
+};
 
 #endif
@@ -27,88 +27,83 @@
 using namespace std;
 using namespace VDS;
 
-Tri::Tri()
-{
-    miNextSubTri = Forest::iNIL_TRI;
-}
-
-Tri::~Tri()
-{
-}
-
 // TODO: make these functions less unintelligible
 
-void Tri::InitializeProxiesAndLiveTris(TriIndex iTri, const Forest &rForest, Renderer *pRenderer, PatchIndex PatchID)
+void VDS::TriInitializeProxiesAndLiveTris(TriIndex iTri, const Forest &rForest, Renderer *pRenderer, PatchIndex PatchID)
 {
-// TODO: pass (locations of) proxy back refs in directly instead of recalculating through forest.mpTriRefs
-	TriProxyBackRef **pTriRefs = pRenderer->mpCut->mpTriRefs;
-	BudgetItem **pNodeRefs = pRenderer->mpCut->mpNodeRefs;
+// TODO: pass (locations of) proxy back refs in directly instead of recalculating through forest.mTriRefs
+	RefTable<TriProxyBackRef> &rTriRefs = pRenderer->mpCut->mTriRefs;
+	RefTable<BudgetItem> &rNodeRefs = pRenderer->mpCut->mNodeRefs;
+
+	const NodeIndex *corners = rForest.mpTris[iTri].miCorners;
 
     for (int i = 0; i < 3; i++)
     {
-		NodeIndex *proxy = &(*pTriRefs[iTri])[i];
+		NodeIndex *proxy = &(*rTriRefs.Get(iTri))[i];
         *proxy = rForest.iROOT_NODE;
-        while ((*proxy != miCorners[i]) && 
-			(pNodeRefs[rForest.mpNodes[*proxy].miFirstChild] != NULL))
+        while ((*proxy != corners[i]) && 
+			(rNodeRefs.Get(rForest.mpNodes[*proxy].miFirstChild) != NULL))
         {
-            MoveProxyDown(iTri, i, rForest, pRenderer);
+            TriMoveProxyDown(iTri, i, rForest, pRenderer);
         }
-		unsigned int tri_index = pTriRefs[iTri] - pRenderer->mpPatchTriData[PatchID].TriProxyBackRefs;
-		pRenderer->mpPatchTriData[PatchID].TriProxiesArray[tri_index][i] = pRenderer->GetVertexRenderDatumIndex(pNodeRefs[*proxy]->pVertexRenderDatum);
-        AddToLiveTriList(iTri, i, rForest, pRenderer);
+		unsigned int tri_index = rTriRefs.Get(iTri) - pRenderer->mpPatchTriData[PatchID].TriProxyBackRefs;
+		pRenderer->mpPatchTriData[PatchID].TriProxiesArray[tri_index][i] = pRenderer->GetVertexRenderDatumIndex(rNodeRefs.Get(*proxy)->pVertexRenderDatum);
+        TriAddToLiveTriList(iTri, i, rForest, pRenderer);
     }
 }
 
 // TODO: just pass in the pointer to the proxy
-void Tri::MoveProxyDown(TriIndex iTri, int iProxy, const Forest &rForest, Renderer *pRenderer)
+void VDS::TriMoveProxyDown(TriIndex iTri, int iProxy, const Forest &rForest, Renderer *pRenderer)
 {
-	TriProxyBackRef **pTriRefs = pRenderer->mpCut->mpTriRefs;
+	RefTable<TriProxyBackRef> &rTriRefs = pRenderer->mpCut->mTriRefs;
 	const Node *nodes = rForest.mpNodes;
-	NodeIndex *pProxy = &((*pTriRefs[iTri])[iProxy]);
+	NodeIndex *pProxy = &((*rTriRefs.Get(iTri))[iProxy]);
 	*pProxy = nodes[*pProxy].miFirstChild;
 
 	// need additional termination test that sees if current proxy is an ancestor of or is the proxy needed
-	// terminate if corner is greater than proxy->rightsibling
+	// terminate if corner is greater than proxy->rightsibling (in depth-first
+	// order, which need not be index order - see Forest::ReorderNodesForCache())
+	NodeIndex CornerRank = rForest.GetPreorderRank(rForest.mpTris[iTri].miCorners[iProxy]);
 
     while ((nodes[*pProxy].miRightSibling != Forest::iNIL_NODE)
-        && (miCorners[iProxy] >= nodes[*pProxy].miRightSibling))
+        && (CornerRank >= rForest.GetPreorderRank(nodes[*pProxy].miRightSibling)))
     {
         *pProxy = rForest.mpNodes[*pProxy].miRightSibling;
     }
-    assert((*pTriRefs[iTri])[iProxy] <= miCorners[iProxy]);
+    assert(rForest.GetPreorderRank((*rTriRefs.Get(iTri))[iProxy]) <= CornerRank);
 }
 
-int Tri::GetNodeIndex(TriIndex iTri, NodeIndex iNode, const Forest *pForest, Renderer *pRenderer) const
+int VDS::TriGetNodeIndex(TriIndex iTri, NodeIndex iNode, const Forest *pForest, Renderer *pRenderer)
 {
-	TriProxyBackRef **pTriRefs = pRenderer->mpCut->mpTriRefs;
+	RefTable<TriProxyBackRef> &rTriRefs = pRenderer->mpCut->mTriRefs;
 
 #ifdef _DEBUG
-	if (pTriRefs[iTri] == NULL)
+	if (rTriRefs.Get(iTri) == NULL)
 	{
 		cerr << "Error - Trying to get node proxy index of inactive triangle " << iTri << endl;
 	}
 #endif
 	
-	if (pTriRefs[iTri]->backrefs[0] == iNode)
+	if (rTriRefs.Get(iTri)->backrefs[0] == iNode)
 	{
 		return 0;
 	}
-	else if (pTriRefs[iTri]->backrefs[1] == iNode)
+	else if (rTriRefs.Get(iTri)->backrefs[1] == iNode)
 	{
 		return 1;
 	}
-	else if (pTriRefs[iTri]->backrefs[2] == iNode)
+	else if (rTriRefs.Get(iTri)->backrefs[2] == iNode)
 	{
 		return 2;
 	}
-	cerr << endl << "GetNodeIndex couldn't find proxy matching Node " << iNode << endl << "Triangle proxies: " 
-		<< (*pTriRefs[iTri])[0] << " " 
-		<< (*pTriRefs[iTri])[1] << " "
-		<< (*pTriRefs[iTri])[2] << endl;
+	cerr << endl << "TriGetNodeIndex couldn't find proxy matching Node " << iNode << endl << "Triangle proxies: " 
+		<< (*rTriRefs.Get(iTri))[0] << " " 
+		<< (*rTriRefs.Get(iTri))[1] << " "
+		<< (*rTriRefs.Get(iTri))[2] << endl;
 	return -666666;
 }
 
-int Tri::GetNodeIndexC(TriIndex iTri, NodeIndex iNode, const Forest &rForest) const
+int VDS::TriGetNodeIndexC(TriIndex iTri, NodeIndex iNode, const Forest &rForest)
 {
     if (rForest.mpTris[iTri].miCorners[0] == iNode)
     {
@@ -122,71 +117,65 @@ int Tri::GetNodeIndexC(TriIndex iTri, NodeIndex iNode, const Forest &rForest) co
     {
         return 2;
     }
-	cerr << "GetNodeIndex couldn't find proxy matching iNode " << iNode << endl;
+	cerr << "TriGetNodeIndex couldn't find proxy matching iNode " << iNode << endl;
 	return -666666;
 }
 
-void Tri::AddToLiveTriList(TriIndex iTri, int iProxy, const Forest &rForest, Renderer *pRenderer)
+void VDS::TriAddToLiveTriList(TriIndex iTri, int iProxy, const Forest &rForest, Renderer *pRenderer)
 {
-    pRenderer->mpCut->mpTriRefs[iTri]->miNextLiveTris[iProxy] = pRenderer->mpCut->mpNodeRefs[(*pRenderer->mpCut->mpTriRefs[iTri])[iProxy]]->miFirstLiveTri;
-    pRenderer->mpCut->mpNodeRefs[(*pRenderer->mpCut->mpTriRefs[iTri])[iProxy]]->miFirstLiveTri = iTri;
+    pRenderer->mpCut->mTriRefs.Get(iTri)->miNextLiveTris[iProxy] = pRenderer->mpCut->mNodeRefs.Get((*pRenderer->mpCut->mTriRefs.Get(iTri))[iProxy])->miFirstLiveTri;
+    pRenderer->mpCut->mNodeRefs.Get((*pRenderer->mpCut->mTriRefs.Get(iTri))[iProxy])->miFirstLiveTri = iTri;
 
-	pRenderer->IncrementVertexUseCount(pRenderer->mpCut->mpNodeRefs[(*pRenderer->mpCut->mpTriRefs[iTri])[iProxy]]->pVertexRenderDatum);
+	pRenderer->IncrementVertexUseCount(pRenderer->mpCut->mNodeRefs.Get((*pRenderer->mpCut->mTriRefs.Get(iTri))[iProxy])->pVertexRenderDatum);
 }
 
-void Tri::AddToLiveTriListUsingCorners(TriIndex iTri, int iProxy, const Forest &rForest, TriIndex *FirstLiveTris, TriIndex **NextLiveTris)
+void VDS::TriAddToLiveTriListUsingCorners(TriIndex iTri, int iProxy, const Forest &rForest, TriIndex *FirstLiveTris, TriIndex **NextLiveTris)
 {
 	NextLiveTris[iTri][iProxy] = FirstLiveTris[rForest.mpTris[iTri].miCorners[iProxy]];
 	FirstLiveTris[rForest.mpTris[iTri].miCorners[iProxy]] = iTri;
 }
 
 
-void Tri::RemoveFromLiveTriList(TriIndex iTri, NodeIndex iNode, const Forest &rForest, Renderer *pRenderer)
+void VDS::TriRemoveFromLiveTriList(TriIndex iTri, NodeIndex iNode, const Forest &rForest, Renderer *pRenderer)
 {
     TriIndex live_tri;
     TriIndex prev_live_tri;
     TriIndex first_live_tri;
     int k;
     int prev_k;
-    Tri *const tris = rForest.mpTris;
 
-	if (pRenderer->mpCut->mpNodeRefs[iNode] == NULL)
+	if (pRenderer->mpCut->mNodeRefs.Get(iNode) == NULL)
 	{
 		cerr << "Tri being removed's proxy has null NodeRef" << endl;
 		return;
 	}
-    first_live_tri = pRenderer->mpCut->mpNodeRefs[iNode]->miFirstLiveTri;
+    first_live_tri = pRenderer->mpCut->mNodeRefs.Get(iNode)->miFirstLiveTri;
 	assert(first_live_tri != Forest::iNIL_TRI);
     if (first_live_tri == iTri)
     {
-        k = tris[first_live_tri].GetNodeIndex(first_live_tri, iNode, &rForest, pRenderer);
-		pRenderer->mpCut->mpNodeRefs[iNode]->miFirstLiveTri = pRenderer->mpCut->mpTriRefs[first_live_tri]->miNextLiveTris[k];
+        k = TriGetNodeIndex(first_live_tri, iNode, &rForest, pRenderer);
+		pRenderer->mpCut->mNodeRefs.Get(iNode)->miFirstLiveTri = pRenderer->mpCut->mTriRefs.Get(first_live_tri)->miNextLiveTris[k];
     }
     else
     {
         prev_live_tri = first_live_tri;
-        prev_k = tris[prev_live_tri].GetNodeIndex(prev_live_tri, iNode, &rForest, pRenderer);
-        live_tri = pRenderer->mpCut->mpTriRefs[prev_live_tri]->miNextLiveTris[prev_k];
-        k = tris[live_tri].GetNodeIndex(live_tri, iNode, &rForest, pRenderer);
+        prev_k = TriGetNodeIndex(prev_live_tri, iNode, &rForest, pRenderer);
+        live_tri = pRenderer->mpCut->mTriRefs.Get(prev_live_tri)->miNextLiveTris[prev_k];
+        k = TriGetNodeIndex(live_tri, iNode, &rForest, pRenderer);
         while (live_tri != iTri)
         {
             prev_live_tri = live_tri;
             prev_k = k;
-			live_tri = pRenderer->mpCut->mpTriRefs[live_tri]->miNextLiveTris[k];
-            k = tris[live_tri].GetNodeIndex(live_tri, iNode, &rForest, pRenderer);
+			live_tri = pRenderer->mpCut->mTriRefs.Get(live_tri)->miNextLiveTris[k];
+            k = TriGetNodeIndex(live_tri, iNode, &rForest, pRenderer);
             assert(live_tri != Forest::iNIL_NODE);
         }
-		pRenderer->mpCut->mpTriRefs[prev_live_tri]->miNextLiveTris[prev_k] = pRenderer->mpCut->mpTriRefs[live_tri]->miNextLiveTris[k];
+		pRenderer->mpCut->mTriRefs.Get(prev_live_tri)->miNextLiveTris[prev_k] = pRenderer->mpCut->mTriRefs.Get(live_tri)->miNextLiveTris[k];
     }
-	pRenderer->DecrementVertexUseCount(pRenderer->mpCut->mpNodeRefs[iNode]->pVertexRenderDatum);
+	pRenderer->DecrementVertexUseCount(pRenderer->mpCut->mNodeRefs.Get(iNode)->pVertexRenderDatum);
 }
 
-void Tri::CheckLiveTriLists(TriIndex i, const Forest &rForest)
-{
-
-}
-
-void Tri::AddToSubTriList(TriIndex iTri, NodeIndex iNode, const Forest &rForest)
+void VDS::TriAddToSubTriList(TriIndex iTri, NodeIndex iNode, const Forest &rForest)
 {
     Node *const nodes = rForest.mpNodes;
     Tri *const tris = rForest.mpTris;
@@ -194,14 +183,3 @@ void Tri::AddToSubTriList(TriIndex iTri, NodeIndex iNode, const Forest &rForest)
     tris[iTri].miNextSubTri = nodes[iNode].miFirstSubTri;
     nodes[iNode].miFirstSubTri = iTri;
 }
-
-TriIndex Tri::GetNextSubTri() const
-{
-    return miNextSubTri;
-}
-
-NodeIndex Tri::GetCorner(int iCorner) const
-{
-    return miCorners[iCorner];
-}
-
@@ -15,67 +15,51 @@
 #define TRI_H
 #include "vds.h"
 
+// A Tri is a plain record like Node; new Tri[n]() leaves miNextSubTri NIL.
+// What used to be Tri member functions are the free functions below, which
+// take the index of the Tri and the Forest it lives in.
 class VDS::Tri
 {
-// PUBLIC FUNCTIONS
 public:
-	Tri();
-	Tri(const Tri &); //not implemented
-	virtual ~Tri();
-
-// PRIVATE FUNCTIONS
-private:
-	//Moves proxies to lowest nodes above boundary.  Adds Tri to live tri
-	//lists of these new proxies.
-	void InitializeProxiesAndLiveTris(TriIndex iTri, const Forest &rForest, Renderer *pRenderer, PatchIndex PatchID);
-	
-	//Moves a proxy down one level of the Forest.  Does not alter live tri list
-	//Does not check for going below boundary
-	void MoveProxyDown(TriIndex iTri, int iProxy, const Forest &rForest, Renderer *pRenderer);  
-	
-	//Returns an index i either 0, 1, 2. miProxies[i] == iNODE representing
-	//mCorners[i], and miNextLiveTris[i] is this nodes live tri link.  Assumes
-	//that this node is in fact one of the proxies.
-	int GetNodeIndex(TriIndex iTri, NodeIndex iNode, const Forest *pForest, Renderer *pRenderer) const;
-	
-	// same as GetNodeIndex but assumes that all proxies are corners
-	// (i.e. doesn't even use proxies, uses corners) - for preprocessing
-	int GetNodeIndexC(TriIndex iTri, NodeIndex iNode, const Forest &rForest) const;
-	
-	//Adds this node to the live tri list of miProxies[iProxy] in rForest
-	void AddToLiveTriList(TriIndex iTri, int iProxy, const Forest &rForest, Renderer *pRenderer);
-	
-	//Adds this node to the live tri list of miProxies[iProxy] in rForest
-	void AddToLiveTriListUsingCorners(TriIndex iTri, int iProxy, const Forest &rForest, TriIndex *FirstLiveTris, TriIndex **NextLiveTris);
-	
-	//Removes the node from the live tri list of node iNode
-	//undefined behaviour if the Tri is not actually part of the live tri
-	//list of the node
-	void RemoveFromLiveTriList(TriIndex iTri, NodeIndex iNode, const Forest &rForest, Renderer *pRenderer);
-	
-	//Inserts this Tri into the sub tri list of node iNode
-	void AddToSubTriList(TriIndex iTri, NodeIndex iNode, const Forest &rForest);
-	
-	TriIndex GetNextSubTri() const;
-	NodeIndex GetCorner(int iCorner) const;
-
-	Tri &operator =(const Tri &); //not implemented
-
-// DEBUG FUNCTIONS
-	void CheckLiveTriLists(TriIndex i, const Forest &rForest);
-
-// DATA
-public: // making these public for convenience
 	TriIndex miNextSubTri;
 	NodeIndex miCorners[3];
 	PatchIndex mPatchID;
-	
-//Friends
-	friend class Forest;
-	friend class Node;
-	friend class ForestBuilder;
-	friend class Simplifier;
-	friend class Renderer;
 };
 
+namespace VDS
+{
+
+//Moves proxies to lowest nodes above boundary.  Adds Tri to live tri
+//lists of these new proxies.
+void TriInitializeProxiesAndLiveTris(TriIndex iTri, const Forest &rForest, Renderer *pRenderer, PatchIndex PatchID);
+
+//Moves a proxy down one level of the Forest.  Does not alter live tri list
+//Does not check for going below boundary
+void TriMoveProxyDown(TriIndex iTri, int iProxy, const Forest &rForest, Renderer *pRenderer);
+
+//Returns an index i either 0, 1, 2. miProxies[i] == iNODE representing
+//mCorners[i], and miNextLiveTris[i] is this nodes live tri link.  Assumes
+//that this node is in fact one of the proxies.
+int TriGetNodeIndex(TriIndex iTri, NodeIndex iNode, const Forest *pForest, Renderer *pRenderer);
+
+// same as TriGetNodeIndex but assumes that all proxies are corners
+// (i.e. doesn't even use proxies, uses corners) - for preprocessing
+int TriGetNodeIndexC(TriIndex iTri, NodeIndex iNode, const Forest &rForest);
+
+//Adds the Tri to the live tri list of its proxy iProxy
+void TriAddToLiveTriList(TriIndex iTri, int iProxy, const Forest &rForest, Renderer *pRenderer);
+
+//Adds the Tri to the live tri list of its corner iProxy
+void TriAddToLiveTriListUsingCorners(TriIndex iTri, int iProxy, const Forest &rForest, TriIndex *FirstLiveTris, TriIndex **NextLiveTris);
+
+//Removes the Tri from the live tri list of node iNode
+//undefined behaviour if the Tri is not actually part of the live tri
+//list of the node
+void TriRemoveFromLiveTriList(TriIndex iTri, NodeIndex iNode, const Forest &rForest, Renderer *pRenderer);
+
+//Inserts the Tri into the sub tri list of node iNode
+void TriAddToSubTriList(TriIndex iTri, NodeIndex iNode, const Forest &rForest);
+
+} // namespace VDS
+
 #endif
@@ -141,6 +141,7 @@ namespace VDS
 
 	class NodeQueue;
 	class FreeList;
+	template <class T> class RefTable;
 	struct PQElement;
 	class Forest;
 	class Node;
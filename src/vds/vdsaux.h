@@ -26,10 +26,9 @@ struct ReorderQueueLink
 	ReorderQueueLink *mpNext;
 };
 
+// payload of a NodeQueue entry; the queue keeps its heap position separately
 struct BudgetItem
 {
-	int PQindex;
-
 	Point3 mPosition;	// position and BBox values do not need to be in
 						// BudgetItem - they can be obtained by following back
 //	Float mRadius;		// through the cut to the forest and using miNode to 
@@ -39,6 +38,7 @@ struct BudgetItem
 	Point3 mBBoxCenter;
 
     Float mError;
+	double mViewMotion; // owning cut's Cut::mViewMotion when mError was last computed
     NodeIndex miNode;
 	VertexRenderDatum *pVertexRenderDatum;
 	int CutID; // TODO: this doesn't need to be an int - can save space by making into a char or even fewer bits
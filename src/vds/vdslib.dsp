@@ -109,10 +109,6 @@ SOURCE=.\mergeforest.cpp
 # End Source File
 # Begin Source File
 
-SOURCE=.\node.cpp
-# End Source File
-# Begin Source File
-
 SOURCE=.\nodequeue.cpp
 # End Source File
 # Begin Source File
@@ -181,6 +177,10 @@ SOURCE=.\primtypes.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\reftable.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\renderer.h
 # End Source File
 # Begin Source File
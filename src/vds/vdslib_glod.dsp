@@ -105,10 +105,6 @@ SOURCE=.\manager.cpp
 # End Source File
 # Begin Source File
 
-SOURCE=.\node.cpp
-# End Source File
-# Begin Source File
-
 SOURCE=.\nodequeue.cpp
 # End Source File
 # Begin Source File
@@ -173,6 +169,10 @@ SOURCE=.\primtypes.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\reftable.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\renderer.h
 # End Source File
 # Begin Source File
@@ -16,7 +16,6 @@
 #include "xbs.h"
 #include "Hierarchy.h"
 
-#ifdef GLOD_COREPROFILE_FIXED
 class VDSHierarchy: public Hierarchy
 {
     private:
@@ -26,15 +25,14 @@ class VDSHierarchy: public Hierarchy
     
     public:
             GLfloat quadricMultiplier;    
-        
-        Vif *vif; // used for building VDS  
+        int nodeLayout; // GLOD_LAYOUT_*, applied when the forest is built
     
-        Forest *mpForest;  
+        Forest *mpForest; // built directly as the simplifier runs
     
         VDSHierarchy()  : Hierarchy(VDS_Hierarchy)
         {
-            vif = NULL;
             mpForest = NULL;
+            nodeLayout = GLOD_LAYOUT_DEPTH_FIRST;
             numDanglingVerts = 0;
             danglingVerts = new int();
             maxDanglingVerts = 1;
@@ -44,8 +42,6 @@ class VDSHierarchy: public Hierarchy
                 delete mpForest;
             if(danglingVerts != NULL)
                 delete [] danglingVerts;
-            if(vif != NULL)
-                delete vif;
         };
         void InitForLoad() { 
             delete [] danglingVerts;
@@ -90,6 +86,23 @@ class VDSHierarchy: public Hierarchy
         }
 };
 
+// room a VDSCut's renderer starts out with; it grows along with the cut, so
+// many cuts of one large hierarchy don't each pay for the whole forest
+#define VDSCUT_INITIAL_VERTICES 1024
+#define VDSCUT_INITIAL_TRIS 2048
+
+// one patch of a VDSCut as of its last commit(), packed the way readback()
+// hands it out
+struct VDSFrontPatch
+{
+    GLOD_RawPatch raw;          // every attribute the forest has
+    unsigned int maxVerts;      // room in raw's vertex arrays
+    unsigned int maxIndices;    // room in raw.triangles
+    int version;                // commits that changed the patch
+
+    VDSFrontPatch() { raw.data_flags = 0; maxVerts = maxIndices = 0; version = 0; }
+};
+
 class VDSCut : public GLOD_Cut
 {    
     public:
@@ -97,6 +110,19 @@ class VDSCut : public GLOD_Cut
         VDS::Renderer *mpRenderer;
         VDS::Cut *mpCut;
 
+        // The renderer is the back state: adaptation folds and unfolds it
+        // in place. commit() packs it into these front patches, which are
+        // all that readback touches.
+        int numFrontPatches;
+        VDSFrontPatch *frontPatches;
+        int *frontVertexMap;            // renderer slot -> packed index + 1
+        unsigned int frontVertexMapSize;
+
+        void packFrontPatch(int PatchID);
+        virtual int getPatchLevel(int patch) {
+            return (patch < numFrontPatches) ? frontPatches[patch].version : -1;
+        }
+
         VDSCut(VDSHierarchy *hier);
 
         virtual ~VDSCut()
@@ -105,15 +131,14 @@ class VDSCut : public GLOD_Cut
                 delete mpCut;
             if(mpRenderer != NULL)
                 delete mpRenderer;
+            delete [] frontPatches;
+            delete [] frontVertexMap;
         };      
                 
         virtual void setGroup(GLOD_Group* glodgroup);
         virtual void viewChanged();
         virtual void adaptObjectSpaceErrorThreshold(float threshold);
         virtual void adaptScreenSpaceErrorThreshold(float threshold);
-        virtual void draw(int patchnum);
-        
-        virtual void BindAdaptXform();
         
         virtual void coarsen(ErrorMode mode, int triTermination,
                              float ErrorTermination);
@@ -126,13 +151,11 @@ class VDSCut : public GLOD_Cut
         virtual xbsReal currentErrorScreenSpace(int area=-1);
         
         virtual void updateStats();
+        virtual void commit();
 
         virtual void getReadbackSizes(int patch, GLuint* nindices, GLuint* nverts);
         virtual void readback(int npatch, GLOD_RawPatch* patch);
-
-        void initVBO();
 };
-#endif
 
 #endif //#ifndef _GLOD_XBS_CONTINUOUS_H
 
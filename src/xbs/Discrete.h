@@ -92,7 +92,12 @@ class DiscreteLevel
 #ifdef GLOD
     DiscreteLevel(DiscreteHierarchy* h, GLOD_RawObject *raw, unsigned int level);
 #endif
-    DiscreteLevel() { }; // used by Hierarchy::load to rebuild us
+    DiscreteLevel() { // used by Hierarchy::load to rebuild us
+        hierarchy = NULL;
+        numPatches = 0;
+        patches = NULL;
+        numTris = 0;
+    };
     ~DiscreteLevel() {
         delete [] patches;
     }
@@ -131,7 +136,15 @@ class DiscreteHierarchy : public Hierarchy
         int current;
         OperationType opType;
 
+        // bounding sphere of LOD 0, shared by every cut on this
+        // hierarchy. Computed by the first makeCut().
+        xbsVec3 center;
+        xbsReal radius;
+        int haveBoundingSphere;
+        void computeBoundingSphere();
+
         DiscreteHierarchy(OperationType opType) : Hierarchy(Discrete_Hierarchy) {
+            haveBoundingSphere = 0;
             LODs = NULL;
             errors = NULL;
             numLODs = 0;
@@ -205,10 +218,15 @@ class DiscreteHierarchy : public Hierarchy
         // Whole hierarchy readback
         virtual int  getReadbackSize();
         virtual void readback(void* dst);
+#ifdef GLOD
+        virtual int getNumLevels();
+        virtual bool getLevelPatchData(int level, int patch,
+                                       GLOD_CutPatchData* data);
+#endif
         virtual int load(void* src); // returns 0 on fail
         virtual void changeQuadricMultiplier(GLfloat multiplier);
         virtual int GetPatchCount() {
-            return LODs[current]->numPatches;
+            return LODs[0]->numPatches; // the same at every level
         }
 };
 
@@ -220,29 +238,26 @@ class DiscreteCut : public GLOD_Cut
             currentNumTris = hierarchy->LODs[LODNumber]->numTris;
             refineTris = (LODNumber == 0) ? MAXINT :
                 hierarchy->LODs[LODNumber-1]->numTris;
-            hierarchy->current=LODNumber;
         }
-        void computeBoundingSphere();
     
     public:
         DiscreteHierarchy *hierarchy;
-        int LODNumber;
-    
-        // bounding sphere
-        xbsVec3 center;
-        xbsReal radius;
+        int LODNumber;    // back state, moved by adaptation
+        int frontLOD;     // published state, read by readback
     
         DiscreteCut(DiscreteHierarchy *hier, int LODNum)
         {
             hierarchy = hier;
             LODNumber = LODNum;
-            computeBoundingSphere();
+            frontLOD = LODNum;
             updateStats();
         }
 
         virtual ~DiscreteCut() { }
 
         virtual void viewChanged() { }
+        virtual void commit() { frontLOD = LODNumber; }
+        virtual int getPatchLevel(int patch) { return frontLOD; }
         virtual void adaptObjectSpaceErrorThreshold(float threshold);
         virtual void adaptScreenSpaceErrorThreshold(float threshold);
 
@@ -273,6 +288,7 @@ class DiscreteCut : public GLOD_Cut
 #ifdef GLOD
         virtual void getReadbackSizes(int patch, GLuint* nindices, GLuint* nverts);
         virtual void readback(int npatch, GLOD_RawPatch* patch);
+        virtual bool getPatchData(int patch, GLOD_CutPatchData* data);
 #endif
 
         void initVBO();
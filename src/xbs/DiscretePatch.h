@@ -122,8 +122,17 @@ class DiscretePatchHierarchy : public Hierarchy
 
         //int *current;
         OperationType opType;
+
+        // bounding sphere of LOD 0, shared by every cut on this
+        // hierarchy. Computed by the first makeCut().
+        xbsVec3 center;
+        xbsReal radius;
+        int haveBoundingSphere;
+        void computeBoundingSphere();
+
         DiscretePatchHierarchy(OperationType opType): Hierarchy(DiscretePatch_Hierarchy)
         {
+            haveBoundingSphere = 0;
             LODs = NULL;
             errors = NULL;
             numLODs = NULL;
@@ -187,6 +196,11 @@ class DiscretePatchHierarchy : public Hierarchy
         // Whole hierarchy readback
         virtual int  getReadbackSize();
         virtual void readback(void* dst);
+#ifdef GLOD
+        virtual int getNumLevels();
+        virtual bool getLevelPatchData(int level, int patch,
+                                       GLOD_CutPatchData* data);
+#endif
         virtual int load(void* src); // returns 0 on fail
 
         virtual int GetPatchCount() {
@@ -217,7 +231,6 @@ class DiscretePatchCut : public GLOD_Cut
             }
             //*(hierarchy->current)=LODNumber;
         }
-        void computeBoundingSphere();
     
     public:
         DiscretePatchHierarchy *hierarchy;
@@ -225,16 +238,12 @@ class DiscretePatchCut : public GLOD_Cut
     
         Heap *refineQueue;
         Heap *coarsenQueue;
-        int *patchLevel;
+        int *patchLevel;   // back state, moved by adaptation
+        int *frontLevel;   // published state, read by readback
         
         int modeChange;
         ErrorMode lastMode;
         
-    
-        // bounding sphere
-        xbsVec3 center;
-        xbsReal radius;
-        
         HeapElement **budgetCoarsenHeapData;
         HeapElement **budgetRefineHeapData;
         
@@ -244,7 +253,6 @@ class DiscretePatchCut : public GLOD_Cut
         {
             hierarchy = hier;
             LODNumber = LODNum;
-            computeBoundingSphere();
             patchLevel = new int[hierarchy->LODs[0]->numPatches];
             for (int i=0; i<hierarchy->LODs[0]->numPatches; i++)
                 patchLevel[i]=0;
@@ -279,12 +287,34 @@ class DiscretePatchCut : public GLOD_Cut
                 refineQueue->insert(budgetRefineHeapData[i]);
                 coarsenQueue->insert(budgetCoarsenHeapData[i]);
             }
+            frontLevel = new int[numPatches];
+            commit();
             lastCoarsen = NULL;
             lastRefine = NULL;
             updateStats();
         }
 
+        virtual ~DiscretePatchCut()
+        {
+            // the heaps touch their elements on the way out
+            delete refineQueue;
+            delete coarsenQueue;
+            for (int i=0; i<hierarchy->LODs[0]->numPatches; i++) {
+                delete budgetRefineHeapData[i];
+                delete budgetCoarsenHeapData[i];
+            }
+            delete [] budgetRefineHeapData;
+            delete [] budgetCoarsenHeapData;
+            delete [] patchLevel;
+            delete [] frontLevel;
+        }
+
         virtual void viewChanged() { }
+        virtual void commit() {
+            memcpy(frontLevel, patchLevel,
+                   sizeof(int) * hierarchy->LODs[0]->numPatches);
+        }
+        virtual int getPatchLevel(int patch) { return frontLevel[patch]; }
         virtual void adaptObjectSpaceErrorThreshold(float threshold);
         virtual void adaptScreenSpaceErrorThreshold(float threshold);
         virtual void coarsen(ErrorMode mode, int triTermination,
@@ -375,6 +405,7 @@ class DiscretePatchCut : public GLOD_Cut
         // readback on a cut on a patch
         virtual void getReadbackSizes(int patch, GLuint* nindices, GLuint* nverts);
         virtual void readback(int npatch, GLOD_RawPatch* patch);
+        virtual bool getPatchData(int patch, GLOD_CutPatchData* data);
 
         void initVBO();
         void initLists();
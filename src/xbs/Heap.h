@@ -116,8 +116,11 @@ class Heap
         void heapify(int index);
     
     public:
+        unsigned int numOps; // insert/extractMin/changeKey calls, for stats
+
         Heap(int initialMaxSize=1)
         {
+            numOps = 0;
             _size = 0;
             maxSize = initialMaxSize;
             array = new HeapElement *[maxSize];
@@ -24,9 +24,23 @@ extern VDS::Manager s_VDSMemoryManager;
 class EdgeCollapse;
 class Model;
 class Operation;
+class AttribSetArray;
 
 #include "View.h"
 
+#ifdef GLOD
+// The published geometry of one patch, exposed in place so that fills can
+// write straight into the caller's arrays. The indices refer into verts.
+// When compact is false they only touch some of verts (half-edge levels
+// share the base level's vertices) and must be renumbered on the way out.
+struct GLOD_CutPatchData {
+    AttribSetArray* verts;
+    unsigned int* indices;
+    unsigned int numIndices;
+    bool compact;
+};
+#endif
+
 class GLOD_Cut
 {
     public:
@@ -64,10 +78,28 @@ class GLOD_Cut
         virtual xbsReal currentErrorScreenSpace(int area=-1) = 0;
         virtual void updateStats()=0;
 
+        // Cuts keep a front state, which readback and drawing use, and a
+        // back state that adaptation works on. commit() publishes the back
+        // state; until then, fills on another thread see a stable cut.
+        // Cuts with no separate front state have nothing to do here.
+        virtual void commit() {}
+
+        // The published level of a patch, so that the group can tell
+        // which patches a commit changed. Cuts without levels return a
+        // count of the commits that changed the patch instead. Cuts that
+        // can't answer return -1 and are always reported as changed.
+        virtual int getPatchLevel(int patch) { return -1; }
+
         // readback of a patch on a cut
 #ifdef GLOD
         virtual void getReadbackSizes(int patch, GLuint* nindices, GLuint* nverts) = 0;
         virtual void readback(int npatch, GLOD_RawPatch* patch) = 0;
+
+        // Cuts that keep a patch in one AttribSetArray hand it out here;
+        // the others return false and are read back through a RawPatch.
+        virtual bool getPatchData(int patch, GLOD_CutPatchData* data) {
+            return false;
+        }
 #endif
 
     
@@ -107,6 +139,18 @@ class Hierarchy
         
         virtual int GetPatchCount() = 0;
 
+#ifdef GLOD
+        // Every level of the hierarchy at once, so that an application
+        // can upload all of it and then draw index ranges. Hierarchies
+        // without discrete levels have none; a patch that is missing
+        // from a level returns false.
+        virtual int getNumLevels() { return 0; }
+        virtual bool getLevelPatchData(int level, int patch,
+                                       GLOD_CutPatchData* data) {
+            return false;
+        }
+#endif
+
         OutputType getHierarchyType() { return hier_type; }
         
         void LockInstance() {
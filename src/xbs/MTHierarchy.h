@@ -25,13 +25,49 @@
 
 #include "xbs.h"
 #include "mt.h"
+#ifdef GLOD
+#include "AttribSetArray.h"
+#endif
 
 class MTHierarchy : public Hierarchy
 {
     public:
         MT *mt;
 
-        MTHierarchy() : Hierarchy(MT_Hierarchy) {mt = new MT;};
+        // bounding sphere of the whole MT, shared by every cut on this
+        // hierarchy; stands in for arcs that have no geometry of their
+        // own. Computed by the first makeCut().
+        xbsVec3 center;
+        xbsReal radius;
+        int haveBoundingSphere;
+        void computeBoundingSphere();
+
+#ifdef GLOD
+        // Output form of the MT, built by the first makeCut(): each arc
+        // owns a block of its patch's vertices, numbered in first use
+        // order, and its triangles as indices into that block, in the
+        // cache order of mtArc::orderTris(). A cut is output by
+        // concatenating the vertex blocks and index lists of its arcs.
+        AttribSetArray *patchVerts;
+        unsigned int *arcIndices;
+        int *arcIndexStart;     // numArcs+1 offsets into arcIndices
+        int *arcVertStart;      // first vertex of each arc's block
+        int *arcNumVerts;
+        void buildPatchData();
+#endif
+
+        MTHierarchy() : Hierarchy(MT_Hierarchy)
+        {
+            mt = new MT;
+            haveBoundingSphere = 0;
+#ifdef GLOD
+            patchVerts = NULL;
+            arcIndices = NULL;
+            arcIndexStart = NULL;
+            arcVertStart = NULL;
+            arcNumVerts = NULL;
+#endif
+        };
         virtual void initialize(Model *model);
         virtual void finalize(Model *model);
         virtual void update(Model *model, Operation *op,
@@ -44,27 +80,110 @@ class MTHierarchy : public Hierarchy
                             xbsTriangle **destroyedTris, int numDestroyedTris,
                             xbsVertex *generated_vert);
 
-        virtual void debugWrite(char *filename) {mt->writePlyMT(filename);};
-        virtual ~MTHierarchy() {delete mt; mt=NULL;};
+        virtual void debugWrite(char *filename);
+        virtual ~MTHierarchy()
+        {
+            delete mt;
+            mt=NULL;
+#ifdef GLOD
+            if (patchVerts != NULL)
+            {
+                delete [] patchVerts;
+                delete [] arcIndices;
+                delete [] arcIndexStart;
+                delete [] arcVertStart;
+                delete [] arcNumVerts;
+            }
+#endif
+        };
 
         virtual int  getReadbackSize() {
-            fprintf(stderr, "Hierarchy readback for MT not implemented yet.\n");
-            return 0;
+            return mt->getBinaryMTSize();
         } 
         virtual void readback(void* dst) {
-            fprintf(stderr, "Hierarchy readback for MT not implemented yet.\n");
+            mt->writeBinaryMTToBuffer((char*)dst);
         }
         virtual int load(void* src) {
-            fprintf(stderr, "Load (and readback) for MT not implemented.\n");
-            return 0;
+            return mt->readBinaryMTFromBuffer((char*)src);
         }
         virtual int GetPatchCount() {
-            exit(0);
-            return 0;
+            return mt->getNumPatches();
         }
         virtual void changeQuadricMultiplier(GLfloat multiplier) { }
+#ifdef GLOD
+        virtual GLOD_Cut *makeCut();
+#endif
+};
+
+#ifdef GLOD
+class MTCut;
+
+// The mtCut an MTCut adapts. Arc errors are the object-space errors of
+// the arcs' end nodes, or those errors projected through the GLOD view
+// when the cut is adapted in screen space.
+class MTViewCut : public mtCut
+{
+    public:
+        MTCut *owner;
+        int screenSpace;
+
+        MTViewCut() { owner = NULL; screenSpace = 0; };
+        virtual mtReal getArcError(MT *mt, int arcID);
 };
 
+class MTCut : public GLOD_Cut
+{
+    private:
+        MTHierarchy *hierarchy;
+        MTViewCut cut;      // back state, moved by adaptation
+        ErrorMode lastMode;
+
+        // published state: the vertex blocks and index lists of the
+        // cut's arcs, concatenated by patch into frontVerts and
+        // frontIndices, so that a fill copies one compact range per patch
+        int numFrontIndices;
+        int maxFrontIndices;
+        unsigned int *frontIndices;
+        int *patchStart;    // numPatches+1 offsets into frontIndices
+        AttribSetArray *frontVerts;  // the vertices the cut uses, per patch
+
+        // the cut's arcs with triangles as of the last commit, grouped by
+        // patch, so that a commit can tell which patches it changed;
+        // patchVersion counts those changes and stands in for the level
+        std::vector<int> frontArcs, backArcs;
+        std::vector<int> frontArcStart, backArcStart;  // numPatches+1 each
+        int *patchVersion;
+
+        void setMode(ErrorMode mode);
+        xbsReal getError(ErrorMode mode, int nodeID, mtReal error);
+
+    public:
+        MTCut(MTHierarchy *hier);
+        virtual ~MTCut();
+
+        xbsReal computePixelsOfError(mtArc *arc, xbsReal error, int area=-1);
+
+        virtual void viewChanged();
+        virtual void commit();
+        virtual void adaptObjectSpaceErrorThreshold(float threshold);
+        virtual void adaptScreenSpaceErrorThreshold(float threshold);
+        virtual void coarsen(ErrorMode mode, int triTermination,
+                             float errorTermination);
+        virtual void refine(ErrorMode mode, int triTermination,
+                            float errorTermination);
+        virtual xbsReal coarsenErrorObjectSpace(int area=-1);
+        virtual xbsReal currentErrorObjectSpace(int area=-1);
+        virtual xbsReal coarsenErrorScreenSpace(int area=-1);
+        virtual xbsReal currentErrorScreenSpace(int area=-1);
+        virtual void updateStats();
+
+        virtual void getReadbackSizes(int patch, GLuint* nindices, GLuint* nverts);
+        virtual void readback(int npatch, GLOD_RawPatch* patch);
+        virtual bool getPatchData(int patch, GLOD_CutPatchData* data);
+        virtual int getPatchLevel(int patch) { return patchVersion[patch]; }
+};
+#endif
+
 #endif
 /***************************************************************************
  $Log: MTHierarchy.h,v $
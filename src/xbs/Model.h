@@ -1519,11 +1519,14 @@ class Model
         int numPatches;    
         PlyOtherElems *other_elems;
         char indexed;
+        int numRawPatches;         // patches added by addPatch
+        unsigned int rawFlags;     // their GLOD_HAS_* data flags
 
     
         // private methods related to vertex sharing
-        void share_vertices();
-        void matchAttributes();
+        void share_vertices(struct ShareVertex **vlist, int nverts,
+                            float tolerance);
+        void matchAttributes(struct ShareVertex **vlist);
     
         void init()
         {
@@ -1534,6 +1537,8 @@ class Model
             numPatches = 1;
             indexed = 0;
             other_elems = NULL;
+            numRawPatches = 0;
+            rawFlags = 0;
             borderLock = 0;
             snapMode = PercentReduction;
             reductionPercent = 0.5;
@@ -1544,6 +1549,8 @@ class Model
             errorMetric = GLOD_METRIC_SPHERES;
             permissionGrid = NULL;
             pgPrecision = 2.0;
+            buildError = 0;
+            buildErrorMessage = NULL;
         };
 
     public:
@@ -1561,11 +1568,20 @@ class Model
         PermissionGrid * permissionGrid;
         float pgPrecision;
 
+        // GLOD error raised while a hierarchy is built from this Model. The
+        // build may run on a worker thread, so it is recorded here and
+        // reported by the caller instead of going to GLOD_SetError.
+        int buildError;
+        const char *buildErrorMessage;
+
         Model() { init(); };
         Model(DiscreteLevel *obj);
         Model(GLOD_RawObject* obj);
         ~Model(); /* moved to Model.C */
 
+        int addPatch(GLOD_RawPatch *patch, int patchNum);
+        void reserve(int nverts, int ntris);
+
         void indexVertTris();
         void removeEmptyVerts();
         void setOtherElements(PlyOtherElems *other_elements)
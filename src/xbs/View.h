@@ -17,6 +17,11 @@
 class GLOD_View
 {
     public:
+        // computePixelsOfError calls on this view, for stats. VDS
+        // evaluates errors on several threads, so its callbacks use
+        // projectError and its simplifier keeps the count.
+        unsigned int numErrorEvaluations;
+
         Mat4 matrix;
         xbsVec3 eye;
         xbsVec3 forward;
@@ -35,11 +40,18 @@ class GLOD_View
             yFOV = 45.0f; aspect = 4.0f/3.0f;
             //      xPixels = 640;
             tanFOVby2 = tan((yFOV/2.0) * (M_PI/180.0));
+            numErrorEvaluations = 0;
         }
     
         void SetFrom(float m1[16], float m2[16], float m3[16]);
+        void SetFrom(const float m[16]) { matrix.Set(m); } // single, already combined matrix
         //xbsReal computePixelsOfError(xbsVec3 center, xbsReal objectSpaceError);
-        xbsReal computePixelsOfError(xbsVec3 center, xbsVec3 offsets, xbsReal objectSpaceError, int area=-1);
+        xbsReal computePixelsOfError(xbsVec3 center, xbsVec3 offsets, xbsReal objectSpaceError, int area=-1)
+        {
+            numErrorEvaluations++;
+            return projectError(center, offsets, objectSpaceError, area);
+        }
+        xbsReal projectError(xbsVec3 center, xbsVec3 offsets, xbsReal objectSpaceError, int area=-1);
         xbsReal checkFrustrum(xbsVec3 center, xbsVec3 offsets, int area=-1);
 };
 
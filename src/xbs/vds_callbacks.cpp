@@ -41,7 +41,7 @@ VDS::Float StdErrorScreenSpace(VDS::BudgetItem *pItem, const VDS::Cut *pCut)
     GLOD_View *view = (GLOD_View *)pCut->mpExternalViewClass;
     xbsVec3 center(pItem->mBBoxCenter.X, pItem->mBBoxCenter.Y, pItem->mBBoxCenter.Z);
     xbsVec3 offsets(pItem->mXBBoxOffset, pItem->mYBBoxOffset, pItem->mZBBoxOffset);
-    return view->computePixelsOfError(center, offsets, pCut->mpForest->mpErrorParams[pCut->mpForest->mpNodes[pItem->miNode].miErrorParamIndex]); // 1
+    return view->projectError(center, offsets, pCut->mpForest->mpErrorParams[pCut->mpForest->mpNodes[pItem->miNode].miErrorParamIndex]); // 1
 }
 
 VDS::Float StdErrorScreenSpaceNoFrustum(VDS::BudgetItem *pItem, const VDS::Cut *pCut)
@@ -49,7 +49,7 @@ VDS::Float StdErrorScreenSpaceNoFrustum(VDS::BudgetItem *pItem, const VDS::Cut *
     GLOD_View *view = (GLOD_View *)pCut->mpExternalViewClass;
     xbsVec3 center(pItem->mBBoxCenter.X, pItem->mBBoxCenter.Y, pItem->mBBoxCenter.Z);
     xbsVec3 offsets(pItem->mXBBoxOffset, pItem->mYBBoxOffset, pItem->mZBBoxOffset);
-    return view->computePixelsOfError(center, offsets, pCut->mpForest->mpErrorParams[pCut->mpForest->mpNodes[pItem->miNode].miErrorParamIndex]); // 1
+    return view->projectError(center, offsets, pCut->mpForest->mpErrorParams[pCut->mpForest->mpNodes[pItem->miNode].miErrorParamIndex]); // 1
 }
 
 VDS::Float StdErrorObjectSpace(VDS::BudgetItem *pItem, const VDS::Cut *pCut)
@@ -70,3 +70,12 @@ VDS::Float StdErrorObjectSpaceNoFrustum(VDS::BudgetItem *pItem, const VDS::Cut *
 {
     return pCut->mpForest->mpErrorParams[pCut->mpForest->mpNodes[pItem->miNode].miErrorParamIndex];
 }
+
+// RENDER CALLBACKS ***********************************************
+
+// Cuts are read back into the application's arrays by glodFillElements and
+// glodFillArrays, which copy straight out of the renderer's system memory,
+// so there is nothing to draw here.
+void ClientMemoryRenderCallback(VDS::Renderer &renderer, VDS::PatchIndex PatchID)
+{
+}
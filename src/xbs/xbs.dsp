@@ -121,6 +121,10 @@ SOURCE=.\ModelShare.C
 # End Source File
 # Begin Source File
 
+SOURCE=.\MTHierarchy.C
+# End Source File
+# Begin Source File
+
 SOURCE=.\Operation.C
 # End Source File
 # Begin Source File
@@ -357,8 +357,8 @@ class XBSSimplifier
 	
 	output->initialize(model);
 
-    if (model->errorMetric == GLOD_METRIC_PERMISSION_GRID)
-        model->initPermissionGrid();
+	if (model->errorMetric == GLOD_METRIC_PERMISSION_GRID)
+	    model->initPermissionGrid();
 
 	switch(qm)
 	{